@@ -0,0 +1,199 @@
+/**
+ * @file almacenTickets.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Almacén de tickets en segmentos de solo-agregar con índice binario.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Antes cada sesión creaba su propio Ticket_<nombre>_<hora>.txt: tras meses
+ * en producción son cientos de miles de archivos pequeños, lentos de listar,
+ * respaldar y buscar. Ahora todos los tickets van a unos pocos archivos grandes:
+ *
+ * - segmento_NNNNNN.dat: registros binarios uno tras otro (solo se agrega al final).
+ *   Al pasar de TAM_MAX_SEGMENTO se abre el siguiente segmento.
+ * - tickets.idx: una EntradaIndice de tamaño fijo por ticket, en orden de
+ *   ticketId. Se puede mapear a memoria (mmap) tal cual y buscar con binaria.
+ *
+ * Registro (enteros en el orden nativo del host, little endian en x86/ARM):
+ * | magia (4) | longitud (4) | ticketId (8) | fecha (8) | clienteId (4) | numMensajes (4) |
+ * | largoNombre (2) | nombre | { esMio (1) | largoEmisor (2) | emisor | largoTexto (4) | texto }... | crc32 (4) |
+ *
+ * Primero se escribe el registro y DESPUÉS su entrada en el índice: si el
+ * proceso muere a la mitad, al abrir se descarta lo que quedó sin indexar.
+ */
+
+#ifndef ALMACENTICKETS_H
+#define ALMACENTICKETS_H
+
+#include "chat.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * @struct EntradaIndice
+ * @brief Una fila del índice (40 bytes, sin relleno): dónde está cada ticket.
+ */
+struct EntradaIndice {
+    uint64_t ticketId;      ///< ID del ticket (consecutivo, empieza en 1).
+    int64_t fecha;          ///< Fin de la sesión (segundos Unix). No decrece a lo largo del índice.
+    uint32_t clienteId;     ///< ID del cliente atendido.
+    uint32_t segmento;      ///< Número del archivo segmento_NNNNNN.dat.
+    uint64_t desplazamiento; ///< Byte donde empieza el registro dentro del segmento.
+    uint32_t longitud;      ///< Bytes del registro completo (cabecera + datos + crc).
+    uint32_t reservado;     ///< Siempre 0.
+};
+
+/**
+ * @struct RegistroTicket
+ * @brief Ticket ya leído del almacén (con memoria propia).
+ */
+struct RegistroTicket {
+    uint64_t ticketId = 0;
+    uint32_t clienteId = 0;
+    int64_t fecha = 0;              ///< Fecha real de la sesión (la del índice puede estar ajustada).
+    std::string nombre;
+    std::vector<Mensaje> mensajes;
+};
+
+/**
+ * @class AlmacenTickets
+ * @brief Escritura secuencial de tickets y búsquedas O(log n) por ticket, cliente o fecha.
+ * * No es Thread-Safe: en el servidor solo la usa el hilo escritor de tickets.
+ */
+class AlmacenTickets {
+public:
+    static const uint64_t TAM_MAX_SEGMENTO = 64ull * 1024 * 1024; ///< Tamaño a partir del cual se rota de segmento.
+
+private:
+    std::string directorio;     ///< Carpeta del almacén.
+    bool soloLectura;           ///< true si se abrió solo para consultar (ej. desde la CLI).
+
+    int fdIndice;               ///< tickets.idx (abierto para agregar si no es solo lectura).
+    const EntradaIndice* mapa;  ///< Entradas mapeadas a memoria al abrir.
+    size_t entradasMapa;        ///< Cuántas entradas hay en 'mapa'.
+    size_t bytesMapa;           ///< Tamaño de la región mapeada (para munmap).
+    std::vector<EntradaIndice> anexadas; ///< Entradas agregadas después de mapear.
+
+    int fdSegmento;             ///< Segmento actual, donde se agrega.
+    uint32_t segmentoActual;    ///< Número del segmento actual.
+    uint64_t tamSegmento;       ///< Bytes escritos en el segmento actual.
+
+    mutable std::unordered_map<uint32_t, int> fdsLectura; ///< Segmentos abiertos para pread().
+    mutable std::vector<uint32_t> porCliente;              ///< Posiciones ordenadas por (clienteId, ticketId).
+    mutable bool porClienteValido;                         ///< false si hay que reconstruir 'porCliente'.
+
+    std::string buffer;         ///< Memoria reutilizada para serializar un registro.
+
+    /**
+     * @brief Entrada i-ésima del índice (mapeada o anexada).
+     */
+    const EntradaIndice& entrada(size_t i) const;
+
+    /**
+     * @brief Descarta entradas/bytes incompletos de un cierre abrupto y deja listo el segmento actual.
+     */
+    bool recuperar();
+
+    /**
+     * @brief Abre (o crea) el segmento 'numero' para agregar al final.
+     */
+    bool abrirSegmento(uint32_t numero, bool truncar);
+
+    std::string rutaSegmento(uint32_t numero) const;
+    int fdLectura(uint32_t segmento) const;
+
+    /**
+     * @brief Empieza un registro en 'buffer' (cabecera con la longitud aún en 0).
+     */
+    void iniciarRegistro(uint64_t ticketId, uint32_t clienteId, int64_t fecha,
+                         const std::string& nombre, uint32_t numMensajes);
+
+    /**
+     * @brief Agrega un mensaje al registro en 'buffer'.
+     */
+    void serializarMensaje(bool esMio, std::string_view emisor, std::string_view texto);
+
+    /**
+     * @brief Cierra el registro (longitud + crc), lo escribe y lo indexa.
+     * @return ID del ticket o 0 si falló la escritura.
+     */
+    uint64_t anexarRegistro(uint64_t ticketId, uint32_t clienteId, int64_t fecha);
+
+public:
+    AlmacenTickets();
+    ~AlmacenTickets();
+
+    AlmacenTickets(const AlmacenTickets&) = delete;
+    AlmacenTickets& operator=(const AlmacenTickets&) = delete;
+
+    /**
+     * @brief Abre el almacén (lo crea si no existe y no es solo lectura).
+     * @param carpeta Directorio del almacén.
+     * @param lectura true para abrir sin permiso de escritura (no repara nada).
+     */
+    bool abrir(const std::string& carpeta, bool lectura = false);
+
+    /**
+     * @brief Cierra archivos y libera el mapa.
+     */
+    void cerrar();
+
+    /**
+     * @brief Agrega un ticket al final del segmento actual y a su índice.
+     * * Funciona con cualquier rango de mensajes (Chat::Vista, std::vector<Mensaje>...).
+     * @return ID asignado al ticket, o 0 si hubo error.
+     */
+    template <typename Rango>
+    uint64_t agregar(uint32_t clienteId, const std::string& nombre, int64_t fecha, const Rango& mensajes) {
+        uint64_t ticketId = cantidad() == 0 ? 1 : entrada(cantidad() - 1).ticketId + 1;
+        iniciarRegistro(ticketId, clienteId, fecha, nombre, static_cast<uint32_t>(mensajes.size()));
+        for (const auto& m : mensajes) serializarMensaje(m.esMio, m.emisor, m.texto);
+        return anexarRegistro(ticketId, clienteId, fecha);
+    }
+
+    /**
+     * @brief Baja a disco lo escrito (fdatasync del segmento y del índice).
+     */
+    bool sincronizar();
+
+    /**
+     * @brief Número de tickets guardados.
+     */
+    size_t cantidad() const;
+
+    /**
+     * @brief Búsqueda binaria por ID de ticket.
+     */
+    bool buscarPorTicket(uint64_t ticketId, EntradaIndice& resultado) const;
+
+    /**
+     * @brief Todos los tickets de un cliente (búsqueda binaria sobre una permutación ordenada).
+     */
+    std::vector<EntradaIndice> buscarPorCliente(uint32_t clienteId) const;
+
+    /**
+     * @brief Tickets cuya fecha (del índice) está en [desde, hasta].
+     */
+    std::vector<EntradaIndice> buscarPorFecha(int64_t desde, int64_t hasta) const;
+
+    /**
+     * @brief Lee y valida (crc) el registro al que apunta una entrada del índice.
+     */
+    bool leer(const EntradaIndice& e, RegistroTicket& registro) const;
+};
+
+/**
+ * @brief CRC-32 (IEEE). Detecta registros corruptos o a medio escribir (también lo usa el WAL).
+ */
+uint32_t calcularCrc32(const char* datos, size_t tam);
+
+/**
+ * @brief Reconstruye el reporte .txt de un ticket (mismo formato que el original).
+ * @param salida Se le agrega el texto al final.
+ */
+void exportarTexto(const RegistroTicket& registro, std::string& salida);
+
+#endif
@@ -0,0 +1,202 @@
+/**
+ * @file anilloUring.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Envoltura mínima de io_uring (sin liburing) para aceptar, recibir y enviar.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Con epoll el Kernel avisa "este socket está listo" y luego hace falta una
+ * syscall por cada accept(), recv() o send(). Con io_uring se le PIDEN las
+ * operaciones en una cola compartida (SQ) y el Kernel deja los resultados en
+ * otra (CQ), sin syscalls por operación:
+ * - Accept "multishot": una sola petición acepta a todos los clientes que lleguen.
+ * - Recv "multishot" con buffers provistos: el Kernel elige un buffer libre
+ *   del grupo para cada lectura; nosotros lo devolvemos al terminar (la
+ *   devolución es otra petición que viaja en el mismo lote).
+ * - Send: varias peticiones se someten juntas con un solo io_uring_enter().
+ *
+ * El descriptor del anillo se vigila desde el Reactor (epoll): cuando hay
+ * resultados en la CQ, el Reactor llama a procesar().
+ */
+
+#ifndef ANILLOURING_H
+#define ANILLOURING_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * @struct Completado
+ * @brief Un resultado de la CQ.
+ */
+struct Completado {
+    uint64_t etiqueta;  ///< El 'user_data' con que se pidió la operación.
+    int32_t resultado;  ///< Como el retorno de la syscall (negativo = -errno).
+    uint32_t banderas;  ///< IORING_CQE_F_MORE, IORING_CQE_F_BUFFER...
+
+    /**
+     * @brief true si la petición multishot sigue activa (habrá más resultados).
+     */
+    bool hayMas() const;
+
+    /**
+     * @brief true si el Kernel usó un buffer del anillo; su ID está en buffer().
+     */
+    bool usaBuffer() const;
+    uint16_t buffer() const;
+};
+
+/**
+ * @class AnilloUring
+ * @brief Cola de sometimiento/completado de io_uring más un grupo de buffers de recepción.
+ * * Las peticiones (aceptar, recibir, enviar, cancelar) y someter() son
+ * Thread-Safe. procesar(), datosBuffer() y devolverBuffer() solo desde el
+ * hilo que consume la CQ (el del reactor).
+ */
+class AnilloUring {
+private:
+    int anilloFd;
+
+    // --- Cola de sometimiento (SQ) ---
+    void* memoriaSQ;
+    size_t tamMemoriaSQ;
+    io_uring_sqe* sqes;
+    size_t tamSqes;
+    unsigned* sqCabeza;
+    unsigned* sqCola;
+    unsigned* sqFlags;
+    unsigned sqMascara;
+    unsigned sqEntradas;
+    unsigned sqColaLocal;   ///< Próxima entrada libre (se publica en someter()).
+    std::mutex mtxSQ;       ///< La SQ es de un solo productor: los hilos se turnan.
+
+    // --- Cola de completados (CQ) ---
+    void* memoriaCQ;
+    size_t tamMemoriaCQ;
+    io_uring_cqe* cqes;
+    unsigned* cqCabeza;
+    unsigned* cqCola;
+    unsigned cqMascara;
+
+    // --- Buffers provistos (recepción) ---
+    std::vector<char> memoriaBuffers;
+    unsigned numBuffers;
+    unsigned tamBuffer;
+    std::vector<uint16_t> porDevolver; ///< Buffers que no cupieron en la SQ (requiere mtxSQ).
+
+    /// 'user_data' de las devoluciones de buffers: procesar() no las reporta.
+    static const uint64_t ETIQUETA_INTERNA = 0;
+
+    /**
+     * @brief Siguiente SQE libre (requiere mtxSQ). Si la SQ está llena, somete primero.
+     */
+    io_uring_sqe* tomarSqe();
+
+    /**
+     * @brief Publica la cola local y llama a io_uring_enter() (requiere mtxSQ).
+     */
+    bool someterBloqueado(unsigned banderas);
+
+    /**
+     * @brief Verifica con IORING_REGISTER_PROBE que el Kernel conoce las operaciones que usamos.
+     */
+    bool operacionesSoportadas();
+
+    /**
+     * @brief Arma un accept y un recv multishot sobre sockets desechables y
+     * revisa que sigan vivos (IORING_CQE_F_MORE). Solo desde crear().
+     */
+    bool multishotSoportado();
+
+    /**
+     * @brief Espera el siguiente resultado que no sea una devolución de buffer. Solo desde crear().
+     */
+    bool esperarCompletado(Completado& c);
+
+    /**
+     * @brief Somete las devoluciones que quedaron en 'porDevolver' (requiere mtxSQ).
+     */
+    void reintentarDevoluciones();
+
+    /**
+     * @brief Llena un SQE con la devolución del buffer 'id' (requiere mtxSQ).
+     * @return false si la SQ sigue llena.
+     */
+    bool prepararDevolucion(uint16_t id);
+
+    void liberar();
+
+public:
+    static const uint16_t GRUPO_BUFFERS = 0; ///< ID del grupo de buffers provistos.
+
+    AnilloUring();
+    ~AnilloUring();
+
+    AnilloUring(const AnilloUring&) = delete;
+    AnilloUring& operator=(const AnilloUring&) = delete;
+
+    /**
+     * @brief Crea el anillo y provee 'numBuffers' buffers de 'tamBuffer' bytes para recibir.
+     * @return false si el Kernel no tiene io_uring (o lo tiene deshabilitado), le faltan
+     * operaciones o no soporta accept/recv multishot (Linux < 5.19 / 6.0).
+     */
+    bool crear(unsigned entradas, unsigned numBuffers, unsigned tamBuffer);
+
+    /**
+     * @brief Descriptor del anillo: epoll lo reporta legible cuando hay resultados.
+     */
+    int descriptor() const { return anilloFd; }
+
+    /**
+     * @brief Accept multishot: un resultado por cada conexión nueva (ya no bloqueante).
+     */
+    bool aceptar(int fd, uint64_t etiqueta);
+
+    /**
+     * @brief Recv multishot: un resultado por cada lectura, cada una en un buffer del anillo.
+     */
+    bool recibir(int fd, uint64_t etiqueta);
+
+    /**
+     * @brief Send de 'n' bytes. La memoria debe seguir viva hasta su resultado.
+     */
+    bool enviar(int fd, const void* datos, size_t n, uint64_t etiqueta);
+
+    /**
+     * @brief Cancela la petición que se hizo con 'etiquetaObjetivo'.
+     */
+    bool cancelar(uint64_t etiquetaObjetivo, uint64_t etiqueta);
+
+    /**
+     * @brief Entrega al Kernel las peticiones acumuladas (una syscall para todas).
+     */
+    bool someter();
+
+    /**
+     * @brief Vacía la CQ llamando a 'alCompletar' por cada resultado.
+     * @return Cuántos resultados se procesaron.
+     */
+    size_t procesar(const std::function<void(const Completado&)>& alCompletar);
+
+    /**
+     * @brief Bytes que el Kernel dejó en el buffer 'id'.
+     */
+    const char* datosBuffer(uint16_t id) const;
+
+    /**
+     * @brief Regresa el buffer 'id' al grupo para futuras lecturas (sale con el siguiente someter()).
+     * * Si la SQ está llena se guarda y se reintenta en el siguiente lote: un
+     * buffer perdido achicaría el grupo hasta que todo recv diera ENOBUFS.
+     * * Las etiquetas de las demás peticiones nunca deben ser 0 (ETIQUETA_INTERNA).
+     */
+    void devolverBuffer(uint16_t id);
+};
+
+#endif
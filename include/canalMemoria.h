@@ -0,0 +1,155 @@
+/**
+ * @file canalMemoria.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Transporte por memoria compartida para clientes en la misma máquina.
+ * @version 1.0
+ * @date 06/01/2026
+ * * En el kiosco, cliente y servidor suelen correr en el mismo equipo: mandar
+ * cada trama por TCP (loopback) es pasar dos veces por toda la pila de red.
+ * Aquí cada conexión tiene dos anillos de bytes en una memoria compartida
+ * (memfd), uno por sentido, con un solo productor y un solo consumidor:
+ * escribir y leer son un memcpy y un store atómico, sin syscalls.
+ *
+ * Cada lado tiene un "timbre" (eventfd). Solo se toca el del otro cuando hace
+ * falta: si el lector se declaró dormido antes de esperar, o si el escritor
+ * quedó esperando lugar. Con tráfico continuo no hay llamadas al sistema.
+ *
+ * La negociación: el cliente se conecta a un socket Unix abstracto
+ * ("chat-soporte-<puerto>") y el servidor le responde con los descriptores
+ * (SCM_RIGHTS) de la memoria y de los dos timbres. Ese socket se queda
+ * abierto solo para notar si alguno de los dos cuelga; las tramas van por la
+ * memoria, con el mismo formato que por TCP. Si algo falla, el cliente usa TCP.
+ */
+
+#ifndef CANALMEMORIA_H
+#define CANALMEMORIA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "protocolo.h"
+
+/**
+ * @struct AnilloCompartido
+ * @brief Índices de un anillo dentro de la memoria compartida.
+ * * Los índices solo crecen (la posición real es índice & (capacidad - 1)).
+ * Cada campo va en su propia línea de caché: el productor y el consumidor
+ * no se estorban al escribir el suyo.
+ */
+struct AnilloCompartido {
+    alignas(64) std::atomic<uint64_t> escrito;      ///< Lo escribe solo el productor.
+    alignas(64) std::atomic<uint64_t> leido;        ///< Lo escribe solo el consumidor.
+    alignas(64) std::atomic<uint32_t> lectorDormido; ///< 1 = el consumidor espera su timbre.
+    std::atomic<uint32_t> escritorEsperando;        ///< 1 = el productor espera lugar.
+};
+
+/**
+ * @class CanalMemoria
+ * @brief Un lado (servidor o cliente) de una conexión por memoria compartida.
+ * * escribir()/vaciar() desde un solo hilo a la vez (o con un mutex), y
+ * leerEn()/prepararEspera() desde un solo hilo. No es Thread-Safe.
+ */
+class CanalMemoria {
+private:
+    void* memoria;
+    size_t tamMemoria;
+    uint64_t capacidad;             ///< Bytes por anillo (potencia de 2).
+
+    AnilloCompartido* salida;       ///< El anillo donde este lado escribe.
+    char* datosSalida;
+    AnilloCompartido* entrada;      ///< El anillo que este lado lee.
+    char* datosEntrada;
+
+    int timbrePropio;               ///< eventfd que vigila este lado.
+    int timbreAjeno;                ///< eventfd que vigila el otro lado.
+    int memoriaFd;                  ///< Solo en el servidor, hasta ofrecer().
+
+    CanalMemoria();
+
+    /**
+     * @brief Mapea 'fd' y ubica los anillos; 'esServidor' decide cuál es de salida.
+     */
+    bool mapear(int fd, size_t tam, bool esServidor);
+
+    void tocarTimbreAjeno();
+
+public:
+    static const size_t CAPACIDAD = 64 * 1024; ///< Bytes por sentido.
+
+    ~CanalMemoria();
+    CanalMemoria(const CanalMemoria&) = delete;
+    CanalMemoria& operator=(const CanalMemoria&) = delete;
+
+    /**
+     * @brief Nombre del socket Unix abstracto del servidor que escucha en 'puerto'.
+     * * Empieza con '\0' (espacio abstracto: no deja archivos en disco).
+     */
+    static std::string nombreLocal(int puerto);
+
+    /**
+     * @brief Lado servidor: crea la memoria, la inicializa y crea los dos timbres.
+     * * La memoria va sellada (F_SEAL_SHRINK/GROW/SEAL): el cliente no puede cambiarle el tamaño.
+     * @return nullptr si el Kernel no tiene memfd/eventfd, no se pudo sellar o no hay memoria.
+     */
+    static std::unique_ptr<CanalMemoria> crear();
+
+    /**
+     * @brief Lado servidor: manda al cliente la memoria y los timbres por el socket Unix.
+     * * Después cierra el descriptor de la memoria (el mapeo sigue vivo).
+     */
+    bool ofrecer(int socketLocal);
+
+    /**
+     * @brief Lado cliente: recibe los descriptores de ofrecer() y mapea la memoria.
+     * @return nullptr si el servidor no mandó una oferta válida.
+     */
+    static std::unique_ptr<CanalMemoria> aceptarOferta(int socketLocal);
+
+    /**
+     * @brief Copia hasta 'n' bytes al anillo de salida (y toca el timbre si el otro duerme).
+     * @return Cuántos cupieron.
+     */
+    size_t escribir(const char* datos, size_t n);
+
+    /**
+     * @brief El escritor se declara esperando lugar (el anillo se llenó).
+     * @return true si puede dormir; false si el lector liberó lugar mientras tanto.
+     */
+    bool esperarLugar();
+
+    /**
+     * @brief Pasa todo lo posible del BufferSalida al anillo.
+     * * Si no cupo todo, se declara esperando lugar: el otro lado tocará este
+     * timbre cuando lea, y entonces hay que volver a llamar a vaciar().
+     * @return VACIO o PENDIENTE.
+     */
+    ResultadoVaciado vaciar(BufferSalida& buffer);
+
+    /**
+     * @brief Pasa todo lo que haya en el anillo de entrada al BufferLectura.
+     * @return Bytes leídos, o -1 si los índices no tienen sentido (el otro lado está corrupto).
+     */
+    long leerEn(BufferLectura& buffer);
+
+    /**
+     * @brief El lector se declara dormido antes de esperar su timbre.
+     * @return true si puede dormir; false si llegó algo mientras tanto (hay que leer otra vez).
+     */
+    bool prepararEspera();
+
+    /**
+     * @brief Descriptor a vigilar (epoll/poll): se vuelve legible cuando el otro lado avisa.
+     */
+    int timbre() const { return timbrePropio; }
+
+    /**
+     * @brief Consume el aviso del timbre (para que deje de estar legible).
+     */
+    void apagarTimbre();
+};
+
+#endif
@@ -7,7 +7,7 @@
  * @version 1.0
  * @date 06/01/2026
  * * Este archivo contiene la lógica para almacenar y gestionar el flujo de conversación
- * de manera segura entre hilos 
+ * de manera segura entre hilos
  */
 
 #ifndef CHAT_H
@@ -15,78 +15,293 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
 
 /**
  * @struct Mensaje
  * @brief Estructura de datos simple que representa un único mensaje de texto.
  * * Se utiliza struct en lugar de class porque solo necesitamos un contenedor de datos
  * público sin lógica compleja interna.
+ * * Es la copia PROPIA de un mensaje (tickets, WAL, obtenerHistorial()); dentro
+ * del Chat los mensajes no se guardan así (ver VistaMensaje).
  */
 struct Mensaje{
-    
+
     std::string emisor; ///< Nombre o ID de quien envió el mensaje (ej. "Cliente 1", "Soporte").
     std::string texto;  ///< El contenido del mensaje.
     bool esMio;         ///< Flag booleana para la UI: true=Derecha (Verde), false=Izquierda (Blanco).
 
 };
 
+/**
+ * @struct VistaMensaje
+ * @brief Un mensaje tal como vive en el Chat, SIN copiarlo.
+ * * Los textos apuntan a la memoria de la bitácora: valen mientras exista la
+ * Chat::Vista de la que salió.
+ */
+struct VistaMensaje{
+
+    std::string_view emisor;
+    std::string_view texto;
+    bool esMio;
+
+    Mensaje copia() const { return {std::string(emisor), std::string(texto), esMio}; }
+};
+
 /**
  * @class Chat
  * @brief Clase gestora del historial de la conversación.
  * * Esta clase actúa como un recurso compartido entre:
  * 1. El Hilo de Red (que escribe mensajes recibidos).
  * 2. El Hilo Gráfico/Main (que lee mensajes para dibujarlos).
- * * Utiliza un Mutex para evitar Condiciones de Carrera (Race Conditions).
+ * * Los lectores NUNCA toman un mutex (estilo RCU, Read-Copy-Update):
+ * los mensajes viven en una bitácora de segmentos que solo crece, y un
+ * mensaje ya publicado no se vuelve a modificar. Así el hilo de red nunca
+ * se queda esperando a que termine un frame de dibujo.
  */
 class Chat{
 
+    public:
+        static const size_t TAM_SEGMENTO = 256;   ///< Mensajes por segmento.
+        static const size_t MAX_SEGMENTOS = 4096; ///< Segmentos por sesión (~1 millón de mensajes).
+        static const size_t MAX_EMISORES = 256;   ///< Emisores distintos por sesión.
+        static const size_t TAM_BLOQUE = 64 * 1024;      ///< Bytes por bloque de la arena de textos.
+        static const size_t MAX_BLOQUES_LIBRES = 16;     ///< Bloques que se guardan para la siguiente sesión.
+
     private:
         /**
-         * @brief Contenedor dinámico de mensajes.
-         * * Se eligió std::vector por sobre std::list o arreglos fijos porque:
-         * 1. Permite acceso rápido e iteración secuencial (ideal para dibujar 60 FPS).
-         * 2. Crece dinámicamente según sea necesario.
+         * @brief Un mensaje dentro de la bitácora (16 bytes, contra ~72 de un Mensaje).
+         * * El texto vive en la arena de la bitácora y el emisor es un índice a
+         * su tabla de emisores: guardar un mensaje no pide memoria por mensaje.
+         */
+        struct RegistroMensaje {
+            const char* texto;
+            uint32_t largo;
+            uint16_t emisor;    ///< Índice en Bitacora::emisores.
+            bool esMio;
+        };
+
+        /**
+         * @brief Bloque de mensajes de tamaño fijo.
+         * * Se reservan de a TAM_SEGMENTO mensajes para que agregar nunca
+         * tenga que mover (realloc) lo que un lector podría estar leyendo.
+         */
+        struct Segmento {
+            RegistroMensaje registros[TAM_SEGMENTO];
+        };
+
+        /**
+         * @brief Bitácora de una sesión: directorio fijo de segmentos + contador publicado.
+         * * Un mensaje solo es visible cuando 'publicados' lo incluye, y se
+         * escribe ANTES de incrementar el contador (orden release/acquire).
+         * * Los textos van en una arena (bloques de TAM_BLOQUE que se llenan de
+         * corrido y nunca se mueven) y los emisores se guardan una sola vez
+         * ("Yo", "Sistema", "Cliente 5"...). Todo se libera junto con la bitácora.
+         */
+        struct Bitacora {
+            std::atomic<Segmento*> segmentos[MAX_SEGMENTOS]; ///< Directorio (nullptr = aún no reservado).
+            std::atomic<size_t> publicados;                  ///< Mensajes visibles para los lectores.
+            std::atomic<int> lectores;                       ///< Vistas vivas que apuntan a esta bitácora.
+            uint64_t versionBase;                            ///< Versión del Chat al crearla (tras la limpieza).
+            bool avisoLlena;                                 ///< Ya se reportó que se llenó (solo escritores).
+
+            std::string_view emisores[MAX_EMISORES];         ///< Nombres (en la arena), publicados con el mensaje que los usa.
+            size_t numEmisores;                              ///< Solo escritores.
+
+            std::vector<char*> bloques;                      ///< Arena: bloques de TAM_BLOQUE (solo escritores).
+            std::vector<char*> bloquesGrandes;               ///< Textos de más de medio bloque, cada uno en el suyo.
+            size_t usadoBloque;                              ///< Bytes usados del último bloque.
+
+            explicit Bitacora(uint64_t base);
+            ~Bitacora();
+
+            VistaMensaje leer(const RegistroMensaje& r) const {
+                return {emisores[r.emisor], std::string_view(r.texto, r.largo), r.esMio};
+            }
+        };
+
+        /**
+         * @brief Bitácora vigente. limpiarHistorial() la sustituye con un intercambio atómico.
+         */
+        std::atomic<Bitacora*> actual;
+
+        /**
+         * @brief Lectores que están en medio de obtenerVista().
+         * * Mientras sea distinto de 0 no se libera ninguna bitácora retirada:
+         * un lector podría haber leído el puntero viejo y aún no registrarse en él.
+         */
+        mutable std::atomic<int> entrando;
+
+        /**
+         * @brief Semáforo de exclusión mutua ENTRE ESCRITORES.
+         * * Solo lo toman agregarMensaje() y limpiarHistorial(). Los lectores no lo tocan.
+         */
+        std::mutex mtxEscritura;
+
+        /**
+         * @brief Bitácoras sustituidas que todavía podrían tener lectores. Protegido por mtxEscritura.
+         */
+        std::vector<Bitacora*> retiradas;
+
+        /**
+         * @brief Contador monotónico de cambios.
+         * * Aumenta en 1 con cada mensaje agregado y con cada limpieza. Es atómico
+         * para que los lectores puedan preguntar "¿cambió algo?" sin hacer nada más.
          */
-        std::vector<Mensaje> historial;
+        std::atomic<uint64_t> version;
 
         /**
-         * @brief Semáforo de exclusión mutua.
-         * * Este objeto es CRITICO. Bloquea el acceso al vector mientras un hilo
-         * está escribiendo, obligando al otro a esperar. Sin esto, el programa
-         * crashearía al intentar leer y escribir memoria simultáneamente.
+         * @brief Bloques de arena de bitácoras ya liberadas, para no volver a pedirlos. Protegido por mtxEscritura.
          */
-        std::mutex mtx;
+        std::vector<char*> bloquesLibres;
+
+        /**
+         * @brief Libera las bitácoras retiradas que ya nadie lee. Requiere mtxEscritura.
+         */
+        void liberarRetiradas();
+
+        /**
+         * @brief Copia 'texto' a la arena de 'b' y devuelve dónde quedó. Requiere mtxEscritura.
+         */
+        const char* copiarEnArena(Bitacora& b, std::string_view texto);
+
+        /**
+         * @brief Índice de 'emisor' en la tabla de 'b' (lo agrega si es nuevo). Requiere mtxEscritura.
+         * @return false si la tabla está llena.
+         */
+        bool internarEmisor(Bitacora& b, std::string_view emisor, uint16_t& indice);
 
     public:
         /**
-         * @brief Constructor por defecto. Inicializa un historial vacío.
+         * @class Vista
+         * @brief Instantánea consistente del historial, SIN copiar mensajes.
+         * * Ve exactamente los mensajes publicados cuando se obtuvo; lo que se
+         * agregue después no la altera. Mientras exista, la bitácora no se libera
+         * aunque el historial se limpie.
          */
-        Chat(){};
+        class Vista {
+            private:
+                Bitacora* bitacora; ///< Bitácora referenciada (nullptr si la vista fue movida).
+                size_t cantidad;    ///< Mensajes visibles en esta instantánea.
+
+                friend class Chat;
+                Vista(Bitacora* b, size_t n);
+
+                const RegistroMensaje* segmentoDe(size_t i) const;
+
+            public:
+                Vista(const Vista& otra);
+                Vista(Vista&& otra) noexcept;
+                Vista& operator=(Vista otra) noexcept;
+                ~Vista();
+
+                /**
+                 * @brief Iterador de solo lectura, para usar la vista en un for de rango.
+                 * * Recorre segmento por segmento: solo consulta el directorio al cruzar
+                 * de un segmento al siguiente. Entrega VistaMensaje por valor.
+                 */
+                class Iterador {
+                    private:
+                        const Vista* vista;
+                        size_t indice;
+                        const RegistroMensaje* segmento; ///< Primer registro del segmento actual.
+                    public:
+                        Iterador(const Vista* v, size_t i) : vista(v), indice(i), segmento(nullptr) {
+                            if (indice < vista->cantidad) segmento = vista->segmentoDe(indice);
+                        }
+                        VistaMensaje operator*() const { return vista->bitacora->leer(segmento[indice % TAM_SEGMENTO]); }
+                        Iterador& operator++() {
+                            ++indice;
+                            if (indice % TAM_SEGMENTO == 0 && indice < vista->cantidad) segmento = vista->segmentoDe(indice);
+                            return *this;
+                        }
+                        bool operator!=(const Iterador& otro) const { return indice != otro.indice; }
+                        bool operator==(const Iterador& otro) const { return indice == otro.indice; }
+                };
+
+                size_t size() const { return cantidad; }
+                bool empty() const { return cantidad == 0; }
+                VistaMensaje operator[](size_t i) const;
+                Iterador begin() const { return Iterador(this, 0); }
+                Iterador end() const { return Iterador(this, cantidad); }
+
+                /**
+                 * @brief Versión del Chat que representa esta instantánea.
+                 */
+                uint64_t obtenerVersion() const;
+
+                /**
+                 * @brief Versión que tenía el Chat justo después de la limpieza que creó esta bitácora.
+                 */
+                uint64_t obtenerVersionBase() const;
+        };
+
+        /**
+         * @brief Constructor por defecto. Inicializa un historial vacío en la versión 0.
+         */
+        Chat();
+
+        /**
+         * @brief Destructor. Libera todas las bitácoras (no deben quedar vistas vivas).
+         */
+        ~Chat();
+
+        Chat(const Chat&) = delete;
+        Chat& operator=(const Chat&) = delete;
 
         /**
          * @brief Inserta un nuevo mensaje en el historial de forma segura.
+         * * El texto se copia una sola vez (a la arena); el emisor, solo la
+         * primera vez que aparece en la sesión.
          * @param emisor El nombre de quien envía.
          * @param texto El contenido del mensaje.
          * @param esMio Define si el mensaje lo escribí yo (true) o me llegó (false).
          */
-        void agregarMensaje(std::string emisor, std::string texto, bool esMio);
+        void agregarMensaje(std::string_view emisor, std::string_view texto, bool esMio);
+
+        /**
+         * @brief Obtiene una instantánea del historial SIN bloquear y SIN copiar.
+         * * Es la forma recomendada de leer para dibujar: cuesta unas pocas
+         * operaciones atómicas sin importar el largo de la conversación.
+         */
+        Vista obtenerVista() const;
+
+        /**
+         * @brief Obtiene una COPIA del historial actual.
+         * @return std::vector<Mensaje> Una copia de los mensajes.
+         * * Útil cuando se necesita un vector propio (ej. para serializar).
+         */
+        std::vector<Mensaje> obtenerHistorial() const;
+
+        /**
+         * @brief Versión actual del historial. No bloquea.
+         */
+        uint64_t obtenerVersion() const;
 
         /**
-         * @brief Obtiene una COPIA del historial actual para ser dibujada.
-         * @return std::vector<Mensaje> Una copia segura de los mensajes.
-         * * Se devuelve por valor (copia) y no por referencia para que el hilo gráfico
-         * pueda dibujar tranquilo sin bloquear al hilo de red por mucho tiempo.
+         * @brief Sincroniza una copia local copiando SOLO lo que cambió.
+         * * Si la versión no cambió, regresa sin hacer nada más.
+         * * Si hubo una limpieza desde esa versión, la copia se vacía y se rellena.
+         * @param versionLocal Versión que el consumidor ya tiene; se actualiza.
+         * @param copiaLocal Copia del consumidor; se le agregan los mensajes nuevos.
+         * @return true si la copia cambió.
          */
-        std::vector<Mensaje> obtenerHistorial();
+        bool obtenerCambios(uint64_t& versionLocal, std::vector<Mensaje>& copiaLocal) const;
 
         /**
          * @brief Borra todos los mensajes almacenados.
          * * Utilizado cuando se cambia de cliente o se cierra una sesión,
          * para asegurar que el siguiente usuario empiece con la pantalla limpia.
+         * * Las vistas que ya existían siguen viendo la sesión anterior.
+         * * Es el "reinicio" de la arena: los bloques de la sesión anterior se
+         * reciclan en cuanto ninguna vista la lee.
          */
         void limpiarHistorial();
 
 };
 
-#endif
\ No newline at end of file
+#endif
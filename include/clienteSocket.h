@@ -15,6 +15,10 @@
 
 #include <netinet/in.h> // Estructuras necesarias para direcciones de internet (sockaddr_in)
 #include <string>       // Para manejar cadenas de texto dinámicas (std::string)
+#include <mutex>        // Para que el hilo de red y el de UI no mezclen tramas al enviar
+#include <memory>       // std::unique_ptr del canal de memoria
+#include "protocolo.h"  // Formato de tramas compartido con el servidor
+#include "canalMemoria.h" // Transporte sin red cuando el servidor está en esta máquina
 
 /**
  * @class ClienteSocket
@@ -39,6 +43,60 @@ class ClienteSocket{
          */
         sockaddr_in serverAddr;
 
+        BufferLectura entrada;             ///< Bytes recibidos que aún no forman una trama completa.
+        DecodificadorTramas decodificador; ///< Estado del decodificador incremental.
+        uint32_t secuenciaSalida;          ///< Secuencia de la próxima trama a enviar.
+        BufferSalida salida;               ///< Tramas que el Kernel aún no acepta.
+        bool esperandoEscritura;           ///< true si 'salida' quedó a medias y hay que esperar POLLOUT.
+
+        /**
+         * @brief eventfd con el que enviarTrama() despierta al hilo de red.
+         * * Si el Kernel no aceptó todo, el resto lo termina de mandar el hilo
+         * de red (vigilando POLLOUT), no el hilo de UI.
+         */
+        int despertador;
+
+        /**
+         * @brief true mientras el hilo de red usa el socket en poll()/recv().
+         * * Entonces cerrar() no lo cierra (el número podría reutilizarse en
+         * medio de la espera): lo apaga con shutdown() y deja el close() a
+         * ese hilo, que lo hace al soltarlo (ver 'porCerrar').
+         */
+        bool usandoSocket;
+        int porCerrar;                     ///< Socket que cerrar() dejó para que lo cierre el hilo de red (-1 = ninguno).
+
+        /**
+         * @brief Protege 'clienteSocket', 'secuenciaSalida', 'salida', 'esperandoEscritura',
+         * 'usandoSocket' y 'porCerrar'.
+         * * El hilo de UI envía mensajes y el hilo de red contesta PINGs:
+         * sin esto podrían salir dos tramas con la secuencia invertida.
+         */
+        std::mutex mtxEnvio;
+
+        /**
+         * @brief Memoria compartida con el servidor (si está en esta máquina).
+         * * Con canal, 'clienteSocket' es el socket Unix de la negociación y solo
+         * sirve para notar que el servidor colgó; las tramas van por aquí.
+         */
+        std::unique_ptr<CanalMemoria> canal;
+        bool memoriaCompartida;            ///< Intentar la memoria compartida al conectar a 127.x.
+
+        /**
+         * @brief El socket aceptó datos: manda lo pendiente (hilo de red).
+         */
+        void continuarEscritura();
+
+        /**
+         * @brief El hilo de red dejó de usar el socket: si cerrar() llegó mientras tanto, lo cierra.
+         */
+        void soltarSocket();
+
+        /**
+         * @brief Pide la memoria compartida al servidor local de 'puerto'.
+         * @return true si 'clienteSocket' ya es el socket Unix y 'canal' está listo.
+         */
+        bool conectarLocal(int puerto);
+
     public:
 
         /**
@@ -70,18 +128,35 @@ class ClienteSocket{
         bool conectar(const char* ip, int puerto);
 
         /**
-         * @brief Envía datos a través del túnel.
-         * * Serializa el texto y lo empuja al buffer de salida de la tarjeta de red.
+         * @brief Con true (por omisión), conectar() a 127.x intenta primero la
+         * memoria compartida y solo si falla usa TCP.
+         */
+        void usarMemoriaCompartida(bool activar);
+
+        /**
+         * @brief Envía un mensaje de chat a través del túnel.
+         * * Lo empaqueta en una trama MENSAJE y la empuja al buffer de salida de la tarjeta de red.
+         * Nunca bloquea: lo que el Kernel no acepte lo termina de mandar el hilo de red.
          * @param mensaje El texto crudo (string) a enviar.
+         * @return SATURADO si el servidor no está leyendo al ritmo; CERRADO si no hay conexión;
+         * DEMASIADO_GRANDE si pasa de MAX_CARGA (no se envía).
+         */
+        EstadoEnvio enviar(const char* mensaje);
+
+        /**
+         * @brief Envía una trama de cualquier tipo (ej. PONG). Thread-Safe, no bloquea.
          */
-        void enviar(const char* mensaje);
+        EstadoEnvio enviarTrama(TipoTrama tipo, std::string_view datos);
 
         /**
-         * @brief Espera y captura datos provenientes del servidor.
-         * * Lee el buffer de entrada de la tarjeta de red.
-         * @return std::string El mensaje reconstruido como objeto string de C++.
+         * @brief Espera y captura la siguiente trama proveniente del servidor.
+         * * Solo llama a recv() cuando el buffer no contiene ya una trama completa,
+         * así varias tramas que llegaron juntas se entregan sin más syscalls.
+         * * Mientras espera también termina de mandar la salida pendiente.
+         * @param trama Donde se deja la trama recibida.
+         * @return false si el servidor cerró la conexión o mandó datos inválidos.
          */
-        std::string recibir();
+        bool recibir(Trama& trama);
 
         /**
          * @brief Cierra ordenadamente la conexión.
@@ -0,0 +1,130 @@
+/**
+ * @file colaMPSC.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Cola sin bloqueos de muchos productores y un consumidor, con despertador eventfd.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Algoritmo de D. Vyukov: cada productor enlaza su nodo con un solo
+ * exchange() atómico (nunca espera a nadie); el único consumidor avanza por
+ * la lista sin atómicos de escritura. Así el hilo que acepta conexiones no
+ * compite por un mutex con el que las despacha.
+ *
+ * El consumidor puede dormir en esperar() (o vigilar descriptor() con
+ * epoll/poll): el primer productor que encuentra la cola "sin avisar" escribe
+ * en el eventfd; los demás no hacen ninguna llamada al sistema.
+ */
+
+#ifndef COLAMPSC_H
+#define COLAMPSC_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+/**
+ * @class ColaMPSC
+ * @brief FIFO: empujar() desde cualquier hilo, sacar()/esperar() desde uno solo.
+ */
+template <typename T>
+class ColaMPSC {
+private:
+    /**
+     * @brief Nodo de la lista. El nodo al frente es siempre un "centinela" ya consumido.
+     */
+    struct Nodo {
+        std::atomic<Nodo*> siguiente{nullptr};
+        T valor{};
+    };
+
+    alignas(64) std::atomic<Nodo*> ultimo;   ///< Donde enlazan los productores.
+    alignas(64) Nodo* frente;                ///< Centinela; solo lo toca el consumidor.
+    std::atomic<bool> avisado;               ///< true si ya hay un aviso pendiente en el eventfd.
+    int despertador;                         ///< eventfd.
+
+public:
+    ColaMPSC() : avisado(false) {
+        Nodo* centinela = new Nodo();
+        ultimo.store(centinela, std::memory_order_relaxed);
+        frente = centinela;
+        despertador = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+
+    ~ColaMPSC() {
+        T descartado;
+        while (sacar(descartado)) {}
+        delete frente;
+        if (despertador >= 0) ::close(despertador);
+    }
+
+    ColaMPSC(const ColaMPSC&) = delete;
+    ColaMPSC& operator=(const ColaMPSC&) = delete;
+
+    /**
+     * @brief Agrega al final y despierta al consumidor. Thread-Safe, sin bloqueos.
+     */
+    void empujar(T valor) {
+        Nodo* nodo = new Nodo();
+        nodo->valor = std::move(valor);
+        Nodo* anterior = ultimo.exchange(nodo, std::memory_order_acq_rel);
+        // Entre el exchange y este store la lista está "cortada": sacar() lo ve como vacía.
+        anterior->siguiente.store(nodo, std::memory_order_release);
+
+        if (!avisado.exchange(true, std::memory_order_acq_rel)) {
+            uint64_t uno = 1;
+            ssize_t ignorado = ::write(despertador, &uno, sizeof(uno));
+            (void)ignorado;
+        }
+    }
+
+    /**
+     * @brief Saca el primero. Solo desde el hilo consumidor.
+     * @return false si está vacía (o un productor está a mitad de enlazar; su aviso llegará).
+     */
+    bool sacar(T& valor) {
+        Nodo* siguiente = frente->siguiente.load(std::memory_order_acquire);
+        if (!siguiente) return false;
+        valor = std::move(siguiente->valor);
+        delete frente;
+        frente = siguiente; // El nodo sacado pasa a ser el nuevo centinela.
+        return true;
+    }
+
+    /**
+     * @brief Duerme hasta que haya un aviso o pase 'limite' (negativo = sin límite). Solo desde el hilo consumidor.
+     * * Consume el aviso ANTES de que el llamador vacíe la cola: un productor
+     * que llegue después volverá a avisar, así que no se pierde ninguno.
+     * @return true si hubo aviso.
+     */
+    bool esperar(std::chrono::milliseconds limite) {
+        pollfd p{despertador, POLLIN, 0};
+        if (::poll(&p, 1, static_cast<int>(limite.count())) <= 0) return false;
+        uint64_t contador;
+        ssize_t ignorado = ::read(despertador, &contador, sizeof(contador));
+        (void)ignorado;
+        avisado.store(false, std::memory_order_seq_cst);
+        return true;
+    }
+
+    /**
+     * @brief Despierta a esperar() sin agregar nada (p. ej. para apagar). Thread-Safe.
+     */
+    void despertar() {
+        avisado.store(true, std::memory_order_seq_cst);
+        uint64_t uno = 1;
+        ssize_t ignorado = ::write(despertador, &uno, sizeof(uno));
+        (void)ignorado;
+    }
+
+    /**
+     * @brief eventfd que se vuelve legible cuando hay llegadas (para epoll/poll externos).
+     */
+    int descriptor() const { return despertador; }
+};
+
+#endif
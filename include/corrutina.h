@@ -0,0 +1,189 @@
+/**
+ * @file corrutina.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Corrutinas de C++20 que se reanudan dentro de un Reactor.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Una sesión escrita como corrutina se lee de arriba a abajo
+ * ("espera al siguiente cliente, lee su mensaje, contéstale...") aunque por
+ * debajo no bloquee a nadie: cada co_await guarda su estado en el marco de la
+ * corrutina (unos cientos de bytes en el heap, no la pila de un hilo) y le
+ * regresa el control al Reactor. Cuando el descriptor que esperaba se vuelve
+ * legible, el Reactor la reanuda justo después del co_await.
+ *
+ * - Tarea<T>: corrutina perezosa; arranca al hacerle co_await (o con iniciar()).
+ * - Avisador: un descriptor (eventfd) vigilado por un Reactor al que UNA
+ *   corrutina puede esperar con co_await aviso.siguiente().
+ */
+
+#ifndef CORRUTINA_H
+#define CORRUTINA_H
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <utility>
+#include "reactor.h"
+
+/**
+ * @struct PromesaBaseTarea
+ * @brief Lo común a toda Tarea: arranque perezoso y regreso a quien la esperaba.
+ */
+struct PromesaBaseTarea {
+    std::coroutine_handle<> continuacion; ///< Corrutina que hizo co_await sobre esta (o nada).
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    /**
+     * @brief Al terminar, salta directo a quien la esperaba (transferencia
+     * simétrica: sin crecer la pila aunque haya muchas tareas anidadas).
+     */
+    struct AlTerminar {
+        bool await_ready() noexcept { return false; }
+        template <typename Promesa>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promesa> yo) noexcept {
+            std::coroutine_handle<> siguiente = yo.promise().continuacion;
+            return siguiente ? siguiente : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    AlTerminar final_suspend() noexcept { return {}; }
+
+    /// El proyecto no usa excepciones: si alguna escapa de una sesión, es un error de programación.
+    void unhandled_exception() noexcept { std::terminate(); }
+};
+
+/**
+ * @struct PromesaTarea
+ * @brief Guarda el valor del co_return hasta que quien esperaba lo recoja.
+ */
+template <typename T>
+struct PromesaTarea : PromesaBaseTarea {
+    std::optional<T> valor;
+
+    void return_value(T v) { valor.emplace(std::move(v)); }
+    T tomar() { return std::move(*valor); }
+};
+
+template <>
+struct PromesaTarea<void> : PromesaBaseTarea {
+    void return_void() noexcept {}
+    void tomar() noexcept {}
+};
+
+/**
+ * @class Tarea
+ * @brief Corrutina perezosa que devuelve un T. Dueña de su marco (move-only).
+ * * Al destruirse una Tarea suspendida se destruye su marco, y con él las
+ * subtareas que estuviera esperando.
+ */
+template <typename T = void>
+class Tarea {
+public:
+    struct promise_type : PromesaTarea<T> {
+        Tarea get_return_object() noexcept {
+            return Tarea(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+private:
+    std::coroutine_handle<promise_type> marco;
+
+    explicit Tarea(std::coroutine_handle<promise_type> h) : marco(h) {}
+
+public:
+    Tarea() = default;
+    Tarea(Tarea&& otra) noexcept : marco(std::exchange(otra.marco, {})) {}
+    Tarea& operator=(Tarea&& otra) noexcept {
+        if (this != &otra) {
+            if (marco) marco.destroy();
+            marco = std::exchange(otra.marco, {});
+        }
+        return *this;
+    }
+    Tarea(const Tarea&) = delete;
+    Tarea& operator=(const Tarea&) = delete;
+
+    ~Tarea() {
+        if (marco) marco.destroy();
+    }
+
+    /**
+     * @brief Arranca una tarea raíz (la que nadie espera). Solo en el hilo de su Reactor.
+     */
+    void iniciar() {
+        if (marco && !marco.done()) marco.resume();
+    }
+
+    /**
+     * @brief true si ya llegó a su co_return (o si no hay tarea).
+     */
+    bool terminada() const { return !marco || marco.done(); }
+
+    // --- co_await tarea: la arranca y reanuda a quien espera cuando termine ---
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> quien) noexcept {
+        marco.promise().continuacion = quien;
+        return marco;
+    }
+    T await_resume() { return marco.promise().tomar(); }
+};
+
+/**
+ * @class Avisador
+ * @brief Puente entre un descriptor que "suena" (eventfd) y la corrutina que lo espera.
+ * * El descriptor se registra una sola vez en el Reactor. Cada vez que se
+ * vuelve legible se consume el aviso y, si hay una corrutina esperando, se
+ * reanuda. Si nadie esperaba, el aviso simplemente se consume: quien espera
+ * siempre revisa su condición ANTES del co_await, así que no se pierde nada.
+ * * Todo ocurre en el hilo del Reactor; no lleva mutex.
+ */
+class Avisador {
+private:
+    Reactor& reactor;
+    int fd;
+    std::function<void()> consumir;     ///< Apaga el aviso (p. ej. leer el eventfd).
+    std::coroutine_handle<> esperando;  ///< A lo más una corrutina.
+    bool registrado;
+
+public:
+    /**
+     * @param consumir Cómo apagar el aviso. Sin ella se lee el contador del eventfd.
+     */
+    Avisador(Reactor& reactor, int fd, std::function<void()> consumir = nullptr);
+    ~Avisador();
+
+    Avisador(const Avisador&) = delete;
+    Avisador& operator=(const Avisador&) = delete;
+
+    /**
+     * @brief Registra el descriptor en el Reactor (hilo del Reactor o antes de ejecutar()).
+     */
+    bool armar();
+
+    /**
+     * @brief Reanuda a quien esté esperando sin que haya sonado el descriptor (p. ej. al apagar).
+     * * Solo en el hilo del Reactor; desde otro hilo, publicarla con Reactor::publicar().
+     */
+    void despertar();
+
+    /**
+     * @brief Awaitable de siguiente(): siempre suspende y guarda a la corrutina.
+     */
+    struct Espera {
+        Avisador& aviso;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> quien) noexcept { aviso.esperando = quien; }
+        void await_resume() const noexcept {}
+    };
+
+    /**
+     * @brief co_await aviso.siguiente(): duerme hasta el próximo aviso.
+     */
+    Espera siguiente() { return Espera{*this}; }
+};
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file histograma.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Histograma de latencias al estilo HDR (precisión relativa fija).
+ * @version 1.0
+ * @date 06/01/2026
+ * * Guardar cada muestra y ordenarlas (como bench_chat) no escala a millones
+ * de mediciones. Aquí cada potencia de dos se parte en SUB_CUBETAS cubetas
+ * lineales: cualquier valor se guarda con un error relativo < 1/128 (0.8%),
+ * registrar() es O(1) sin memoria extra y dos histogramas se suman cubeta a
+ * cubeta (uno por hilo, se combinan al final).
+ */
+
+#ifndef HISTOGRAMA_H
+#define HISTOGRAMA_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class Histograma
+ * @brief Conteos por cubeta logarítmico-lineal. No es Thread-Safe (uno por hilo).
+ * * Las unidades las decide quien registra (el generador de carga usa microsegundos).
+ */
+class Histograma {
+public:
+    static const unsigned BITS_SUB = 7;                 ///< log2 de las cubetas por potencia de dos.
+    static const uint64_t SUB_CUBETAS = 1ull << BITS_SUB;
+
+private:
+    std::vector<uint64_t> conteos;
+    uint64_t total;
+    uint64_t minimo;
+    uint64_t maximo;
+    long double suma;   ///< Para la media (long double: no se desborda con millones de muestras).
+
+    static size_t indice(uint64_t valor);
+
+    /**
+     * @brief Valor representativo (punto medio) de una cubeta.
+     */
+    static uint64_t valorDe(size_t cubeta);
+
+public:
+    Histograma();
+
+    void registrar(uint64_t valor);
+
+    /**
+     * @brief Suma las muestras de otro histograma (ej. el de otro hilo).
+     */
+    void combinar(const Histograma& otro);
+
+    void limpiar();
+
+    uint64_t cantidad() const { return total; }
+    uint64_t minimoValor() const { return total ? minimo : 0; }
+    uint64_t maximoValor() const { return maximo; }
+    double media() const;
+
+    /**
+     * @brief Valor bajo el cual cae el 'p' por ciento de las muestras (0..100).
+     */
+    uint64_t percentil(double p) const;
+};
+
+#endif
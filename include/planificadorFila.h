@@ -0,0 +1,155 @@
+/**
+ * @file planificadorFila.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Orden en que se atiende a quienes esperan: FIFO o por plazo de servicio (SLA).
+ * @version 1.0
+ * @date 06/01/2026
+ * * El despachador ya no saca "al que llegó primero" de un deque, sino "al
+ * que diga el planificador". Cada entrada trae una fecha límite:
+ * llegada + plazo de su clase. PlanificadorFIFO ignora las clases (todas
+ * con plazo 0: la fecha límite es la llegada). PlanificadorSLA atiende
+ * primero a quien vence antes (Earliest Deadline First) con un montículo
+ * binario: O(log n) al entrar y al salir.
+ *
+ * Con plazos por clase el envejecimiento sale solo: la fecha límite de un
+ * cliente normal no se mueve, así que, por muchos prioritarios que lleguen
+ * después, en cuanto su plazo vence antes que el de ellos pasa adelante.
+ * Nadie espera para siempre.
+ */
+
+#ifndef PLANIFICADORFILA_H
+#define PLANIFICADORFILA_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "protocolo.h"
+#include "registroClientes.h"
+
+/**
+ * @struct EntradaFila
+ * @brief Un cliente en camino a ser atendido, tal como lo ve el despachador.
+ * * Puede quedar vieja (el cliente colgó o cambió de clase): el servidor la
+ * compara con la conexión al sacarla y, si ya no corresponde, la salta.
+ */
+struct EntradaFila {
+    int socket = -1;
+    ManejadorCliente cliente;  ///< Si ya no es válido, el cliente colgó mientras esperaba.
+    std::chrono::steady_clock::time_point limite; ///< Llegada + plazo de su clase.
+    uint32_t ingreso = 0;      ///< Cuántas veces había cambiado de clase (las entradas viejas se descartan).
+};
+
+/**
+ * @enum PoliticaFila
+ * @brief Qué planificador usa el servidor.
+ */
+enum class PoliticaFila {
+    FIFO,   ///< Orden de llegada; las tramas CLASE se ignoran.
+    SLA     ///< Primero quien vence antes, con un plazo por clase.
+};
+
+/**
+ * @brief Plazo (SLA) de cada clase, indexado por ClaseServicio.
+ */
+using PlazosServicio = std::array<std::chrono::seconds, NUM_CLASES>;
+
+/**
+ * @class PlanificadorFila
+ * @brief Punto de extensión: cualquier orden que se pueda expresar con agregar/frente/sacar.
+ * * agregar(), frente() y sacar() solo desde el hilo despachador (no es
+ * Thread-Safe). plazo() y distingueClases() no cambian después de crearlo:
+ * los reactores los consultan para calcular lugares.
+ */
+class PlanificadorFila {
+public:
+    virtual ~PlanificadorFila() = default;
+
+    virtual void agregar(const EntradaFila& entrada) = 0;
+    virtual bool vacio() const = 0;
+
+    /**
+     * @brief El siguiente a atender (requiere !vacio()).
+     */
+    virtual const EntradaFila& frente() const = 0;
+    virtual void sacar() = 0;
+
+    /**
+     * @brief Entradas guardadas, incluidas las viejas que aún no se saltan.
+     */
+    virtual size_t cantidad() const = 0;
+
+    /**
+     * @brief Plazo de una clase: la fecha límite de una entrada es llegada + plazo.
+     */
+    virtual std::chrono::steady_clock::duration plazo(ClaseServicio clase) const = 0;
+
+    /**
+     * @brief false si la clase no cambia el orden (no vale la pena reclasificar).
+     */
+    virtual bool distingueClases() const = 0;
+};
+
+/**
+ * @class PlanificadorFIFO
+ * @brief El comportamiento de siempre: un deque en orden de llegada.
+ */
+class PlanificadorFIFO final : public PlanificadorFila {
+private:
+    std::deque<EntradaFila> fila;
+
+public:
+    void agregar(const EntradaFila& entrada) override { fila.push_back(entrada); }
+    bool vacio() const override { return fila.empty(); }
+    const EntradaFila& frente() const override { return fila.front(); }
+    void sacar() override { fila.pop_front(); }
+    size_t cantidad() const override { return fila.size(); }
+    std::chrono::steady_clock::duration plazo(ClaseServicio) const override { return {}; }
+    bool distingueClases() const override { return false; }
+};
+
+/**
+ * @class PlanificadorSLA
+ * @brief Earliest Deadline First sobre un montículo binario (std::push_heap/pop_heap).
+ * * Empates por orden de llegada al planificador: entre iguales sigue siendo FIFO.
+ */
+class PlanificadorSLA final : public PlanificadorFila {
+private:
+    struct Nodo {
+        EntradaFila entrada;
+        uint64_t orden;     ///< Desempate: quién entró antes al planificador.
+    };
+    std::vector<Nodo> monticulo;  ///< Montículo de mínimos por (limite, orden).
+    uint64_t siguienteOrden;
+    PlazosServicio plazos;
+
+    static bool despues(const Nodo& a, const Nodo& b);
+
+public:
+    explicit PlanificadorSLA(const PlazosServicio& plazos);
+
+    void agregar(const EntradaFila& entrada) override;
+    bool vacio() const override { return monticulo.empty(); }
+    const EntradaFila& frente() const override { return monticulo.front().entrada; }
+    void sacar() override;
+    size_t cantidad() const override { return monticulo.size(); }
+    std::chrono::steady_clock::duration plazo(ClaseServicio clase) const override;
+    bool distingueClases() const override { return true; }
+};
+
+/**
+ * @brief Plazos por defecto: 5 minutos para NORMAL y 30 segundos para PRIORITARIA.
+ */
+PlazosServicio plazosPorDefecto();
+
+/**
+ * @brief Crea el planificador de 'politica' ('plazos' solo se usa con SLA).
+ */
+std::unique_ptr<PlanificadorFila> crearPlanificador(PoliticaFila politica, const PlazosServicio& plazos);
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @file posicionesCola.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Lugar de cada cliente en la fila de espera y estimación de su espera.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Cada cliente que entra a la fila recibe un "turno" (contador que solo
+ * crece). Su lugar es cuántos turnos menores o iguales al suyo siguen
+ * esperando. Con un contador por cliente, cada vez que alguien sale de la
+ * fila habría que restarle uno a todos los que van detrás: O(n) por salida.
+ *
+ * Aquí los turnos viven en un árbol de Fenwick (Binary Indexed Tree) de
+ * 0 y 1: entrar, salir y preguntar el lugar de alguien cuestan O(log n).
+ *
+ * Con prioridades hay un árbol por clase de servicio sobre los mismos
+ * turnos: el turno dice el orden de llegada y el árbol de su clase cuenta
+ * solo a los de esa clase. Cambiar de clase pasa el turno de un árbol a
+ * otro sin moverlo. Guardando la llegada de cada turno se puede contar
+ * (búsqueda binaria + prefijo) cuántos de una clase llegaron antes de cierto
+ * momento: con eso se arma el lugar bajo cualquier orden por fecha límite
+ * (ver planificadorFila.h).
+ */
+
+#ifndef POSICIONESCOLA_H
+#define POSICIONESCOLA_H
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <vector>
+
+/**
+ * @class PosicionesCola
+ * @brief Árboles de Fenwick (uno por clase) sobre una ventana de turnos [base, siguiente).
+ * * Cuando la ventana se llena se descartan los turnos del principio que ya
+ * salieron y se reconstruye con el doble de lo que sigue vivo (O(n), pero
+ * solo cada vez que entran tantos como caben: O(1) amortizado).
+ * * No es Thread-Safe: en el servidor se usa siempre con mtxCola tomado.
+ */
+class PosicionesCola {
+private:
+    std::vector<std::vector<uint32_t>> arboles; ///< Un Fenwick por clase, con índices desde 1 ([0] no se usa).
+    std::vector<uint8_t> clases;    ///< Clase + 1 del turno base + i; 0 si ya salió de la fila.
+    std::vector<std::chrono::steady_clock::time_point> llegadas; ///< Llegada del turno base + i (no decrece).
+    std::vector<size_t> vivos;      ///< Cuántos de cada clase siguen en la fila.
+    uint64_t base;                  ///< Turno que ocupa el índice 0.
+    uint64_t siguiente;             ///< Turno que recibirá el próximo en llegar.
+
+    void sumar(size_t clase, size_t indice, int delta);
+
+    /**
+     * @brief Cuántos de 'clase' hay en los índices [0..indice].
+     */
+    uint32_t prefijo(size_t clase, size_t indice) const;
+
+    /**
+     * @brief Descarta el prefijo que ya salió y rehace los árboles con lugar para el doble.
+     */
+    void reconstruir();
+
+public:
+    explicit PosicionesCola(size_t numClases = 1);
+
+    /**
+     * @brief Alguien de 'clase' entra al final de la fila. O(log n).
+     * * Si 'llegada' es anterior a la del último turno se toma la de este:
+     * las llegadas nunca decrecen (de eso depende anterioresA()).
+     * @return Su turno.
+     */
+    uint64_t agregar(std::chrono::steady_clock::time_point llegada, size_t clase = 0);
+
+    /**
+     * @brief Sale de la fila (lo atienden o colgó). O(log n). Repetirlo no hace nada.
+     */
+    void quitar(uint64_t turno);
+
+    /**
+     * @brief Pasa un turno vigente a otra clase sin cambiar su lugar en el orden de llegada. O(log n).
+     */
+    void cambiarClase(uint64_t turno, size_t clase);
+
+    /**
+     * @brief Lugar entre los de su clase (1 = el que llegó primero). O(log n).
+     * @return 0 si el turno ya no está en la fila.
+     */
+    uint32_t posicion(uint64_t turno) const;
+
+    /**
+     * @brief Llegada con la que quedó registrado un turno vigente de la ventana.
+     */
+    std::chrono::steady_clock::time_point llegada(uint64_t turno) const { return llegadas[turno - base]; }
+
+    /**
+     * @brief Cuántos de 'clase' siguen en la fila habiendo llegado antes de 'momento'. O(log n).
+     */
+    uint32_t anterioresA(std::chrono::steady_clock::time_point momento, size_t clase = 0) const;
+
+    /**
+     * @brief Cuántos de 'clase' esperan.
+     */
+    size_t total(size_t clase) const { return vivos[clase]; }
+
+    /**
+     * @brief Cuántos esperan, de todas las clases.
+     */
+    size_t total() const;
+};
+
+/**
+ * @class EstimadorEspera
+ * @brief Promedio móvil de la duración de las últimas sesiones.
+ * * Con un solo agente, quien va en el lugar p espera lo que le falta a la
+ * sesión en curso más p - 1 sesiones promedio.
+ * * No es Thread-Safe.
+ */
+class EstimadorEspera {
+private:
+    static const size_t VENTANA = 32;   ///< Sesiones que entran en el promedio.
+
+    double duraciones[VENTANA];         ///< Segundos de cada sesión (anillo).
+    size_t cantidad;                    ///< Cuántas hay (hasta VENTANA).
+    size_t siguiente;                   ///< Dónde va la próxima.
+    double suma;                        ///< Suma de las que hay.
+
+public:
+    EstimadorEspera();
+
+    /**
+     * @brief Anota lo que duró una sesión terminada.
+     */
+    void registrarSesion(std::chrono::steady_clock::duration duracion);
+
+    /**
+     * @brief Espera estimada, en segundos, para el lugar 'posicion'.
+     * @param enCurso Cuánto lleva la sesión actual (negativo = el agente está libre).
+     * @return -1 mientras no haya terminado ninguna sesión.
+     */
+    int32_t segundos(uint32_t posicion, std::chrono::steady_clock::duration enCurso) const;
+};
+
+#endif
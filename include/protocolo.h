@@ -0,0 +1,351 @@
+/**
+ * @file protocolo.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Formato de tramas binarias compartido por cliente y servidor.
+ * @version 1.0
+ * @date 06/01/2026
+ * * TCP es un flujo de bytes, no de mensajes: dos send() pueden llegar juntos
+ * en un solo recv() o un mensaje largo puede llegar partido. Por eso cada
+ * mensaje viaja dentro de una "trama" con una cabecera de tamaño fijo que
+ * indica su tipo, su longitud y su número de secuencia.
+ *
+ * Cabecera (12 bytes, enteros en orden de red / Big Endian):
+ * | tipo (1) | version (1) | reservado (2) | longitud (4) | secuencia (4) |
+ */
+
+#ifndef PROTOCOLO_H
+#define PROTOCOLO_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <sys/uio.h>   // iovec
+
+/**
+ * @enum TipoTrama
+ * @brief Qué transporta una trama. Sustituye a los comandos de texto "/WAIT" y "/START".
+ */
+enum class TipoTrama : uint8_t {
+    MENSAJE = 1, ///< Texto de chat escrito por una persona.
+    WAIT    = 2, ///< Servidor -> Cliente: estás en la cola de espera.
+    START   = 3, ///< Servidor -> Cliente: un agente te está atendiendo.
+    PING    = 4, ///< Sondeo de vida (keepalive de aplicación).
+    PONG    = 5, ///< Respuesta a un PING.
+    POSICION = 6, ///< Servidor -> Cliente: lugar en la fila y tiempo estimado (ver AvisoPosicion).
+    CLASE   = 7  ///< Cliente -> Servidor: clase pedida (1 byte, ClaseServicio). Solo cuenta la primera, en la fila, y el servidor decide si la concede.
+};
+
+/**
+ * @enum ClaseServicio
+ * @brief Con qué prioridad se atiende a un cliente (carga de una trama CLASE).
+ * * Cada clase tiene su propio plazo (SLA) en el planificador de la fila.
+ */
+enum class ClaseServicio : uint8_t {
+    NORMAL      = 0, ///< La de todos, si no dicen otra cosa.
+    PRIORITARIA = 1  ///< Clientes con contrato: plazo más corto.
+};
+
+const size_t NUM_CLASES = 2; ///< Clases de servicio que existen.
+
+const uint8_t VERSION_PROTOCOLO = 1;     ///< Versión del formato de cabecera.
+const size_t TAM_CABECERA = 12;          ///< Bytes que ocupa la cabecera.
+const uint32_t MAX_CARGA = 1024 * 1024;  ///< Tamaño máximo de un mensaje (1 MiB). Protege de basura en la red.
+
+/**
+ * @struct VistaTrama
+ * @brief Trama decodificada SIN copiar: 'datos' apunta dentro del BufferLectura.
+ * * Válida solo hasta la siguiente escritura en el buffer (reservar()).
+ */
+struct VistaTrama {
+    TipoTrama tipo;         ///< Tipo de la trama.
+    uint32_t secuencia;     ///< Número de secuencia del emisor.
+    std::string_view datos; ///< Carga útil (puede contener cualquier byte, incluso '\0').
+};
+
+/**
+ * @struct Trama
+ * @brief Versión con memoria propia de VistaTrama, para pasarla entre hilos.
+ */
+struct Trama {
+    TipoTrama tipo;     ///< Tipo de la trama.
+    uint32_t secuencia; ///< Número de secuencia del emisor.
+    std::string datos;  ///< Carga útil copiada.
+};
+
+/**
+ * @struct AvisoPosicion
+ * @brief Carga de una trama POSICION (12 bytes, enteros en orden de red).
+ * | posicion (4) | enCola (4) | segundos (4) |
+ */
+struct AvisoPosicion {
+    uint32_t posicion = 0;  ///< 1 = el siguiente en ser atendido.
+    uint32_t enCola = 0;    ///< Cuántos esperan en total.
+    int32_t segundos = -1;  ///< Espera estimada; -1 = aún no hay con qué estimarla.
+};
+
+const size_t TAM_AVISO_POSICION = 12;   ///< Bytes de la carga de una trama POSICION.
+
+/**
+ * @brief Codifica 'aviso' como carga de una trama POSICION.
+ */
+std::string codificarPosicion(const AvisoPosicion& aviso);
+
+/**
+ * @brief Lee la carga de una trama POSICION.
+ * @return false si no mide TAM_AVISO_POSICION.
+ */
+bool decodificarPosicion(std::string_view datos, AvisoPosicion& aviso);
+
+/**
+ * @class BufferLectura
+ * @brief Buffer de entrada creciente, uno por conexión.
+ * * Los bytes se escriben al final (recv) y se consumen desde el inicio
+ * (decodificador). Cuando se acaba el espacio primero se compacta (se mueven
+ * los bytes pendientes al principio) y solo si no alcanza se hace crecer.
+ */
+class BufferLectura {
+private:
+    std::vector<char> datos; ///< Memoria del buffer.
+    size_t inicio;           ///< Primer byte aún no consumido.
+    size_t fin;              ///< Primer byte libre.
+
+public:
+    /**
+     * @brief Constructor.
+     * @param capacidadInicial Bytes reservados al inicio.
+     */
+    explicit BufferLectura(size_t capacidadInicial = 4096);
+
+    /**
+     * @brief Garantiza al menos 'minimo' bytes libres al final.
+     * * Invalida las VistaTrama obtenidas antes.
+     * @return Puntero donde escribir (ej. el destino de recv()).
+     */
+    char* reservar(size_t minimo);
+
+    /**
+     * @brief Bytes libres al final del buffer.
+     */
+    size_t espacioLibre() const;
+
+    /**
+     * @brief Marca como escritos 'n' bytes después de reservar().
+     */
+    void confirmar(size_t n);
+
+    /**
+     * @brief Bytes recibidos que aún no se consumen.
+     */
+    std::string_view pendiente() const;
+
+    /**
+     * @brief Descarta 'n' bytes del inicio (ya procesados).
+     */
+    void consumir(size_t n);
+};
+
+/**
+ * @enum EstadoEnvio
+ * @brief Lo que se le informa a quien envía un mensaje.
+ */
+enum class EstadoEnvio {
+    ENVIADO,   ///< Entregado al Kernel (o en camino, con el buffer holgado).
+    SATURADO,  ///< Quedó en el buffer de salida: el receptor no está leyendo al ritmo. Conviene frenar.
+    CERRADO,   ///< No hay conexión a quién enviarlo.
+    DEMASIADO_GRANDE ///< Pasa de MAX_CARGA: el otro lado cortaría la conexión. No se envió.
+};
+
+/**
+ * @enum ResultadoVaciado
+ * @brief Resultado de intentar escribir el BufferSalida en el socket.
+ */
+enum class ResultadoVaciado {
+    VACIO,      ///< Se escribió todo.
+    PENDIENTE,  ///< El Kernel no acepta más por ahora (EAGAIN): esperar a EPOLLOUT/POLLOUT.
+    ERROR       ///< El socket ya no sirve (el otro lado colgó).
+};
+
+/**
+ * @brief Carga de una trama codificada UNA vez y compartida por muchas conexiones (difusión).
+ * * Cada conexión solo guarda su cabecera (su propia secuencia) y un puntero.
+ */
+using CargaCompartida = std::shared_ptr<const std::string>;
+
+/**
+ * @class BufferSalida
+ * @brief Anillo de bytes por conexión con las tramas que aún no salen al Kernel.
+ * * Las tramas se codifican directo en el anillo y vaciar() las manda TODAS
+ * con un solo sendmsg() (el writev de los sockets: hasta dos tramos del
+ * anillo). Si el receptor es lento, lo que no cabe en el Kernel se queda
+ * aquí en vez de bloquear a quien envía.
+ *
+ * Contrapresión con histéresis: pasa a "saturado" al superar 'marcaAlta' y
+ * solo vuelve a libre al bajar de 'marcaBaja'. No es Thread-Safe.
+ */
+class BufferSalida {
+private:
+    std::vector<char> datos; ///< Memoria del anillo (capacidad potencia de 2).
+    size_t inicio;           ///< Primer byte aún no enviado.
+    size_t ocupados;         ///< Bytes pendientes en el anillo.
+    size_t enVuelo;          ///< Bytes entregados con extraer() cuyo envío no ha terminado.
+    size_t marcaAlta;        ///< Umbral para marcarse saturado.
+    size_t marcaBaja;        ///< Umbral para dejar de estarlo.
+    bool saturado;
+
+    /**
+     * @brief Trama con carga compartida, intercalada en el flujo del anillo.
+     * * 'corte' es la posición del flujo del anillo (bytes escritos desde
+     * siempre) en la que va: sale después de todo lo escrito antes que ella.
+     */
+    struct Adjunto {
+        uint64_t corte;
+        char cabecera[TAM_CABECERA];
+        CargaCompartida carga;
+        TipoTrama tipo;
+        uint32_t secuencia;
+        uint32_t clave;        ///< != 0: se puede reemplazar por una más nueva con la misma clave.
+        size_t entregados;     ///< Bytes ya entregados de cabecera + carga.
+
+        size_t total() const { return TAM_CABECERA + carga->size(); }
+    };
+    std::deque<Adjunto> adjuntos;
+    uint64_t entregadosAnillo; ///< Bytes del anillo ya entregados desde siempre (el flujo va hasta + 'ocupados').
+    size_t bytesAdjuntos;      ///< Lo que falta entregar de los adjuntos.
+
+    /**
+     * @brief Junta hasta 'max' tramos de lo pendiente, en orden (anillo y adjuntos).
+     * @return Cuántos tramos se llenaron.
+     */
+    size_t armarTramos(iovec* tramos, size_t max) const;
+
+    /**
+     * @brief Da por entregados 'n' bytes del flujo (anillo y adjuntos, en orden).
+     */
+    void consumirFlujo(size_t n);
+
+    /**
+     * @brief Copia 'n' bytes al final del anillo (puede dar la vuelta).
+     */
+    void copiarAlFinal(const char* origen, size_t n);
+
+    /**
+     * @brief Garantiza lugar para 'n' bytes más; si no cabe, duplica y endereza el anillo.
+     */
+    void asegurarEspacio(size_t n);
+
+    void consumir(size_t n);
+
+public:
+    static const size_t MARCA_ALTA = 256 * 1024; ///< Valor por defecto de 'marcaAlta'.
+    static const size_t MARCA_BAJA = 64 * 1024;  ///< Valor por defecto de 'marcaBaja'.
+
+    explicit BufferSalida(size_t capacidadInicial = 4096,
+                          size_t marcaAlta = MARCA_ALTA, size_t marcaBaja = MARCA_BAJA);
+
+    /**
+     * @brief Codifica una trama al final del anillo (sin syscalls).
+     */
+    void agregarTrama(TipoTrama tipo, uint32_t secuencia, std::string_view datos);
+
+    /**
+     * @brief Encola una trama cuya carga comparten varias conexiones: solo se copia la cabecera.
+     * * Con 'clave' != 0, si ya hay una trama del mismo tipo con esa clave que
+     * aún no empezó a salir, se le cambia la carga por la nueva en vez de encolar otra (un
+     * receptor lento recibe solo el aviso más reciente de cada clave).
+     * @return true si se usó 'secuencia' (trama nueva); false si se fusionó.
+     */
+    bool agregarCompartida(TipoTrama tipo, uint32_t secuencia, const CargaCompartida& carga, uint32_t clave = 0);
+
+    /**
+     * @brief Manda al Kernel todo lo posible sin bloquear (MSG_DONTWAIT | MSG_NOSIGNAL).
+     */
+    ResultadoVaciado vaciar(int fd);
+
+    /**
+     * @brief Bytes que aún no salen (incluye los que están en vuelo y las cargas compartidas).
+     */
+    size_t pendiente() const { return ocupados + bytesAdjuntos + enVuelo; }
+
+    /**
+     * @brief true si no hay nada por entregar (puede haber bytes en vuelo).
+     */
+    bool vacio() const { return ocupados == 0 && adjuntos.empty(); }
+
+    /**
+     * @brief true desde que se superó la marca alta hasta que se baja de la marca baja.
+     */
+    bool estaSaturado() const { return saturado; }
+
+    /**
+     * @brief Mueve TODO lo pendiente a 'destino' (que se reemplaza) y vacía el anillo.
+     * * Para envíos asíncronos (io_uring): el Kernel lee la memoria después,
+     * y el anillo podría crecer (moverse) mientras tanto.
+     */
+    void extraer(std::string& destino);
+
+    /**
+     * @brief El Kernel terminó de enviar 'n' bytes de los extraídos.
+     */
+    void confirmarEnvio(size_t n);
+
+    /**
+     * @brief Primer tramo contiguo de lo pendiente (para transportes que no son un socket).
+     */
+    std::string_view tramoPendiente() const;
+
+    /**
+     * @brief Da por entregados los primeros 'n' bytes de tramoPendiente().
+     */
+    void confirmarEntrega(size_t n);
+
+    /**
+     * @brief Olvida lo pendiente (el socket se va a cerrar).
+     */
+    void descartar();
+};
+
+/**
+ * @enum ResultadoDecodificacion
+ * @brief Resultado de intentar extraer una trama del buffer.
+ */
+enum class ResultadoDecodificacion {
+    TRAMA,      ///< Se extrajo una trama completa.
+    INCOMPLETA, ///< Faltan bytes: hay que volver a leer del socket.
+    ERROR       ///< Cabecera inválida o secuencia rota: hay que cerrar la conexión.
+};
+
+/**
+ * @class DecodificadorTramas
+ * @brief Decodificador incremental: tolera tramas partidas y varias tramas por lectura.
+ * * Además verifica que las secuencias lleguen en orden (0, 1, 2...), lo que
+ * detecta cualquier mensaje perdido o duplicado.
+ */
+class DecodificadorTramas {
+private:
+    uint32_t secuenciaEsperada; ///< Secuencia que debe traer la siguiente trama.
+
+public:
+    DecodificadorTramas();
+
+    /**
+     * @brief Intenta extraer la siguiente trama del buffer.
+     * * Si devuelve TRAMA, los bytes ya quedaron consumidos y 'trama.datos'
+     * apunta dentro del buffer (cero copias).
+     */
+    ResultadoDecodificacion siguiente(BufferLectura& buffer, VistaTrama& trama);
+};
+
+/**
+ * @brief Agrega una trama codificada al final de 'salida'.
+ * * Se agrega (y no se devuelve un string nuevo) para poder juntar varias
+ * tramas y mandarlas con un solo send().
+ */
+void codificarTrama(std::string& salida, TipoTrama tipo, uint32_t secuencia, std::string_view datos);
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * @file reactor.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Bucle de eventos basado en epoll (patrón Reactor).
+ * @version 1.0
+ * @date 06/01/2026
+ * * En lugar de tener un hilo bloqueado por cada llamada (accept, recv...),
+ * un solo hilo le pregunta al Kernel "¿qué sockets están listos?" y ejecuta
+ * el callback asociado a cada uno. Así un proceso puede vigilar miles de conexiones.
+ */
+
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <chrono>
+
+/**
+ * @class Reactor
+ * @brief Envoltura de epoll con callbacks por descriptor.
+ * * Reglas de uso:
+ * 1. registrar(), modificar() y quitar() solo se llaman desde el hilo del reactor
+ *    (o antes de arrancar ejecutar()).
+ * 2. Otros hilos que necesiten tocar el reactor usan publicar(), que encola
+ *    una tarea y despierta al bucle mediante un eventfd.
+ */
+class Reactor {
+public:
+    /**
+     * @brief Firma de los callbacks de lectura/escritura.
+     * * Recibe la máscara de eventos de epoll (EPOLLIN, EPOLLRDHUP, EPOLLERR...).
+     */
+    using Callback = std::function<void(uint32_t eventos)>;
+
+private:
+    /**
+     * @brief Registro interno de un descriptor vigilado.
+     * * Su dirección se guarda en epoll_event.data.ptr para evitar búsquedas
+     * en un mapa por cada evento.
+     */
+    struct Manejador {
+        int fd;           ///< Descriptor vigilado.
+        Callback cb;      ///< Acción a ejecutar cuando el Kernel lo reporta listo.
+        bool activo;      ///< false si fue quitado a mitad de un lote de eventos.
+    };
+
+    int epollFd;        ///< Descriptor de la instancia epoll.
+    int despertadorFd;  ///< eventfd usado por publicar() para interrumpir epoll_wait().
+    std::atomic<bool> corriendo; ///< Controla la salida del bucle principal.
+
+    std::unordered_map<int, std::unique_ptr<Manejador>> manejadores; ///< Manejadores vivos indexados por fd.
+
+    /**
+     * @brief Manejadores quitados durante el lote actual.
+     * * No se destruyen de inmediato porque epoll pudo haber devuelto más
+     * eventos apuntando a ellos en el mismo lote. Se liberan al terminarlo.
+     */
+    std::vector<std::unique_ptr<Manejador>> retirados;
+
+    std::vector<int> temporizadores; ///< timerfd creados con programarPeriodico().
+
+    std::mutex mtxTareas;                       ///< Protege la lista de tareas publicadas.
+    std::vector<std::function<void()>> tareas;  ///< Tareas pendientes de otros hilos.
+
+    void ejecutarTareas();
+
+public:
+    /**
+     * @brief Constructor. No crea recursos del Kernel (ver crear()).
+     */
+    Reactor();
+
+    /**
+     * @brief Destructor. Libera el epoll, el eventfd y los manejadores.
+     */
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    /**
+     * @brief Crea la instancia epoll y el eventfd de despertar.
+     * @return true si ambos descriptores se crearon correctamente.
+     */
+    bool crear();
+
+    /**
+     * @brief Empieza a vigilar un descriptor.
+     * @param fd Descriptor (idealmente en modo no bloqueante).
+     * @param eventos Máscara de epoll (ej. EPOLLIN | EPOLLRDHUP).
+     * @param cb Acción a ejecutar cuando el descriptor esté listo.
+     */
+    bool registrar(int fd, uint32_t eventos, Callback cb);
+
+    /**
+     * @brief Cambia la máscara de eventos de un descriptor ya registrado.
+     */
+    bool modificar(int fd, uint32_t eventos);
+
+    /**
+     * @brief Deja de vigilar un descriptor. NO lo cierra.
+     */
+    void quitar(int fd);
+
+    /**
+     * @brief Ejecuta 'tarea' dentro del hilo del reactor cada 'intervalo'.
+     * * Usa un timerfd, que epoll vigila igual que a un socket.
+     */
+    bool programarPeriodico(std::chrono::milliseconds intervalo, std::function<void()> tarea);
+
+    /**
+     * @brief Encola una tarea para ejecutarse dentro del hilo del reactor.
+     * * Thread-Safe: es la única forma correcta de tocar el reactor desde otro hilo.
+     */
+    void publicar(std::function<void()> tarea);
+
+    /**
+     * @brief Bucle principal. Bloquea el hilo que lo llama hasta detener().
+     */
+    void ejecutar();
+
+    /**
+     * @brief Pide al bucle que termine en su siguiente vuelta. Thread-Safe.
+     * * Si llega antes de ejecutar(), el bucle termina en cuanto arranca.
+     */
+    void detener();
+};
+
+#endif
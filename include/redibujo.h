@@ -0,0 +1,63 @@
+/**
+ * @file redibujo.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Señal de "hay que volver a dibujar" compartida entre hilos.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Antes ambas ventanas se redibujaban 60 veces por segundo aunque nada
+ * cambiara. Ahora el bucle de la interfaz duerme sobre esta señal y solo
+ * dibuja cuando alguien la marca: un evento de entrada, un mensaje nuevo
+ * o un cambio en la cola/sesión.
+ */
+
+#ifndef REDIBUJO_H
+#define REDIBUJO_H
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+/**
+ * @brief Cada cuánto, como máximo, la interfaz dormida revisa sus eventos de ventana.
+ * * Los hilos de red la despiertan al instante; este límite solo acota la
+ * latencia del teclado y el ratón (~25 ms, imperceptible).
+ */
+static const std::chrono::milliseconds ESPERA_EVENTOS_UI(25);
+
+/**
+ * @class SenalRedibujo
+ * @brief Bandera sucia + despertador para el hilo de la interfaz.
+ * * Cualquier hilo puede marcarla; solo el hilo de la interfaz la espera y la consume.
+ */
+class SenalRedibujo {
+private:
+    std::mutex mtx;              ///< Protege 'pendiente'.
+    std::condition_variable cv;  ///< Despierta a esperar() cuando alguien marca.
+    bool pendiente;              ///< true si hay cambios que aún no se dibujan.
+
+public:
+    SenalRedibujo();
+
+    /**
+     * @brief Avisa que hay algo nuevo que mostrar. Thread-Safe, no bloquea al que llama.
+     */
+    void marcar();
+
+    /**
+     * @brief Duerme hasta que la señal se marque o pase 'limite'.
+     * * El límite existe porque SFML no permite despertar a la ventana desde otro
+     * hilo: cada 'limite' la interfaz revisa sus propios eventos de teclado/ratón.
+     * @return true si la señal está marcada (no la consume).
+     */
+    bool esperar(std::chrono::milliseconds limite);
+
+    /**
+     * @brief Consume la señal.
+     * @return true si estaba marcada.
+     */
+    bool tomar();
+};
+
+#endif
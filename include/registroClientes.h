@@ -0,0 +1,98 @@
+/**
+ * @file registroClientes.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Registro de clientes conectados con manejadores generacionales.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Sustituye al vector 'listaClientes', que solo crecía: cada búsqueda lo
+ * recorría entero y, como el Kernel recicla los números de socket, podía
+ * devolver el nombre de un cliente que ya se había ido.
+ *
+ * Los clientes viven en un "slab" (vector de ranuras reutilizables). Cada
+ * ranura lleva un contador de generación que sube al liberarla: un
+ * ManejadorCliente viejo apunta a la misma ranura pero con otra generación,
+ * así que se detecta en vez de leer datos de otro cliente. Dos tablas hash
+ * (por socket y por ID) dan búsquedas O(1). La memoria depende de cuántos
+ * están conectados AHORA, no de cuántos han pasado.
+ */
+
+#ifndef REGISTROCLIENTES_H
+#define REGISTROCLIENTES_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * @struct InfoCliente
+ * @brief Datos asociados a un cliente conectado.
+ * * Permite guardar información relevante del cliente para su administración.
+ */
+struct InfoCliente {
+    int socket;         ///< El ID numérico del socket (File Descriptor).
+    int id;             ///< ID único autoincremental asignado por nuestro sistema.
+    std::string nombre; ///< Nombre para mostrar en la interfaz (ej. "Cliente 5").
+};
+
+/**
+ * @struct ManejadorCliente
+ * @brief Referencia estable a un cliente: ranura + generación.
+ */
+struct ManejadorCliente {
+    uint32_t indice = UINT32_MAX; ///< Ranura dentro del slab.
+    uint32_t generacion = 0;      ///< Generación de la ranura cuando se creó el manejador.
+
+    bool valido() const { return indice != UINT32_MAX; }
+};
+
+/**
+ * @class RegistroClientes
+ * @brief Slab de InfoCliente con índices por socket e ID.
+ * * No es Thread-Safe: en el servidor se usa siempre con mtxCola tomado.
+ */
+class RegistroClientes {
+private:
+    /**
+     * @brief Una ranura del slab.
+     */
+    struct Ranura {
+        uint32_t generacion = 0;
+        bool ocupada = false;
+        InfoCliente info;
+    };
+
+    std::vector<Ranura> ranuras;
+    std::vector<uint32_t> libres;                          ///< Ranuras desocupadas (se reusan primero).
+    std::unordered_map<int, ManejadorCliente> porSocket;
+    std::unordered_map<int, ManejadorCliente> porId;
+
+public:
+    /**
+     * @brief Registra un cliente. Si su socket ya estaba registrado, reemplaza al anterior.
+     */
+    ManejadorCliente agregar(InfoCliente info);
+
+    /**
+     * @brief Libera la ranura del cliente. Los manejadores a ella quedan inválidos.
+     * @return false si el manejador ya no era válido.
+     */
+    bool quitar(ManejadorCliente manejador);
+
+    /**
+     * @return El cliente, o nullptr si el manejador es de una generación anterior.
+     */
+    const InfoCliente* buscar(ManejadorCliente manejador) const;
+    const InfoCliente* buscarPorSocket(int socket) const;
+    const InfoCliente* buscarPorId(int id) const;
+
+    /**
+     * @brief Clientes registrados ahora mismo.
+     */
+    size_t cantidad() const { return porSocket.size(); }
+};
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * @file renderChat.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Dibujo de las burbujas de chat compartido por ambas interfaces.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Antes, cada frame se creaba un sf::Text y un sf::RectangleShape por CADA
+ * mensaje y se medía su tamaño, aunque estuviera fuera de la pantalla. Aquí la
+ * geometría de cada burbuja se calcula UNA sola vez y solo se dibujan las que
+ * caen dentro de la ventana de scroll.
+ * * Además todo el chat se dibuja en 2 llamadas a draw(): un sf::VertexArray
+ * con todas las burbujas y otro con todos los glifos (letras) visibles.
+ */
+
+#ifndef RENDERCHAT_H
+#define RENDERCHAT_H
+
+#include "chat.h"
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @struct EstiloBurbujas
+ * @brief Parámetros visuales de las burbujas (cada aplicación tiene los suyos).
+ */
+struct EstiloBurbujas {
+    unsigned tamLetra = 16;        ///< Tamaño de la fuente de los mensajes.
+    float padding = 15.f;          ///< Espacio entre el texto y el borde de la burbuja.
+    float separacion = 12.f;       ///< Espacio vertical entre burbujas.
+    float margenSuperior = 90.f;   ///< Y de la primera burbuja (debajo del header).
+    float margenLateral = 20.f;    ///< Distancia de la burbuja al borde de la ventana.
+    float radio = 10.f;            ///< Radio de las esquinas redondeadas.
+    float anchoVentana = 450.f;    ///< Ancho del área de chat (para alinear a la derecha).
+    sf::Color fondoMio = sf::Color(0, 102, 255);     ///< Burbuja de mensajes propios.
+    sf::Color fondoOtro = sf::Color::White;          ///< Burbuja de mensajes recibidos.
+    sf::Color bordeOtro = sf::Color(200, 200, 200);  ///< Contorno de las burbujas recibidas.
+    sf::Color textoMio = sf::Color::White;           ///< Color del texto propio.
+    sf::Color textoOtro = sf::Color(30, 30, 30);     ///< Color del texto recibido.
+};
+
+/**
+ * @struct GeometriaBurbuja
+ * @brief Posición y tamaño ya calculados de una burbuja.
+ */
+struct GeometriaBurbuja {
+    sf::Vector2f posicion; ///< Esquina superior izquierda de la burbuja.
+    sf::Vector2f tamano;   ///< Ancho y alto de la burbuja.
+    sf::Vector2f posTexto; ///< Posición del texto dentro de la burbuja.
+};
+
+/**
+ * @class LayoutChat
+ * @brief Caché de la disposición de las burbujas + recorte por ventana visible.
+ * * La Y de cada burbuja es la suma acumulada (prefix sum) de las alturas
+ * anteriores, así que es creciente: encontrar la primera burbuja visible es
+ * una búsqueda binaria, y el costo de un frame depende de cuántas burbujas
+ * caben en pantalla, no del largo de la conversación.
+ */
+class LayoutChat {
+private:
+    const sf::Font& font;  ///< Fuente usada para medir y dibujar.
+    EstiloBurbujas estilo; ///< Parámetros visuales.
+
+    Chat::Vista vista;                       ///< Última instantánea sincronizada (de ahí sale el texto).
+    uint64_t versionSincronizada;            ///< Versión del Chat que representa la caché.
+    std::vector<GeometriaBurbuja> burbujas;  ///< Geometría de cada mensaje de 'vista'.
+    float alturaAcumulada;                   ///< Y donde iría la siguiente burbuja.
+
+    sf::VertexArray verticesBurbujas; ///< Triángulos de las burbujas visibles (sin textura).
+    sf::VertexArray verticesTexto;    ///< Quads de los glifos visibles (textura de la fuente).
+    size_t rangoDesde;                ///< Primera burbuja incluida en los vértices.
+    size_t rangoHasta;                ///< Una después de la última burbuja incluida.
+    bool verticesSucios;              ///< true si los vértices deben reconstruirse.
+
+    /**
+     * @brief Mide un mensaje y agrega su burbuja al final de la caché.
+     */
+    void agregarBurbuja(const VistaMensaje& m);
+
+    /**
+     * @brief Recorre los glifos de un texto con el mismo algoritmo que sf::Text.
+     * * Si 'destino' no es nulo agrega un quad (2 triángulos) por glifo.
+     * @return Rectángulo que ocupa el texto, relativo a 'origen'.
+     */
+    sf::FloatRect colocarTexto(std::string_view texto, sf::Vector2f origen, sf::Color color,
+                               sf::VertexArray* destino) const;
+
+    /**
+     * @brief Agrega un rectángulo con esquinas redondeadas como abanico de triángulos.
+     */
+    void agregarRectanguloRedondeado(sf::Vector2f posicion, sf::Vector2f tamano, float radio, sf::Color color);
+
+    /**
+     * @brief Reconstruye los dos VertexArray para las burbujas [desde, hasta).
+     */
+    void construirVertices(size_t desde, size_t hasta);
+
+public:
+    /**
+     * @brief Constructor.
+     * @param fuente Fuente ya cargada (debe vivir más que el layout).
+     * @param estiloBurbujas Colores y medidas propias de la aplicación.
+     * @param chat Historial a dibujar (se sincroniza de inmediato).
+     */
+    LayoutChat(const sf::Font& fuente, const EstiloBurbujas& estiloBurbujas, const Chat& chat);
+
+    /**
+     * @brief Trae los cambios del Chat y mide SOLO los mensajes nuevos.
+     * * Si el Chat no cambió no hace nada; si se limpió, reinicia la caché.
+     */
+    void sincronizar(const Chat& chat);
+
+    /**
+     * @brief Dibuja las burbujas que intersectan la franja visible [arriba, arriba + alto].
+     * * Los vértices solo se reconstruyen si cambió el rango visible o el contenido;
+     * mover el scroll dentro del mismo rango no cuesta nada (lo hace la vista).
+     */
+    void dibujar(sf::RenderTarget& destino, float arriba, float alto);
+
+    /**
+     * @brief Y final del contenido (para calcular el límite de scroll).
+     */
+    float alturaTotal() const;
+};
+
+#endif
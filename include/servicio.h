@@ -0,0 +1,234 @@
+/**
+ * @file servicio.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Núcleo del servidor de soporte, independiente de la interfaz.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Reúne lo que antes vivía dentro del main() del servidor gráfico: la red
+ * (ServerSocket), la sesión activa (Chat), el WAL, la persistencia de tickets,
+ * el hilo de sesiones ("El Portero" + lector). Así lo usan igual la ventana SFML
+ * (servidor) y la versión sin pantalla (servidor_headless).
+ *
+ * Cada sesión pasa por LIBRE -> ASIGNADA -> ACTIVA -> CERRANDO -> LIBRE.
+ * La fila y cada sesión son corrutinas (ver corrutina.h) que corren en el
+ * reactor del hilo de sesiones: "co_await siguienteCliente()" y
+ * "co_await leerMensaje()" suspenden sin bloquear el hilo, y el reactor las
+ * reanuda cuando suena el eventfd de llegadas o el de la bandeja del cliente
+ * activo. Nunca hay sondeo.
+ */
+
+#ifndef SERVICIO_H
+#define SERVICIO_H
+
+#include "socket.h"
+#include "chat.h"
+#include "tickets.h"
+#include "wal.h"
+#include "reactor.h"
+#include "corrutina.h"
+#include <string>
+#include <optional>
+#include <atomic>
+#include <thread>
+#include <functional>
+
+/**
+ * @struct ConfigServicio
+ * @brief Parámetros de arranque del servicio.
+ */
+struct ConfigServicio {
+    std::string ip = "127.0.0.1";   ///< "0.0.0.0" para aceptar conexiones de la LAN.
+    int puerto = 8080;
+    int espera = SOMAXCONN;         ///< Backlog de listen() por socket de escucha (el Kernel lo recorta).
+    std::string carpetaTickets = "tickets";
+    std::string carpetaWAL = "wal";
+    PoliticaDurabilidad durabilidad = PoliticaDurabilidad::POR_LOTE;
+    BackendRed backend = BackendRed::EPOLL; ///< Si io_uring no está disponible se cae a epoll.
+    int fragmentos = 1;             ///< Reactores con su propio socket de escucha (0 = uno por núcleo).
+    bool fijarNucleos = false;      ///< Fijar el hilo de cada reactor a un núcleo.
+    bool memoriaCompartida = true;  ///< Ofrecer memoria compartida a los clientes de la misma máquina.
+    PoliticaFila politicaFila = PoliticaFila::FIFO; ///< Orden de atención de la fila.
+    PlazosServicio plazos = plazosPorDefecto();     ///< SLA de cada clase (solo con PoliticaFila::SLA).
+    std::vector<std::string> autorizadosPrioridad;  ///< IPs que pueden pedir la clase PRIORITARIA (vacío = nadie).
+};
+
+/**
+ * @enum EstadoSesion
+ * @brief Fase del puesto del agente.
+ */
+enum class EstadoSesion {
+    LIBRE,      ///< Sin cliente: la fila espera (co_await) a que alguien llegue.
+    ASIGNADA,   ///< Se tomó al siguiente de la fila; se le envía START y se abre el historial.
+    ACTIVA,     ///< Conversando: la sesión espera (co_await) el siguiente mensaje.
+    CERRANDO    ///< El cliente colgó: se genera el ticket y se libera el puesto.
+};
+
+/**
+ * @class ServicioSoporte
+ * @brief Sesiones, cola y tickets del agente, sin nada de interfaz.
+ * * Hilos: el reactor (red), el de sesiones (un reactor con la corrutina de la
+ * fila y la del cliente activo) y los escritores del WAL y de los tickets. Las sesiones avanzan solas; quien lo
+ * use solo redibuja cuando le avisen de un cambio y llama a enviar() para responder.
+ */
+class ServicioSoporte {
+public:
+    /**
+     * @brief Firma del aviso de mensaje entrante (nombre del cliente, texto).
+     */
+    using AvisoMensaje = std::function<void(const std::string& nombre, const std::string& texto)>;
+
+private:
+    ConfigServicio config;
+    ServerSocket servidor;
+    Chat historial;
+
+    // El WAL va antes que la persistencia: se destruye después y los avisos
+    // de "ticket guardado" nunca llegan a un WAL ya cerrado.
+    WAL wal;
+    PersistenciaTickets persistencia;
+
+    std::function<void()> avisoCambios; ///< Algo cambió (cola, sesión o mensajes).
+    AvisoMensaje avisoMensaje;          ///< Llegó un mensaje del cliente activo.
+
+    std::atomic<bool> detenido;
+    std::atomic<EstadoSesion> estado;
+    std::thread hiloReactor;
+    std::thread hiloSesiones;
+
+    // Orden: el reactor de sesiones antes que sus avisadores, y estos antes
+    // que la corrutina; así el marco de la fila se destruye primero.
+    Reactor reactorSesiones;    ///< Solo lo corre hiloSesiones; ahí se reanudan las corrutinas.
+    Avisador avisoLlegadas;     ///< Suena cuando alguien entra a la fila (o al apagar).
+    Avisador avisoEntrada;      ///< Suena cuando el cliente activo escribe o cuelga.
+    Tarea<> fila;               ///< Corrutina raíz: atenderFila().
+
+    /**
+     * @brief Rehace los tickets que la corrida anterior no alcanzó a guardar y arranca el WAL.
+     */
+    bool recuperar();
+
+    /**
+     * @brief Hilo de sesiones: corre el reactor donde viven las corrutinas.
+     */
+    void bucleSesiones();
+
+    /**
+     * @brief Corrutina raíz: mientras no se apague, espera al siguiente cliente y lo atiende.
+     */
+    Tarea<> atenderFila();
+
+    /**
+     * @brief LIBRE -> ACTIVA: suspende hasta que haya a quién atender.
+     * @return false si se está apagando el servicio.
+     */
+    Tarea<bool> siguienteCliente();
+
+    /**
+     * @brief Una sesión completa, de arriba a abajo: mensajes hasta que cuelgue y luego el ticket.
+     */
+    Tarea<> sesion();
+
+    /**
+     * @brief Suspende hasta el siguiente mensaje del cliente activo.
+     * @return std::nullopt si colgó (o se está apagando el servicio); un mensaje vacío es un mensaje.
+     */
+    Tarea<std::optional<std::string>> leerMensaje();
+
+    /**
+     * @brief LIBRE -> ASIGNADA -> ACTIVA: toma al siguiente de la fila y abre su historial.
+     * @return false si la fila estaba vacía (o todos colgaron mientras esperaban).
+     */
+    bool asignarSiguiente();
+
+    /**
+     * @brief ACTIVA: pasa un mensaje del cliente al historial, al WAL y al aviso.
+     */
+    void atenderMensaje(const std::string& mensaje);
+
+    /**
+     * @brief CERRANDO -> LIBRE: encola el ticket y libera el puesto.
+     */
+    void cerrarSesion();
+
+    void cambiarEstado(EstadoSesion nuevo);
+
+    void notificar();
+
+public:
+    explicit ServicioSoporte(ConfigServicio configuracion = ConfigServicio());
+
+    /**
+     * @brief Detiene los hilos y vacía el WAL y la cola de tickets.
+     */
+    ~ServicioSoporte();
+
+    ServicioSoporte(const ServicioSoporte&) = delete;
+    ServicioSoporte& operator=(const ServicioSoporte&) = delete;
+
+    /**
+     * @brief Registra el aviso de cambios. Se ejecuta en hilos de red: debe ser breve.
+     * * Llamar antes de iniciar().
+     */
+    void alCambiar(std::function<void()> aviso);
+
+    /**
+     * @brief Registra el aviso de mensaje entrante (se ejecuta en el hilo de sesiones, dentro de la corrutina).
+     * * Puede llamar a enviar() para contestar. Llamar antes de iniciar().
+     */
+    void alRecibirMensaje(AvisoMensaje aviso);
+
+    /**
+     * @brief Recupera el estado anterior, abre el puerto y lanza los hilos.
+     */
+    bool iniciar();
+
+    /**
+     * @brief Cierra el puerto y termina los hilos.
+     * * Una sesión en curso NO genera ticket aquí: queda en el WAL y se
+     * guarda como interrumpida en el siguiente arranque.
+     */
+    void detener();
+
+    /**
+     * @brief Fase actual de la sesión (para mostrarla; puede cambiar enseguida).
+     */
+    EstadoSesion estadoSesion() const;
+
+    /**
+     * @brief Envía un mensaje del agente al cliente activo y lo anota en el historial.
+     * * Nunca bloquea en la red (se puede llamar desde el hilo de la interfaz).
+     * @return CERRADO si no hay a quién enviarlo; SATURADO si el cliente no está leyendo;
+     * DEMASIADO_GRANDE si pasa de MAX_CARGA (no se envía ni se anota).
+     */
+    EstadoEnvio enviar(const std::string& texto);
+
+    /**
+     * @brief Aviso a todos los que esperan (o a todos los conectados). No va al historial.
+     * * Ver ServerSocket::difundir(). Thread-Safe, no bloquea en la red.
+     * @return A cuántos clientes se encoló.
+     */
+    size_t difundir(std::string_view texto, uint32_t clave = 0,
+                    DestinoDifusion destino = DestinoDifusion::EN_COLA);
+
+    /**
+     * @brief true mientras el cliente activo tenga demasiada salida pendiente.
+     * * Cuando se libera llega un aviso de cambios.
+     */
+    bool salidaSaturada();
+
+    bool estoyAtendiendo();
+
+    /**
+     * @brief Nombre del cliente activo ("" si no hay).
+     */
+    std::string nombreClienteActual();
+
+    /**
+     * @brief Historial de la sesión activa (para dibujarlo).
+     */
+    Chat& chat();
+};
+
+#endif
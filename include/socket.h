@@ -15,20 +15,113 @@
 #define SERVERSOCKET_H
 
 #include <netinet/in.h>
+#include <sys/socket.h> // SOMAXCONN
 #include <string>
-#include <queue>
+#include <deque>
 #include <vector> // Necesario para std::vector
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include "reactor.h"
+#include "anilloUring.h"
+#include "canalMemoria.h"
+#include "protocolo.h"
+#include "wal.h"
+#include "registroClientes.h"
+#include "colaMPSC.h"
+#include "posicionesCola.h"
+#include "planificadorFila.h"
+
+struct Fragmento;
+
+/**
+ * @struct EstadoConexion
+ * @brief Estado que el reactor mantiene por cada socket abierto.
+ * * Datos de red que solo le importan al reactor; el nombre y el ID para
+ * mostrar están en el RegistroClientes. Ambos se borran al cerrar el socket.
+ */
+struct EstadoConexion {
+    int socket = -1;      ///< Descriptor de la conexión.
+    int id = 0;           ///< ID del cliente (mismo que en InfoCliente).
+    ManejadorCliente cliente; ///< Su ficha en el RegistroClientes.
+    Fragmento* fragmento = nullptr; ///< El que la aceptó: solo su hilo la lee, la vigila y la cierra.
+    bool enCola = true;   ///< true mientras espera turno, false cuando es el cliente activo.
+    ClaseServicio clase = ClaseServicio::NORMAL; ///< Lo que pidió con una trama CLASE (solo cuenta en cola).
+    std::chrono::steady_clock::time_point llegada; ///< Llegada a la fila: su fecha límite es llegada + plazo de su clase.
+    uint64_t turno = 0;   ///< Su turno en 'posiciones' (mientras está en cola): no cambia al cambiar de clase.
+    uint32_t ingreso = 0; ///< Sube al cambiar de clase: las entradas anteriores en el planificador quedan viejas.
+    bool pidioClase = false; ///< Ya mandó su trama CLASE: las siguientes se ignoran.
+    bool autorizadoPrioridad = false; ///< Su dirección está en 'autorizadosPrioridad' (se mira al aceptarlo).
+    AvisoPosicion avisado; ///< Lo último que se le dijo de su lugar (posicion 0 = nada aún).
+    std::chrono::steady_clock::time_point ultimaActividad; ///< Último byte recibido (o momento de conexión).
+
+    BufferLectura entrada;              ///< Bytes recibidos aún sin decodificar (solo lo toca el reactor).
+    DecodificadorTramas decodificador;  ///< Estado del decodificador de tramas (solo lo toca el reactor).
+    uint32_t secuenciaSalida = 0;       ///< Secuencia de la próxima trama a enviar. Protegida por mtxCola.
+    BufferSalida salida;                ///< Tramas que el Kernel aún no acepta. Protegido por mtxCola.
+    bool esperandoEscritura = false;    ///< true mientras se espera EPOLLOUT (epoll) o hay un send en vuelo (io_uring).
+
+    /**
+     * @brief Cliente en la misma máquina: las tramas van por memoria compartida
+     * y 'socket' (Unix) solo sirve para notar que colgó. nullptr = por el socket.
+     */
+    std::unique_ptr<CanalMemoria> memoria;
+
+    uint32_t generacion = 0;            ///< Distingue esta conexión de otra que reciba el mismo número de socket (io_uring).
+    bool vigilada = true;               ///< false cuando ya no se deben procesar sus lecturas (io_uring).
+};
+
+/**
+ * @enum BackendRed
+ * @brief Cómo hace el servidor sus accept/recv/send.
+ */
+enum class BackendRed {
+    EPOLL,      ///< Aviso de "listo" y una syscall por operación.
+    IO_URING    ///< Operaciones pedidas al Kernel por anillos compartidos (multishot + buffers provistos).
+};
 
 /**
- * @struct InfoCliente
- * @brief Datos asociados a un cliente conectado.
- * * Permite guardar información relevante del cliente para su administración.
+ * @enum EstadoEntrada
+ * @brief Resultado de intentarRecibir().
  */
-struct InfoCliente {
-    int socket;         ///< El ID numérico del socket (File Descriptor).
-    int id;             ///< ID único autoincremental asignado por nuestro sistema.
-    std::string nombre; ///< Nombre para mostrar en la interfaz (ej. "Cliente 5").
+enum class EstadoEntrada {
+    MENSAJE,    ///< Se entregó un mensaje del cliente activo.
+    VACIA,      ///< Aún no escribe nada (conviene esperar a descriptorEntrada()).
+    CERRADA     ///< Colgó, o ya no hay cliente activo.
+};
+
+/**
+ * @enum DestinoDifusion
+ * @brief A quién le llega un aviso de difundir().
+ */
+enum class DestinoDifusion {
+    EN_COLA,    ///< Solo a quienes esperan turno.
+    TODOS       ///< También al cliente que está siendo atendido.
+};
+
+/**
+ * @struct Fragmento
+ * @brief Un reactor con su propio socket de escucha y, con io_uring, su propio anillo.
+ * * Con varios fragmentos, cada socket de escucha se abre con SO_REUSEPORT
+ * en el mismo puerto y el Kernel reparte entre ellos las conexiones nuevas.
+ * Cada conexión se queda en el fragmento que la aceptó hasta cerrarse.
+ */
+struct Fragmento {
+    int indice = 0;
+    int socketEscucha = -1;
+    Reactor reactor;
+    std::unique_ptr<AnilloUring> anillo;  ///< nullptr = epoll.
+    std::vector<int> aceptadosUring;      ///< Accepts de io_uring del lote actual (se registran juntos).
+    int descriptorReserva = -1;           ///< /dev/null guardado para poder rechazar conexiones sin descriptores libres.
+    std::vector<int> escuchasPausadas;    ///< Sockets de escucha sin EPOLLIN hasta el siguiente keepalive (EMFILE).
+    std::thread hilo;                     ///< Sin hilo propio el fragmento 0: corre en quien llama a aceptarClientes().
+
+    uint64_t versionAvisada = 0;          ///< 'versionFila' con la que se avisaron posiciones por última vez.
+    std::chrono::steady_clock::time_point ultimoAvisoPosiciones; ///< Cuándo se recorrieron por última vez.
 };
 
 /**
@@ -37,34 +130,287 @@ struct InfoCliente {
  * * Responsabilidades:
  * 1. Escuchar conexiones entrantes en un puerto específico.
  * 2. Gestionar la concurrencia mediante hilos (Acceptor Thread vs Main Thread).
- * 3. Administrar la cola de espera (FIFO) para atención al cliente.
+ * 3. Administrar la cola de espera (FIFO o por plazos de servicio) para atención al cliente.
  * 4. Mantener el registro de todos los clientes conectados.
  */
 class ServerSocket {
 private:
-    int serverSocket;       ///< Descriptor del socket principal que escucha ("El Oído").
-    int clienteActual;      ///< Socket del cliente que está siendo atendido actualmente (-1 si libre).
+    std::atomic<int> clienteActual; ///< Socket del cliente que está siendo atendido actualmente (-1 si libre).
     sockaddr_in serverAddr; ///< Configuración de red (IP/Puerto).
     int contadorID;         ///< Contador para generar IDs únicos (1, 2, 3...).
 
-public:
     /**
-     * @brief Cola de espera "First-In, First-Out" (FIFO).
-     * * Almacena los sockets de los clientes que están esperando turno.
-     * Es pública para depuración, pero debería accederse con cuidado.
+     * @brief Estado por conexión viva, indexado por socket.
+     * * Los reactores insertan y borran entradas (siempre con mtxCola); cada
+     * entrada la borra solo el hilo de su fragmento. Los demás hilos solo
+     * consultan/modifican campos con mtxCola tomado.
+     */
+    std::unordered_map<int, EstadoConexion> conexiones;
+
+    /**
+     * @brief Entrega de clientes nuevos (y de los que cambian de clase): el
+     * reactor empuja sin tomar ningún mutex y despierta al despachador por un eventfd.
+     */
+    ColaMPSC<EntradaFila> llegadas;
+
+    /**
+     * @brief Fila de espera: decide a quién se atiende después (FIFO por defecto).
+     * * Es privada del hilo despachador (el que llama a tomarSiguienteCliente()):
+     * no lleva mutex. Quien cuelga mientras espera se descarta al llegar al frente.
+     */
+    std::unique_ptr<PlanificadorFila> planificador;
+
+    /**
+     * @brief IPv4 (orden de red) que pueden pedir una clase distinta de NORMAL.
+     * * La trama CLASE la manda el cliente: sin esta lista cualquiera se
+     * declararía prioritario y el SLA no serviría de nada. Vacía = nadie.
+     * Los clientes por memoria compartida cuentan como 127.0.0.1.
+     */
+    std::vector<uint32_t> autorizadosPrioridad;
+
+    /**
+     * @brief Lugar de cada cliente en cola, por clase y turno (O(log n)). Protegido por mtxCola.
+     * * Se actualiza al llegar, al ser atendido, al cambiar de clase y al
+     * colgar; así no hace falta recorrer la fila para saber cuántos van
+     * delante de alguien.
+     */
+    PosicionesCola posiciones;
+    EstimadorEspera estimador;          ///< Duración de las sesiones recientes. Protegido por mtxCola.
+    std::chrono::steady_clock::time_point inicioSesion; ///< Cuándo empezó la sesión actual. Protegido por mtxCola.
+
+    /**
+     * @brief Sube cada vez que cambia algo que mueve los lugares (entrada, salida, fin de sesión).
+     * * Se lee sin mutex: sin cambios, los fragmentos no recorren sus conexiones.
+     */
+    std::atomic<uint64_t> versionFila;
+
+    /**
+     * @brief Mensajes del cliente activo que el reactor ya leyó y que recibir() aún no entrega.
+     */
+    std::deque<std::string> bandejaEntrada;
+    bool activoDesconectado;           ///< true cuando el reactor detectó que el cliente activo colgó.
+    std::condition_variable cvEntrada; ///< Despierta a recibir() cuando hay mensaje o desconexión.
+    int avisoEntrada;                  ///< eventfd con el mismo aviso que cvEntrada, para quien no bloquea (corrutinas).
+
+    /**
+     * @brief Despierta a recibir() y hace legible 'avisoEntrada'. Requiere mtxCola tomado.
+     */
+    void avisarEntrada();
+
+    /**
+     * @brief Se invoca (desde el hilo del reactor) cuando cambia la cola de espera.
+     * * Permite que la interfaz duerma en lugar de revisar la cola en cada frame.
+     */
+    std::function<void()> avisoCambios;
+
+    /**
+     * @brief Bitácora donde se anotan las entradas/salidas de la cola y los inicios de sesión (opcional).
+     */
+    WAL* wal;
+
+    BackendRed backendPedido;           ///< Lo que se pidió con usarBackend().
+
+    /**
+     * @brief Memoria de los send de io_uring que el Kernel aún no termina, por etiqueta.
+     * * Vive aquí y no en la conexión: si la conexión se cierra con un send en
+     * vuelo, el Kernel todavía podría leerla. Protegido por mtxCola.
+     */
+    std::unordered_map<uint64_t, std::string> enviosEnVuelo;
+
+    /**
+     * @brief Bucles de eventos: cada uno acepta por su propio socket de escucha,
+     * vigila a los suyos (en cola o activo) y atiende sus temporizadores.
+     * * Aun con io_uring, el Reactor sigue siendo el bucle: vigila el descriptor
+     * del anillo, los temporizadores y las tareas publicadas.
+     * * Va después de 'enviosEnVuelo' para que los anillos se destruyan antes que esa memoria.
+     */
+    std::vector<std::unique_ptr<Fragmento>> fragmentos;
+    int fragmentosPedidos;              ///< Lo que se pidió con usarFragmentos().
+    bool fijarNucleos;                  ///< Fijar el hilo de cada fragmento a un núcleo.
+    uint32_t siguienteGeneracion;       ///< Para EstadoConexion::generacion.
+
+    bool memoriaCompartida;             ///< Lo que se pidió con usarMemoriaCompartida().
+    int socketLocal;                    ///< Socket Unix abstracto donde se negocia la memoria compartida (-1 = sin él).
+
+    /**
+     * @brief Abre el socket Unix de la memoria compartida y lo vigila desde el fragmento 0.
+     */
+    bool abrirLocal();
+
+    /**
+     * @brief Acepta a los clientes locales: a cada uno le ofrece su memoria y sus timbres.
+     */
+    void aceptarLocales(Fragmento& fragmento);
+
+    /**
+     * @brief Callback del timbre de una conexión por memoria: tramas nuevas o lugar para escribir.
+     */
+    void atenderTimbre(int fd);
+
+    /**
+     * @brief Manda lo pendiente de varias conexiones de 'fragmento' (hilo del fragmento).
+     * * Toma mtxCola por tandas para no frenar al resto mientras vacía miles.
+     */
+    void vaciarLote(Fragmento& fragmento, const std::vector<std::pair<int, uint32_t>>& destinos);
+
+    /**
+     * @brief Tarea periódica: avisa su lugar y su espera estimada a los clientes en cola del fragmento.
+     * * Solo a quien le cambió algo visible, y a lo más una vez por periodo
+     * (aunque salgan muchos de la fila entre uno y otro).
+     */
+    void avisarPosiciones(Fragmento& fragmento);
+
+    /**
+     * @brief Lugar y espera estimada de una conexión en cola. Requiere mtxCola tomado.
+     */
+    AvisoPosicion calcularPosicion(const EstadoConexion& conexion, std::chrono::steady_clock::time_point ahora) const;
+
+    /**
+     * @brief Trama CLASE de un cliente en cola: lo cambia de clase y lo vuelve a
+     * entregar al planificador con su nueva fecha límite. Requiere mtxCola tomado.
+     */
+    void reclasificar(int fd, EstadoConexion& conexion, std::string_view datos);
+
+    /**
+     * @brief true si la dirección del otro extremo de 'fd' está en 'autorizadosPrioridad'.
+     * * Hace una llamada al sistema (getpeername): se usa al aceptar, sin mtxCola.
+     */
+    bool puedePedirPrioridad(int fd) const;
+
+    /**
+     * @brief true si la entrada aún corresponde a alguien en cola (no colgó ni cambió de clase).
+     * * Requiere mtxCola tomado.
+     */
+    bool vigente(const EntradaFila& entrada) const;
+
+    /**
+     * @brief Encola una trama POSICION; si la anterior no ha salido, solo se reemplaza. Requiere mtxCola tomado.
+     */
+    void encolarPosicion(EstadoConexion& conexion, const AvisoPosicion& aviso);
+
+    /**
+     * @brief Manda lo encolado si no hay ya un envío en curso. Requiere mtxCola tomado.
+     */
+    void empujarSalida(EstadoConexion& conexion);
+
+    /**
+     * @brief Hilo de un fragmento: lo fija a su núcleo (si se pidió) y corre su reactor.
+     */
+    void correrFragmento(Fragmento& fragmento);
+
+    /**
+     * @brief Acepta las conexiones pendientes del fragmento, en lotes, hasta que accept4() diga EAGAIN.
+     */
+    void aceptarPendientes(Fragmento& fragmento);
+
+    /**
+     * @brief accept4() falló por EMFILE/ENFILE en 'escucha': rechaza al primero de la cola del Kernel.
+     * @return false si no se pudo: se pausó 'escucha' hasta el siguiente keepalive.
+     */
+    bool rechazarSinDescriptores(Fragmento& fragmento, int escucha);
+
+    /**
+     * @brief Da de alta sockets recién aceptados: registro, WAIT y lugar en la fila, WAL y fila de llegadas.
+     * * Todo el lote con una sola toma de mtxCola. Solo desde el hilo del fragmento.
+     * @param canales Si no es nullptr, la memoria compartida de cada socket (clientes locales).
+     */
+    void registrarClientes(Fragmento& fragmento, const int* sockets, size_t cantidad,
+                           std::unique_ptr<CanalMemoria>* canales = nullptr);
+
+    /**
+     * @brief Empieza a leer de un cliente (epoll: lo registra; io_uring: recv multishot).
+     * * Con 'timbre' (memoria compartida) siempre se usa el reactor: el timbre
+     * trae las tramas y el socket solo avisa si cuelga.
+     */
+    void vigilarCliente(Fragmento& fragmento, int fd, uint32_t generacion, int timbre = -1);
+
+    /**
+     * @brief Deja de leer de un cliente sin cerrarlo. Requiere mtxCola tomado.
+     */
+    void dejarDeVigilar(EstadoConexion& conexion);
+
+    /**
+     * @brief Callback del reactor para el descriptor del anillo: procesa la CQ.
+     */
+    void procesarCompletados(Fragmento& fragmento);
+
+    /**
+     * @brief Un resultado de io_uring: conexión nueva, datos recibidos o send terminado.
+     */
+    void alCompletarUring(Fragmento& fragmento, const Completado& completado);
+
+    /**
+     * @brief Mueve la salida pendiente a un send de io_uring. Requiere mtxCola tomado.
+     */
+    void iniciarEnvioUring(EstadoConexion& conexion);
+
+    /**
+     * @brief Callback del reactor para un socket de cliente (en cola o activo).
+     */
+    void atenderConexion(int fd, uint32_t eventos);
+
+    /**
+     * @brief Decodifica todas las tramas completas que haya en el buffer de una conexión.
+     * @return false si el flujo está corrupto y hay que cerrar la conexión.
+     */
+    bool procesarTramas(int fd, EstadoConexion& conexion);
+
+    /**
+     * @brief Codifica una trama en el buffer de salida y lo vacía si el socket acepta datos.
+     * * Requiere mtxCola tomado (protege la secuencia y el buffer). Nunca bloquea.
      */
-    std::queue<int> colaClientes;
+    void enviarTrama(EstadoConexion& conexion, TipoTrama tipo, std::string_view datos);
 
     /**
-     * @brief Base de datos en memoria de todos los conectados.
-     * * Se usa para buscar el nombre de un cliente a partir de su socket.
+     * @brief Manda lo que se pueda del buffer de salida; si el Kernel está lleno, pide EPOLLOUT.
+     * * Requiere mtxCola tomado.
      */
-    std::vector<InfoCliente> listaClientes;
+    void vaciarSalida(EstadoConexion& conexion);
 
     /**
-     * @brief Mutex para proteger la cola de condiciones de carrera.
-     * * Vital porque el Hilo Aceptador (background) mete gente a la cola
-     * y el Hilo Principal (Main) saca gente de la cola. Sin esto, el programa crashea.
+     * @brief EPOLLOUT en una conexión que tenía salida pendiente (hilo del reactor).
+     * @return false si el socket ya no sirve.
+     */
+    bool continuarEscritura(int fd);
+
+    /**
+     * @brief Tarea periódica: manda PING a conexiones inactivas del fragmento y retira las que no responden.
+     */
+    void revisarInactivos(Fragmento& fragmento);
+
+    /**
+     * @brief Retira una conexión que colgó: la saca del reactor y de la cola.
+     */
+    void desconectar(int fd);
+
+    /**
+     * @brief Quita el socket del reactor, borra su estado y lo cierra. Solo en el hilo del reactor.
+     */
+    void cerrarConexion(int fd);
+
+    /**
+     * @brief Nombre del cliente de un socket. Requiere mtxCola tomado.
+     */
+    std::string nombreDe(int fd) const;
+
+    /**
+     * @brief Pasa las llegadas al planificador y descarta del frente las entradas que ya no valen.
+     * * Solo desde el hilo despachador.
+     */
+    void actualizarFila();
+
+public:
+    /**
+     * @brief Fichas de los clientes conectados AHORA (se borran al cerrar su socket).
+     * * Se usa para buscar el nombre o el ID de un cliente a partir de su socket.
+     * Es pública para depuración; acceder siempre con mtxCola tomado.
+     */
+    RegistroClientes registroClientes;
+
+    /**
+     * @brief Mutex para proteger el estado de las conexiones de condiciones de carrera.
+     * * Cubre 'conexiones', 'registroClientes', la bandeja y el cliente actual.
+     * La fila de espera ya no: esa entrega va por 'llegadas', sin mutex.
      */
     std::mutex mtxCola;
 
@@ -78,6 +424,51 @@ public:
      */
     ~ServerSocket();
 
+    /**
+     * @brief Elige el backend de E/S. Llamar antes de crear().
+     * * Si se pide IO_URING y el Kernel no lo tiene, crear() avisa y sigue con epoll.
+     */
+    void usarBackend(BackendRed backend);
+
+    /**
+     * @brief Backend en uso (después de crear()).
+     */
+    BackendRed backend() const;
+
+    /**
+     * @brief Reparte la red en 'cantidad' reactores, cada uno con su hilo y su
+     * socket de escucha (SO_REUSEPORT). Llamar antes de crear().
+     * * 0 = uno por núcleo disponible. Con 'fijar', el hilo de cada fragmento
+     * se fija a un núcleo distinto (sched_setaffinity).
+     * * La fila de espera sigue siendo una sola, en orden de llegada.
+     */
+    void usarFragmentos(int cantidad, bool fijar);
+
+    /**
+     * @brief Cuántos fragmentos hay (después de crear()).
+     */
+    size_t cantidadFragmentos() const;
+
+    /**
+     * @brief Ofrece memoria compartida a los clientes de esta misma máquina. Llamar antes de escuchar().
+     * * Además del puerto TCP se escucha en un socket Unix abstracto; el
+     * cliente que llega por ahí recibe su memoria y ya no usa la pila de red.
+     */
+    void usarMemoriaCompartida(bool activar);
+
+    /**
+     * @brief Cambia el orden de la fila de espera. Llamar antes de aceptarClientes().
+     * * Sin llamarla se atiende en orden de llegada (PlanificadorFIFO).
+     */
+    void usarPlanificador(std::unique_ptr<PlanificadorFila> nuevo);
+
+    /**
+     * @brief Direcciones IPv4 ("10.0.0.7") a las que se les concede la clase que pidan.
+     * * A los demás solo se les acepta NORMAL. Llamar antes de aceptarClientes().
+     * @return false si alguna dirección no es válida (no se cambia nada).
+     */
+    bool autorizarPrioridad(const std::vector<std::string>& direcciones);
+
     /**
      * @brief Crea el socket del servidor usando la syscall socket().
      * @return true si se creó el descriptor correctamente.
@@ -96,41 +487,123 @@ public:
     bool bindear();
 
     /**
-     * @brief Pone al socket en modo pasivo para escuchar conexiones.
-     * @param espera Tamaño del backlog (cuántas conexiones pendientes admite el kernel).
+     * @brief Pone al socket en modo pasivo (y no bloqueante) para escuchar conexiones.
+     * @param espera Tamaño del backlog por socket de escucha (el Kernel lo recorta a net.core.somaxconn).
      */
-    bool escuchar(int espera = 5);
+    bool escuchar(int espera = SOMAXCONN);
 
     /**
-     * @brief Bucle infinito (para correr en un hilo aparte) que acepta conexiones.
-     * * Cuando llega alguien, lo registra, lo mete a la cola y le envía señal de espera.
+     * @brief Bucle de los reactores (para correr en un hilo aparte).
+     * * Atiende accepts, clientes en cola (desconexiones) y la sesión activa.
+     * Cuando llega alguien, lo registra, lo mete a la cola y le envía señal de espera.
+     * * Con varios fragmentos, lanza un hilo por cada uno además del que llama,
+     * y no regresa hasta que todos terminan (cerrarServidor()).
      * * Thread-Safe: Usa mtxCola al modificar la cola.
      */
     void aceptarClientes();      
 
+    /**
+     * @brief Registra la función a llamar cuando alguien entra o sale de la cola.
+     * * Debe llamarse antes de lanzar el hilo de aceptarClientes(). La función se
+     * ejecuta en el hilo del reactor, así que debe ser breve y no bloquear.
+     */
+    void alCambiarEstado(std::function<void()> aviso);
+
+    /**
+     * @brief Anota en el WAL los cambios de la cola y los inicios de sesión.
+     * * Debe llamarse antes de lanzar el hilo de aceptarClientes().
+     */
+    void usarWAL(WAL* bitacora);
+
+    /**
+     * @brief Hace que el siguiente cliente reciba el ID ultimoId + 1.
+     * * Tras una caída, evita repetir IDs que ya aparecen en tickets guardados.
+     */
+    void continuarIdsDesde(int ultimoId);
+
     /**
      * @brief Extrae al siguiente cliente de la cola y lo marca como activo.
-     * * Thread-Safe: Usa mtxCola.
+     * * Solo desde el hilo despachador (siempre el mismo).
      * @return true si había alguien en la cola y se pudo tomar, false si estaba vacía.
      */
     bool tomarSiguienteCliente(); 
 
     /**
-     * @brief Busca en el vector listaClientes el nombre asociado a un socket.
+     * @brief Duerme hasta que llegue un cliente nuevo, pase 'limite' (negativo = sin límite)
+     * o se cierre el servidor. Solo desde el hilo despachador.
+     */
+    bool esperarClientes(std::chrono::milliseconds limite);
+
+    /**
+     * @brief eventfd que se vuelve legible cuando llega un cliente (para integrarlo en otro epoll/poll).
+     */
+    int descriptorLlegadas() const;
+
+    /**
+     * @brief Apaga el aviso de descriptorLlegadas() sin esperar (para quien lo vigila con su propio epoll).
+     * * Solo desde el hilo despachador. Después hay que volver a revisar la fila.
+     */
+    void consumirAvisoLlegadas();
+
+    /**
+     * @brief Busca en el registro el nombre asociado a un socket. O(1), Thread-Safe.
      * @param socket El ID del socket a buscar.
-     * @return El nombre del cliente o "Desconocido".
+     * @return El nombre del cliente o "Desconocido" (ej. si ya se cerró).
      */
     std::string obtenerNombrePorSocket(int socket);
 
     /**
-     * @brief Recibe datos del cliente que está siendo atendido ACTUALMENTE.
+     * @brief Busca el ID único (no el socket, que el Kernel recicla) asociado a un socket.
+     * * O(1), Thread-Safe.
+     * @return El ID del cliente o 0 si no se encontró.
+     */
+    int obtenerIdPorSocket(int socket);
+
+    /**
+     * @brief Recibe un mensaje (trama MENSAJE) del cliente que está siendo atendido ACTUALMENTE.
+     * * Bloquea hasta que el reactor entregue un mensaje. Devuelve "" si el cliente
+     * colgó o si no hay nadie siendo atendido.
      */
     std::string recibir();
 
     /**
-     * @brief Envía datos al cliente que está siendo atendido ACTUALMENTE.
+     * @brief Versión que nunca bloquea de recibir(): para esperar se vigila descriptorEntrada().
+     * * Si el cliente colgó, primero entrega los mensajes que alcanzó a mandar.
+     */
+    EstadoEntrada intentarRecibir(std::string& mensaje);
+
+    /**
+     * @brief eventfd que se vuelve legible cuando el cliente activo escribe o cuelga.
+     */
+    int descriptorEntrada() const;
+
+    /**
+     * @brief Envía un mensaje (trama MENSAJE) al cliente que está siendo atendido ACTUALMENTE.
+     * * Nunca bloquea: si el cliente no lee, el mensaje espera en su buffer de salida.
+     * @return SATURADO si ese buffer pasó la marca alta (conviene dejar de enviar);
+     * DEMASIADO_GRANDE si msg pasa de MAX_CARGA (no se envía).
+     */
+    EstadoEnvio enviar(const std::string& msg);
+
+    /**
+     * @brief Manda el mismo aviso (trama MENSAJE) a muchos clientes: falla del servicio,
+     * tiempos de espera, horario de cierre...
+     * * La carga se codifica una sola vez y cada conexión solo guarda su
+     * cabecera y un puntero a ella. Aquí solo se encola (con un solo
+     * mtxCola); los envíos los hace el reactor de cada fragmento. Thread-Safe.
+     * @param clave Con clave != 0, un aviso anterior con la misma clave que
+     * aún no empezó a salir se reemplaza: a un cliente lento no se le acumulan
+     * avisos viejos.
+     * @return A cuántas conexiones se encoló (0 si texto pasa de MAX_CARGA).
+     */
+    size_t difundir(std::string_view texto, uint32_t clave = 0,
+                    DestinoDifusion destino = DestinoDifusion::EN_COLA);
+
+    /**
+     * @brief true si el buffer de salida del cliente activo sigue sobre la marca baja tras saturarse.
+     * * Al bajar de la marca baja se dispara el aviso de cambios.
      */
-    void enviar(const std::string& msg);
+    bool salidaSaturada();
 
     /**
      * @brief Cierra la conexión con un cliente específico.
@@ -149,7 +622,8 @@ public:
 
     /**
      * @brief Verifica si hay personas esperando en la fila.
-     * @return true si la cola no está vacía. Thread-Safe.
+     * * Solo desde el hilo despachador (la fila es suya).
+     * @return true si la cola no está vacía.
      */
     bool hayClientesEnCola();
 
@@ -160,7 +634,7 @@ public:
     bool estoyAtendiendo();
 
     /**
-     * @brief Resetea el estado del agente a "Libre".
+     * @brief Resetea el estado del agente a "Libre" y cierra el socket del cliente.
      * * Se llama cuando el cliente actual se desconecta o termina la sesión.
      */
     void liberarClienteActual();
@@ -0,0 +1,144 @@
+/**
+ * @file tickets.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Persistencia asíncrona de los tickets de soporte.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Antes el ticket se escribía dentro del hilo de red: mientras el disco
+ * respondía no se leía a nadie ni se podía pasar al siguiente cliente.
+ * Ahora el hilo de red solo ENCOLA el ticket (por movimiento, sin copiar
+ * mensajes) y un hilo escritor dedicado los guarda por lotes en el
+ * AlmacenTickets (ver almacenTickets.h).
+ */
+
+#ifndef TICKETS_H
+#define TICKETS_H
+
+#include "chat.h"
+#include "almacenTickets.h"
+#include <string>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <ctime>
+
+/**
+ * @struct Ticket
+ * @brief Todo lo necesario para escribir el reporte de una sesión terminada.
+ * * 'historial' es una instantánea del Chat: mantiene viva la bitácora de la
+ * sesión (aunque el Chat ya se haya limpiado) sin copiar ningún mensaje.
+ */
+struct Ticket {
+    int id;                ///< ID del cliente (el de InfoCliente, no el socket).
+    std::string nombre;    ///< Nombre legible (ej. "Cliente 5").
+    std::time_t fecha;     ///< Momento en que terminó la sesión.
+    Chat::Vista historial; ///< Mensajes de la sesión.
+};
+
+/**
+ * @enum PoliticaDurabilidad
+ * @brief Qué tanto se espera al disco antes de dar un ticket por guardado.
+ */
+enum class PoliticaDurabilidad {
+    NINGUNA,    ///< Solo write(): el Kernel decide cuándo bajarlo a disco (lo más rápido).
+    POR_LOTE,   ///< Un fdatasync() al final de cada lote: un apagón pierde como mucho el lote en curso.
+    POR_TICKET  ///< fdatasync() tras cada ticket: cada ticket es durable al escribirse.
+};
+
+/**
+ * @class PersistenciaTickets
+ * @brief Cola acotada + hilo escritor que guarda los tickets por lotes.
+ * * Si la cola se llena (el disco no da abasto), encolar() espera: es
+ * preferible frenar el cierre de sesiones a perder tickets.
+ */
+class PersistenciaTickets {
+private:
+    std::string directorio;          ///< Carpeta del almacén de tickets.
+    PoliticaDurabilidad politica;    ///< Cuándo se fuerza la escritura a disco.
+    size_t capacidad;                ///< Máximo de tickets esperando en la cola.
+    size_t maxLote;                  ///< Máximo de tickets que el escritor toma de una vez.
+
+    std::deque<Ticket> pendientes;   ///< Tickets por escribir. Protegido por mtx.
+    std::mutex mtx;                  ///< Protege 'pendientes' y 'detenido'.
+    std::condition_variable cvTrabajo; ///< Despierta al escritor cuando hay tickets.
+    std::condition_variable cvEspacio; ///< Despierta a encolar() cuando se libera lugar.
+    bool detenido;                   ///< true tras detener(): no se aceptan más tickets.
+    std::thread escritor;            ///< Hilo que escribe a disco.
+    AlmacenTickets almacen;          ///< Segmentos + índice. Solo lo toca el hilo escritor.
+    bool abierto;                    ///< true si el almacén ya se abrió.
+    std::function<void(int)> avisoGuardado; ///< Se llama con el clienteId de cada ticket ya durable.
+
+    /**
+     * @brief Bucle del hilo escritor: toma lotes y los guarda hasta que se detenga.
+     */
+    void bucleEscritor();
+
+    /**
+     * @brief Escribe un lote completo y aplica la política de durabilidad.
+     */
+    void escribirLote(std::vector<Ticket>& lote);
+
+
+public:
+    /**
+     * @brief Constructor. No arranca el hilo (ver iniciar()).
+     * @param carpeta Directorio del almacén de tickets.
+     * @param politicaDisco Política de durabilidad.
+     * @param capacidadCola Tickets que pueden esperar antes de que encolar() bloquee.
+     * @param tamLote Tickets por lote como máximo.
+     */
+    PersistenciaTickets(std::string carpeta = "tickets", PoliticaDurabilidad politicaDisco = PoliticaDurabilidad::POR_LOTE,
+                        size_t capacidadCola = 256, size_t tamLote = 32);
+
+    /**
+     * @brief Destructor. Llama a detener(): ningún ticket encolado se pierde.
+     */
+    ~PersistenciaTickets();
+
+    PersistenciaTickets(const PersistenciaTickets&) = delete;
+    PersistenciaTickets& operator=(const PersistenciaTickets&) = delete;
+
+    /**
+     * @brief Abre el almacén sin lanzar el hilo (para guardarAhora()).
+     */
+    bool abrir();
+
+    /**
+     * @brief Guarda un ticket de inmediato y lo baja a disco, en el hilo que llama.
+     * * Solo para el arranque (tickets recuperados del WAL), ANTES de iniciar().
+     * @return ID del ticket o 0 si falló.
+     */
+    uint64_t guardarAhora(int clienteId, const std::string& nombre, std::time_t fecha,
+                          const std::vector<Mensaje>& mensajes);
+
+    /**
+     * @brief Registra la función a llamar cuando un ticket ya es durable según la política.
+     * * Corre en el hilo escritor. Debe registrarse antes de iniciar().
+     */
+    void alGuardar(std::function<void(int clienteId)> aviso);
+
+    /**
+     * @brief Abre el almacén (si hace falta) y lanza el hilo escritor.
+     * @return false si no se pudo abrir el almacén.
+     */
+    bool iniciar();
+
+    /**
+     * @brief Entrega un ticket al escritor (se mueve, no se copia). Thread-Safe.
+     * * Solo bloquea si la cola está llena.
+     * @return false si la persistencia ya fue detenida.
+     */
+    bool encolar(Ticket&& ticket);
+
+    /**
+     * @brief Escribe todo lo pendiente y termina el hilo escritor.
+     */
+    void detener();
+};
+
+#endif
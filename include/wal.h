@@ -0,0 +1,190 @@
+/**
+ * @file wal.h
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Bitácora de escritura anticipada (WAL) del estado vivo del servidor.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Si el proceso muere, la conversación en curso (que solo vive en el Chat)
+ * y la cola de espera se pierden, y no se escribe ningún ticket. El WAL anota
+ * cada transición (entrar/salir de la cola, inicio/fin de sesión, cada mensaje,
+ * ticket guardado) en archivos wal_NNNNNN.log. Al reiniciar se reconstruyen
+ * las sesiones sin ticket y el orden de la cola.
+ *
+ * "Group commit": quien anota solo copia bytes a un buffer en memoria (no
+ * toca el disco). Un hilo aparte escribe y hace fdatasync de todo lo que se
+ * juntó mientras esperaba al disco, así N anotaciones cuestan un solo fsync.
+ *
+ * Registro: | largo (4) | crc32 (4) | tipo (1) | datos (largo bytes) |
+ * El crc cubre tipo + datos. Un registro incompleto al final marca el punto de caída.
+ */
+
+#ifndef WAL_H
+#define WAL_H
+
+#include "chat.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+/**
+ * @struct SesionRecuperada
+ * @brief Sesión que empezó pero cuyo ticket nunca llegó al almacén.
+ */
+struct SesionRecuperada {
+    int clienteId = 0;
+    std::string nombre;
+    int64_t fecha = 0;              ///< Fin de la sesión (o momento de la recuperación si no terminó).
+    bool terminada = false;         ///< false si el servidor cayó con la sesión en curso.
+    std::vector<Mensaje> mensajes;
+};
+
+/**
+ * @struct ClienteEnEspera
+ * @brief Cliente que estaba en la cola cuando el servidor cayó.
+ */
+struct ClienteEnEspera {
+    int clienteId;
+    std::string nombre;
+};
+
+/**
+ * @struct EstadoRecuperado
+ * @brief Lo que se reconstruye del WAL al arrancar.
+ */
+struct EstadoRecuperado {
+    int ultimoId = 0;                        ///< Mayor ID de cliente asignado (para no repetirlos).
+    std::vector<SesionRecuperada> pendientes; ///< Sesiones a las que les falta el ticket.
+    std::vector<ClienteEnEspera> cola;        ///< Orden de la cola de espera.
+};
+
+/**
+ * @class WAL
+ * @brief Bitácora con group commit y recuperación. Thread-Safe.
+ * * Uso: recuperar() -> (guardar las sesiones pendientes) -> iniciar() -> anotar...
+ */
+class WAL {
+public:
+    static const uint64_t TAM_MAX_SEGMENTO = 16ull * 1024 * 1024; ///< Tamaño a partir del cual se rota de archivo.
+
+private:
+    /**
+     * @brief Tipos de registro.
+     */
+    enum class Tipo : uint8_t {
+        CONTADOR = 1,       ///< Mayor ID asignado (al inicio de cada archivo).
+        EN_COLA = 2,        ///< Un cliente entró a la cola.
+        FUERA_DE_COLA = 3,  ///< Un cliente abandonó la cola sin ser atendido.
+        INICIO_SESION = 4,  ///< El agente empezó a atender a un cliente (sale de la cola).
+        MENSAJE = 5,        ///< Un mensaje de la sesión.
+        FIN_SESION = 6,     ///< La sesión terminó y su ticket se encoló.
+        TICKET_GUARDADO = 7 ///< El ticket ya está en el almacén: la sesión se puede olvidar.
+    };
+
+    std::string directorio;      ///< Carpeta de los archivos wal_NNNNNN.log.
+
+    std::mutex mtx;              ///< Protege todo lo que sigue (salvo 'fd', que es del hilo escritor).
+    std::condition_variable cvPendiente; ///< Despierta al hilo escritor.
+    std::condition_variable cvDurable;   ///< Despierta a esperarDurable().
+    std::string pendiente;       ///< Registros anotados que aún no se escriben.
+    uint64_t lsnAnotado;         ///< Bytes anotados desde iniciar() (número de secuencia lógico).
+    uint64_t lsnDurable;         ///< Bytes que ya pasaron por fdatasync.
+    bool detenido;               ///< true tras detener().
+    bool fallido;                ///< El disco falló: ya no se escribe nada y 'lsnDurable' no avanza más.
+
+    // Estado mínimo para rotar archivos sin perder nada.
+    int ultimoId;                              ///< Mayor ID visto.
+    std::vector<ClienteEnEspera> cola;         ///< Cola actual (se reescribe al rotar).
+    std::map<int, uint32_t> sesionesSinTicket; ///< clienteId -> primer archivo con registros suyos.
+    uint32_t segmentoActual;                   ///< Archivo al que va 'pendiente'.
+    uint32_t primerSegmento;                   ///< Archivo más viejo que sigue en disco.
+    uint64_t tamSegmento;                      ///< Bytes en el archivo actual (incluye 'pendiente').
+
+    std::vector<uint32_t> segmentosViejos;     ///< Archivos de la corrida anterior (se borran en iniciar()).
+    int fd;                      ///< Archivo actual. Solo lo usa el hilo escritor.
+    std::thread escritor;        ///< Hilo de group commit.
+
+    std::string rutaSegmento(uint32_t numero) const;
+
+    /**
+     * @brief Empieza un registro al final de 'destino' (largo y crc se completan al cerrar).
+     * * Los campos se agregan directamente a 'destino': no hay strings intermedios.
+     * @return Posición donde empieza el registro.
+     */
+    static size_t abrirRegistro(std::string& destino, Tipo tipo);
+
+    /**
+     * @brief Completa largo y crc del registro que empieza en 'inicio'.
+     */
+    static void cerrarRegistro(std::string& destino, size_t inicio);
+
+    /**
+     * @brief Cierra un registro escrito en 'pendiente' y despierta al escritor. Requiere mtx.
+     * @return LSN al final del registro.
+     */
+    uint64_t confirmar(size_t inicio);
+
+    /**
+     * @brief Registros que describen el estado actual (cabecera de un archivo nuevo). Requiere mtx.
+     */
+    std::string instantanea() const;
+
+    /**
+     * @brief Bucle del hilo escritor.
+     */
+    void bucleEscritor();
+
+    /**
+     * @brief Aplica un registro leído del disco al estado que se está reconstruyendo.
+     */
+    static bool aplicar(Tipo tipo, const char* datos, size_t tam, EstadoRecuperado& estado,
+                        std::map<int, SesionRecuperada>& sesiones);
+
+public:
+    WAL();
+    ~WAL();
+
+    WAL(const WAL&) = delete;
+    WAL& operator=(const WAL&) = delete;
+
+    /**
+     * @brief Lee los archivos de una corrida anterior y reconstruye su estado.
+     * * Un registro incompleto o corrupto al final se interpreta como el punto de la caída.
+     * @param carpeta Directorio del WAL (se crea si no existe).
+     * @param estado Donde se dejan las sesiones pendientes, la cola y el último ID.
+     */
+    bool recuperar(const std::string& carpeta, EstadoRecuperado& estado);
+
+    /**
+     * @brief Descarta los archivos viejos y empieza uno nuevo. Lanza el hilo escritor.
+     * * Llamar DESPUÉS de haber guardado las sesiones pendientes que dio recuperar().
+     * @param ultimoIdAsignado Mayor ID de cliente ya usado.
+     */
+    bool iniciar(int ultimoIdAsignado);
+
+    /**
+     * @brief Escribe lo pendiente y termina el hilo escritor.
+     */
+    void detener();
+
+    // --- Anotaciones (no bloquean por disco; devuelven el LSN del registro) ---
+    uint64_t clienteEnCola(int clienteId, const std::string& nombre);
+    uint64_t clienteFueraDeCola(int clienteId);
+    uint64_t sesionIniciada(int clienteId, const std::string& nombre, int64_t fecha);
+    uint64_t mensaje(int clienteId, const std::string& emisor, const std::string& texto, bool esMio);
+    uint64_t sesionTerminada(int clienteId, int64_t fecha);
+    uint64_t ticketGuardado(int clienteId);
+
+    /**
+     * @brief Espera a que todo hasta 'lsn' esté en disco (para quien necesite confirmarlo).
+     * @return false si no llegó ni llegará: el WAL falló o se detuvo antes.
+     */
+    bool esperarDurable(uint64_t lsn);
+};
+
+#endif
@@ -0,0 +1,470 @@
+/**
+ * @file almacenTickets.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación del almacén de tickets segmentado.
+ * @version 1.0
+ * @date 06/01/2026
+ */
+
+#include "../include/almacenTickets.h"
+#include <iostream>
+#include <algorithm>
+#include <numeric>   // std::iota
+#include <cstring>   // memcpy
+#include <cstdio>    // snprintf
+#include <ctime>
+#include <climits>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static_assert(sizeof(EntradaIndice) == 40, "EntradaIndice debe medir 40 bytes para poder mapearse");
+
+/// Firma al inicio de tickets.idx.
+static const char MAGIA_INDICE[8] = {'T', 'K', 'I', 'D', 'X', '0', '0', '1'};
+/// Bytes de la cabecera de tickets.idx (firma + tamaño de entrada + reservado).
+static const size_t TAM_CABECERA_INDICE = 16;
+/// Firma al inicio de cada registro ("TKT1").
+static const uint32_t MAGIA_REGISTRO = 0x31544B54;
+/// Bytes fijos de un registro antes del nombre (magia, longitud, ticketId, fecha, clienteId, numMensajes).
+static const size_t TAM_CABECERA_REGISTRO = 32;
+
+// ================= UTILIDADES =================
+
+struct TablaCrc32 {
+    uint32_t valores[256];
+    TablaCrc32() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            valores[i] = c;
+        }
+    }
+};
+
+/**
+ * @brief CRC-32 (IEEE). La tabla se calcula en el primer uso (inicialización
+ * de estático local: segura aunque la llamen varios hilos a la vez).
+ */
+uint32_t calcularCrc32(const char* datos, size_t tam) {
+    static const TablaCrc32 tabla;
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < tam; ++i) crc = tabla.valores[(crc ^ static_cast<uint8_t>(datos[i])) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template <typename T>
+static void anexar(std::string& buffer, T valor) {
+    buffer.append(reinterpret_cast<const char*>(&valor), sizeof(T));
+}
+
+/**
+ * @brief Lector secuencial con verificación de límites sobre un registro ya leído.
+ */
+struct Cursor {
+    const char* p;
+    const char* fin;
+
+    template <typename T>
+    bool leer(T& valor) {
+        if (static_cast<size_t>(fin - p) < sizeof(T)) return false;
+        std::memcpy(&valor, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    bool leer(std::string& texto, size_t largo) {
+        if (static_cast<size_t>(fin - p) < largo) return false;
+        texto.assign(p, largo);
+        p += largo;
+        return true;
+    }
+};
+
+static bool escribirTodo(int fd, const char* datos, size_t tam) {
+    while (tam > 0) {
+        ssize_t n = ::write(fd, datos, tam);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        datos += n;
+        tam -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// ================= APERTURA Y RECUPERACIÓN =================
+
+AlmacenTickets::AlmacenTickets()
+    : soloLectura(false), fdIndice(-1), mapa(nullptr), entradasMapa(0), bytesMapa(0),
+      fdSegmento(-1), segmentoActual(0), tamSegmento(0), porClienteValido(false) {}
+
+AlmacenTickets::~AlmacenTickets() {
+    cerrar();
+}
+
+std::string AlmacenTickets::rutaSegmento(uint32_t numero) const {
+    char nombre[32];
+    std::snprintf(nombre, sizeof(nombre), "/segmento_%06u.dat", numero);
+    return directorio + nombre;
+}
+
+/**
+ * @brief Abre el almacén.
+ * * 1. Crea la carpeta y la cabecera del índice si hacen falta.
+ * 2. Mapea el índice a memoria (las búsquedas no hacen read()).
+ * 3. Si se va a escribir, repara lo que un cierre abrupto haya dejado a medias.
+ */
+bool AlmacenTickets::abrir(const std::string& carpeta, bool lectura) {
+    cerrar();
+    directorio = carpeta;
+    soloLectura = lectura;
+
+    if (!soloLectura && mkdir(directorio.c_str(), 0755) < 0 && errno != EEXIST) {
+        std::cerr << "[TICKETS] No se pudo crear la carpeta " << directorio << ".\n";
+        return false;
+    }
+
+    std::string ruta = directorio + "/tickets.idx";
+    fdIndice = ::open(ruta.c_str(), soloLectura ? O_RDONLY | O_CLOEXEC : O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fdIndice < 0) {
+        std::cerr << "[TICKETS] No se pudo abrir " << ruta << ".\n";
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fdIndice, &st) < 0) return false;
+    size_t tam = static_cast<size_t>(st.st_size);
+
+    if (tam == 0 && !soloLectura) {
+        char cabecera[TAM_CABECERA_INDICE] = {};
+        std::memcpy(cabecera, MAGIA_INDICE, sizeof(MAGIA_INDICE));
+        uint32_t tamEntrada = sizeof(EntradaIndice);
+        std::memcpy(cabecera + 8, &tamEntrada, sizeof(tamEntrada));
+        if (!escribirTodo(fdIndice, cabecera, sizeof(cabecera))) return false;
+        tam = TAM_CABECERA_INDICE;
+    }
+
+    char cabecera[TAM_CABECERA_INDICE];
+    if (tam < TAM_CABECERA_INDICE || pread(fdIndice, cabecera, sizeof(cabecera), 0) != (ssize_t)sizeof(cabecera) ||
+        std::memcmp(cabecera, MAGIA_INDICE, sizeof(MAGIA_INDICE)) != 0) {
+        std::cerr << "[TICKETS] " << ruta << " no es un indice de tickets valido.\n";
+        cerrar();
+        return false;
+    }
+
+    // Una entrada a medio escribir (el proceso murió en medio del write) no cuenta.
+    entradasMapa = (tam - TAM_CABECERA_INDICE) / sizeof(EntradaIndice);
+    if (entradasMapa > 0) {
+        bytesMapa = TAM_CABECERA_INDICE + entradasMapa * sizeof(EntradaIndice);
+        void* base = mmap(nullptr, bytesMapa, PROT_READ, MAP_SHARED, fdIndice, 0);
+        if (base == MAP_FAILED) {
+            std::cerr << "[TICKETS] No se pudo mapear el indice.\n";
+            bytesMapa = 0;
+            cerrar();
+            return false;
+        }
+        mapa = reinterpret_cast<const EntradaIndice*>(static_cast<const char*>(base) + TAM_CABECERA_INDICE);
+    }
+
+    if (soloLectura) return true;
+    if (!recuperar()) {
+        cerrar();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Deja el almacén en un estado consistente antes de agregar.
+ * * Se descartan del final del índice las entradas cuyo registro no llegó
+ * completo al segmento, y del segmento los bytes que no llegaron a indexarse.
+ */
+bool AlmacenTickets::recuperar() {
+    while (entradasMapa > 0) {
+        const EntradaIndice& e = mapa[entradasMapa - 1];
+        struct stat st;
+        if (stat(rutaSegmento(e.segmento).c_str(), &st) == 0 &&
+            e.desplazamiento + e.longitud <= static_cast<uint64_t>(st.st_size)) break;
+        std::cerr << "[TICKETS] Se descarta el ticket #" << e.ticketId << " (registro incompleto).\n";
+        --entradasMapa;
+    }
+
+    off_t finIndice = static_cast<off_t>(TAM_CABECERA_INDICE + entradasMapa * sizeof(EntradaIndice));
+    if (ftruncate(fdIndice, finIndice) < 0 || lseek(fdIndice, finIndice, SEEK_SET) < 0) return false;
+
+    uint32_t segmento = 1;
+    uint64_t fin = 0;
+    if (entradasMapa > 0) {
+        const EntradaIndice& ultima = mapa[entradasMapa - 1];
+        segmento = ultima.segmento;
+        fin = ultima.desplazamiento + ultima.longitud;
+    }
+
+    if (!abrirSegmento(segmento, false)) return false;
+    if (ftruncate(fdSegmento, static_cast<off_t>(fin)) < 0 || lseek(fdSegmento, static_cast<off_t>(fin), SEEK_SET) < 0)
+        return false;
+    tamSegmento = fin;
+    return true;
+}
+
+bool AlmacenTickets::abrirSegmento(uint32_t numero, bool truncar) {
+    if (fdSegmento >= 0) ::close(fdSegmento);
+
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (truncar ? O_TRUNC : 0);
+    fdSegmento = ::open(rutaSegmento(numero).c_str(), flags, 0644);
+    if (fdSegmento < 0) {
+        std::cerr << "[TICKETS] No se pudo abrir el segmento " << numero << ".\n";
+        return false;
+    }
+    segmentoActual = numero;
+    tamSegmento = 0;
+    return true;
+}
+
+void AlmacenTickets::cerrar() {
+    if (mapa) munmap(const_cast<char*>(reinterpret_cast<const char*>(mapa) - TAM_CABECERA_INDICE), bytesMapa);
+    mapa = nullptr;
+    entradasMapa = 0;
+    bytesMapa = 0;
+    anexadas.clear();
+
+    if (fdIndice >= 0) ::close(fdIndice);
+    if (fdSegmento >= 0) ::close(fdSegmento);
+    fdIndice = fdSegmento = -1;
+
+    for (auto& par : fdsLectura) ::close(par.second);
+    fdsLectura.clear();
+    porCliente.clear();
+    porClienteValido = false;
+}
+
+// ================= ESCRITURA =================
+
+void AlmacenTickets::iniciarRegistro(uint64_t ticketId, uint32_t clienteId, int64_t fecha,
+                                     const std::string& nombre, uint32_t numMensajes) {
+    buffer.clear();
+    anexar<uint32_t>(buffer, MAGIA_REGISTRO);
+    anexar<uint32_t>(buffer, 0); // Longitud: se completa en anexarRegistro().
+    anexar<uint64_t>(buffer, ticketId);
+    anexar<int64_t>(buffer, fecha);
+    anexar<uint32_t>(buffer, clienteId);
+    anexar<uint32_t>(buffer, numMensajes);
+
+    uint16_t largo = static_cast<uint16_t>(std::min<size_t>(nombre.size(), UINT16_MAX));
+    anexar<uint16_t>(buffer, largo);
+    buffer.append(nombre.data(), largo);
+}
+
+void AlmacenTickets::serializarMensaje(bool esMio, std::string_view emisor, std::string_view texto) {
+    uint16_t largoEmisor = static_cast<uint16_t>(std::min<size_t>(emisor.size(), UINT16_MAX));
+    anexar<uint8_t>(buffer, esMio ? 1 : 0);
+    anexar<uint16_t>(buffer, largoEmisor);
+    buffer.append(emisor.data(), largoEmisor);
+    anexar<uint32_t>(buffer, static_cast<uint32_t>(texto.size()));
+    buffer += texto;
+}
+
+/**
+ * @brief Escritura puramente secuencial: un write() al segmento y otro al índice.
+ */
+uint64_t AlmacenTickets::anexarRegistro(uint64_t ticketId, uint32_t clienteId, int64_t fecha) {
+    if (soloLectura || fdSegmento < 0) {
+        std::cerr << "[TICKETS] El almacen no esta abierto para escritura.\n";
+        return 0;
+    }
+
+    uint32_t longitud = static_cast<uint32_t>(buffer.size() + sizeof(uint32_t));
+    std::memcpy(&buffer[4], &longitud, sizeof(longitud));
+    anexar<uint32_t>(buffer, calcularCrc32(buffer.data(), buffer.size()));
+
+    // Segmento lleno: se continúa en uno nuevo.
+    if (tamSegmento > 0 && tamSegmento + longitud > TAM_MAX_SEGMENTO) {
+        if (!abrirSegmento(segmentoActual + 1, true)) return 0;
+    }
+
+    // Si algo falla se deshace lo que haya quedado a medias: un registro sin
+    // índice o media entrada de índice desalinearían todo lo que venga después.
+    auto deshacer = [this](bool indice) {
+        if (ftruncate(fdSegmento, static_cast<off_t>(tamSegmento)) == 0)
+            lseek(fdSegmento, static_cast<off_t>(tamSegmento), SEEK_SET);
+        if (!indice) return;
+        off_t finIndice = static_cast<off_t>(TAM_CABECERA_INDICE + cantidad() * sizeof(EntradaIndice));
+        if (ftruncate(fdIndice, finIndice) == 0) lseek(fdIndice, finIndice, SEEK_SET);
+    };
+
+    if (!escribirTodo(fdSegmento, buffer.data(), buffer.size())) {
+        std::cerr << "[TICKETS] No se pudo escribir el ticket #" << ticketId << ".\n";
+        deshacer(false);
+        return 0;
+    }
+
+    // El índice debe tener fechas no decrecientes para buscar por rango con
+    // búsqueda binaria: si el reloj retrocede se usa la última fecha indexada.
+    int64_t fechaIndice = fecha;
+    if (cantidad() > 0) fechaIndice = std::max(fechaIndice, entrada(cantidad() - 1).fecha);
+
+    EntradaIndice e{ticketId, fechaIndice, clienteId, segmentoActual, tamSegmento, longitud, 0};
+    if (!escribirTodo(fdIndice, reinterpret_cast<const char*>(&e), sizeof(e))) {
+        std::cerr << "[TICKETS] No se pudo indexar el ticket #" << ticketId << ".\n";
+        deshacer(true);
+        return 0;
+    }
+    tamSegmento += longitud;
+
+    anexadas.push_back(e);
+    porClienteValido = false;
+    return ticketId;
+}
+
+bool AlmacenTickets::sincronizar() {
+    if (soloLectura) return true;
+    bool ok = fdSegmento >= 0 && fdatasync(fdSegmento) == 0;
+    return fdIndice >= 0 && fdatasync(fdIndice) == 0 && ok;
+}
+
+// ================= CONSULTAS =================
+
+size_t AlmacenTickets::cantidad() const {
+    return entradasMapa + anexadas.size();
+}
+
+const EntradaIndice& AlmacenTickets::entrada(size_t i) const {
+    return i < entradasMapa ? mapa[i] : anexadas[i - entradasMapa];
+}
+
+bool AlmacenTickets::buscarPorTicket(uint64_t ticketId, EntradaIndice& resultado) const {
+    size_t izq = 0, der = cantidad();
+    while (izq < der) {
+        size_t medio = izq + (der - izq) / 2;
+        if (entrada(medio).ticketId < ticketId) izq = medio + 1;
+        else der = medio;
+    }
+    if (izq == cantidad() || entrada(izq).ticketId != ticketId) return false;
+    resultado = entrada(izq);
+    return true;
+}
+
+/**
+ * @brief El índice está ordenado por ticket (y fecha), no por cliente.
+ * * La primera consulta arma una permutación ordenada por cliente (O(n log n));
+ * las siguientes son búsquedas binarias mientras no se agreguen tickets.
+ */
+std::vector<EntradaIndice> AlmacenTickets::buscarPorCliente(uint32_t clienteId) const {
+    if (!porClienteValido) {
+        porCliente.resize(cantidad());
+        std::iota(porCliente.begin(), porCliente.end(), 0u);
+        std::stable_sort(porCliente.begin(), porCliente.end(), [this](uint32_t a, uint32_t b) {
+            return entrada(a).clienteId < entrada(b).clienteId;
+        });
+        porClienteValido = true;
+    }
+
+    auto desde = std::partition_point(porCliente.begin(), porCliente.end(),
+                                      [&](uint32_t i) { return entrada(i).clienteId < clienteId; });
+    std::vector<EntradaIndice> resultado;
+    for (auto it = desde; it != porCliente.end() && entrada(*it).clienteId == clienteId; ++it)
+        resultado.push_back(entrada(*it));
+    return resultado;
+}
+
+std::vector<EntradaIndice> AlmacenTickets::buscarPorFecha(int64_t desde, int64_t hasta) const {
+    size_t izq = 0, der = cantidad();
+    while (izq < der) {
+        size_t medio = izq + (der - izq) / 2;
+        if (entrada(medio).fecha < desde) izq = medio + 1;
+        else der = medio;
+    }
+
+    std::vector<EntradaIndice> resultado;
+    for (size_t i = izq; i < cantidad() && entrada(i).fecha <= hasta; ++i) resultado.push_back(entrada(i));
+    return resultado;
+}
+
+int AlmacenTickets::fdLectura(uint32_t segmento) const {
+    auto it = fdsLectura.find(segmento);
+    if (it != fdsLectura.end()) return it->second;
+
+    int fd = ::open(rutaSegmento(segmento).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) fdsLectura[segmento] = fd;
+    return fd;
+}
+
+bool AlmacenTickets::leer(const EntradaIndice& e, RegistroTicket& registro) const {
+    int fd = fdLectura(e.segmento);
+    if (fd < 0 || e.longitud < TAM_CABECERA_REGISTRO + sizeof(uint32_t)) return false;
+
+    std::string datos(e.longitud, '\0');
+    if (pread(fd, &datos[0], e.longitud, static_cast<off_t>(e.desplazamiento)) != static_cast<ssize_t>(e.longitud))
+        return false;
+
+    uint32_t crcGuardado;
+    std::memcpy(&crcGuardado, datos.data() + e.longitud - sizeof(uint32_t), sizeof(uint32_t));
+    if (calcularCrc32(datos.data(), e.longitud - sizeof(uint32_t)) != crcGuardado) {
+        std::cerr << "[TICKETS] El ticket #" << e.ticketId << " esta corrupto (crc).\n";
+        return false;
+    }
+
+    Cursor c{datos.data(), datos.data() + e.longitud - sizeof(uint32_t)};
+    uint32_t magia, longitud, numMensajes;
+    uint16_t largoNombre;
+    if (!c.leer(magia) || magia != MAGIA_REGISTRO || !c.leer(longitud) || longitud != e.longitud ||
+        !c.leer(registro.ticketId) || !c.leer(registro.fecha) || !c.leer(registro.clienteId) ||
+        !c.leer(numMensajes) || !c.leer(largoNombre) || !c.leer(registro.nombre, largoNombre))
+        return false;
+
+    registro.mensajes.clear();
+    registro.mensajes.reserve(numMensajes);
+    for (uint32_t i = 0; i < numMensajes; ++i) {
+        Mensaje m;
+        uint8_t esMio;
+        uint16_t largoEmisor;
+        uint32_t largoTexto;
+        if (!c.leer(esMio) || !c.leer(largoEmisor) || !c.leer(m.emisor, largoEmisor) ||
+            !c.leer(largoTexto) || !c.leer(m.texto, largoTexto))
+            return false;
+        m.esMio = esMio != 0;
+        registro.mensajes.push_back(std::move(m));
+    }
+    return true;
+}
+
+// ================= EXPORTACIÓN =================
+
+/**
+ * @brief Mismo texto que escribía el antiguo generarTicket().
+ */
+void exportarTexto(const RegistroTicket& registro, std::string& salida) {
+    char fechaTexto[32];
+    std::time_t fecha = static_cast<std::time_t>(registro.fecha);
+    std::tm tm;
+    localtime_r(&fecha, &tm);
+    std::strftime(fechaTexto, sizeof(fechaTexto), "%Y-%m-%d %H:%M:%S", &tm);
+
+    salida += "========================================\n";
+    salida += "          TICKET DE SOPORTE             \n";
+    salida += "========================================\n";
+    salida += "ID Cliente:   "; salida += std::to_string(registro.clienteId); salida += '\n';
+    salida += "Nombre:       "; salida += registro.nombre; salida += '\n';
+    salida += "Fecha y Hora: "; salida += fechaTexto; salida += '\n';
+    salida += "Total Msjs:   "; salida += std::to_string(registro.mensajes.size()); salida += '\n';
+    salida += "========================================\n\n";
+    salida += "--- HISTORIAL DE CONVERSACION ---\n";
+
+    for (const Mensaje& msg : registro.mensajes) {
+        salida += '[';
+        salida += msg.esMio ? std::string("AGENTE") : registro.nombre;
+        salida += "]: ";
+        salida += msg.texto;
+        salida += '\n';
+    }
+
+    salida += "\n========================================\n";
+    salida += "          FIN DEL REPORTE               \n";
+}
@@ -0,0 +1,409 @@
+/**
+ * @file anilloUring.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación de la envoltura de io_uring con syscalls directas.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Se habla con el Kernel a través de tres regiones de memoria compartida
+ * (SQ, CQ y el arreglo de SQEs) que se mapean con mmap(). Las cabezas y colas
+ * de los anillos las escriben ambos lados, así que se leen con acquire y se
+ * publican con release.
+ */
+
+#include "../include/anilloUring.h"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+static int ioUringSetup(unsigned entradas, io_uring_params* p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entradas, p));
+}
+
+static int ioUringEnter(int fd, unsigned aSometer, unsigned minCompletados, unsigned banderas) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, aSometer, minCompletados, banderas, nullptr, 0));
+}
+
+static int ioUringRegister(int fd, unsigned codigo, void* arg, unsigned nArgs) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, codigo, arg, nArgs));
+}
+
+static unsigned leerAdquirir(const unsigned* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void escribirLiberar(unsigned* p, unsigned valor) {
+    __atomic_store_n(p, valor, __ATOMIC_RELEASE);
+}
+
+bool Completado::hayMas() const { return (banderas & IORING_CQE_F_MORE) != 0; }
+bool Completado::usaBuffer() const { return (banderas & IORING_CQE_F_BUFFER) != 0; }
+uint16_t Completado::buffer() const { return static_cast<uint16_t>(banderas >> IORING_CQE_BUFFER_SHIFT); }
+
+AnilloUring::AnilloUring()
+    : anilloFd(-1), memoriaSQ(nullptr), tamMemoriaSQ(0), sqes(nullptr), tamSqes(0),
+      sqCabeza(nullptr), sqCola(nullptr), sqFlags(nullptr), sqMascara(0), sqEntradas(0), sqColaLocal(0),
+      memoriaCQ(nullptr), tamMemoriaCQ(0), cqes(nullptr), cqCabeza(nullptr), cqCola(nullptr), cqMascara(0),
+      numBuffers(0), tamBuffer(0) {}
+
+AnilloUring::~AnilloUring() {
+    liberar();
+}
+
+void AnilloUring::liberar() {
+    if (sqes) munmap(sqes, tamSqes);
+    if (memoriaCQ && memoriaCQ != memoriaSQ) munmap(memoriaCQ, tamMemoriaCQ);
+    if (memoriaSQ) munmap(memoriaSQ, tamMemoriaSQ);
+    if (anilloFd != -1) close(anilloFd);
+    sqes = nullptr;
+    memoriaCQ = memoriaSQ = nullptr;
+    anilloFd = -1;
+}
+
+bool AnilloUring::operacionesSoportadas() {
+    const unsigned MAX_OPS = 256;
+    std::vector<char> memoria(sizeof(io_uring_probe) + MAX_OPS * sizeof(io_uring_probe_op), 0);
+    io_uring_probe* sonda = reinterpret_cast<io_uring_probe*>(memoria.data());
+    if (ioUringRegister(anilloFd, IORING_REGISTER_PROBE, sonda, MAX_OPS) < 0) return false;
+
+    for (unsigned op : {IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_ASYNC_CANCEL,
+                        IORING_OP_PROVIDE_BUFFERS}) {
+        if (op > sonda->last_op || !(sonda->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Crea el anillo, mapea sus regiones y provee los buffers de recepción.
+ * * Cualquier fallo deja el objeto vacío y devuelve false: el servidor sigue con epoll.
+ */
+bool AnilloUring::crear(unsigned entradas, unsigned numBuf, unsigned tamBuf) {
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    p.cq_entries = entradas * 4; // Los multishot producen muchos resultados por petición.
+
+    anilloFd = ioUringSetup(entradas, &p);
+    if (anilloFd < 0) {
+        anilloFd = -1;
+        return false;
+    }
+    // Necesitamos que el Kernel guarde los resultados si la CQ se llena (no los tire).
+    if (!(p.features & IORING_FEAT_NODROP) || !operacionesSoportadas()) {
+        liberar();
+        return false;
+    }
+
+    // 1. Regiones SQ y CQ (una sola si el Kernel lo permite).
+    tamMemoriaSQ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    tamMemoriaCQ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool unaSola = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (unaSola) tamMemoriaSQ = tamMemoriaCQ = std::max(tamMemoriaSQ, tamMemoriaCQ);
+
+    memoriaSQ = mmap(nullptr, tamMemoriaSQ, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     anilloFd, IORING_OFF_SQ_RING);
+    if (memoriaSQ == MAP_FAILED) { memoriaSQ = nullptr; liberar(); return false; }
+
+    if (unaSola) {
+        memoriaCQ = memoriaSQ;
+    } else {
+        memoriaCQ = mmap(nullptr, tamMemoriaCQ, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         anilloFd, IORING_OFF_CQ_RING);
+        if (memoriaCQ == MAP_FAILED) { memoriaCQ = nullptr; liberar(); return false; }
+    }
+
+    tamSqes = p.sq_entries * sizeof(io_uring_sqe);
+    void* memoriaSqes = mmap(nullptr, tamSqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             anilloFd, IORING_OFF_SQES);
+    if (memoriaSqes == MAP_FAILED) { liberar(); return false; }
+    sqes = static_cast<io_uring_sqe*>(memoriaSqes);
+
+    char* sq = static_cast<char*>(memoriaSQ);
+    sqCabeza = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    sqCola = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sqFlags = reinterpret_cast<unsigned*>(sq + p.sq_off.flags);
+    sqMascara = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sqEntradas = p.sq_entries;
+    sqColaLocal = *sqCola;
+
+    // El arreglo de índices es la identidad: la entrada i de la SQ usa el SQE i.
+    unsigned* arreglo = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    for (unsigned i = 0; i < sqEntradas; ++i) arreglo[i] = i;
+
+    char* cq = static_cast<char*>(memoriaCQ);
+    cqCabeza = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cqCola = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cqMascara = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+    // 2. Buffers provistos para los recv multishot: se entregan todos de una vez
+    //    y se espera la respuesta aquí mismo (nadie más usa el anillo todavía).
+    numBuffers = numBuf;
+    tamBuffer = tamBuf;
+    memoriaBuffers.assign(static_cast<size_t>(numBuffers) * tamBuffer, 0);
+
+    io_uring_sqe* sqe = tomarSqe();
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int>(numBuffers);
+    sqe->addr = reinterpret_cast<uint64_t>(memoriaBuffers.data());
+    sqe->len = tamBuffer;
+    sqe->buf_group = GRUPO_BUFFERS;
+    sqe->off = 0; // ID del primer buffer.
+    sqe->user_data = ETIQUETA_INTERNA;
+    if (!someterBloqueado(IORING_ENTER_GETEVENTS)) { liberar(); return false; }
+
+    unsigned cabeza = *cqCabeza;
+    if (cabeza == leerAdquirir(cqCola) || cqes[cabeza & cqMascara].res < 0) { liberar(); return false; }
+    escribirLiberar(cqCabeza, cabeza + 1);
+
+    // 3. La sonda no distingue un Kernel con ACCEPT/RECV pero sin multishot.
+    if (!multishotSoportado()) { liberar(); return false; }
+    return true;
+}
+
+bool AnilloUring::esperarCompletado(Completado& c) {
+    while (true) {
+        unsigned cabeza = *cqCabeza;
+        if (cabeza != leerAdquirir(cqCola)) {
+            const io_uring_cqe& cqe = cqes[cabeza & cqMascara];
+            c = Completado{cqe.user_data, cqe.res, cqe.flags};
+            escribirLiberar(cqCabeza, cabeza + 1);
+            if (c.etiqueta != ETIQUETA_INTERNA) return true;
+            continue;
+        }
+        if (ioUringEnter(anilloFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) return false;
+    }
+}
+
+/**
+ * @brief Los opcodes ACCEPT y RECV existen desde mucho antes que su modo
+ * multishot (Linux 5.19 para accept, 6.0 para recv). En un Kernel intermedio
+ * el accept multishot termina enseguida con -EINVAL: el servidor no
+ * aceptaría a nadie. Se prueba de verdad, con el resultado ya listo antes de
+ * pedirlo (un cliente conectado a un puerto efímero de loopback y un byte
+ * escrito en un socketpair): ambos deben llegar con IORING_CQE_F_MORE.
+ * Luego se cancelan.
+ */
+bool AnilloUring::multishotSoportado() {
+    const uint64_t PRUEBA_ACEPTAR = 1, PRUEBA_RECIBIR = 2, PRUEBA_CANCELAR = 3;
+
+    int escucha = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int cliente = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int par[2] = {-1, -1};
+    auto cerrar = [&] {
+        for (int fd : {escucha, cliente, par[0], par[1]})
+            if (fd != -1) close(fd);
+    };
+    sockaddr_in direccion{};
+    direccion.sin_family = AF_INET;
+    direccion.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t largo = sizeof(direccion);
+    if (escucha == -1 || cliente == -1 || socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, par) < 0 ||
+        bind(escucha, reinterpret_cast<sockaddr*>(&direccion), sizeof(direccion)) < 0 || listen(escucha, 1) < 0 ||
+        getsockname(escucha, reinterpret_cast<sockaddr*>(&direccion), &largo) < 0 ||
+        connect(cliente, reinterpret_cast<sockaddr*>(&direccion), sizeof(direccion)) < 0 ||
+        write(par[1], "x", 1) != 1) {
+        cerrar();
+        return false;
+    }
+
+    // Una prueba: el multishot ya tiene su primer resultado listo; sigue vivo si trae F_MORE.
+    auto probar = [&](uint64_t etiqueta) {
+        if (!someterBloqueado(0)) return false;
+        Completado c{};
+        if (!esperarCompletado(c) || c.etiqueta != etiqueta) return false;
+        if (c.etiqueta == PRUEBA_ACEPTAR && c.resultado >= 0) close(c.resultado);
+        if (c.usaBuffer()) prepararDevolucion(c.buffer());
+        if (c.resultado < 0 || !c.hayMas()) return false;
+
+        // Se cancela y se espera el fin de ambos (el cancel y el último resultado del multishot).
+        io_uring_sqe* sqe = tomarSqe();
+        if (!sqe) return false;
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = etiqueta;
+        sqe->user_data = PRUEBA_CANCELAR;
+        if (!someterBloqueado(0)) return false;
+        bool cancelado = false, terminado = false;
+        while (!cancelado || !terminado) {
+            if (!esperarCompletado(c)) return false;
+            if (c.etiqueta == PRUEBA_CANCELAR) cancelado = true;
+            else if (!c.hayMas()) terminado = true;
+            if (c.usaBuffer()) prepararDevolucion(c.buffer());
+        }
+        return true;
+    };
+
+    bool soportado = false;
+    io_uring_sqe* sqe = tomarSqe();
+    if (sqe) {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = escucha;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->user_data = PRUEBA_ACEPTAR;
+        soportado = probar(PRUEBA_ACEPTAR);
+    }
+    if (soportado && (sqe = tomarSqe())) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = par[0];
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = GRUPO_BUFFERS;
+        sqe->user_data = PRUEBA_RECIBIR;
+        soportado = probar(PRUEBA_RECIBIR);
+    } else {
+        soportado = false;
+    }
+    someterBloqueado(0); // Salen las devoluciones de buffers.
+    cerrar();
+    return soportado;
+}
+
+io_uring_sqe* AnilloUring::tomarSqe() {
+    if (sqColaLocal - leerAdquirir(sqCabeza) >= sqEntradas) {
+        // SQ llena: que el Kernel consuma lo pendiente antes de seguir.
+        if (!someterBloqueado(0)) return nullptr;
+        if (sqColaLocal - leerAdquirir(sqCabeza) >= sqEntradas) return nullptr;
+    }
+    io_uring_sqe* sqe = &sqes[sqColaLocal & sqMascara];
+    std::memset(sqe, 0, sizeof(*sqe));
+    ++sqColaLocal;
+    return sqe;
+}
+
+bool AnilloUring::someterBloqueado(unsigned banderas) {
+    escribirLiberar(sqCola, sqColaLocal);
+    unsigned pendientes = sqColaLocal - leerAdquirir(sqCabeza);
+    if (pendientes == 0 && banderas == 0) return true;
+
+    while (true) {
+        int r = ioUringEnter(anilloFd, pendientes, 0, banderas);
+        if (r >= 0) return true;
+        if (errno == EINTR) continue;
+        // EAGAIN/EBUSY: el Kernel no tiene lugar para más resultados; se reintenta en la próxima vuelta.
+        if (errno == EAGAIN || errno == EBUSY) return true;
+        std::cerr << "[RED] io_uring_enter fallo (errno " << errno << ").\n";
+        return false;
+    }
+}
+
+bool AnilloUring::aceptar(int fd, uint64_t etiqueta) {
+    std::lock_guard<std::mutex> lock(mtxSQ);
+    io_uring_sqe* sqe = tomarSqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = etiqueta;
+    return true;
+}
+
+bool AnilloUring::recibir(int fd, uint64_t etiqueta) {
+    std::lock_guard<std::mutex> lock(mtxSQ);
+    io_uring_sqe* sqe = tomarSqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT; // El Kernel elige el buffer del grupo.
+    sqe->buf_group = GRUPO_BUFFERS;
+    sqe->user_data = etiqueta;
+    return true;
+}
+
+bool AnilloUring::enviar(int fd, const void* datos, size_t n, uint64_t etiqueta) {
+    std::lock_guard<std::mutex> lock(mtxSQ);
+    io_uring_sqe* sqe = tomarSqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(datos);
+    sqe->len = static_cast<uint32_t>(n);
+    // MSG_WAITALL: el Kernel reintenta los envíos parciales por nosotros.
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    sqe->user_data = etiqueta;
+    return true;
+}
+
+bool AnilloUring::cancelar(uint64_t etiquetaObjetivo, uint64_t etiqueta) {
+    std::lock_guard<std::mutex> lock(mtxSQ);
+    io_uring_sqe* sqe = tomarSqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = etiquetaObjetivo;
+    sqe->user_data = etiqueta;
+    return true;
+}
+
+bool AnilloUring::someter() {
+    std::lock_guard<std::mutex> lock(mtxSQ);
+    reintentarDevoluciones();
+    return someterBloqueado(0);
+}
+
+size_t AnilloUring::procesar(const std::function<void(const Completado&)>& alCompletar) {
+    size_t total = 0;
+    while (true) {
+        unsigned cabeza = *cqCabeza;
+        unsigned cola = leerAdquirir(cqCola);
+        while (cabeza != cola) {
+            const io_uring_cqe& cqe = cqes[cabeza & cqMascara];
+            Completado c{cqe.user_data, cqe.res, cqe.flags};
+            ++cabeza;
+            // Se libera la entrada antes del callback: puede tardar y el Kernel ya puede reusarla.
+            escribirLiberar(cqCabeza, cabeza);
+            if (c.etiqueta == ETIQUETA_INTERNA) {
+                // Buffer devuelto: solo importa si el Kernel no lo aceptó.
+                if (c.resultado < 0) std::cerr << "[RED] io_uring rechazo un buffer devuelto (" << c.resultado << ").\n";
+                continue;
+            }
+            alCompletar(c);
+            ++total;
+        }
+
+        // Si la CQ se desbordó, el Kernel guardó resultados aparte: pedirlos y repetir.
+        if (!(leerAdquirir(sqFlags) & IORING_SQ_CQ_OVERFLOW)) break;
+        std::lock_guard<std::mutex> lock(mtxSQ);
+        someterBloqueado(IORING_ENTER_GETEVENTS);
+    }
+    return total;
+}
+
+const char* AnilloUring::datosBuffer(uint16_t id) const {
+    return memoriaBuffers.data() + static_cast<size_t>(id) * tamBuffer;
+}
+
+bool AnilloUring::prepararDevolucion(uint16_t id) {
+    io_uring_sqe* sqe = tomarSqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = 1;
+    sqe->addr = reinterpret_cast<uint64_t>(datosBuffer(id));
+    sqe->len = tamBuffer;
+    sqe->buf_group = GRUPO_BUFFERS;
+    sqe->off = id;
+    sqe->user_data = ETIQUETA_INTERNA;
+    return true;
+}
+
+void AnilloUring::reintentarDevoluciones() {
+    while (!porDevolver.empty() && prepararDevolucion(porDevolver.back())) porDevolver.pop_back();
+}
+
+void AnilloUring::devolverBuffer(uint16_t id) {
+    std::lock_guard<std::mutex> lock(mtxSQ);
+    reintentarDevoluciones();
+    if (!porDevolver.empty() || !prepararDevolucion(id)) porDevolver.push_back(id);
+}
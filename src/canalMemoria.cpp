@@ -0,0 +1,292 @@
+/**
+ * @file canalMemoria.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación del transporte por memoria compartida.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Aquí viven memfd_create, mmap, eventfd y el paso de descriptores por
+ * sockets Unix (sendmsg/recvmsg con SCM_RIGHTS).
+ */
+
+#include "../include/canalMemoria.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>        // F_ADD_SEALS
+#include <unistd.h>
+#include <sys/mman.h>      // memfd_create(), mmap()
+#include <sys/stat.h>      // fstat()
+#include <sys/eventfd.h>
+#include <sys/socket.h>    // sendmsg()/recvmsg() con SCM_RIGHTS
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "Los atomicos de la memoria compartida deben funcionar entre procesos (sin candados)");
+
+/// "CHSM": marca de que la memoria es de este programa.
+static const uint32_t MAGIA_CANAL = 0x4D534843;
+static const uint32_t VERSION_CANAL = 1;
+/// Byte que acompaña a los descriptores en la oferta.
+static const char BYTE_OFERTA = 'M';
+/// Descriptores de la oferta: memoria, timbre del servidor, timbre del cliente.
+static const int DESCRIPTORES_OFERTA = 3;
+
+/**
+ * @struct CabeceraCanal
+ * @brief Inicio de la memoria compartida; detrás van los datos de los dos anillos.
+ */
+struct CabeceraCanal {
+    uint32_t magia;
+    uint32_t version;
+    uint64_t capacidad;
+    AnilloCompartido haciaServidor;
+    AnilloCompartido haciaCliente;
+};
+
+/// Los datos empiezan en la siguiente línea de caché después de la cabecera.
+static const size_t INICIO_DATOS = (sizeof(CabeceraCanal) + 63) & ~static_cast<size_t>(63);
+
+static size_t tamanoCanal(uint64_t capacidad) {
+    return INICIO_DATOS + 2 * capacidad;
+}
+
+CanalMemoria::CanalMemoria()
+    : memoria(nullptr), tamMemoria(0), capacidad(0),
+      salida(nullptr), datosSalida(nullptr), entrada(nullptr), datosEntrada(nullptr),
+      timbrePropio(-1), timbreAjeno(-1), memoriaFd(-1) {}
+
+CanalMemoria::~CanalMemoria() {
+    if (memoria) munmap(memoria, tamMemoria);
+    if (timbrePropio != -1) close(timbrePropio);
+    if (timbreAjeno != -1) close(timbreAjeno);
+    if (memoriaFd != -1) close(memoriaFd);
+}
+
+std::string CanalMemoria::nombreLocal(int puerto) {
+    return std::string(1, '\0') + "chat-soporte-" + std::to_string(puerto);
+}
+
+bool CanalMemoria::mapear(int fd, size_t tam, bool esServidor) {
+    void* p = mmap(nullptr, tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return false;
+    memoria = p;
+    tamMemoria = tam;
+
+    CabeceraCanal* cabecera = static_cast<CabeceraCanal*>(memoria);
+    capacidad = cabecera->capacidad;
+    char* datos = static_cast<char*>(memoria) + INICIO_DATOS;
+    char* datosHaciaServidor = datos;
+    char* datosHaciaCliente = datos + capacidad;
+
+    salida = esServidor ? &cabecera->haciaCliente : &cabecera->haciaServidor;
+    datosSalida = esServidor ? datosHaciaCliente : datosHaciaServidor;
+    entrada = esServidor ? &cabecera->haciaServidor : &cabecera->haciaCliente;
+    datosEntrada = esServidor ? datosHaciaServidor : datosHaciaCliente;
+    return true;
+}
+
+std::unique_ptr<CanalMemoria> CanalMemoria::crear() {
+    std::unique_ptr<CanalMemoria> canal(new CanalMemoria());
+    size_t tam = tamanoCanal(CAPACIDAD);
+
+    canal->memoriaFd = memfd_create("chat-soporte", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (canal->memoriaFd == -1 || ftruncate(canal->memoriaFd, static_cast<off_t>(tam)) != 0) return nullptr;
+
+    // El cliente recibe este mismo descriptor: si pudiera achicar la memoria,
+    // el siguiente acceso del servidor al anillo sería un SIGBUS. Se sella el
+    // tamaño (y los sellos mismos) antes de ofrecerla; sin sellos no hay canal.
+    if (fcntl(canal->memoriaFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) return nullptr;
+
+    // memfd empieza en ceros; aun así los atómicos se construyen como tales.
+    void* p = mmap(nullptr, sizeof(CabeceraCanal), PROT_READ | PROT_WRITE, MAP_SHARED, canal->memoriaFd, 0);
+    if (p == MAP_FAILED) return nullptr;
+    CabeceraCanal* cabecera = new (p) CabeceraCanal();
+    cabecera->magia = MAGIA_CANAL;
+    cabecera->version = VERSION_CANAL;
+    cabecera->capacidad = CAPACIDAD;
+    for (AnilloCompartido* anillo : {&cabecera->haciaServidor, &cabecera->haciaCliente}) {
+        anillo->escrito.store(0);
+        anillo->leido.store(0);
+        // Nadie ha empezado a leer: el primer escrito de cada lado toca el timbre.
+        anillo->lectorDormido.store(1);
+        anillo->escritorEsperando.store(0);
+    }
+    munmap(p, sizeof(CabeceraCanal));
+
+    canal->timbrePropio = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    canal->timbreAjeno = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (canal->timbrePropio == -1 || canal->timbreAjeno == -1) return nullptr;
+
+    if (!canal->mapear(canal->memoriaFd, tam, true)) return nullptr;
+    return canal;
+}
+
+bool CanalMemoria::ofrecer(int socketLocal) {
+    if (memoriaFd == -1) return false;
+
+    char byte = BYTE_OFERTA;
+    iovec tramo{&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(DESCRIPTORES_OFERTA * sizeof(int))] = {};
+
+    msghdr mensaje{};
+    mensaje.msg_iov = &tramo;
+    mensaje.msg_iovlen = 1;
+    mensaje.msg_control = control;
+    mensaje.msg_controllen = sizeof(control);
+
+    cmsghdr* cm = CMSG_FIRSTHDR(&mensaje);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(DESCRIPTORES_OFERTA * sizeof(int));
+    int descriptores[DESCRIPTORES_OFERTA] = {memoriaFd, timbrePropio, timbreAjeno};
+    std::memcpy(CMSG_DATA(cm), descriptores, sizeof(descriptores));
+
+    ssize_t enviados;
+    do {
+        enviados = sendmsg(socketLocal, &mensaje, MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (enviados < 0 && errno == EINTR);
+    if (enviados != 1) return false;
+
+    close(memoriaFd);
+    memoriaFd = -1;
+    return true;
+}
+
+std::unique_ptr<CanalMemoria> CanalMemoria::aceptarOferta(int socketLocal) {
+    char byte = 0;
+    iovec tramo{&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(DESCRIPTORES_OFERTA * sizeof(int))] = {};
+
+    msghdr mensaje{};
+    mensaje.msg_iov = &tramo;
+    mensaje.msg_iovlen = 1;
+    mensaje.msg_control = control;
+    mensaje.msg_controllen = sizeof(control);
+
+    ssize_t leidos;
+    do {
+        leidos = recvmsg(socketLocal, &mensaje, MSG_CMSG_CLOEXEC);
+    } while (leidos < 0 && errno == EINTR);
+
+    // Se recogen los descriptores aunque la oferta no sirva, para no dejarlos abiertos.
+    int descriptores[DESCRIPTORES_OFERTA] = {-1, -1, -1};
+    cmsghdr* cm = leidos == 1 ? CMSG_FIRSTHDR(&mensaje) : nullptr;
+    bool completa = cm && cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS &&
+                    cm->cmsg_len == CMSG_LEN(DESCRIPTORES_OFERTA * sizeof(int)) &&
+                    !(mensaje.msg_flags & MSG_CTRUNC);
+    if (cm && cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS) {
+        size_t recibidos = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        std::memcpy(descriptores, CMSG_DATA(cm), std::min<size_t>(recibidos, DESCRIPTORES_OFERTA) * sizeof(int));
+    }
+
+    std::unique_ptr<CanalMemoria> canal(new CanalMemoria());
+    canal->timbreAjeno = descriptores[1];   // El del servidor: lo toca el cliente.
+    canal->timbrePropio = descriptores[2];
+    int memoriaFd = descriptores[0];
+    if (!completa || byte != BYTE_OFERTA) {
+        if (memoriaFd != -1) close(memoriaFd);
+        return nullptr;
+    }
+
+    // El servidor podría ser otro programa: se valida el tamaño antes de mapear.
+    struct stat info;
+    size_t tam = tamanoCanal(CAPACIDAD);
+    bool valido = fstat(memoriaFd, &info) == 0 && static_cast<size_t>(info.st_size) == tam &&
+                  canal->mapear(memoriaFd, tam, false);
+    close(memoriaFd);
+    if (!valido) return nullptr;
+
+    const CabeceraCanal* cabecera = static_cast<const CabeceraCanal*>(canal->memoria);
+    if (cabecera->magia != MAGIA_CANAL || cabecera->version != VERSION_CANAL || cabecera->capacidad != CAPACIDAD)
+        return nullptr;
+    return canal;
+}
+
+void CanalMemoria::tocarTimbreAjeno() {
+    uint64_t uno = 1;
+    ssize_t ignorado = write(timbreAjeno, &uno, sizeof(uno));
+    (void)ignorado;
+}
+
+void CanalMemoria::apagarTimbre() {
+    uint64_t avisos;
+    ssize_t ignorado = read(timbrePropio, &avisos, sizeof(avisos));
+    (void)ignorado;
+}
+
+/**
+ * @brief Productor: copia, publica 'escrito' y solo entonces mira si el lector duerme.
+ * * Ambos lados usan seq_cst en "publicar y luego mirar la bandera del otro":
+ * o el escritor ve la bandera de dormido, o el lector ve el dato nuevo antes
+ * de dormir. Nunca se quedan los dos esperando.
+ */
+size_t CanalMemoria::escribir(const char* datos, size_t n) {
+    uint64_t escrito = salida->escrito.load(std::memory_order_relaxed);
+    uint64_t ocupados = escrito - salida->leido.load(std::memory_order_acquire);
+    if (ocupados > capacidad) return 0; // Índices corruptos: no se escribe nada.
+
+    size_t cantidad = static_cast<size_t>(std::min<uint64_t>(n, capacidad - ocupados));
+    if (cantidad == 0) return 0;
+
+    size_t posicion = static_cast<size_t>(escrito & (capacidad - 1));
+    size_t primerTramo = std::min(cantidad, static_cast<size_t>(capacidad) - posicion);
+    std::memcpy(datosSalida + posicion, datos, primerTramo);
+    std::memcpy(datosSalida, datos + primerTramo, cantidad - primerTramo);
+    salida->escrito.store(escrito + cantidad, std::memory_order_seq_cst);
+
+    if (salida->lectorDormido.load(std::memory_order_seq_cst) != 0 && salida->lectorDormido.exchange(0) != 0)
+        tocarTimbreAjeno();
+    return cantidad;
+}
+
+ResultadoVaciado CanalMemoria::vaciar(BufferSalida& buffer) {
+    while (!buffer.vacio()) {
+        std::string_view tramo = buffer.tramoPendiente();
+        size_t cantidad = escribir(tramo.data(), tramo.size());
+        buffer.confirmarEntrega(cantidad);
+        if (cantidad == tramo.size()) continue;
+
+        if (esperarLugar()) return ResultadoVaciado::PENDIENTE;
+    }
+    return ResultadoVaciado::VACIO;
+}
+
+bool CanalMemoria::esperarLugar() {
+    // Se declara y se vuelve a mirar: el lector pudo liberar lugar justo ahora.
+    salida->escritorEsperando.store(1, std::memory_order_seq_cst);
+    uint64_t ocupados = salida->escrito.load(std::memory_order_relaxed) -
+                        salida->leido.load(std::memory_order_seq_cst);
+    return ocupados >= capacidad;
+}
+
+long CanalMemoria::leerEn(BufferLectura& buffer) {
+    long total = 0;
+    while (true) {
+        uint64_t leido = entrada->leido.load(std::memory_order_relaxed);
+        uint64_t disponibles = entrada->escrito.load(std::memory_order_acquire) - leido;
+        if (disponibles > capacidad) return -1;
+        if (disponibles == 0) break;
+
+        char* destino = buffer.reservar(static_cast<size_t>(disponibles));
+        size_t cantidad = static_cast<size_t>(std::min<uint64_t>(disponibles, buffer.espacioLibre()));
+        size_t posicion = static_cast<size_t>(leido & (capacidad - 1));
+        size_t primerTramo = std::min(cantidad, static_cast<size_t>(capacidad) - posicion);
+        std::memcpy(destino, datosEntrada + posicion, primerTramo);
+        std::memcpy(destino + primerTramo, datosEntrada, cantidad - primerTramo);
+        buffer.confirmar(cantidad);
+        entrada->leido.store(leido + cantidad, std::memory_order_seq_cst);
+        total += static_cast<long>(cantidad);
+
+        if (entrada->escritorEsperando.load(std::memory_order_seq_cst) != 0 &&
+            entrada->escritorEsperando.exchange(0) != 0)
+            tocarTimbreAjeno();
+    }
+    return total;
+}
+
+bool CanalMemoria::prepararEspera() {
+    entrada->lectorDormido.store(1, std::memory_order_seq_cst);
+    return entrada->escrito.load(std::memory_order_seq_cst) == entrada->leido.load(std::memory_order_relaxed);
+}
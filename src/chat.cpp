@@ -7,46 +7,268 @@
  * @version 1.0
  * @date 06/01/2026
  * * Este archivo contiene el código ejecutable de la clase Chat.
- * Aquí es donde se aplica la exclusión mutua (Mutex) para proteger la memoria.
+ * Los escritores se coordinan con un Mutex; los lectores solo usan
+ * operaciones atómicas (publicación con release/acquire).
  */
 
 #include "../include/chat.h"
+#include <iostream>
+#include <cstring>
+
+// ================= BITACORA =================
+
+Chat::Bitacora::Bitacora(uint64_t base)
+    : publicados(0), lectores(0), versionBase(base), avisoLlena(false), numEmisores(0), usadoBloque(TAM_BLOQUE) {
+    for (auto& s : segmentos) s.store(nullptr, std::memory_order_relaxed);
+}
+
+Chat::Bitacora::~Bitacora() {
+    for (auto& s : segmentos) delete s.load(std::memory_order_relaxed);
+    for (char* bloque : bloques) delete[] bloque;
+    for (char* bloque : bloquesGrandes) delete[] bloque;
+}
+
+// ================= VISTA =================
+
+Chat::Vista::Vista(Bitacora* b, size_t n) : bitacora(b), cantidad(n) {}
+
+/**
+ * @brief Copiar una vista solo suma un lector: los mensajes no se copian.
+ */
+Chat::Vista::Vista(const Vista& otra) : bitacora(otra.bitacora), cantidad(otra.cantidad) {
+    if (bitacora) bitacora->lectores.fetch_add(1);
+}
+
+Chat::Vista::Vista(Vista&& otra) noexcept : bitacora(otra.bitacora), cantidad(otra.cantidad) {
+    otra.bitacora = nullptr;
+    otra.cantidad = 0;
+}
+
+Chat::Vista& Chat::Vista::operator=(Vista otra) noexcept {
+    std::swap(bitacora, otra.bitacora);
+    std::swap(cantidad, otra.cantidad);
+    return *this;
+}
+
+/**
+ * @brief Soltar la vista. La bitácora la libera después un escritor (liberarRetiradas).
+ */
+Chat::Vista::~Vista() {
+    if (bitacora) bitacora->lectores.fetch_sub(1);
+}
+
+const Chat::RegistroMensaje* Chat::Vista::segmentoDe(size_t i) const {
+    return bitacora->segmentos[i / TAM_SEGMENTO].load(std::memory_order_acquire)->registros;
+}
+
+VistaMensaje Chat::Vista::operator[](size_t i) const {
+    return bitacora->leer(segmentoDe(i)[i % TAM_SEGMENTO]);
+}
+
+uint64_t Chat::Vista::obtenerVersion() const {
+    return bitacora ? bitacora->versionBase + cantidad : 0;
+}
+
+uint64_t Chat::Vista::obtenerVersionBase() const {
+    return bitacora ? bitacora->versionBase : 0;
+}
+
+// ================= CHAT =================
+
+Chat::Chat() : actual(new Bitacora(0)), entrando(0), version(0) {}
+
+Chat::~Chat() {
+    delete actual.load();
+    for (Bitacora* b : retiradas) delete b;
+    for (char* bloque : bloquesLibres) delete[] bloque;
+}
 
 /**
- * @brief Agrega un mensaje al vector de forma segura (Thread-Safe).
+ * @brief Asignador "bump": el texto va pegado al anterior en el bloque actual.
+ * * Un bloque nuevo sale primero de los reciclados de sesiones anteriores;
+ * solo si no hay se pide al sistema. Los textos muy grandes llevan su propio
+ * bloque para no desperdiciar el resto del actual.
+ */
+const char* Chat::copiarEnArena(Bitacora& b, std::string_view texto) {
+    if (texto.empty()) return "";
+
+    if (texto.size() > TAM_BLOQUE / 2) {
+        char* propio = new char[texto.size()];
+        std::memcpy(propio, texto.data(), texto.size());
+        b.bloquesGrandes.push_back(propio);
+        return propio;
+    }
+
+    if (TAM_BLOQUE - b.usadoBloque < texto.size()) {
+        if (bloquesLibres.empty()) {
+            b.bloques.push_back(new char[TAM_BLOQUE]);
+        } else {
+            b.bloques.push_back(bloquesLibres.back());
+            bloquesLibres.pop_back();
+        }
+        b.usadoBloque = 0;
+    }
+
+    char* destino = b.bloques.back() + b.usadoBloque;
+    std::memcpy(destino, texto.data(), texto.size());
+    b.usadoBloque += texto.size();
+    return destino;
+}
+
+/**
+ * @brief Búsqueda lineal: en una sesión hay un puñado de emisores
+ * ("Sistema", "Yo", el cliente), así que recorrerlos es más barato que un hash.
+ */
+bool Chat::internarEmisor(Bitacora& b, std::string_view emisor, uint16_t& indice) {
+    for (size_t i = 0; i < b.numEmisores; ++i) {
+        if (b.emisores[i] == emisor) {
+            indice = static_cast<uint16_t>(i);
+            return true;
+        }
+    }
+    if (b.numEmisores >= MAX_EMISORES) return false;
+
+    // Se escribe antes de publicar el mensaje que lo usa: los lectores lo ven completo.
+    b.emisores[b.numEmisores] = std::string_view(copiarEnArena(b, emisor), emisor.size());
+    indice = static_cast<uint16_t>(b.numEmisores++);
+    return true;
+}
+
+/**
+ * @brief Agrega un mensaje al final de la bitácora.
  * * Utiliza el patrón RAII para el bloqueo: El mutex se bloquea al crear 'lock'
  * y se desbloquea AUTOMÁTICAMENTE cuando la función termina (se cierra la llave).
+ * * El mutex solo excluye a OTROS ESCRITORES: los lectores siguen leyendo
+ * mientras tanto porque nunca ven un mensaje a medio escribir.
  * * @param emisor Quién envía el mensaje.
  * @param texto Contenido del mensaje.
  * @param esMio Booleano para determinar el color de la burbuja en la UI.
  */
-void Chat::agregarMensaje(std::string emisor, std::string texto, bool esMio){
-    // CRÍTICO: Bloqueamos el acceso antes de tocar el vector.
-    // Si otro hilo intenta entrar aquí, se quedará congelado esperando hasta que terminemos.
-    std::lock_guard<std::mutex> lock(mtx);
-    
-    // Operación de escritura en memoria compartida
-    historial.push_back({emisor, texto, esMio});
-    
-    // Al llegar a esta llave '}', el lock_guard se destruye y libera el mutex.
+void Chat::agregarMensaje(std::string_view emisor, std::string_view texto, bool esMio){
+    std::lock_guard<std::mutex> lock(mtxEscritura);
+
+    Bitacora* b = actual.load(std::memory_order_relaxed);
+    size_t n = b->publicados.load(std::memory_order_relaxed);
+    size_t indiceSegmento = n / TAM_SEGMENTO;
+
+    uint16_t indiceEmisor = 0;
+    if (indiceSegmento >= MAX_SEGMENTOS || !internarEmisor(*b, emisor, indiceEmisor)) {
+        if (!b->avisoLlena)
+            std::cerr << (indiceSegmento >= MAX_SEGMENTOS ? "[CHAT] Historial lleno" : "[CHAT] Demasiados emisores en la sesion")
+                      << ", se descartan mensajes nuevos.\n";
+        b->avisoLlena = true;
+        return;
+    }
+
+    // 1. Si el segmento no existe aún, lo reservamos (nadie lo ve todavía).
+    Segmento* s = b->segmentos[indiceSegmento].load(std::memory_order_relaxed);
+    if (s == nullptr) {
+        s = new Segmento();
+        b->segmentos[indiceSegmento].store(s, std::memory_order_release);
+    }
+
+    // 2. Escribimos el mensaje en un lugar que ningún lector puede ver aún.
+    s->registros[n % TAM_SEGMENTO] = {copiarEnArena(*b, texto), static_cast<uint32_t>(texto.size()), indiceEmisor, esMio};
+
+    // 3. Publicamos: a partir de aquí los lectores lo ven completo.
+    b->publicados.store(n + 1, std::memory_order_release);
+    version.store(b->versionBase + n + 1, std::memory_order_release);
+
+    liberarRetiradas();
+}
+
+/**
+ * @brief Toma una instantánea del historial sin bloquear.
+ * * Protocolo (todas las operaciones seq_cst):
+ * 1. Anunciarse en 'entrando'.
+ * 2. Leer el puntero a la bitácora vigente y registrarse como lector en ella.
+ * 3. Retirarse de 'entrando'.
+ * Un escritor solo libera una bitácora retirada si ve 'entrando' == 0 Y
+ * 'lectores' == 0, lo que garantiza que nadie quedó a medio registrarse.
+ */
+Chat::Vista Chat::obtenerVista() const {
+    entrando.fetch_add(1);
+    Bitacora* b = actual.load();
+    b->lectores.fetch_add(1);
+    entrando.fetch_sub(1);
+
+    return Vista(b, b->publicados.load(std::memory_order_acquire));
 }
 
 /**
- * @brief Devuelve una copia instantánea del chat actual.
- * * Es necesario bloquear también para LEER, porque si el vector se redimensiona
- * (realloc) mientras lo leemos, el programa crashearía.
+ * @brief Devuelve una copia del chat actual, construida desde una vista.
  * * @return std::vector<Mensaje> Copia completa del historial.
  */
-std::vector<Mensaje> Chat::obtenerHistorial(){
-    std::lock_guard<std::mutex> lock(mtx);
-    return historial; // Se devuelve una copia, no el original.
+std::vector<Mensaje> Chat::obtenerHistorial() const {
+    Vista vista = obtenerVista();
+    std::vector<Mensaje> copia;
+    copia.reserve(vista.size());
+    for (const VistaMensaje& m : vista) copia.push_back(m.copia());
+    return copia;
 }
 
 /**
- * @brief Vacia el vector de mensajes.
- * * Se utiliza al cambiar de cliente para limpiar la pantalla.
+ * @brief Vacia el historial sustituyendo la bitácora por una nueva.
+ * * La vieja no se borra aquí: pasa a 'retiradas' hasta que ninguna vista la use.
  */
 void Chat::limpiarHistorial() {
-    std::lock_guard<std::mutex> lock(mtx); 
-    historial.clear(); 
-}
\ No newline at end of file
+    std::lock_guard<std::mutex> lock(mtxEscritura);
+
+    uint64_t base = version.load(std::memory_order_relaxed) + 1;
+    Bitacora* vieja = actual.exchange(new Bitacora(base));
+    version.store(base, std::memory_order_release);
+
+    retiradas.push_back(vieja);
+    liberarRetiradas();
+}
+
+/**
+ * @brief Reclamación diferida de memoria (requiere mtxEscritura).
+ */
+void Chat::liberarRetiradas() {
+    if (retiradas.empty() || entrando.load() != 0) return;
+
+    for (size_t i = 0; i < retiradas.size();) {
+        if (retiradas[i]->lectores.load() == 0) {
+            // La arena se "reinicia": sus bloques los usará la siguiente sesión.
+            std::vector<char*>& bloques = retiradas[i]->bloques;
+            while (!bloques.empty() && bloquesLibres.size() < MAX_BLOQUES_LIBRES) {
+                bloquesLibres.push_back(bloques.back());
+                bloques.pop_back();
+            }
+            delete retiradas[i];
+            retiradas[i] = retiradas.back();
+            retiradas.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+uint64_t Chat::obtenerVersion() const {
+    return version.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Copia incremental del historial.
+ * * El trabajo es proporcional a los mensajes NUEVOS, no al tamaño de la conversación.
+ */
+bool Chat::obtenerCambios(uint64_t& versionLocal, std::vector<Mensaje>& copiaLocal) const {
+    // Camino rápido: nada cambió.
+    if (versionLocal == version.load(std::memory_order_acquire)) return false;
+
+    Vista vista = obtenerVista();
+
+    size_t desde;
+    if (versionLocal < vista.obtenerVersionBase()) {
+        // Hubo una limpieza que el consumidor no ha visto: empieza de cero.
+        copiaLocal.clear();
+        desde = 0;
+    } else {
+        desde = static_cast<size_t>(versionLocal - vista.obtenerVersionBase());
+    }
+
+    for (size_t i = desde; i < vista.size(); ++i) copiaLocal.push_back(vista[i].copia());
+    versionLocal = vista.obtenerVersion();
+    return true;
+}
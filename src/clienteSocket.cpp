@@ -15,15 +15,26 @@
 #include <unistd.h>      // Para close()
 #include <arpa/inet.h>   // Para inet_pton, htons
 #include <cstring>       // Para strlen
+#include <cerrno>        // Para errno
+#include <poll.h>        // Para poll
+#include <sys/eventfd.h> // Para eventfd
+#include <sys/un.h>      // Para sockaddr_un (negociación de la memoria compartida)
+#include <cstddef>       // Para offsetof
 
 using namespace std;
 
+/// Espacio libre mínimo que se pide al buffer antes de cada recv().
+static const size_t TAM_LECTURA = 4096;
+
 /**
  * @brief Constructor.
  * * Inicializa el descriptor del socket en -1 para indicar que está "vacío" o "no asignado".
  * Esto evita que intentemos cerrar o usar un socket basura por accidente.
  */
-ClienteSocket::ClienteSocket() : clienteSocket(-1){}
+ClienteSocket::ClienteSocket()
+    : clienteSocket(-1), secuenciaSalida(0), esperandoEscritura(false),
+      despertador(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), usandoSocket(false), porCerrar(-1),
+      memoriaCompartida(true){}
 
 /**
  * @brief Destructor.
@@ -32,6 +43,8 @@ ClienteSocket::ClienteSocket() : clienteSocket(-1){}
  */
 ClienteSocket::~ClienteSocket(){
     cerrar();
+    if(porCerrar != -1) close(porCerrar);
+    if(despertador != -1) close(despertador);
 }
 
 /**
@@ -67,6 +80,12 @@ bool ClienteSocket::conectar(const char* ip, int puerto){
         cerr << "IP Invalida del servidor" << endl;
         return false;
     }
+
+    // 127.x: el servidor está en esta máquina, se intenta no pasar por la pila de red.
+    if(memoriaCompartida && std::strncmp(ip, "127.", 4) == 0 && conectarLocal(puerto)){
+        cout << "Conectado con el servidor exitosamente (memoria compartida)" << endl;
+        return true;
+    }
     
     // connect(): Inicia el saludo TCP.
     // Si esta función retorna 0, significa que el cable está conectado virtualmente.
@@ -80,35 +99,189 @@ bool ClienteSocket::conectar(const char* ip, int puerto){
 }
 
 /**
- * @brief Envía bytes crudos al servidor.
- * * Utiliza 'send' en lugar de 'write' porque es específico para sockets.
+ * @brief Negociación de la memoria compartida.
+ * * Se conecta al socket Unix abstracto del servidor y espera (a lo más un
+ * segundo) la memoria y los timbres. Si sale bien, el socket TCP de crear()
+ * se cierra sin haberse usado y su lugar lo toma el socket Unix.
+ */
+bool ClienteSocket::conectarLocal(int puerto){
+    int local = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(local < 0) return false;
+
+    sockaddr_un direccion{};
+    direccion.sun_family = AF_UNIX;
+    std::string nombre = CanalMemoria::nombreLocal(puerto);
+    std::memcpy(direccion.sun_path, nombre.data(), nombre.size());
+    socklen_t largo = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + nombre.size());
+    timeval limite{1, 0};
+    setsockopt(local, SOL_SOCKET, SO_RCVTIMEO, &limite, sizeof(limite));
+
+    std::unique_ptr<CanalMemoria> nuevo;
+    if(connect(local, reinterpret_cast<sockaddr*>(&direccion), largo) == 0)
+        nuevo = CanalMemoria::aceptarOferta(local);
+    if(!nuevo){
+        close(local);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtxEnvio);
+    if(clienteSocket != -1) close(clienteSocket);
+    clienteSocket = local;
+    canal = std::move(nuevo);
+    return true;
+}
+
+void ClienteSocket::usarMemoriaCompartida(bool activar){
+    memoriaCompartida = activar;
+}
+
+/**
+ * @brief Envía un mensaje de chat al servidor.
  * @param mensaje Cadena de caracteres estilo C.
  */
-void ClienteSocket::enviar(const char* mensaje){
+EstadoEnvio ClienteSocket::enviar(const char* mensaje){
     // strlen calcula la longitud exacta del texto(sin basura extra).
-    send(clienteSocket, mensaje, strlen(mensaje), 0);
+    return enviarTrama(TipoTrama::MENSAJE, std::string_view(mensaje, strlen(mensaje)));
+}
+
+/**
+ * @brief Empaqueta y envía una trama.
+ * * La trama se codifica en el buffer de salida y se intenta mandar sin
+ * bloquear (sendmsg con MSG_DONTWAIT | MSG_NOSIGNAL). Si el Kernel no la
+ * acepta completa, se despierta al hilo de red para que la termine cuando
+ * haya lugar; mientras tanto, las tramas nuevas se acumulan y salen juntas.
+ */
+EstadoEnvio ClienteSocket::enviarTrama(TipoTrama tipo, std::string_view datos){
+    // El servidor rechazaría la trama y cortaría la conexión: no se manda.
+    if(datos.size() > MAX_CARGA) return EstadoEnvio::DEMASIADO_GRANDE;
+
+    std::lock_guard<std::mutex> lock(mtxEnvio);
+    if(clienteSocket == -1) return EstadoEnvio::CERRADO;
+
+    salida.agregarTrama(tipo, secuenciaSalida++, datos);
+    if(!esperandoEscritura && canal){
+        // Anillo lleno: el timbre despierta al hilo de red cuando el servidor lea.
+        esperandoEscritura = canal->vaciar(salida) == ResultadoVaciado::PENDIENTE;
+    } else if(!esperandoEscritura){
+        ResultadoVaciado resultado = salida.vaciar(clienteSocket);
+        if(resultado == ResultadoVaciado::ERROR){
+            salida.descartar();
+            return EstadoEnvio::CERRADO;
+        }
+        if(resultado == ResultadoVaciado::PENDIENTE){
+            esperandoEscritura = true;
+            uint64_t uno = 1;
+            ssize_t ignorado = write(despertador, &uno, sizeof(uno));
+            (void)ignorado;
+        }
+    }
+    return salida.estaSaturado() ? EstadoEnvio::SATURADO : EstadoEnvio::ENVIADO;
+}
+
+void ClienteSocket::continuarEscritura(){
+    std::lock_guard<std::mutex> lock(mtxEnvio);
+    if(canal){
+        esperandoEscritura = canal->vaciar(salida) == ResultadoVaciado::PENDIENTE;
+        return;
+    }
+    ResultadoVaciado resultado = salida.vaciar(clienteSocket);
+    if(resultado == ResultadoVaciado::ERROR) salida.descartar();
+    if(resultado != ResultadoVaciado::PENDIENTE) esperandoEscritura = false;
 }
 
 /**
- * @brief Escucha y captura la respuesta del servidor.
+ * @brief Escucha y captura la siguiente trama del servidor.
  * * Esta función es BLOQUEANTE por defecto (espera hasta que llegue algo).
+ * * Primero intenta decodificar lo que ya está en el buffer; solo si falta
+ * información vuelve a leer de la red.
  */
-std::string ClienteSocket::recibir(){
-    // Buffer de 1KB en el Stack (memoria rápida).
-    // {0} inicializa todo en nulos para evitar basura de memoria.
-    char buffer[1024] = {0};
-    
-    // recv(): Lee del buffer de entrada de la tarjeta de red.
-    // Retorna la cantidad de bytes que realmente llegaron.
-    int bytesLeidos = recv(clienteSocket, buffer, sizeof(buffer), 0);
-    
-    if(bytesLeidos > 0){
-        // Convertimos el array de char a string de C++ automáticamente.
-        return std::string(buffer);
+bool ClienteSocket::recibir(Trama& trama){
+    while(true){
+        VistaTrama vista;
+        ResultadoDecodificacion resultado = decodificador.siguiente(entrada, vista);
+
+        if(resultado == ResultadoDecodificacion::TRAMA){
+            // Única copia: del buffer de lectura al string del mensaje.
+            trama.tipo = vista.tipo;
+            trama.secuencia = vista.secuencia;
+            trama.datos.assign(vista.datos.data(), vista.datos.size());
+            return true;
+        }
+
+        if(resultado == ResultadoDecodificacion::ERROR){
+            cerr << "Error: el servidor envio una trama invalida" << endl;
+            return false;
+        }
+
+        // Memoria compartida: se lee el anillo y solo se duerme si sigue vacío
+        // después de declararse dormido (si no, el servidor no tocaría el timbre).
+        if(canal){
+            long leidos = canal->leerEn(entrada);
+            if(leidos < 0){
+                cerr << "Error: la memoria compartida con el servidor esta corrupta" << endl;
+                return false;
+            }
+            if(leidos > 0 || !canal->prepararEspera()) continue;
+        }
+
+        // Esperar a que haya datos, a que el socket acepte la salida pendiente o a un aviso de enviarTrama().
+        // El descriptor se toma con el mutex y queda "en uso" hasta el final de la vuelta:
+        // si cerrar() llega mientras tanto, el close() lo hace este hilo (soltarSocket()).
+        int fd;
+        bool hayPendiente;
+        {
+            std::lock_guard<std::mutex> lock(mtxEnvio);
+            if(clienteSocket == -1) return false;
+            fd = clienteSocket;
+            hayPendiente = esperandoEscritura && !canal;
+            usandoSocket = true;
+        }
+        struct Uso {
+            ClienteSocket* cliente;
+            ~Uso(){ cliente->soltarSocket(); }
+        } uso{this};
+
+        pollfd vigilados[3] = {
+            {fd, static_cast<short>(POLLIN | (hayPendiente ? POLLOUT : 0)), 0},
+            {despertador, POLLIN, 0},
+            {canal ? canal->timbre() : -1, POLLIN, 0} // poll ignora los descriptores negativos.
+        };
+        if(poll(vigilados, 3, -1) < 0){
+            if(errno == EINTR) continue;
+            return false;
+        }
+        if(vigilados[1].revents & POLLIN){
+            uint64_t avisos;
+            ssize_t ignorado = read(despertador, &avisos, sizeof(avisos));
+            (void)ignorado;
+        }
+        if(vigilados[2].revents & POLLIN){
+            // El servidor escribió o liberó lugar en el anillo de salida.
+            canal->apagarTimbre();
+            continuarEscritura();
+        }
+        if(vigilados[0].revents & POLLOUT) continuarEscritura();
+        {
+            std::lock_guard<std::mutex> lock(mtxEnvio);
+            if(clienteSocket == -1) return false; // cerrar() nos despertó.
+        }
+        if(!(vigilados[0].revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL))) continue;
+        if(canal) return false; // Por el socket Unix no llegan datos: solo puede ser que el servidor colgó.
+
+        // recv(): Lee del buffer de entrada de la tarjeta de red directo a nuestro buffer.
+        // Retorna la cantidad de bytes que realmente llegaron.
+        char* destino = entrada.reservar(TAM_LECTURA);
+        ssize_t bytesLeidos = recv(fd, destino, entrada.espacioLibre(), 0);
+
+        if(bytesLeidos > 0){
+            entrada.confirmar(bytesLeidos);
+        } else if(bytesLeidos < 0 && errno == EINTR){
+            continue;
+        } else {
+            // Si bytesLeidos es 0, significa que el servidor cerró la conexión.
+            return false;
+        }
     }
-    
-    // Si bytesLeidos es 0, significa que el servidor cerró la conexión.
-    return "";
 }
 
 /**
@@ -116,8 +289,30 @@ std::string ClienteSocket::recibir(){
  * * Libera el puerto y la memoria en el Kernel.
  */
 void ClienteSocket::cerrar(){
+    std::lock_guard<std::mutex> lock(mtxEnvio);
     if(clienteSocket != -1){
-        close(clienteSocket);
+        // Si el hilo de red está en poll()/recv() con este descriptor, cerrarlo aquí
+        // dejaría que el número se reutilice bajo sus pies: se apaga y lo cierra él.
+        if(usandoSocket){
+            shutdown(clienteSocket, SHUT_RDWR);
+            porCerrar = clienteSocket;
+        } else {
+            close(clienteSocket);
+        }
         clienteSocket = -1; // Marcamos como cerrado para no cerrarlo dos veces.
+
+        // Despertar al hilo de red si está esperando en poll().
+        uint64_t uno = 1;
+        ssize_t ignorado = write(despertador, &uno, sizeof(uno));
+        (void)ignorado;
     }
-}
\ No newline at end of file
+}
+
+void ClienteSocket::soltarSocket(){
+    std::lock_guard<std::mutex> lock(mtxEnvio);
+    usandoSocket = false;
+    if(porCerrar != -1){
+        close(porCerrar);
+        porCerrar = -1;
+    }
+}
@@ -0,0 +1,42 @@
+/**
+ * @file corrutina.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación del Avisador (la Tarea vive completa en el header).
+ * @version 1.0
+ * @date 06/01/2026
+ */
+
+#include "../include/corrutina.h"
+#include <cstdint>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+Avisador::Avisador(Reactor& reactor, int fd, std::function<void()> consumir)
+    : reactor(reactor), fd(fd), consumir(std::move(consumir)), registrado(false) {}
+
+Avisador::~Avisador() {
+    if (registrado) reactor.quitar(fd);
+}
+
+bool Avisador::armar() {
+    if (registrado) return true;
+    registrado = reactor.registrar(fd, EPOLLIN, [this](uint32_t) {
+        if (consumir) {
+            consumir();
+        } else {
+            uint64_t contador;
+            ssize_t ignorado = ::read(fd, &contador, sizeof(contador));
+            (void)ignorado;
+        }
+        despertar();
+    });
+    return registrado;
+}
+
+void Avisador::despertar() {
+    // Se suelta ANTES de reanudar: la corrutina puede volver a esperar aquí mismo.
+    std::coroutine_handle<> quien = std::exchange(esperando, {});
+    if (quien) quien.resume();
+}
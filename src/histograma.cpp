@@ -0,0 +1,82 @@
+/**
+ * @file histograma.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación del histograma logarítmico-lineal.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Cubetas: los valores < 2*SUB_CUBETAS se guardan exactos (cubeta = valor).
+ * Desde ahí, con k = bit más alto y desplazamiento = k - BITS_SUB, la mantisa
+ * (valor >> desplazamiento) queda en [SUB_CUBETAS, 2*SUB_CUBETAS) y
+ * cubeta = desplazamiento * SUB_CUBETAS + mantisa. Las cubetas son contiguas.
+ */
+
+#include "../include/histograma.h"
+#include <algorithm>
+#include <cmath>
+
+/// Cubetas necesarias para cubrir hasta 2^64 - 1.
+static const size_t NUM_CUBETAS = (64 - Histograma::BITS_SUB + 1) * Histograma::SUB_CUBETAS;
+
+Histograma::Histograma() : conteos(NUM_CUBETAS, 0), total(0), minimo(UINT64_MAX), maximo(0), suma(0) {}
+
+size_t Histograma::indice(uint64_t valor) {
+    if (valor < 2 * SUB_CUBETAS) return static_cast<size_t>(valor);
+    unsigned k = 63 - static_cast<unsigned>(__builtin_clzll(valor));
+    unsigned desplazamiento = k - BITS_SUB;
+    return static_cast<size_t>(desplazamiento) * SUB_CUBETAS + static_cast<size_t>(valor >> desplazamiento);
+}
+
+uint64_t Histograma::valorDe(size_t cubeta) {
+    if (cubeta < 2 * SUB_CUBETAS) return cubeta;
+    uint64_t desplazamiento = cubeta / SUB_CUBETAS - 1;
+    uint64_t mantisa = cubeta - desplazamiento * SUB_CUBETAS;
+    uint64_t inferior = mantisa << desplazamiento;
+    return inferior + ((1ull << desplazamiento) >> 1);
+}
+
+void Histograma::registrar(uint64_t valor) {
+    ++conteos[indice(valor)];
+    ++total;
+    minimo = std::min(minimo, valor);
+    maximo = std::max(maximo, valor);
+    suma += valor;
+}
+
+void Histograma::combinar(const Histograma& otro) {
+    for (size_t i = 0; i < NUM_CUBETAS; ++i) conteos[i] += otro.conteos[i];
+    total += otro.total;
+    minimo = std::min(minimo, otro.minimo);
+    maximo = std::max(maximo, otro.maximo);
+    suma += otro.suma;
+}
+
+void Histograma::limpiar() {
+    std::fill(conteos.begin(), conteos.end(), 0);
+    total = 0;
+    minimo = UINT64_MAX;
+    maximo = 0;
+    suma = 0;
+}
+
+double Histograma::media() const {
+    return total ? static_cast<double>(suma / static_cast<long double>(total)) : 0.0;
+}
+
+uint64_t Histograma::percentil(double p) const {
+    if (total == 0) return 0;
+    if (p >= 100.0) return maximo;
+
+    // Rango (1..total) de la muestra buscada.
+    uint64_t objetivo = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total)));
+    if (objetivo == 0) objetivo = 1;
+
+    uint64_t acumulado = 0;
+    for (size_t i = 0; i < NUM_CUBETAS; ++i) {
+        acumulado += conteos[i];
+        // El punto medio nunca se reporta fuera de lo realmente observado.
+        if (acumulado >= objetivo) return std::min(std::max(valorDe(i), minimo), maximo);
+    }
+    return maximo;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file main_bench_chat.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Benchmark de contención lectores/escritores sobre el historial del Chat.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Compara el Chat actual (lecturas sin bloqueo con vistas) contra el diseño
+ * anterior (vector + mutex + copia completa en cada lectura), con hilos
+ * escritores (como el hilo de red) y lectores (como el bucle de dibujo)
+ * compitiendo al mismo tiempo.
+ *
+ * Uso: bench_chat [segundos] [lectores] [escritores] [limpiarCada]
+ */
+
+#include "../include/chat.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+/**
+ * @class ChatConMutex
+ * @brief Réplica del diseño anterior del Chat, usada como línea base.
+ */
+class ChatConMutex {
+    private:
+        std::vector<Mensaje> historial;
+        std::mutex mtx;
+
+    public:
+        void agregarMensaje(std::string emisor, std::string texto, bool esMio) {
+            std::lock_guard<std::mutex> lock(mtx);
+            historial.push_back({std::move(emisor), std::move(texto), esMio});
+        }
+
+        std::vector<Mensaje> obtenerHistorial() {
+            std::lock_guard<std::mutex> lock(mtx);
+            return historial;
+        }
+
+        void limpiarHistorial() {
+            std::lock_guard<std::mutex> lock(mtx);
+            historial.clear();
+        }
+};
+
+/**
+ * @struct Resultado
+ * @brief Números de una corrida.
+ */
+struct Resultado {
+    double escriturasPorSeg;   ///< Mensajes agregados por segundo (todos los escritores).
+    double lecturasPorSeg;     ///< "Frames" de lectura completos por segundo (todos los lectores).
+    double p99EscrituraUs;     ///< Percentil 99 de la latencia de agregarMensaje (microsegundos).
+    double maxEscrituraUs;     ///< Peor latencia observada de agregarMensaje (microsegundos).
+};
+
+/**
+ * @brief Lectura equivalente a un frame de dibujo en cada diseño.
+ */
+static size_t leerFrame(Chat& chat) {
+    size_t total = 0;
+    for (const VistaMensaje& m : chat.obtenerVista()) total += m.texto.size();
+    return total;
+}
+
+static size_t leerFrame(ChatConMutex& chat) {
+    size_t total = 0;
+    for (const Mensaje& m : chat.obtenerHistorial()) total += m.texto.size();
+    return total;
+}
+
+/**
+ * @brief Ejecuta una corrida de contención sobre cualquiera de los dos diseños.
+ */
+template <typename TipoChat>
+Resultado correr(int segundos, int lectores, int escritores, int limpiarCada) {
+    TipoChat chat;
+    std::atomic<bool> activo(true);
+    std::atomic<uint64_t> escrituras(0), lecturas(0), basura(0);
+    std::vector<std::vector<double>> latencias(escritores);
+
+    std::vector<std::thread> hilos;
+    for (int e = 0; e < escritores; ++e) {
+        hilos.emplace_back([&, e] {
+            std::string texto = "Hola, tengo un problema con mi pedido numero 12345";
+            uint64_t n = 0;
+            while (activo.load(std::memory_order_relaxed)) {
+                auto t0 = Reloj::now();
+                chat.agregarMensaje("Cliente 1", texto, false);
+                auto t1 = Reloj::now();
+                // Muestreamos 1 de cada 16 para no medir la propia medición.
+                if ((n & 15) == 0) latencias[e].push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+                ++n;
+                // Solo el primer escritor simula el cambio de cliente.
+                if (e == 0 && limpiarCada > 0 && n % limpiarCada == 0) chat.limpiarHistorial();
+            }
+            escrituras += n;
+        });
+    }
+
+    for (int l = 0; l < lectores; ++l) {
+        hilos.emplace_back([&] {
+            uint64_t n = 0, suma = 0;
+            while (activo.load(std::memory_order_relaxed)) {
+                suma += leerFrame(chat);
+                ++n;
+            }
+            lecturas += n;
+            basura += suma;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(segundos));
+    activo = false;
+    for (auto& h : hilos) h.join();
+
+    std::vector<double> todas;
+    for (auto& v : latencias) todas.insert(todas.end(), v.begin(), v.end());
+    std::sort(todas.begin(), todas.end());
+
+    Resultado r;
+    r.escriturasPorSeg = static_cast<double>(escrituras) / segundos;
+    r.lecturasPorSeg = static_cast<double>(lecturas) / segundos;
+    r.p99EscrituraUs = todas.empty() ? 0 : todas[static_cast<size_t>(todas.size() * 0.99)];
+    r.maxEscrituraUs = todas.empty() ? 0 : todas.back();
+    return r;
+}
+
+static void imprimir(const char* nombre, const Resultado& r) {
+    std::cout << std::left << std::setw(14) << nombre << std::right << std::fixed << std::setprecision(1)
+              << std::setw(16) << r.escriturasPorSeg
+              << std::setw(14) << r.lecturasPorSeg
+              << std::setw(14) << r.p99EscrituraUs
+              << std::setw(14) << r.maxEscrituraUs << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    int segundos = argc > 1 ? std::atoi(argv[1]) : 2;
+    int lectores = argc > 2 ? std::atoi(argv[2]) : 2;
+    int escritores = argc > 3 ? std::atoi(argv[3]) : 1;
+    int limpiarCada = argc > 4 ? std::atoi(argv[4]) : 20000;
+
+    std::cout << "Contencion: " << lectores << " lectores, " << escritores << " escritores, "
+              << segundos << " s por corrida, limpieza cada " << limpiarCada << " mensajes\n\n";
+    std::cout << std::left << std::setw(14) << "diseno" << std::right
+              << std::setw(16) << "escrituras/s"
+              << std::setw(14) << "lecturas/s"
+              << std::setw(14) << "p99 esc(us)"
+              << std::setw(14) << "max esc(us)" << "\n";
+
+    imprimir("vistas (RCU)", correr<Chat>(segundos, lectores, escritores, limpiarCada));
+    imprimir("mutex+copia", correr<ChatConMutex>(segundos, lectores, escritores, limpiarCada));
+    return 0;
+}
@@ -0,0 +1,713 @@
+/**
+ * @file main_benchmarks.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Microbenchmarks de los caminos calientes (Chat, registro de clientes, protocolo, tickets, red, corrutinas).
+ * @version 1.0
+ * @date 06/01/2026
+ * * Cada prueba se calibra hasta durar ~TIEMPO_OBJETIVO por repetición, se
+ * repite varias veces y se reporta la mediana en ns por operación. Los
+ * resultados pueden guardarse en JSON y compararse contra una línea base:
+ *
+ *   benchmarks --json base.json                 (guardar)
+ *   benchmarks --comparar base.json [--umbral 10] (falla si algo empeoró más del umbral %)
+ *
+ * Otras opciones: --filtro <texto> (solo pruebas cuyo nombre lo contenga),
+ * --repeticiones <n> (5).
+ *
+ * Además de tiempos se reporta memoria (bytes pedidos al heap, medidos con
+ * mallinfo2) para 100 000 mensajes en el Chat y, como referencia, en un
+ * std::vector<Mensaje>. Esas medidas no entran en la comparación.
+ */
+
+#include "../include/chat.h"
+#include "../include/socket.h"
+#include "../include/protocolo.h"
+#include "../include/almacenTickets.h"
+#include "../include/corrutina.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <malloc.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+using Reloj = std::chrono::steady_clock;
+
+/// Duración buscada para cada repetición (suficiente para que el ruido del reloj no importe).
+static const std::chrono::milliseconds TIEMPO_OBJETIVO(100);
+
+/**
+ * @brief Impide que el compilador elimine un cálculo cuyo resultado no se usa.
+ */
+template <typename T>
+static inline void noOptimizar(const T& valor) {
+    asm volatile("" : : "r,m"(valor) : "memory");
+}
+
+/**
+ * @struct Benchmark
+ * @brief Una prueba: recibe cuántas operaciones hacer y las hace.
+ */
+struct Benchmark {
+    std::string nombre;
+    std::function<void(uint64_t iteraciones)> correr;
+};
+
+/**
+ * @struct Medicion
+ * @brief Resultado de una prueba.
+ */
+struct Medicion {
+    std::string nombre;
+    double nsPorOp;       ///< Mediana de las repeticiones.
+    double minNs;
+    double maxNs;
+    uint64_t iteraciones; ///< Operaciones por repetición.
+    int repeticiones;
+};
+
+static double nsPorOperacion(const Benchmark& b, uint64_t n) {
+    auto t0 = Reloj::now();
+    b.correr(n);
+    auto t1 = Reloj::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(n);
+}
+
+/**
+ * @brief Calibra (duplicando n hasta ~1/5 del objetivo) y luego mide.
+ */
+static Medicion medir(const Benchmark& b, int repeticiones) {
+    uint64_t n = 1;
+    while (true) {
+        double ns = nsPorOperacion(b, n);
+        double total = ns * static_cast<double>(n);
+        if (total >= std::chrono::duration<double, std::nano>(TIEMPO_OBJETIVO).count() / 5 || n >= (1ull << 40)) {
+            double objetivo = std::chrono::duration<double, std::nano>(TIEMPO_OBJETIVO).count();
+            n = std::max<uint64_t>(1, static_cast<uint64_t>(objetivo / std::max(ns, 0.01)));
+            break;
+        }
+        n *= 2;
+    }
+
+    std::vector<double> muestras;
+    for (int r = 0; r < repeticiones; ++r) muestras.push_back(nsPorOperacion(b, n));
+    std::sort(muestras.begin(), muestras.end());
+    return {b.nombre, muestras[muestras.size() / 2], muestras.front(), muestras.back(), n, repeticiones};
+}
+
+// ================= PRUEBAS =================
+
+static std::string textoDe(size_t tam) {
+    static const char relleno[] = "Hola, tengo un problema con mi pedido. ";
+    std::string texto(tam, ' ');
+    for (size_t k = 0; k < tam; ++k) texto[k] = relleno[k % (sizeof(relleno) - 1)];
+    return texto;
+}
+
+static void llenarChat(Chat& chat, size_t mensajes) {
+    std::string texto = textoDe(64);
+    for (size_t i = 0; i < mensajes; ++i) chat.agregarMensaje(i % 2 ? "Yo" : "Cliente 1", texto, i % 2 == 1);
+}
+
+static std::vector<Benchmark> pruebasChat() {
+    std::vector<Benchmark> pruebas;
+
+    pruebas.push_back({"chat/agregarMensaje", [](uint64_t n) {
+        Chat chat;
+        std::string texto = textoDe(64);
+        for (uint64_t i = 0; i < n; ++i) {
+            chat.agregarMensaje("Cliente 1", texto, false);
+            // Una sesión real no crece sin límite: se limpia como al cambiar de cliente.
+            if ((i & 4095) == 4095) chat.limpiarHistorial();
+        }
+    }});
+
+    for (size_t tam : {10, 1000, 100000}) {
+        // El historial se llena una sola vez, fuera de la medición.
+        auto chat = std::make_shared<Chat>();
+        llenarChat(*chat, tam);
+
+        pruebas.push_back({"chat/obtenerHistorial/" + std::to_string(tam), [chat](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                std::vector<Mensaje> copia = chat->obtenerHistorial();
+                noOptimizar(copia.data());
+            }
+        }});
+
+        pruebas.push_back({"chat/obtenerVista+recorrer/" + std::to_string(tam), [chat](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                size_t total = 0;
+                for (const VistaMensaje& m : chat->obtenerVista()) total += m.texto.size();
+                noOptimizar(total);
+            }
+        }});
+    }
+    return pruebas;
+}
+
+static std::vector<Benchmark> pruebasRegistro() {
+    std::vector<Benchmark> pruebas;
+    for (int clientes : {100, 10000, 100000}) {
+        auto servidor = std::make_shared<ServerSocket>();
+        for (int i = 0; i < clientes; ++i)
+            servidor->registroClientes.agregar({1000 + i, i + 1, "Cliente " + std::to_string(i + 1)});
+
+        pruebas.push_back({"registro/obtenerNombrePorSocket/" + std::to_string(clientes), [servidor, clientes](uint64_t n) {
+            // Se busca a los más antiguos (el peor caso de la antigua búsqueda lineal) y a uno reciente.
+            for (uint64_t i = 0; i < n; ++i) {
+                int socket = (i & 1) ? 1000 + clientes - 1 : 1000 + static_cast<int>(i % 16);
+                std::string nombre = servidor->obtenerNombrePorSocket(socket);
+                noOptimizar(nombre.data());
+            }
+        }});
+    }
+
+    // Rotación de clientes: cada uno entra y sale (la memoria del registro no crece).
+    pruebas.push_back({"registro/agregar+quitar", [](uint64_t n) {
+        RegistroClientes registro;
+        for (uint64_t i = 0; i < n; ++i) {
+            int id = static_cast<int>(i);
+            ManejadorCliente m = registro.agregar({1000 + id % 512, id, "Cliente " + std::to_string(id)});
+            registro.quitar(m);
+        }
+        noOptimizar(registro.cantidad());
+    }});
+
+    // Fila con 'enCola' esperando: atender al primero, llegar uno nuevo y preguntar el lugar de alguien.
+    for (size_t enCola : {1000, 100000}) {
+        pruebas.push_back({"registro/posiciones/" + std::to_string(enCola), [enCola](uint64_t n) {
+            using Reloj = std::chrono::steady_clock;
+            PosicionesCola posiciones;
+            for (size_t i = 0; i < enCola; ++i) posiciones.agregar(Reloj::time_point(Reloj::duration(i)));
+            uint64_t primero = 0;
+            for (uint64_t i = 0; i < n; ++i) {
+                posiciones.quitar(primero++);
+                uint64_t ultimo = posiciones.agregar(Reloj::time_point(Reloj::duration(enCola + i)));
+                noOptimizar(posiciones.posicion(primero + (ultimo - primero) / 2));
+            }
+        }});
+
+        // Lo mismo para el planificador por plazos: 1 de cada 8 es prioritario y se mete adelante.
+        pruebas.push_back({"registro/planificador/sla/" + std::to_string(enCola), [enCola](uint64_t n) {
+            using Reloj = std::chrono::steady_clock;
+            PlazosServicio plazos = plazosPorDefecto();
+            std::unique_ptr<PlanificadorFila> planificador = crearPlanificador(PoliticaFila::SLA, plazos);
+            auto entrada = [&](uint64_t i) {
+                ClaseServicio clase = (i % 8 == 0) ? ClaseServicio::PRIORITARIA : ClaseServicio::NORMAL;
+                return EntradaFila{static_cast<int>(i), {}, Reloj::time_point(Reloj::duration(i)) + planificador->plazo(clase), 0};
+            };
+            for (size_t i = 0; i < enCola; ++i) planificador->agregar(entrada(i));
+            for (uint64_t i = 0; i < n; ++i) {
+                noOptimizar(planificador->frente().socket);
+                planificador->sacar();
+                planificador->agregar(entrada(enCola + i));
+            }
+        }});
+    }
+    return pruebas;
+}
+
+/**
+ * @brief Lote de tramas codificadas (secuencias 0..cantidad-1) como llegarían del socket.
+ */
+static std::string loteTramas(size_t cantidad, size_t tam, bool mezclado) {
+    std::string texto = textoDe(tam), salida;
+    for (size_t i = 0; i < cantidad; ++i) {
+        TipoTrama tipo = TipoTrama::MENSAJE;
+        if (mezclado && i % 8 == 0) tipo = (i % 16 == 0) ? TipoTrama::PING : TipoTrama::WAIT;
+        codificarTrama(salida, tipo, static_cast<uint32_t>(i), tipo == TipoTrama::MENSAJE ? texto : std::string());
+    }
+    return salida;
+}
+
+static std::vector<Benchmark> pruebasProtocolo() {
+    std::vector<Benchmark> pruebas;
+    const size_t LOTE = 1024;
+
+    pruebas.push_back({"protocolo/codificarTrama/64", [](uint64_t n) {
+        std::string texto = textoDe(64), salida;
+        for (uint64_t i = 0; i < n; ++i) {
+            salida.clear();
+            codificarTrama(salida, TipoTrama::MENSAJE, static_cast<uint32_t>(i), texto);
+            noOptimizar(salida.data());
+        }
+    }});
+
+    for (size_t tam : {64, 4096}) {
+        std::string lote = loteTramas(LOTE, tam, false);
+        pruebas.push_back({"protocolo/decodificar/" + std::to_string(tam), [lote](uint64_t n) {
+            for (uint64_t hechas = 0; hechas < n;) {
+                BufferLectura buffer(lote.size());
+                DecodificadorTramas decodificador;
+                std::memcpy(buffer.reservar(lote.size()), lote.data(), lote.size());
+                buffer.confirmar(lote.size());
+                VistaTrama trama;
+                while (hechas < n && decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::TRAMA) {
+                    noOptimizar(trama.datos.data());
+                    ++hechas;
+                }
+            }
+        }});
+    }
+
+    // Lo que hace hiloRedCliente por cada trama: decodificar, copiar y despachar por tipo.
+    std::string loteMezclado = loteTramas(LOTE, 64, true);
+    pruebas.push_back({"protocolo/despachoCliente", [lote = std::move(loteMezclado)](uint64_t n) {
+        Trama trama;
+        uint64_t esperas = 0, pings = 0, mensajes = 0;
+        for (uint64_t hechas = 0; hechas < n;) {
+            BufferLectura buffer(lote.size());
+            DecodificadorTramas decodificador;
+            std::memcpy(buffer.reservar(lote.size()), lote.data(), lote.size());
+            buffer.confirmar(lote.size());
+            VistaTrama vista;
+            while (hechas < n && decodificador.siguiente(buffer, vista) == ResultadoDecodificacion::TRAMA) {
+                trama.tipo = vista.tipo;
+                trama.secuencia = vista.secuencia;
+                trama.datos.assign(vista.datos.data(), vista.datos.size());
+                switch (trama.tipo) {
+                    case TipoTrama::WAIT: case TipoTrama::START: ++esperas; break;
+                    case TipoTrama::PING: ++pings; break;
+                    case TipoTrama::MENSAJE: mensajes += trama.datos.size(); break;
+                    default: break;
+                }
+                ++hechas;
+            }
+        }
+        noOptimizar(esperas + pings + mensajes);
+    }});
+    return pruebas;
+}
+
+static std::vector<Benchmark> pruebasTickets(const std::string& carpeta) {
+    std::vector<Benchmark> pruebas;
+
+    // Sustituye a generarTicket(): hoy el .txt se produce con exportarTexto().
+    pruebas.push_back({"tickets/exportarTexto/50", [](uint64_t n) {
+        RegistroTicket r;
+        r.ticketId = 1;
+        r.clienteId = 7;
+        r.fecha = 1767700000;
+        r.nombre = "Cliente 7";
+        std::string texto = textoDe(64);
+        for (int i = 0; i < 50; ++i) r.mensajes.push_back({i % 2 ? "Yo" : "Cliente 7", texto, i % 2 == 1});
+        std::string salida;
+        for (uint64_t i = 0; i < n; ++i) {
+            salida.clear();
+            exportarTexto(r, salida);
+            noOptimizar(salida.data());
+        }
+    }});
+
+    // Serializar y anexar un ticket al almacén (sin fdatasync: mide CPU + write()).
+    auto almacen = std::make_shared<AlmacenTickets>();
+    if (almacen->abrir(carpeta + "/almacen")) {
+        pruebas.push_back({"tickets/almacenAgregar/50", [almacen](uint64_t n) {
+            std::vector<Mensaje> mensajes;
+            std::string texto = textoDe(64);
+            for (int i = 0; i < 50; ++i) mensajes.push_back({i % 2 ? "Yo" : "Cliente 7", texto, i % 2 == 1});
+            for (uint64_t i = 0; i < n; ++i)
+                noOptimizar(almacen->agregar(7, "Cliente 7", 1767700000 + static_cast<int64_t>(i), mensajes));
+        }});
+    }
+    return pruebas;
+}
+
+/**
+ * @struct BancoRed
+ * @brief Servidor real (con su hilo de reactor) y clientes TCP por loopback.
+ * * Nadie toma clientes de la fila: todos quedan en espera y el servidor solo
+ * contesta sus PINGs, que es justo el camino recv -> decodificar -> send.
+ */
+struct BancoRed {
+    ServerSocket servidor;
+    std::thread hiloReactor;
+    std::vector<int> clientes;
+    std::vector<uint32_t> secuencias; ///< Siguiente secuencia de cada cliente.
+    std::vector<std::string> pendientes; ///< Bytes leídos que aún no forman trama.
+
+    ~BancoRed() {
+        // Primero el servidor: así no reporta cada desconexión en la salida.
+        servidor.cerrarServidor();
+        if (hiloReactor.joinable()) hiloReactor.join();
+        for (int fd : clientes) close(fd);
+    }
+
+    /**
+     * @brief Lee del cliente 'i' hasta completar un PONG (salta WAIT y PINGs del keepalive).
+     */
+    bool esperarPong(size_t i) { return esperarTrama(i, TipoTrama::PONG); }
+
+    /**
+     * @brief Lee del cliente 'i' hasta completar una trama 'tipo' (salta las demás).
+     */
+    bool esperarTrama(size_t i, TipoTrama tipo) {
+        std::string& b = pendientes[i];
+        char lectura[4096];
+        while (true) {
+            while (b.size() >= TAM_CABECERA) {
+                uint32_t largo;
+                std::memcpy(&largo, b.data() + 4, sizeof(largo));
+                size_t total = TAM_CABECERA + ntohl(largo);
+                if (b.size() < total) break;
+                bool esBuscada = static_cast<TipoTrama>(b[0]) == tipo;
+                b.erase(0, total);
+                if (esBuscada) return true;
+            }
+            ssize_t leidos = recv(clientes[i], lectura, sizeof(lectura), 0);
+            if (leidos <= 0) return false;
+            b.append(lectura, static_cast<size_t>(leidos));
+        }
+    }
+};
+
+/**
+ * @brief Levanta el servidor con 'backend' y conecta 'conexiones' clientes.
+ * @return nullptr si el backend no está disponible (io_uring cae a epoll) o algo falla.
+ */
+static std::shared_ptr<BancoRed> abrirBancoRed(BackendRed backend, int conexiones, int espera = 128) {
+    // El servidor anuncia cada cliente nuevo en std::cout; no debe mezclarse con la tabla.
+    struct Silencio {
+        std::streambuf* anterior = std::cout.rdbuf(nullptr);
+        ~Silencio() { std::cout.rdbuf(anterior); }
+    } silencio;
+
+    auto banco = std::make_shared<BancoRed>();
+    banco->servidor.usarBackend(backend);
+    if (!banco->servidor.crear() || banco->servidor.backend() != backend) return nullptr;
+
+    // Cada banco sigue vivo hasta el final: uno distinto por puerto (si está ocupado, el siguiente).
+    static int siguientePuerto = 47810;
+    int puerto = siguientePuerto;
+    while (puerto < siguientePuerto + 20 &&
+           !(banco->servidor.configurar("127.0.0.1", puerto) && banco->servidor.bindear())) ++puerto;
+    if (puerto == siguientePuerto + 20 || !banco->servidor.escuchar(espera)) return nullptr;
+    siguientePuerto = puerto + 1;
+    banco->hiloReactor = std::thread([b = banco.get()] { b->servidor.aceptarClientes(); });
+
+    sockaddr_in direccion{};
+    direccion.sin_family = AF_INET;
+    direccion.sin_port = htons(puerto);
+    inet_pton(AF_INET, "127.0.0.1", &direccion.sin_addr);
+    for (int i = 0; i < conexiones; ++i) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd == -1) return nullptr;
+        banco->clientes.push_back(fd);
+        int uno = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &uno, sizeof(uno));
+        if (connect(fd, reinterpret_cast<sockaddr*>(&direccion), sizeof(direccion)) < 0) return nullptr;
+    }
+    banco->secuencias.assign(banco->clientes.size(), 0);
+    banco->pendientes.assign(banco->clientes.size(), std::string());
+
+    // Un PING por cliente: al volver su PONG, el servidor ya lo registró (y ya imprimió).
+    std::string ping;
+    for (size_t i = 0; i < banco->clientes.size(); ++i) {
+        ping.clear();
+        codificarTrama(ping, TipoTrama::PING, banco->secuencias[i]++, "");
+        if (send(banco->clientes[i], ping.data(), ping.size(), MSG_NOSIGNAL) < 0 || !banco->esperarPong(i)) return nullptr;
+    }
+    return banco;
+}
+
+/**
+ * @brief Ida y vuelta PING -> PONG por loopback con cada backend de red.
+ * * /1: latencia de una sola conexión. /64: cada operación es una ida y vuelta
+ * de un lote en el que las 64 conexiones tienen un PING en vuelo a la vez.
+ */
+static std::vector<Benchmark> pruebasRed() {
+    std::vector<Benchmark> pruebas;
+    const std::pair<BackendRed, const char*> backends[] = {{BackendRed::EPOLL, "epoll"}, {BackendRed::IO_URING, "io_uring"}};
+
+    for (const auto& backend : backends) {
+        for (int conexiones : {1, 64}) {
+            std::shared_ptr<BancoRed> banco = abrirBancoRed(backend.first, conexiones);
+            if (!banco) {
+                std::cerr << "[AVISO] Se omite red/pingPong/" << backend.second << "/" << conexiones << ".\n";
+                continue;
+            }
+            std::string nombre = std::string("red/pingPong/") + backend.second + "/" + std::to_string(conexiones);
+            pruebas.push_back({nombre, [banco](uint64_t n) {
+                std::string ping;
+                size_t total = banco->clientes.size();
+                for (uint64_t hechas = 0; hechas < n; hechas += total) {
+                    for (size_t i = 0; i < total; ++i) {
+                        ping.clear();
+                        codificarTrama(ping, TipoTrama::PING, banco->secuencias[i]++, "");
+                        if (send(banco->clientes[i], ping.data(), ping.size(), MSG_NOSIGNAL) < 0) return;
+                    }
+                    for (size_t i = 0; i < total; ++i)
+                        if (!banco->esperarPong(i)) return;
+                }
+            }});
+        }
+    }
+
+    // Difusión: un aviso a toda la cola, medido hasta que el último cliente lo leyó.
+    const int enCola = 4096; // Cliente y servidor en el mismo proceso: 2 descriptores por conexión.
+    for (const auto& backend : backends) {
+        std::shared_ptr<BancoRed> banco = abrirBancoRed(backend.first, enCola, SOMAXCONN);
+        std::string nombre = std::string("red/difundir/") + backend.second + "/" + std::to_string(enCola);
+        if (!banco) {
+            std::cerr << "[AVISO] Se omite " << nombre << ".\n";
+            continue;
+        }
+        pruebas.push_back({nombre, [banco](uint64_t n) {
+            std::string aviso = textoDe(64);
+            for (uint64_t i = 0; i < n; ++i) {
+                banco->servidor.difundir(aviso, 1);
+                for (size_t c = 0; c < banco->clientes.size(); ++c)
+                    if (!banco->esperarTrama(c, TipoTrama::MENSAJE)) return;
+            }
+        }});
+    }
+    return pruebas;
+}
+
+/**
+ * @brief Suspende guardando a la corrutina donde el banco la pueda reanudar (hace de "socket").
+ */
+struct EsperaBanco {
+    std::coroutine_handle<>* destino;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> quien) noexcept { *destino = quien; }
+    void await_resume() const noexcept {}
+};
+
+static Tarea<int> leerBanco(std::coroutine_handle<>* destino) {
+    co_await EsperaBanco{destino};
+    co_return 1;
+}
+
+static Tarea<> sesionBanco(std::coroutine_handle<>* destino, uint64_t* atendidas) {
+    int mensajes = co_await leerBanco(destino);
+    *atendidas += mensajes;
+}
+
+/**
+ * @brief Una sesión como corrutina: crearla, dejarla suspendida en un co_await,
+ * reanudarla y destruirla. Se mantienen hasta 'vivas' suspendidas a la vez.
+ */
+static std::vector<Benchmark> pruebasCorrutinas() {
+    std::vector<Benchmark> pruebas;
+    for (size_t vivas : {1, 100000}) {
+        pruebas.push_back({"corrutina/sesion/" + std::to_string(vivas), [vivas](uint64_t n) {
+            std::vector<Tarea<>> sesiones;
+            std::vector<std::coroutine_handle<>> pendientes(vivas);
+            uint64_t atendidas = 0;
+            for (uint64_t hechas = 0; hechas < n; hechas += vivas) {
+                size_t lote = static_cast<size_t>(std::min<uint64_t>(vivas, n - hechas));
+                for (size_t i = 0; i < lote; ++i) {
+                    sesiones.push_back(sesionBanco(&pendientes[i], &atendidas));
+                    sesiones.back().iniciar();
+                }
+                for (size_t i = 0; i < lote; ++i) pendientes[i].resume();
+                sesiones.clear();
+            }
+            noOptimizar(atendidas);
+        }});
+    }
+    return pruebas;
+}
+
+// ================= MEMORIA =================
+
+/**
+ * @struct MedidaMemoria
+ * @brief Bytes que quedaron pedidos al heap después de construir algo.
+ */
+struct MedidaMemoria {
+    std::string nombre;
+    size_t bytes;
+    size_t elementos;
+};
+
+static size_t bytesEnUso() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd; // Bloques en uso + los que malloc pidió con mmap.
+}
+
+static std::vector<MedidaMemoria> medirMemoria(const std::string& filtro) {
+    const size_t mensajes = 100000;
+    std::vector<MedidaMemoria> medidas;
+    auto quiere = [&filtro](const std::string& nombre) { return filtro.empty() || nombre.find(filtro) != std::string::npos; };
+
+    std::string nombre = "memoria/chat/" + std::to_string(mensajes);
+    if (quiere(nombre)) {
+        size_t antes = bytesEnUso();
+        auto chat = std::make_unique<Chat>();
+        llenarChat(*chat, mensajes);
+        medidas.push_back({nombre, bytesEnUso() - antes, mensajes});
+    }
+
+    // Referencia: los mismos mensajes guardados uno por uno con sus dos std::string.
+    nombre = "memoria/vectorMensajes/" + std::to_string(mensajes);
+    if (quiere(nombre)) {
+        size_t antes = bytesEnUso();
+        std::vector<Mensaje> copia;
+        copia.reserve(mensajes);
+        std::string texto = textoDe(64);
+        for (size_t i = 0; i < mensajes; ++i) copia.push_back({i % 2 ? "Yo" : "Cliente 1", texto, i % 2 == 1});
+        medidas.push_back({nombre, bytesEnUso() - antes, mensajes});
+    }
+    return medidas;
+}
+
+// ================= JSON =================
+
+static void escribirJSON(std::ostream& salida, const std::vector<Medicion>& mediciones,
+                         const std::vector<MedidaMemoria>& memoria) {
+    salida << "{\n  \"unidad\": \"ns_por_op\",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < mediciones.size(); ++i) {
+        const Medicion& m = mediciones[i];
+        salida << "    {\"nombre\": \"" << m.nombre << "\", \"ns_por_op\": " << std::fixed << std::setprecision(3) << m.nsPorOp
+               << ", \"min_ns\": " << m.minNs << ", \"max_ns\": " << m.maxNs
+               << ", \"iteraciones\": " << m.iteraciones << ", \"repeticiones\": " << m.repeticiones << "}"
+               << (i + 1 < mediciones.size() ? "," : "") << "\n";
+    }
+    // "medida" y no "nombre": leerJSON() solo debe encontrar los tiempos.
+    salida << "  ],\n  \"memoria\": [\n";
+    for (size_t i = 0; i < memoria.size(); ++i) {
+        const MedidaMemoria& m = memoria[i];
+        salida << "    {\"medida\": \"" << m.nombre << "\", \"bytes\": " << m.bytes
+               << ", \"bytes_por_elemento\": " << std::fixed << std::setprecision(1)
+               << static_cast<double>(m.bytes) / static_cast<double>(m.elementos) << "}"
+               << (i + 1 < memoria.size() ? "," : "") << "\n";
+    }
+    salida << "  ]\n}\n";
+}
+
+/**
+ * @brief Lee un JSON producido por escribirJSON() (solo nombre y ns_por_op).
+ */
+static bool leerJSON(const std::string& archivo, std::map<std::string, double>& base) {
+    std::ifstream entrada(archivo);
+    if (!entrada) return false;
+    std::stringstream ss;
+    ss << entrada.rdbuf();
+    std::string texto = ss.str();
+
+    const std::string claveNombre = "\"nombre\": \"", claveValor = "\"ns_por_op\": ";
+    size_t pos = 0;
+    while ((pos = texto.find(claveNombre, pos)) != std::string::npos) {
+        pos += claveNombre.size();
+        size_t fin = texto.find('"', pos);
+        size_t valor = texto.find(claveValor, fin);
+        if (fin == std::string::npos || valor == std::string::npos) return false;
+        base[texto.substr(pos, fin - pos)] = std::strtod(texto.c_str() + valor + claveValor.size(), nullptr);
+        pos = valor;
+    }
+    return true;
+}
+
+static void uso() {
+    std::cerr << "Uso: benchmarks [--filtro TEXTO] [--repeticiones N] [--json ARCHIVO]\n"
+              << "                  [--comparar BASE.json] [--umbral PORCIENTO]\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string filtro, archivoJSON, archivoBase;
+    int repeticiones = 5;
+    double umbral = 10.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string opcion = argv[i];
+        if (i + 1 >= argc) { uso(); return 1; }
+        const char* valor = argv[++i];
+        if (opcion == "--filtro") filtro = valor;
+        else if (opcion == "--repeticiones") repeticiones = std::max(1, std::atoi(valor));
+        else if (opcion == "--json") archivoJSON = valor;
+        else if (opcion == "--comparar") archivoBase = valor;
+        else if (opcion == "--umbral") umbral = std::atof(valor);
+        else { uso(); return 1; }
+    }
+
+    std::map<std::string, double> base;
+    if (!archivoBase.empty() && !leerJSON(archivoBase, base)) {
+        std::cerr << "[ERROR] No se pudo leer la linea base " << archivoBase << ".\n";
+        return 1;
+    }
+
+    char plantilla[] = "/tmp/benchmarksXXXXXX";
+    const char* temporal = mkdtemp(plantilla);
+    if (!temporal) {
+        std::cerr << "[ERROR] No se pudo crear una carpeta temporal.\n";
+        return 1;
+    }
+
+    std::vector<Benchmark> pruebas;
+    for (auto grupo : {pruebasChat(), pruebasRegistro(), pruebasProtocolo(), pruebasTickets(temporal), pruebasRed(), pruebasCorrutinas()})
+        pruebas.insert(pruebas.end(), grupo.begin(), grupo.end());
+
+    std::vector<Medicion> mediciones;
+    std::cout << std::left << std::setw(44) << "prueba" << std::right << std::setw(14) << "ns/op"
+              << std::setw(14) << (base.empty() ? "min" : "base") << std::setw(10) << (base.empty() ? "" : "cambio") << "\n";
+
+    int regresiones = 0;
+    for (const Benchmark& b : pruebas) {
+        if (!filtro.empty() && b.nombre.find(filtro) == std::string::npos) continue;
+        Medicion m = medir(b, repeticiones);
+        mediciones.push_back(m);
+
+        std::cout << std::left << std::setw(44) << m.nombre << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << m.nsPorOp;
+        auto it = base.find(m.nombre);
+        if (base.empty()) {
+            std::cout << std::setw(14) << m.minNs;
+        } else if (it == base.end() || it->second <= 0) {
+            std::cout << std::setw(14) << "-" << std::setw(10) << "nueva";
+        } else {
+            double cambio = (m.nsPorOp - it->second) / it->second * 100.0;
+            std::cout << std::setw(14) << it->second << std::setw(9) << std::showpos << cambio << std::noshowpos << "%";
+            if (cambio > umbral) {
+                std::cout << "  REGRESION";
+                ++regresiones;
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    std::vector<MedidaMemoria> memoria = medirMemoria(filtro);
+    if (!memoria.empty()) {
+        std::cout << "\n" << std::left << std::setw(44) << "memoria" << std::right << std::setw(14) << "bytes"
+                  << std::setw(14) << "bytes/msg" << "\n";
+        for (const MedidaMemoria& m : memoria)
+            std::cout << std::left << std::setw(44) << m.nombre << std::right << std::setw(14) << m.bytes
+                      << std::fixed << std::setprecision(1) << std::setw(14)
+                      << static_cast<double>(m.bytes) / static_cast<double>(m.elementos) << "\n";
+    }
+
+    std::string limpiar = std::string("rm -rf '") + temporal + "'";
+    if (std::system(limpiar.c_str()) != 0) std::cerr << "[AVISO] No se pudo borrar " << temporal << ".\n";
+
+    if (!archivoJSON.empty()) {
+        std::ofstream salida(archivoJSON);
+        if (!salida) {
+            std::cerr << "[ERROR] No se pudo escribir " << archivoJSON << ".\n";
+            return 1;
+        }
+        escribirJSON(salida, mediciones, memoria);
+    }
+
+    if (regresiones > 0) {
+        std::cout << regresiones << " prueba(s) empeoraron mas de " << umbral << "%.\n";
+        return 2;
+    }
+    return 0;
+}
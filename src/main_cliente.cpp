@@ -7,18 +7,25 @@
  * @version 1.0
  * @date 06/01/2026
  * * Este archivo maneja la Interfaz Gráfica (SFML) para el usuario final.
- * * Implementa el protocolo de comunicación (/WAIT, /START) para bloquear
- * o desbloquear la interacción según la disponibilidad del agente.
+ * * Implementa el protocolo de comunicación (tramas WAIT, START) para bloquear
+ * o desbloquear la interacción según la disponibilidad del agente. Mientras
+ * espera, las tramas POSICION le dicen su lugar en la fila y cuánto le falta.
+ * * Uso: cliente [--prioritario]. Con --prioritario pide la clase PRIORITARIA;
+ * solo cambia algo si el servidor ordena la fila por plazos de servicio y
+ * tiene autorizada la IP de este cliente (--prioridad-ip).
  */
 
 #include "../include/clienteSocket.h"
 #include "../include/chat.h"
+#include "../include/renderChat.h"
+#include "../include/redibujo.h"
 #include <SFML/Graphics.hpp>
 #include <thread>
 #include <atomic> // Para manejar variables entre hilos de forma segura
 #include <iostream>
 #include <optional>
 #include <cstdint>
+#include <cstring>
 
 /**
  * @brief Bandera de estado compartida entre hilos (Thread-Safe).
@@ -28,35 +35,71 @@
  */
 std::atomic<bool> enEspera(true); 
 
+/**
+ * @brief Último lugar en la fila que avisó el servidor (0 = aún no llega ninguno).
+ */
+std::atomic<uint32_t> posicionFila(0);
+std::atomic<uint32_t> totalFila(0);
+std::atomic<int32_t> esperaEstimada(-1); ///< Segundos; -1 = el servidor aún no puede estimarla.
+
+/**
+ * @brief Despierta al bucle de la interfaz cuando el hilo de red cambia algo visible.
+ */
+SenalRedibujo senal;
+
 // ================= HILO DE RED =================
 /**
  * @brief Función del Hilo Secundario: Escucha al servidor.
- * * Se encarga de recibir mensajes y decidir si son TEXTO para el chat
- * o COMANDOS para cambiar el estado de la aplicación.
+ * * Se encarga de recibir tramas y decidir, según su tipo, si son TEXTO para
+ * el chat o COMANDOS para cambiar el estado de la aplicación.
  */
 void hiloRedCliente(ClienteSocket* cliente, Chat* manager) {
-    while (true) {
-        // Bloqueante: Espera a que llegue algo del servidor
-        std::string mensaje = cliente->recibir();
-        
-        if (mensaje.empty()) continue; // Si hay error o vacío, reintentamos
+    Trama trama;
 
+    // Bloqueante: Espera a que llegue algo del servidor. false = conexión perdida.
+    while (cliente->recibir(trama)) {
         // --- DETECTAR COMANDOS DEL PROTOCOLO ---
-        if (mensaje == "/WAIT") {
-            // El servidor nos dice que esperemos. Bloqueamos la UI.
-            enEspera = true; 
-            std::cout << "[SISTEMA] Puesto en cola de espera.\n";
-        }
-        else if (mensaje == "/START") {
-            // El servidor nos dice que es nuestro turno. Desbloqueamos la UI.
-            enEspera = false;
-            std::cout << "[SISTEMA] Agente conectado. Iniciando chat.\n";
-        }
-        else {
-            // Si no es comando, es un mensaje de texto normal del Agente.
-            manager->agregarMensaje("Soporte", mensaje, false);
+        switch (trama.tipo) {
+            case TipoTrama::WAIT:
+                // El servidor nos dice que esperemos. Bloqueamos la UI.
+                enEspera = true;
+                senal.marcar();
+                std::cout << "[SISTEMA] Puesto en cola de espera.\n";
+                break;
+            case TipoTrama::START:
+                // El servidor nos dice que es nuestro turno. Desbloqueamos la UI.
+                enEspera = false;
+                senal.marcar();
+                std::cout << "[SISTEMA] Agente conectado. Iniciando chat.\n";
+                break;
+            case TipoTrama::POSICION: {
+                // Lugar en la fila: solo se refleja en el overlay.
+                AvisoPosicion aviso;
+                if (decodificarPosicion(trama.datos, aviso)) {
+                    posicionFila = aviso.posicion;
+                    totalFila = aviso.enCola;
+                    esperaEstimada = aviso.segundos;
+                    senal.marcar();
+                }
+                break;
+            }
+            case TipoTrama::PING:
+                // Keepalive: el servidor quiere saber si seguimos vivos.
+                cliente->enviarTrama(TipoTrama::PONG, "");
+                break;
+            case TipoTrama::MENSAJE:
+                // Mensaje de texto normal del Agente.
+                manager->agregarMensaje("Soporte", trama.datos, false);
+                senal.marcar();
+                break;
+            default:
+                break;
         }
     }
+
+    std::cout << "[SISTEMA] Se perdio la conexion con el servidor.\n";
+    manager->agregarMensaje("Sistema", "Conexion con el servidor perdida.", false);
+    senal.marcar();
 }
 
 // ================= MAIN =================
@@ -64,7 +107,8 @@ void hiloRedCliente(ClienteSocket* cliente, Chat* manager) {
  * @brief Hilo Principal (UI Thread).
  * * Dibuja la ventana, maneja el input del usuario y renderiza el overlay de bloqueo.
  */
-int main() {
+int main(int argc, char* argv[]) {
+    bool prioritario = argc > 1 && std::strcmp(argv[1], "--prioritario") == 0;
     ClienteSocket cliente;
     Chat miChat;
 
@@ -74,6 +118,8 @@ int main() {
         std::cerr << "Error: No se pudo conectar al servidor.\n";
         return -1;
     }
+    if (prioritario)
+        cliente.enviarTrama(TipoTrama::CLASE, std::string(1, static_cast<char>(ClaseServicio::PRIORITARIA)));
 
     // 2. Iniciar el hilo de escucha en background
     // Usamos detach() para que corra libremente sin bloquear la ventana.
@@ -105,11 +151,26 @@ int main() {
 
     std::string inputTexto;
 
+    // Caché de burbujas: Cliente (Der/Verde WhatsApp) vs Soporte (Izq/Blanco)
+    EstiloBurbujas estilo;
+    estilo.padding = 12.f;
+    estilo.separacion = 10.f;
+    estilo.anchoVentana = static_cast<float>(window.getSize().x);
+    estilo.fondoMio = sf::Color(37, 211, 102);
+    LayoutChat layout(font, estilo, miChat);
+
     // ================= BUCLE PRINCIPAL (Game Loop) =================
+    // Solo se redibuja cuando algo cambió; el resto del tiempo el hilo duerme en 'senal'.
+    bool hayCambios = true;
+    uint64_t versionDibujada = miChat.obtenerVersion();
+
     while (window.isOpen()) {
         while (auto event = window.pollEvent()) {
             if (event->is<sf::Event::Closed>()) window.close();
 
+            // Mover el ratón no cambia nada en pantalla; cualquier otro evento sí puede.
+            if (!event->is<sf::Event::MouseMoved>()) hayCambios = true;
+
             // Scroll manual (Siempre permitido para leer historial)
             if (const auto* mouseWheel = event->getIf<sf::Event::MouseWheelScrolled>()) {
                 if (mouseWheel->wheel == sf::Mouse::Wheel::Vertical) {
@@ -127,8 +188,14 @@ int main() {
                     if (unicode == '\n' || unicode == '\r') {
                         if (!inputTexto.empty()) {
                             // Enviar al servidor y mostrar en pantalla propia
-                            cliente.enviar(inputTexto.c_str());
-                            miChat.agregarMensaje("Yo", inputTexto, true);
+                            // No bloquea: si el servidor no lee al ritmo, el mensaje espera en el buffer.
+                            EstadoEnvio estadoEnvio = cliente.enviar(inputTexto.c_str());
+                            if (estadoEnvio == EstadoEnvio::SATURADO)
+                                std::cout << "[AVISO] La red va lenta; los mensajes salen en cuanto se pueda.\n";
+                            if (estadoEnvio == EstadoEnvio::DEMASIADO_GRANDE)
+                                std::cout << "[AVISO] El mensaje es demasiado largo; no se envio.\n";
+                            else
+                                miChat.agregarMensaje("Yo", inputTexto, true);
                             inputTexto.clear();
                             currentScrollY = maxScrollY; // Auto-scroll al fondo
                         }
@@ -143,45 +210,36 @@ int main() {
             }
         }
 
+        // --- ¿HAY QUE DIBUJAR? ---
+        if (senal.tomar()) hayCambios = true;
+        if (miChat.obtenerVersion() != versionDibujada) hayCambios = true;
+        if (!hayCambios) {
+            // Nada cambió: dormimos hasta que la red avise o toque revisar la ventana.
+            senal.esperar(ESPERA_EVENTOS_UI);
+            continue;
+        }
+        hayCambios = false;
+        versionDibujada = miChat.obtenerVersion();
+        float scrollAntes = currentScrollY;
+
         window.clear(sf::Color(240, 242, 245)); // Fondo gris suave (Estilo App Moderna)
 
         // 1. --- DIBUJAR MENSAJES (Capa con movimiento) ---
         viewChat.setCenter({225, 350 + currentScrollY});
         window.setView(viewChat);
 
-        float y = 90.f;
-        for (const auto& m : miChat.obtenerHistorial()) {
-            sf::Text msg(font, m.texto, 16);
-            msg.setFillColor(m.esMio ? sf::Color::White : sf::Color(30, 30, 30));
-
-            sf::FloatRect bounds = msg.getLocalBounds();
-            sf::RectangleShape burbuja;
-            float padding = 12.f;
-            burbuja.setSize({bounds.size.x + (padding * 2), bounds.size.y + (padding * 2)});
-            
-            if (m.esMio) { // Cliente (Verde WhatsApp)
-                float xPos = window.getSize().x - burbuja.getSize().x - 20.f;
-                burbuja.setPosition({xPos, y});
-                burbuja.setFillColor(sf::Color(37, 211, 102));
-                msg.setPosition({xPos + padding, y + padding - 4.f});
-            } else { // Soporte (Blanco)
-                burbuja.setPosition({20.f, y});
-                burbuja.setFillColor(sf::Color::White);
-                burbuja.setOutlineColor(sf::Color(200, 200, 200));
-                burbuja.setOutlineThickness(1.f);
-                msg.setPosition({20.f + padding, y + padding - 4.f});
-            }
-
-            window.draw(burbuja);
-            window.draw(msg);
-            y += burbuja.getSize().y + 10.f;
-        }
+        // Solo se miden los mensajes nuevos y solo se dibujan las burbujas visibles.
+        layout.sincronizar(miChat);
+        layout.dibujar(window, currentScrollY, 700.f);
+        float y = layout.alturaTotal();
 
         // Lógica de límite de scroll
         maxScrollY = (y > 600.f) ? (y - 600.f) : 0;
         if (currentScrollY < maxScrollY && currentScrollY > maxScrollY - 60.f) {
             currentScrollY = maxScrollY;
         }
+        // El auto-scroll movió la cámara: hace falta otro frame para mostrarlo.
+        if (currentScrollY != scrollAntes) hayCambios = true;
 
         // 2. --- DIBUJAR UI FIJA (Header y Footer) ---
         window.setView(window.getDefaultView()); // Restaurar vista estática
@@ -226,12 +284,30 @@ int main() {
             txtEspera.setFillColor(sf::Color::White);
             window.draw(txtEspera);
 
-            sf::Text subEspera(font, "Por favor espera tu turno...", 16);
+            // Con el aviso del servidor se muestra el lugar en la fila; mientras no llegue, el texto genérico.
+            std::string textoSub = "Por favor espera tu turno...";
+            uint32_t lugar = posicionFila;
+            if (lugar > 0) {
+                textoSub = "Tu lugar en la fila: " + std::to_string(lugar) + " de " + std::to_string(totalFila.load());
+            }
+            sf::Text subEspera(font, textoSub, 16);
             sf::FloatRect subBounds = subEspera.getLocalBounds();
             subEspera.setOrigin({subBounds.size.x / 2.f, subBounds.size.y / 2.f});
             subEspera.setPosition({225.f, 340.f});
             subEspera.setFillColor(sf::Color(200, 200, 200));
             window.draw(subEspera);
+
+            int32_t segundos = esperaEstimada;
+            if (lugar > 0 && segundos >= 0) {
+                std::string textoEta = segundos < 60 ? "Tiempo estimado: menos de 1 min"
+                                                     : "Tiempo estimado: ~" + std::to_string((segundos + 30) / 60) + " min";
+                sf::Text txtEta(font, textoEta, 16);
+                sf::FloatRect etaBounds = txtEta.getLocalBounds();
+                txtEta.setOrigin({etaBounds.size.x / 2.f, etaBounds.size.y / 2.f});
+                txtEta.setPosition({225.f, 370.f});
+                txtEta.setFillColor(sf::Color(200, 200, 200));
+                window.draw(txtEta);
+            }
         }
 
         window.display();
@@ -0,0 +1,614 @@
+/**
+ * @file main_loadgen.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Generador de carga: miles de clientes simulados contra el servidor.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Cada sesión se comporta como el cliente gráfico: se conecta, espera la
+ * trama WAIT (está en cola), luego START (la atiende el agente) y entonces
+ * manda mensajes, esperando cada respuesta antes de "pensar" y mandar el
+ * siguiente. Al terminar cuelga, lo que cierra el ticket en el servidor.
+ * Pensado para correr contra 'servidor_headless --eco'.
+ *
+ * Métricas (histogramas en microsegundos, reportados en ms):
+ *   aceptacion   connect() -> primera trama del servidor (WAIT).
+ *   en cola      WAIT -> START.
+ *   hasta START  connect() -> START.
+ *   cola <clase> en cola, separado por clase de servicio (solo con --prioritarios).
+ *   ida/vuelta   MENSAJE enviado -> respuesta del agente.
+ * También se cuentan los avisos: MENSAJE que llegan sin haber preguntado
+ * nada (p. ej. difundidos a la cola), y las tramas POSICION de la fila.
+ *
+ * Las llegadas siguen un horario fijo (tasa por segundo); cada hilo maneja
+ * sus sesiones con un epoll propio y un montículo de temporizadores.
+ *
+ * Uso: chat_loadgen [opciones]
+ *   --ip <ip>              Servidor (127.0.0.1).
+ *   --puerto <n>           Puerto (8080).
+ *   --clientes <n>         Sesiones a simular (1000).
+ *   --tasa <n>             Llegadas por segundo; 0 = todas de golpe (200).
+ *   --mensajes <n>         Mensajes por sesión (3).
+ *   --tam <bytes>          Tamaño de cada mensaje (64).
+ *   --pensar <ms>          Pausa entre respuesta y siguiente mensaje (0).
+ *   --hilos <n>            Hilos del generador (1).
+ *   --duracion <s>         Límite de tiempo de la corrida (120).
+ *   --transporte <t>       tcp | memoria (tcp). Con memoria las sesiones negocian
+ *                          la memoria compartida del servidor local (se ignora --ip).
+ *   --prioritarios <p>     Porcentaje de sesiones que, al recibir WAIT, piden la
+ *                          clase PRIORITARIA (0). Solo cambia algo con 'servidor_headless --fila sla
+ *                          --prioridad-ip <ip del generador>'.
+ */
+
+#include "../include/protocolo.h"
+#include "../include/histograma.h"
+#include "../include/canalMemoria.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <cstddef>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+using Reloj = std::chrono::steady_clock;
+
+/// Espacio libre mínimo que se pide al buffer antes de cada recv().
+static const size_t TAM_LECTURA = 4096;
+
+/// En data.u64 del epoll: el evento es del timbre de la sesión, no de su socket.
+static const uint64_t BIT_TIMBRE = 1ull << 63;
+
+/**
+ * @struct ConfigCarga
+ * @brief Parámetros de la corrida.
+ */
+struct ConfigCarga {
+    std::string ip = "127.0.0.1";
+    int puerto = 8080;
+    int clientes = 1000;
+    double tasa = 200;
+    int mensajes = 3;
+    size_t tam = 64;
+    int pensarMs = 0;
+    int hilos = 1;
+    int duracionS = 120;
+    bool memoria = false;   ///< --transporte memoria.
+    int prioritarios = 0;   ///< % de sesiones PRIORITARIA.
+};
+
+/**
+ * @enum EstadoSesion
+ * @brief Momento de la vida de un cliente simulado.
+ */
+enum class EstadoSesion {
+    PROGRAMADA,  ///< Aún no toca conectarse.
+    CONECTANDO,  ///< connect() en curso (o, por memoria, esperando la oferta).
+    CONECTADA,   ///< Conectada, sin noticias del servidor.
+    EN_COLA,     ///< Recibió WAIT.
+    ESPERANDO,   ///< Atendida, mensaje enviado y esperando respuesta.
+    PENSANDO,    ///< Atendida, entre una respuesta y el siguiente mensaje.
+    TERMINADA,   ///< Hizo todo y colgó.
+    FALLIDA      ///< Error de conexión o de protocolo, o cierre del servidor.
+};
+
+/**
+ * @struct Sesion
+ * @brief Un cliente simulado.
+ */
+struct Sesion {
+    int fd = -1;
+    EstadoSesion estado = EstadoSesion::PROGRAMADA;
+    ClaseServicio clase = ClaseServicio::NORMAL;
+    Reloj::time_point llegada;   ///< Momento programado de llegada.
+    Reloj::time_point conexion;  ///< Momento del connect().
+    Reloj::time_point espera;    ///< Momento del WAIT.
+    Reloj::time_point envio;     ///< Momento del último MENSAJE enviado.
+    int enviados = 0;
+    bool recibioAlgo = false;
+
+    BufferLectura entrada{512};
+    DecodificadorTramas decodificador;
+    uint32_t secuenciaSalida = 0;
+    std::string salida;          ///< Bytes que el Kernel (o el anillo) aún no aceptó.
+    std::unique_ptr<CanalMemoria> canal; ///< Solo con --transporte memoria.
+};
+
+/**
+ * @struct Metricas
+ * @brief Lo que mide cada hilo (se combinan al final).
+ */
+struct Metricas {
+    Histograma aceptacion, enCola, hastaStart, idaVuelta;
+    Histograma enColaPorClase[NUM_CLASES];  ///< 'enCola' separado por clase de servicio.
+    uint64_t completadas = 0;
+    uint64_t fallidasConexion = 0;
+    uint64_t fallidasCierre = 0;
+    uint64_t fallidasProtocolo = 0;
+    uint64_t sinTerminar = 0;
+    uint64_t avisos = 0;          ///< MENSAJE recibidos sin haber preguntado nada.
+    uint64_t posiciones = 0;      ///< Tramas POSICION (lugar en la fila) recibidas.
+
+    void combinar(const Metricas& otra) {
+        aceptacion.combinar(otra.aceptacion);
+        enCola.combinar(otra.enCola);
+        hastaStart.combinar(otra.hastaStart);
+        idaVuelta.combinar(otra.idaVuelta);
+        for (size_t k = 0; k < NUM_CLASES; ++k) enColaPorClase[k].combinar(otra.enColaPorClase[k]);
+        completadas += otra.completadas;
+        fallidasConexion += otra.fallidasConexion;
+        fallidasCierre += otra.fallidasCierre;
+        fallidasProtocolo += otra.fallidasProtocolo;
+        sinTerminar += otra.sinTerminar;
+        avisos += otra.avisos;
+        posiciones += otra.posiciones;
+    }
+};
+
+static uint64_t microsDesde(Reloj::time_point desde, Reloj::time_point hasta) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(hasta - desde).count();
+    return us > 0 ? static_cast<uint64_t>(us) : 0;
+}
+
+/**
+ * @class Generador
+ * @brief Un hilo del generador: sus sesiones, su epoll y sus temporizadores.
+ */
+class Generador {
+private:
+    using Evento = std::pair<Reloj::time_point, size_t>; ///< (cuándo, índice de sesión)
+
+    const ConfigCarga& config;
+    sockaddr_in destino;
+    sockaddr_un local;   ///< Socket Unix abstracto del servidor (--transporte memoria).
+    socklen_t largoLocal;
+    std::string texto;   ///< Carga de cada MENSAJE.
+    int epollFd;
+    std::vector<Sesion> sesiones;
+    std::priority_queue<Evento, std::vector<Evento>, std::greater<Evento>> temporizadores;
+    size_t vivas;        ///< Sesiones que aún no terminan ni fallan.
+
+    void conectar(size_t i, Reloj::time_point ahora) {
+        if (config.memoria) { conectarLocal(i, ahora); return; }
+        Sesion& s = sesiones[i];
+        s.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (s.fd < 0) { fallar(i, metricas.fallidasConexion); return; }
+
+        int uno = 1;
+        setsockopt(s.fd, IPPROTO_TCP, TCP_NODELAY, &uno, sizeof(uno));
+        s.conexion = ahora;
+        if (connect(s.fd, reinterpret_cast<const sockaddr*>(&destino), sizeof(destino)) < 0 && errno != EINPROGRESS) {
+            fallar(i, metricas.fallidasConexion);
+            return;
+        }
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+        ev.data.u64 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, s.fd, &ev);
+        s.estado = EstadoSesion::CONECTANDO;
+    }
+
+    /**
+     * @brief Por memoria: el connect() Unix es inmediato y la oferta llega como EPOLLIN.
+     */
+    void conectarLocal(size_t i, Reloj::time_point ahora) {
+        Sesion& s = sesiones[i];
+        s.fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (s.fd < 0) { fallar(i, metricas.fallidasConexion); return; }
+
+        s.conexion = ahora;
+        if (connect(s.fd, reinterpret_cast<const sockaddr*>(&local), largoLocal) < 0) {
+            fallar(i, metricas.fallidasConexion);
+            return;
+        }
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, s.fd, &ev);
+        s.estado = EstadoSesion::CONECTANDO;
+    }
+
+    /**
+     * @brief Llegó la oferta del servidor: se mapea la memoria y se vigila el timbre.
+     */
+    void aceptarOferta(size_t i, Reloj::time_point ahora) {
+        Sesion& s = sesiones[i];
+        s.canal = CanalMemoria::aceptarOferta(s.fd);
+        if (!s.canal) { fallar(i, metricas.fallidasConexion); return; }
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = i | BIT_TIMBRE;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, s.canal->timbre(), &ev);
+        s.estado = EstadoSesion::CONECTADA;
+        atenderTimbre(i, ahora); // El WAIT pudo llegar junto con la oferta.
+    }
+
+    /**
+     * @brief Timbre de la sesión: tramas en el anillo o lugar para lo pendiente.
+     */
+    void atenderTimbre(size_t i, Reloj::time_point ahora) {
+        Sesion& s = sesiones[i];
+        if (s.fd < 0 || !s.canal) return;
+        s.canal->apagarTimbre();
+        if (!s.salida.empty()) vaciarSalida(i);
+
+        do {
+            long n = s.canal->leerEn(s.entrada);
+            if (n < 0) { fallar(i, metricas.fallidasProtocolo); return; }
+            if (n > 0 && !procesarEntrada(i, ahora)) return;
+        } while (s.fd >= 0 && !s.canal->prepararEspera());
+    }
+
+    /**
+     * @brief Despacha las tramas completas de 'entrada'. false si la sesión ya no sigue.
+     */
+    bool procesarEntrada(size_t i, Reloj::time_point ahora) {
+        Sesion& s = sesiones[i];
+        VistaTrama trama;
+        ResultadoDecodificacion r;
+        while (s.fd >= 0 && (r = s.decodificador.siguiente(s.entrada, trama)) == ResultadoDecodificacion::TRAMA)
+            procesarTrama(i, trama, ahora);
+        if (s.fd >= 0 && r == ResultadoDecodificacion::ERROR) fallar(i, metricas.fallidasProtocolo);
+        return s.fd >= 0;
+    }
+
+    void cerrar(Sesion& s, EstadoSesion final) {
+        if (s.fd >= 0) ::close(s.fd); // close() también lo retira del epoll.
+        s.fd = -1;
+        s.canal.reset();              // Cierra los timbres (y los retira del epoll).
+        s.estado = final;
+        --vivas;
+    }
+
+    void fallar(size_t i, uint64_t& contador) {
+        ++contador;
+        cerrar(sesiones[i], EstadoSesion::FALLIDA);
+    }
+
+    /**
+     * @brief Codifica una trama y la manda (lo que no quepa se manda con EPOLLOUT).
+     */
+    void enviarTrama(size_t i, TipoTrama tipo, std::string_view datos) {
+        Sesion& s = sesiones[i];
+        bool habiaPendiente = !s.salida.empty();
+        codificarTrama(s.salida, tipo, s.secuenciaSalida++, datos);
+        if (!habiaPendiente) vaciarSalida(i);
+    }
+
+    void vaciarSalida(size_t i) {
+        Sesion& s = sesiones[i];
+        if (s.canal) {
+            // Anillo lleno: el servidor toca el timbre cuando lea.
+            while (!s.salida.empty()) {
+                s.salida.erase(0, s.canal->escribir(s.salida.data(), s.salida.size()));
+                if (s.salida.empty() || s.canal->esperarLugar()) break;
+            }
+            return;
+        }
+        while (!s.salida.empty()) {
+            ssize_t n = send(s.fd, s.salida.data(), s.salida.size(), MSG_NOSIGNAL);
+            if (n > 0) { s.salida.erase(0, static_cast<size_t>(n)); continue; }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            fallar(i, metricas.fallidasCierre);
+            return;
+        }
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP | (s.salida.empty() ? 0u : static_cast<uint32_t>(EPOLLOUT));
+        ev.data.u64 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, s.fd, &ev);
+    }
+
+    void enviarMensaje(size_t i, Reloj::time_point ahora) {
+        Sesion& s = sesiones[i];
+        s.estado = EstadoSesion::ESPERANDO;
+        s.envio = ahora;
+        enviarTrama(i, TipoTrama::MENSAJE, texto);
+    }
+
+    void procesarTrama(size_t i, const VistaTrama& trama, Reloj::time_point ahora) {
+        Sesion& s = sesiones[i];
+        if (!s.recibioAlgo) {
+            s.recibioAlgo = true;
+            metricas.aceptacion.registrar(microsDesde(s.conexion, ahora));
+            s.espera = ahora;
+        }
+
+        switch (trama.tipo) {
+            case TipoTrama::WAIT:
+                s.estado = EstadoSesion::EN_COLA;
+                s.espera = ahora;
+                if (s.clase != ClaseServicio::NORMAL)
+                    enviarTrama(i, TipoTrama::CLASE, std::string(1, static_cast<char>(s.clase)));
+                break;
+
+            case TipoTrama::START:
+                metricas.enCola.registrar(microsDesde(s.espera, ahora));
+                metricas.enColaPorClase[static_cast<size_t>(s.clase)].registrar(microsDesde(s.espera, ahora));
+                metricas.hastaStart.registrar(microsDesde(s.conexion, ahora));
+                if (config.mensajes > 0) {
+                    enviarMensaje(i, ahora);
+                } else {
+                    ++metricas.completadas;
+                    cerrar(s, EstadoSesion::TERMINADA);
+                }
+                break;
+
+            case TipoTrama::MENSAJE:
+                if (s.estado != EstadoSesion::ESPERANDO) { ++metricas.avisos; break; } // Aviso o mensaje espontáneo.
+                metricas.idaVuelta.registrar(microsDesde(s.envio, ahora));
+                if (++s.enviados >= config.mensajes) {
+                    ++metricas.completadas;
+                    cerrar(s, EstadoSesion::TERMINADA);
+                } else if (config.pensarMs > 0) {
+                    s.estado = EstadoSesion::PENSANDO;
+                    temporizadores.push({ahora + std::chrono::milliseconds(config.pensarMs), i});
+                } else {
+                    enviarMensaje(i, ahora);
+                }
+                break;
+
+            case TipoTrama::PING:
+                enviarTrama(i, TipoTrama::PONG, {});
+                break;
+
+            case TipoTrama::POSICION:
+                ++metricas.posiciones;
+                break;
+
+            case TipoTrama::PONG:
+            case TipoTrama::CLASE: // Solo va del cliente al servidor.
+                break;
+        }
+    }
+
+    void atender(size_t i, uint32_t eventos) {
+        Sesion& s = sesiones[i];
+        if (s.fd < 0) return;
+        Reloj::time_point ahora = Reloj::now();
+
+        if (s.canal) {
+            // Por el socket Unix no llegan tramas: cualquier evento es que el servidor colgó.
+            fallar(i, metricas.fallidasCierre);
+            return;
+        }
+        if (config.memoria) {
+            if (eventos & EPOLLIN) aceptarOferta(i, ahora);
+            else fallar(i, metricas.fallidasConexion);
+            return;
+        }
+
+        if (s.estado == EstadoSesion::CONECTANDO) {
+            int error = 0;
+            socklen_t largo = sizeof(error);
+            getsockopt(s.fd, SOL_SOCKET, SO_ERROR, &error, &largo);
+            if (error != 0) { fallar(i, metricas.fallidasConexion); return; }
+            if (!(eventos & (EPOLLOUT | EPOLLIN))) return;
+            s.estado = EstadoSesion::CONECTADA;
+            vaciarSalida(i); // Deja de pedir EPOLLOUT.
+            if (s.fd < 0) return;
+        } else if ((eventos & EPOLLOUT) && !s.salida.empty()) {
+            vaciarSalida(i);
+            if (s.fd < 0) return;
+        }
+
+        if (!(eventos & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) return;
+
+        while (s.fd >= 0) {
+            char* hueco = s.entrada.reservar(TAM_LECTURA);
+            ssize_t n = recv(s.fd, hueco, s.entrada.espacioLibre(), 0);
+            if (n > 0) {
+                s.entrada.confirmar(static_cast<size_t>(n));
+                if (!procesarEntrada(i, ahora)) return;
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            fallar(i, metricas.fallidasCierre); // El servidor colgó (n == 0) o error.
+            return;
+        }
+    }
+
+public:
+    Metricas metricas;
+
+    Generador(const ConfigCarga& cfg, const sockaddr_in& direccion)
+        : config(cfg), destino(direccion), local{}, texto(cfg.tam, 'x'), epollFd(-1), vivas(0) {
+        local.sun_family = AF_UNIX;
+        std::string nombre = CanalMemoria::nombreLocal(cfg.puerto);
+        std::memcpy(local.sun_path, nombre.data(), nombre.size());
+        largoLocal = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + nombre.size());
+
+        // Texto legible, como lo escribiría una persona.
+        static const char relleno[] = "Hola, tengo un problema con mi pedido. ";
+        for (size_t k = 0; k < texto.size(); ++k) texto[k] = relleno[k % (sizeof(relleno) - 1)];
+    }
+
+    /**
+     * @brief Agrega una sesión que debe conectarse en 'llegada'.
+     */
+    void programar(Reloj::time_point llegada, ClaseServicio clase) {
+        sesiones.emplace_back();
+        sesiones.back().llegada = llegada;
+        sesiones.back().clase = clase;
+        temporizadores.push({llegada, sesiones.size() - 1});
+        ++vivas;
+    }
+
+    void correr(Reloj::time_point limite) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) return;
+        std::vector<epoll_event> eventos(256);
+
+        while (vivas > 0) {
+            Reloj::time_point ahora = Reloj::now();
+            if (ahora >= limite) break;
+
+            // Temporizadores vencidos: llegadas y fin de "pensar".
+            while (!temporizadores.empty() && temporizadores.top().first <= ahora) {
+                size_t i = temporizadores.top().second;
+                temporizadores.pop();
+                if (sesiones[i].estado == EstadoSesion::PROGRAMADA) conectar(i, ahora);
+                else if (sesiones[i].estado == EstadoSesion::PENSANDO) enviarMensaje(i, ahora);
+            }
+
+            Reloj::time_point siguiente = temporizadores.empty() ? limite : std::min(limite, temporizadores.top().first);
+            auto espera = std::chrono::duration_cast<std::chrono::milliseconds>(siguiente - Reloj::now()).count();
+            int n = epoll_wait(epollFd, eventos.data(), static_cast<int>(eventos.size()),
+                               static_cast<int>(std::max<long long>(0, std::min<long long>(espera + 1, 1000))));
+            for (int k = 0; k < n; ++k) {
+                uint64_t dato = eventos[k].data.u64;
+                if (dato & BIT_TIMBRE) atenderTimbre(static_cast<size_t>(dato & ~BIT_TIMBRE), Reloj::now());
+                else atender(static_cast<size_t>(dato), eventos[k].events);
+            }
+        }
+
+        for (Sesion& s : sesiones) {
+            if (s.estado == EstadoSesion::TERMINADA || s.estado == EstadoSesion::FALLIDA) continue;
+            ++metricas.sinTerminar;
+            if (s.fd >= 0) ::close(s.fd);
+            s.fd = -1;
+            s.canal.reset();
+        }
+        ::close(epollFd);
+    }
+};
+
+static void uso() {
+    std::cerr << "Uso: chat_loadgen [--ip IP] [--puerto N] [--clientes N] [--tasa N] [--mensajes N]\n"
+              << "                    [--tam BYTES] [--pensar MS] [--hilos N] [--duracion S]\n"
+              << "                    [--transporte tcp|memoria] [--prioritarios P]\n";
+}
+
+static void imprimirFila(const char* nombre, const Histograma& h) {
+    auto ms = [](uint64_t us) { return static_cast<double>(us) / 1000.0; };
+    std::cout << std::left << std::setw(14) << nombre << std::right
+              << std::setw(9) << h.cantidad() << std::fixed << std::setprecision(3)
+              << std::setw(11) << h.media() / 1000.0
+              << std::setw(11) << ms(h.percentil(50))
+              << std::setw(11) << ms(h.percentil(90))
+              << std::setw(11) << ms(h.percentil(99))
+              << std::setw(11) << ms(h.percentil(99.9))
+              << std::setw(11) << ms(h.maximoValor()) << "\n";
+}
+
+/**
+ * @brief Miles de sockets superan el límite típico de 1024 descriptores.
+ */
+static void subirLimiteDescriptores(size_t necesarios) {
+    rlimit limite;
+    if (getrlimit(RLIMIT_NOFILE, &limite) != 0) return;
+    if (limite.rlim_cur >= necesarios) return;
+    limite.rlim_cur = std::min<rlim_t>(limite.rlim_max, necesarios);
+    setrlimit(RLIMIT_NOFILE, &limite);
+    if (limite.rlim_cur < necesarios)
+        std::cerr << "[AVISO] El limite de descriptores (" << limite.rlim_cur << ") es menor que los clientes.\n";
+}
+
+int main(int argc, char* argv[]) {
+    ConfigCarga config;
+    for (int i = 1; i < argc; ++i) {
+        std::string opcion = argv[i];
+        if (i + 1 >= argc) { uso(); return 1; }
+        const char* valor = argv[++i];
+        if (opcion == "--ip") config.ip = valor;
+        else if (opcion == "--puerto") config.puerto = std::atoi(valor);
+        else if (opcion == "--clientes") config.clientes = std::atoi(valor);
+        else if (opcion == "--tasa") config.tasa = std::atof(valor);
+        else if (opcion == "--mensajes") config.mensajes = std::atoi(valor);
+        else if (opcion == "--tam") config.tam = static_cast<size_t>(std::atol(valor));
+        else if (opcion == "--pensar") config.pensarMs = std::atoi(valor);
+        else if (opcion == "--hilos") config.hilos = std::max(1, std::atoi(valor));
+        else if (opcion == "--duracion") config.duracionS = std::atoi(valor);
+        else if (opcion == "--transporte" && std::strcmp(valor, "tcp") == 0) config.memoria = false;
+        else if (opcion == "--transporte" && std::strcmp(valor, "memoria") == 0) config.memoria = true;
+        else if (opcion == "--prioritarios") config.prioritarios = std::atoi(valor);
+        else { uso(); return 1; }
+    }
+    if (config.clientes <= 0 || config.tam > MAX_CARGA || config.prioritarios < 0 || config.prioritarios > 100) {
+        uso();
+        return 1;
+    }
+
+    sockaddr_in destino{};
+    destino.sin_family = AF_INET;
+    destino.sin_port = htons(static_cast<uint16_t>(config.puerto));
+    if (inet_pton(AF_INET, config.ip.c_str(), &destino.sin_addr) <= 0) {
+        std::cerr << "IP Invalida del servidor\n";
+        return 1;
+    }
+    subirLimiteDescriptores(static_cast<size_t>(config.clientes) + 64);
+
+    // Horario de llegadas: la sesión k llega en inicio + k/tasa y le toca al hilo k % hilos.
+    std::vector<Generador> generadores;
+    generadores.reserve(config.hilos);
+    for (int h = 0; h < config.hilos; ++h) generadores.emplace_back(config, destino);
+
+    Reloj::time_point inicio = Reloj::now();
+    for (int k = 0; k < config.clientes; ++k) {
+        auto desfase = config.tasa > 0 ? std::chrono::duration_cast<Reloj::duration>(std::chrono::duration<double>(k / config.tasa))
+                                       : Reloj::duration::zero();
+        // Los prioritarios quedan repartidos a lo largo de la corrida, no todos al principio.
+        ClaseServicio clase = (k * 37) % 100 < config.prioritarios ? ClaseServicio::PRIORITARIA : ClaseServicio::NORMAL;
+        generadores[k % config.hilos].programar(inicio + desfase, clase);
+    }
+
+    std::cout << "chat_loadgen: " << config.clientes << " sesiones, " << config.mensajes << " mensajes de "
+              << config.tam << " B, tasa " << config.tasa << "/s, pensar " << config.pensarMs << " ms, "
+              << config.hilos << " hilo(s), " << (config.memoria ? "memoria compartida" : "tcp")
+              << ", " << config.prioritarios << "% prioritarios\n";
+
+    Reloj::time_point limite = inicio + std::chrono::seconds(config.duracionS);
+    std::vector<std::thread> hilos;
+    for (Generador& g : generadores) hilos.emplace_back([&g, limite] { g.correr(limite); });
+    for (std::thread& h : hilos) h.join();
+    double segundos = std::chrono::duration<double>(Reloj::now() - inicio).count();
+
+    Metricas total;
+    for (const Generador& g : generadores) total.combinar(g.metricas);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "completadas " << total.completadas
+              << "  fallidas " << (total.fallidasConexion + total.fallidasCierre + total.fallidasProtocolo)
+              << " (conexion " << total.fallidasConexion << ", cierre " << total.fallidasCierre
+              << ", protocolo " << total.fallidasProtocolo << ")"
+              << "  sin terminar " << total.sinTerminar << "  avisos " << total.avisos
+              << "  posiciones " << total.posiciones << "\n"
+              << "duracion " << segundos << " s  sesiones/s " << total.completadas / segundos
+              << "  mensajes/s " << total.idaVuelta.cantidad() / segundos << "\n\n";
+
+    std::cout << std::left << std::setw(14) << "metrica (ms)" << std::right
+              << std::setw(9) << "n" << std::setw(11) << "media" << std::setw(11) << "p50"
+              << std::setw(11) << "p90" << std::setw(11) << "p99" << std::setw(11) << "p99.9"
+              << std::setw(11) << "max" << "\n";
+    imprimirFila("aceptacion", total.aceptacion);
+    imprimirFila("en cola", total.enCola);
+    imprimirFila("hasta START", total.hastaStart);
+    if (config.prioritarios > 0) {
+        imprimirFila("cola normal", total.enColaPorClase[static_cast<size_t>(ClaseServicio::NORMAL)]);
+        imprimirFila("cola priorit.", total.enColaPorClase[static_cast<size_t>(ClaseServicio::PRIORITARIA)]);
+    }
+    imprimirFila("ida/vuelta", total.idaVuelta);
+
+    return (total.completadas == static_cast<uint64_t>(config.clientes)) ? 0 : 2;
+}
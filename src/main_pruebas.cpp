@@ -0,0 +1,1716 @@
+/**
+ * @file main_pruebas.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Pruebas unitarias del núcleo (protocolo, buffers, almacenes, fila).
+ * @version 1.0
+ * @date 06/01/2026
+ * * Cada prueba es una función que revisa sus condiciones con COMPROBAR();
+ * las que fallan se reportan con archivo y línea y el programa termina con
+ * código 1. CTest corre un grupo por proceso:
+ *
+ *   pruebas                   (todas)
+ *   pruebas --filtro protocolo/  (solo las que contengan el texto)
+ */
+
+#include "../include/protocolo.h"
+#include "../include/almacenTickets.h"
+#include "../include/wal.h"
+#include "../include/posicionesCola.h"
+#include "../include/planificadorFila.h"
+#include "../include/socket.h"
+#include "../include/colaMPSC.h"
+#include "../include/registroClientes.h"
+#include "../include/chat.h"
+#include "../include/canalMemoria.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <new>
+#include <optional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+
+/**
+ * @struct Prueba
+ * @brief Una prueba: nombre "grupo/caso" y la función que la corre.
+ */
+struct Prueba {
+    std::string nombre;
+    std::function<void()> correr;
+};
+
+static int fallas = 0; ///< Comprobaciones fallidas en la prueba en curso.
+
+/**
+ * @brief Si 'condicion' es falsa, la reporta y sigue (para ver todas las fallas de una vez).
+ */
+#define COMPROBAR(condicion)                                                            \
+    do {                                                                                \
+        if (!(condicion)) {                                                             \
+            std::cerr << "  [FALLA] " << __FILE__ << ":" << __LINE__ << ": " #condicion "\n"; \
+            ++fallas;                                                                   \
+        }                                                                               \
+    } while (0)
+
+// ================= PROTOCOLO =================
+
+/**
+ * @brief Copia 'bytes' al final del buffer como si llegaran de un recv().
+ */
+static void recibir(BufferLectura& buffer, std::string_view bytes) {
+    std::memcpy(buffer.reservar(bytes.size()), bytes.data(), bytes.size());
+    buffer.confirmar(bytes.size());
+}
+
+/**
+ * @brief Cabecera a mano, para armar tramas que codificarTrama() nunca produciría.
+ */
+static std::string cabeceraCruda(uint8_t tipo, uint8_t version, uint32_t longitud, uint32_t secuencia) {
+    std::string cabecera(TAM_CABECERA, '\0');
+    cabecera[0] = static_cast<char>(tipo);
+    cabecera[1] = static_cast<char>(version);
+    uint32_t longitudRed = htonl(longitud), secuenciaRed = htonl(secuencia);
+    std::memcpy(&cabecera[4], &longitudRed, 4);
+    std::memcpy(&cabecera[8], &secuenciaRed, 4);
+    return cabecera;
+}
+
+static std::vector<Prueba> pruebasProtocolo() {
+    std::vector<Prueba> pruebas;
+
+    pruebas.push_back({"protocolo/variasTramasPorLectura", [] {
+        std::string flujo;
+        codificarTrama(flujo, TipoTrama::MENSAJE, 0, "hola");
+        codificarTrama(flujo, TipoTrama::PING, 1, "");
+        codificarTrama(flujo, TipoTrama::MENSAJE, 2, std::string_view("a\0b", 3));
+
+        BufferLectura buffer(16);
+        recibir(buffer, flujo);
+        DecodificadorTramas decodificador;
+        VistaTrama trama;
+
+        COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::TRAMA);
+        COMPROBAR(trama.tipo == TipoTrama::MENSAJE && trama.secuencia == 0 && trama.datos == "hola");
+        COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::TRAMA);
+        COMPROBAR(trama.tipo == TipoTrama::PING && trama.secuencia == 1 && trama.datos.empty());
+        COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::TRAMA);
+        COMPROBAR(trama.secuencia == 2 && trama.datos == std::string_view("a\0b", 3));
+        COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::INCOMPLETA);
+        COMPROBAR(buffer.pendiente().empty());
+    }});
+
+    pruebas.push_back({"protocolo/tramaPartidaByteAByte", [] {
+        std::string flujo;
+        codificarTrama(flujo, TipoTrama::MENSAJE, 0, "mensaje partido en muchos recv()");
+        codificarTrama(flujo, TipoTrama::PONG, 1, "");
+
+        BufferLectura buffer(4);
+        DecodificadorTramas decodificador;
+        VistaTrama trama;
+        std::vector<std::string> recibidas;
+        for (char c : flujo) {
+            recibir(buffer, std::string_view(&c, 1));
+            ResultadoDecodificacion r;
+            while ((r = decodificador.siguiente(buffer, trama)) == ResultadoDecodificacion::TRAMA)
+                recibidas.emplace_back(trama.datos);
+            COMPROBAR(r == ResultadoDecodificacion::INCOMPLETA);
+        }
+        COMPROBAR(recibidas.size() == 2);
+        COMPROBAR(!recibidas.empty() && recibidas[0] == "mensaje partido en muchos recv()");
+    }});
+
+    pruebas.push_back({"protocolo/bufferSinCapacidadInicial", [] {
+        BufferLectura buffer(0);
+        std::string flujo;
+        codificarTrama(flujo, TipoTrama::MENSAJE, 0, "crece desde cero");
+        recibir(buffer, flujo);
+        DecodificadorTramas decodificador;
+        VistaTrama trama;
+        COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::TRAMA);
+        COMPROBAR(trama.datos == "crece desde cero");
+    }});
+
+    pruebas.push_back({"protocolo/secuenciaFueraDeOrden", [] {
+        std::string flujo;
+        codificarTrama(flujo, TipoTrama::MENSAJE, 0, "a");
+        codificarTrama(flujo, TipoTrama::MENSAJE, 2, "c"); // Falta la 1.
+
+        BufferLectura buffer;
+        recibir(buffer, flujo);
+        DecodificadorTramas decodificador;
+        VistaTrama trama;
+        COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::TRAMA);
+        COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::ERROR);
+    }});
+
+    pruebas.push_back({"protocolo/secuenciaDuplicada", [] {
+        std::string flujo;
+        codificarTrama(flujo, TipoTrama::MENSAJE, 0, "a");
+        codificarTrama(flujo, TipoTrama::MENSAJE, 0, "a");
+
+        BufferLectura buffer;
+        recibir(buffer, flujo);
+        DecodificadorTramas decodificador;
+        VistaTrama trama;
+        COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::TRAMA);
+        COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::ERROR);
+    }});
+
+    pruebas.push_back({"protocolo/cabeceraIncompleta", [] {
+        BufferLectura buffer;
+        recibir(buffer, cabeceraCruda(1, VERSION_PROTOCOLO, 3, 0).substr(0, TAM_CABECERA - 1));
+        DecodificadorTramas decodificador;
+        VistaTrama trama;
+        COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::INCOMPLETA);
+        COMPROBAR(buffer.pendiente().size() == TAM_CABECERA - 1);
+    }});
+
+    pruebas.push_back({"protocolo/longitudExcesiva", [] {
+        // Se rechaza con solo la cabecera: no hay que esperar (ni reservar) el MiB y pico.
+        BufferLectura buffer;
+        recibir(buffer, cabeceraCruda(1, VERSION_PROTOCOLO, MAX_CARGA + 1, 0));
+        DecodificadorTramas decodificador;
+        VistaTrama trama;
+        COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::ERROR);
+
+        BufferLectura justa;
+        recibir(justa, cabeceraCruda(1, VERSION_PROTOCOLO, MAX_CARGA, 0));
+        DecodificadorTramas otro;
+        COMPROBAR(otro.siguiente(justa, trama) == ResultadoDecodificacion::INCOMPLETA);
+    }});
+
+    pruebas.push_back({"protocolo/versionDesconocida", [] {
+        BufferLectura buffer;
+        recibir(buffer, cabeceraCruda(1, VERSION_PROTOCOLO + 1, 0, 0));
+        DecodificadorTramas decodificador;
+        VistaTrama trama;
+        COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::ERROR);
+    }});
+
+    pruebas.push_back({"protocolo/tipoFueraDeRango", [] {
+        uint8_t ultimo = static_cast<uint8_t>(TipoTrama::CLASE);
+        for (uint8_t tipo : {uint8_t(0), uint8_t(ultimo + 1), uint8_t(255)}) {
+            BufferLectura buffer;
+            recibir(buffer, cabeceraCruda(tipo, VERSION_PROTOCOLO, 0, 0));
+            DecodificadorTramas decodificador;
+            VistaTrama trama;
+            COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::ERROR);
+        }
+        for (uint8_t tipo = static_cast<uint8_t>(TipoTrama::MENSAJE); tipo <= ultimo; ++tipo) {
+            BufferLectura buffer;
+            recibir(buffer, cabeceraCruda(tipo, VERSION_PROTOCOLO, 0, 0));
+            DecodificadorTramas decodificador;
+            VistaTrama trama;
+            COMPROBAR(decodificador.siguiente(buffer, trama) == ResultadoDecodificacion::TRAMA);
+        }
+    }});
+
+    pruebas.push_back({"protocolo/cargaExcesivaNoSeEnvia", [] {
+        // El receptor cortaría la conexión: se rechaza antes de mirar si hay a quién mandarlo.
+        struct Silencio {
+            std::streambuf* anterior = std::cerr.rdbuf(nullptr);
+            ~Silencio() { std::cerr.rdbuf(anterior); }
+        } silencio;
+
+        ServerSocket servidor;
+        std::string justo(MAX_CARGA, 'x'), excesivo(MAX_CARGA + 1, 'x');
+        COMPROBAR(servidor.enviar(excesivo) == EstadoEnvio::DEMASIADO_GRANDE);
+        COMPROBAR(servidor.enviar(justo) == EstadoEnvio::CERRADO);
+        COMPROBAR(servidor.difundir(excesivo) == 0);
+    }});
+
+    return pruebas;
+}
+
+// ================= BUFFER DE SALIDA =================
+
+/**
+ * @brief Saca lo pendiente como un transporte que acepta a lo más 'porVez' bytes por envío.
+ */
+static std::string drenar(BufferSalida& buffer, size_t porVez = SIZE_MAX) {
+    std::string salida;
+    while (!buffer.vacio()) {
+        std::string_view tramo = buffer.tramoPendiente();
+        size_t n = std::min(tramo.size(), porVez);
+        salida.append(tramo.data(), n);
+        buffer.confirmarEntrega(n);
+    }
+    return salida;
+}
+
+static CargaCompartida compartida(std::string texto) {
+    return std::make_shared<const std::string>(std::move(texto));
+}
+
+static std::vector<Prueba> pruebasBufferSalida() {
+    std::vector<Prueba> pruebas;
+
+    pruebas.push_back({"bufferSalida/anilloDaLaVuelta", [] {
+        // 64 bytes de anillo: al consumir y volver a escribir, las tramas quedan partidas en dos tramos.
+        BufferSalida buffer(64);
+        std::string esperado, recibido;
+        for (uint32_t i = 0; i < 40; ++i) {
+            std::string carga(static_cast<size_t>(i % 7) * 3, static_cast<char>('a' + i % 26));
+            buffer.agregarTrama(TipoTrama::MENSAJE, i, carga);
+            codificarTrama(esperado, TipoTrama::MENSAJE, i, carga);
+            // Se entrega solo una parte: siempre queda algo pendiente en medio del anillo.
+            std::string_view tramo = buffer.tramoPendiente();
+            size_t n = tramo.size() / 2 + 1;
+            recibido.append(tramo.data(), n);
+            buffer.confirmarEntrega(n);
+        }
+        recibido += drenar(buffer, 5);
+        COMPROBAR(recibido == esperado);
+        COMPROBAR(buffer.pendiente() == 0);
+    }});
+
+    pruebas.push_back({"bufferSalida/creceEnderezando", [] {
+        BufferSalida buffer(64);
+        std::string esperado;
+        buffer.agregarTrama(TipoTrama::MENSAJE, 0, std::string(30, 'x')); // 42 bytes.
+        codificarTrama(esperado, TipoTrama::MENSAJE, 0, std::string(30, 'x'));
+        buffer.confirmarEntrega(40); // Lo pendiente empieza en el byte 40 del anillo.
+        buffer.agregarTrama(TipoTrama::MENSAJE, 1, std::string(20, 'y')); // Da la vuelta.
+        codificarTrama(esperado, TipoTrama::MENSAJE, 1, std::string(20, 'y'));
+        buffer.agregarTrama(TipoTrama::MENSAJE, 2, std::string(500, 'z')); // No cabe: crece.
+        codificarTrama(esperado, TipoTrama::MENSAJE, 2, std::string(500, 'z'));
+        COMPROBAR(drenar(buffer) == esperado.substr(40));
+    }});
+
+    pruebas.push_back({"bufferSalida/marcasConHisteresis", [] {
+        BufferSalida buffer(64, 100, 40);
+        COMPROBAR(!buffer.estaSaturado());
+        buffer.agregarTrama(TipoTrama::MENSAJE, 0, std::string(50, 'a')); // 62 bytes.
+        COMPROBAR(!buffer.estaSaturado());
+        buffer.agregarTrama(TipoTrama::MENSAJE, 1, std::string(50, 'b')); // 124 bytes.
+        COMPROBAR(buffer.estaSaturado());
+
+        buffer.confirmarEntrega(70); // Quedan 54: entre las marcas sigue saturado.
+        COMPROBAR(buffer.pendiente() == 54);
+        COMPROBAR(buffer.estaSaturado());
+        buffer.confirmarEntrega(14); // Quedan 40: llega a la marca baja.
+        COMPROBAR(!buffer.estaSaturado());
+
+        // Las cargas compartidas y lo que está en vuelo también cuentan.
+        buffer.agregarCompartida(TipoTrama::MENSAJE, 2, compartida(std::string(60, 'c')));
+        COMPROBAR(buffer.estaSaturado());
+        std::string enVuelo;
+        buffer.extraer(enVuelo);
+        COMPROBAR(buffer.vacio());
+        COMPROBAR(buffer.pendiente() == enVuelo.size());
+        COMPROBAR(buffer.estaSaturado());
+        buffer.confirmarEnvio(enVuelo.size() - 40);
+        COMPROBAR(!buffer.estaSaturado());
+        buffer.confirmarEnvio(40);
+        COMPROBAR(buffer.pendiente() == 0);
+    }});
+
+    pruebas.push_back({"bufferSalida/ordenConCompartidas", [] {
+        BufferSalida buffer(64);
+        CargaCompartida difusion = compartida("para todos");
+        std::string esperado;
+        buffer.agregarTrama(TipoTrama::WAIT, 0, "antes");
+        codificarTrama(esperado, TipoTrama::WAIT, 0, "antes");
+        buffer.agregarCompartida(TipoTrama::MENSAJE, 1, difusion);
+        codificarTrama(esperado, TipoTrama::MENSAJE, 1, *difusion);
+        buffer.agregarTrama(TipoTrama::START, 2, "despues");
+        codificarTrama(esperado, TipoTrama::START, 2, "despues");
+        buffer.agregarCompartida(TipoTrama::MENSAJE, 3, difusion);
+        codificarTrama(esperado, TipoTrama::MENSAJE, 3, *difusion);
+
+        BufferSalida copia = buffer;
+        COMPROBAR(drenar(buffer, 3) == esperado);
+        std::string extraido;
+        copia.extraer(extraido);
+        COMPROBAR(extraido == esperado);
+    }});
+
+    pruebas.push_back({"bufferSalida/fusionPorClave", [] {
+        BufferSalida buffer(64);
+        std::string esperado;
+        COMPROBAR(buffer.agregarCompartida(TipoTrama::POSICION, 0, compartida("vieja"), 7));
+        COMPROBAR(buffer.agregarCompartida(TipoTrama::POSICION, 1, compartida("otra clave"), 8));
+        // Misma clave y tipo, sin empezar a salir: reemplaza la carga, conserva lugar y secuencia.
+        COMPROBAR(!buffer.agregarCompartida(TipoTrama::POSICION, 2, compartida("la mas nueva"), 7));
+        // Mismo número de clave pero otro tipo: no se fusiona.
+        COMPROBAR(buffer.agregarCompartida(TipoTrama::MENSAJE, 2, compartida("mensaje"), 7));
+        // Sin clave nunca se fusiona.
+        COMPROBAR(buffer.agregarCompartida(TipoTrama::MENSAJE, 3, compartida("mensaje")));
+
+        codificarTrama(esperado, TipoTrama::POSICION, 0, "la mas nueva");
+        codificarTrama(esperado, TipoTrama::POSICION, 1, "otra clave");
+        codificarTrama(esperado, TipoTrama::MENSAJE, 2, "mensaje");
+        codificarTrama(esperado, TipoTrama::MENSAJE, 3, "mensaje");
+        COMPROBAR(buffer.pendiente() == esperado.size());
+        COMPROBAR(drenar(buffer) == esperado);
+    }});
+
+    pruebas.push_back({"bufferSalida/noFusionaLoYaEmpezado", [] {
+        BufferSalida buffer(64);
+        std::string esperado;
+        buffer.agregarCompartida(TipoTrama::POSICION, 0, compartida("primera"), 7);
+        codificarTrama(esperado, TipoTrama::POSICION, 0, "primera");
+        buffer.confirmarEntrega(3); // Ya salió parte de la cabecera: cambiarla rompería el flujo.
+        COMPROBAR(buffer.agregarCompartida(TipoTrama::POSICION, 1, compartida("segunda"), 7));
+        codificarTrama(esperado, TipoTrama::POSICION, 1, "segunda");
+        COMPROBAR(drenar(buffer) == esperado.substr(3));
+    }});
+
+    pruebas.push_back({"bufferSalida/vaciarEnSocket", [] {
+        int par[2];
+        COMPROBAR(socketpair(AF_UNIX, SOCK_STREAM, 0, par) == 0);
+        int chico = 4096;
+        setsockopt(par[0], SOL_SOCKET, SO_SNDBUF, &chico, sizeof(chico));
+
+        BufferSalida buffer(64);
+        std::string esperado;
+        CargaCompartida grande = compartida(std::string(256 * 1024, 'g'));
+        for (uint32_t i = 0; i < 8; ++i) {
+            buffer.agregarTrama(TipoTrama::MENSAJE, 2 * i, "corto");
+            codificarTrama(esperado, TipoTrama::MENSAJE, 2 * i, "corto");
+            buffer.agregarCompartida(TipoTrama::MENSAJE, 2 * i + 1, grande);
+            codificarTrama(esperado, TipoTrama::MENSAJE, 2 * i + 1, *grande);
+        }
+
+        // Nadie lee del otro lado: el Kernel se llena y lo demás se queda en el buffer.
+        COMPROBAR(buffer.vaciar(par[0]) == ResultadoVaciado::PENDIENTE);
+        COMPROBAR(!buffer.vacio());
+
+        std::string recibido;
+        char bloque[65536];
+        ResultadoVaciado r;
+        bool llego;
+        do {
+            r = buffer.vaciar(par[0]);
+            llego = false;
+            ssize_t n;
+            while ((n = recv(par[1], bloque, sizeof(bloque), MSG_DONTWAIT)) > 0) {
+                recibido.append(bloque, static_cast<size_t>(n));
+                llego = true;
+            }
+        } while (r == ResultadoVaciado::PENDIENTE || llego);
+        COMPROBAR(r == ResultadoVaciado::VACIO);
+        COMPROBAR(recibido == esperado);
+
+        close(par[1]);
+        buffer.agregarTrama(TipoTrama::PING, 16, "");
+        COMPROBAR(buffer.vaciar(par[0]) == ResultadoVaciado::ERROR);
+        close(par[0]);
+    }});
+
+    return pruebas;
+}
+
+// ================= ALMACEN DE TICKETS =================
+
+static off_t tamArchivo(const std::string& ruta) {
+    struct stat st;
+    return stat(ruta.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+/**
+ * @brief Simula un cierre abrupto cortando 'ruta' a 'tam' bytes.
+ */
+static bool cortar(const std::string& ruta, off_t tam) {
+    return truncate(ruta.c_str(), tam) == 0;
+}
+
+static std::vector<Mensaje> conversacion(int numero) {
+    return {{"Cliente " + std::to_string(numero), "Hola, ticket " + std::to_string(numero), false},
+            {"Soporte", "Con gusto le ayudo.", true}};
+}
+
+/**
+ * @brief Guarda 'cuantos' tickets en un almacén nuevo en 'carpeta' y lo cierra.
+ */
+static bool llenarAlmacen(const std::string& carpeta, int cuantos) {
+    AlmacenTickets almacen;
+    if (!almacen.abrir(carpeta)) return false;
+    for (int i = 1; i <= cuantos; ++i)
+        if (almacen.agregar(static_cast<uint32_t>(100 + i), "Cliente " + std::to_string(i), 1000 + i, conversacion(i)) == 0)
+            return false;
+    return true;
+}
+
+/**
+ * @brief true si los tickets 1..cuantos se leen completos y con su contenido.
+ */
+static bool ticketsIntactos(const AlmacenTickets& almacen, size_t cuantos) {
+    if (almacen.cantidad() != cuantos) return false;
+    for (size_t i = 1; i <= cuantos; ++i) {
+        EntradaIndice e;
+        RegistroTicket r;
+        if (!almacen.buscarPorTicket(i, e) || !almacen.leer(e, r)) return false;
+        if (r.ticketId != i || r.mensajes.size() != 2 || r.mensajes[0].texto != "Hola, ticket " + std::to_string(i))
+            return false;
+    }
+    return true;
+}
+
+static std::vector<Prueba> pruebasAlmacenTickets(const std::string& temporal) {
+    std::vector<Prueba> pruebas;
+
+    pruebas.push_back({"almacenTickets/reabrir", [temporal] {
+        std::string carpeta = temporal + "/reabrir";
+        COMPROBAR(llenarAlmacen(carpeta, 5));
+        AlmacenTickets almacen;
+        COMPROBAR(almacen.abrir(carpeta));
+        COMPROBAR(ticketsIntactos(almacen, 5));
+        COMPROBAR(almacen.buscarPorCliente(103).size() == 1);
+        COMPROBAR(almacen.buscarPorFecha(1002, 1004).size() == 3);
+        COMPROBAR(almacen.agregar(999, "Otro", 2000, conversacion(6)) == 6);
+    }});
+
+    pruebas.push_back({"almacenTickets/segmentoCortado", [temporal] {
+        // El proceso murió escribiendo el registro del ticket 3 (su entrada del índice sí llegó).
+        std::string carpeta = temporal + "/segmentoCortado";
+        COMPROBAR(llenarAlmacen(carpeta, 3));
+        std::string segmento = carpeta + "/segmento_000001.dat";
+        EntradaIndice tercero{};
+        {
+            AlmacenTickets lectura;
+            COMPROBAR(lectura.abrir(carpeta, true));
+            COMPROBAR(lectura.buscarPorTicket(3, tercero));
+        }
+        COMPROBAR(cortar(segmento, static_cast<off_t>(tercero.desplazamiento + tercero.longitud / 2)));
+
+        AlmacenTickets almacen;
+        COMPROBAR(almacen.abrir(carpeta));
+        COMPROBAR(ticketsIntactos(almacen, 2));
+        COMPROBAR(tamArchivo(segmento) == static_cast<off_t>(tercero.desplazamiento));
+
+        // El ID se reutiliza y el registro nuevo queda justo donde empezaba el perdido.
+        COMPROBAR(almacen.agregar(103, "Cliente 3", 1003, conversacion(3)) == 3);
+        COMPROBAR(ticketsIntactos(almacen, 3));
+        almacen.cerrar();
+        COMPROBAR(almacen.abrir(carpeta));
+        COMPROBAR(ticketsIntactos(almacen, 3));
+    }});
+
+    pruebas.push_back({"almacenTickets/indiceCortado", [temporal] {
+        // El registro del ticket 3 llegó completo pero su entrada del índice quedó a medias.
+        std::string carpeta = temporal + "/indiceCortado";
+        COMPROBAR(llenarAlmacen(carpeta, 3));
+        std::string indice = carpeta + "/tickets.idx", segmento = carpeta + "/segmento_000001.dat";
+        EntradaIndice tercero{};
+        {
+            AlmacenTickets lectura;
+            COMPROBAR(lectura.abrir(carpeta, true));
+            COMPROBAR(lectura.buscarPorTicket(3, tercero));
+        }
+        COMPROBAR(cortar(indice, tamArchivo(indice) - static_cast<off_t>(sizeof(EntradaIndice) / 2)));
+
+        AlmacenTickets almacen;
+        COMPROBAR(almacen.abrir(carpeta));
+        COMPROBAR(ticketsIntactos(almacen, 2));
+        // Los bytes del registro que no alcanzó a indexarse se descartan del segmento.
+        COMPROBAR(tamArchivo(segmento) == static_cast<off_t>(tercero.desplazamiento));
+        // Y la entrada a medias, del índice (cabecera de 16 bytes + 2 entradas).
+        COMPROBAR(tamArchivo(indice) == static_cast<off_t>(16 + 2 * sizeof(EntradaIndice)));
+
+        COMPROBAR(almacen.agregar(103, "Cliente 3", 1003, conversacion(3)) == 3);
+        almacen.cerrar();
+        COMPROBAR(almacen.abrir(carpeta));
+        COMPROBAR(ticketsIntactos(almacen, 3));
+    }});
+
+    pruebas.push_back({"almacenTickets/basuraSinIndexar", [temporal] {
+        // El registro se escribió a medias y el índice ni se tocó: bytes sueltos al final del segmento.
+        std::string carpeta = temporal + "/basuraSinIndexar";
+        COMPROBAR(llenarAlmacen(carpeta, 2));
+        std::string segmento = carpeta + "/segmento_000001.dat";
+        off_t fin = tamArchivo(segmento);
+        COMPROBAR(cortar(segmento, fin + 37));
+
+        AlmacenTickets almacen;
+        COMPROBAR(almacen.abrir(carpeta));
+        COMPROBAR(tamArchivo(segmento) == fin);
+        COMPROBAR(almacen.agregar(103, "Cliente 3", 1003, conversacion(3)) == 3);
+        EntradaIndice e;
+        COMPROBAR(almacen.buscarPorTicket(3, e) && e.desplazamiento == static_cast<uint64_t>(fin));
+        COMPROBAR(ticketsIntactos(almacen, 3));
+    }});
+
+    pruebas.push_back({"almacenTickets/soloLecturaNoRepara", [temporal] {
+        std::string carpeta = temporal + "/soloLectura";
+        COMPROBAR(llenarAlmacen(carpeta, 2));
+        std::string segmento = carpeta + "/segmento_000001.dat";
+        off_t fin = tamArchivo(segmento);
+        COMPROBAR(cortar(segmento, fin + 10));
+
+        AlmacenTickets almacen;
+        COMPROBAR(almacen.abrir(carpeta, true));
+        COMPROBAR(ticketsIntactos(almacen, 2));
+        COMPROBAR(tamArchivo(segmento) == fin + 10);
+        COMPROBAR(almacen.agregar(103, "Cliente 3", 1003, conversacion(3)) == 0);
+    }});
+
+    pruebas.push_back({"almacenTickets/crcDetectaCorrupcion", [temporal] {
+        std::string carpeta = temporal + "/crc";
+        COMPROBAR(llenarAlmacen(carpeta, 1));
+        std::string segmento = carpeta + "/segmento_000001.dat";
+        int fd = open(segmento.c_str(), O_WRONLY);
+        COMPROBAR(fd >= 0 && pwrite(fd, "X", 1, 40) == 1);
+        if (fd >= 0) close(fd);
+
+        AlmacenTickets almacen;
+        COMPROBAR(almacen.abrir(carpeta, true));
+        EntradaIndice e;
+        RegistroTicket r;
+        COMPROBAR(almacen.buscarPorTicket(1, e));
+        COMPROBAR(!almacen.leer(e, r));
+    }});
+
+    pruebas.push_back({"almacenTickets/escrituraFallidaSeDeshace", [temporal] {
+        // Con RLIMIT_FSIZE write() falla con EFBIG a la mitad, como con el disco lleno.
+        // Registros vacíos (38 bytes) para que el segmento quede siempre más chico que el
+        // índice (16 + 40 por entrada) y poder hacer fallar uno u otro.
+        std::string carpeta = temporal + "/escrituraFallida";
+        std::string indice = carpeta + "/tickets.idx", segmento = carpeta + "/segmento_000001.dat";
+        std::vector<Mensaje> nada;
+        AlmacenTickets almacen;
+        COMPROBAR(almacen.abrir(carpeta));
+        COMPROBAR(almacen.agregar(1, "", 1, nada) == 1);
+        COMPROBAR(almacen.agregar(2, "", 2, nada) == 2);
+        off_t finSegmento = tamArchivo(segmento), finIndice = tamArchivo(indice);
+        COMPROBAR(finSegmento == 76 && finIndice == 96);
+
+        signal(SIGXFSZ, SIG_IGN);
+        rlimit original;
+        getrlimit(RLIMIT_FSIZE, &original);
+        auto limitar = [&original](rlim_t bytes) {
+            rlimit limite = original;
+            limite.rlim_cur = bytes;
+            setrlimit(RLIMIT_FSIZE, &limite);
+        };
+
+        limitar(100); // El registro no cabe completo en el segmento.
+        COMPROBAR(almacen.agregar(3, "", 3, nada) == 0);
+        COMPROBAR(tamArchivo(segmento) == finSegmento && tamArchivo(indice) == finIndice);
+
+        limitar(120); // El registro sí (114), la entrada del índice no (136).
+        COMPROBAR(almacen.agregar(3, "", 3, nada) == 0);
+        COMPROBAR(tamArchivo(segmento) == finSegmento && tamArchivo(indice) == finIndice);
+
+        setrlimit(RLIMIT_FSIZE, &original);
+        COMPROBAR(almacen.cantidad() == 2);
+        COMPROBAR(almacen.agregar(3, "", 3, nada) == 3);
+        EntradaIndice e;
+        COMPROBAR(almacen.buscarPorTicket(3, e) && e.desplazamiento == static_cast<uint64_t>(finSegmento));
+        almacen.cerrar();
+        COMPROBAR(almacen.abrir(carpeta));
+        COMPROBAR(almacen.cantidad() == 3);
+        RegistroTicket r;
+        COMPROBAR(almacen.buscarPorTicket(3, e) && almacen.leer(e, r) && r.clienteId == 3);
+    }});
+
+    return pruebas;
+}
+
+// ================= WAL =================
+
+/**
+ * @brief Corrida de un servidor contada con el WAL; 'lsns' recibe el LSN al final de cada registro.
+ * * Al final: cliente 1 atendido y con ticket, 2 se fue de la cola, la sesión
+ * de 3 terminó sin ticket, la de 4 quedó a medias (2 mensajes) y 5 espera.
+ */
+static bool escribirHistoria(const std::string& carpeta, std::vector<uint64_t>& lsns) {
+    WAL wal;
+    EstadoRecuperado estado;
+    if (!wal.recuperar(carpeta, estado) || !wal.iniciar(estado.ultimoId)) return false;
+
+    lsns = {wal.clienteEnCola(1, "Ana"), wal.clienteEnCola(2, "Beto"), wal.clienteEnCola(3, "Caro"),
+            wal.clienteFueraDeCola(2),
+            wal.sesionIniciada(1, "Ana", 100), wal.mensaje(1, "Ana", "hola", false),
+            wal.mensaje(1, "Soporte", "dime", true), wal.sesionTerminada(1, 200), wal.ticketGuardado(1),
+            wal.sesionIniciada(3, "Caro", 300), wal.mensaje(3, "Caro", "ayuda", false), wal.sesionTerminada(3, 400),
+            wal.clienteEnCola(4, "Dani"), wal.sesionIniciada(4, "Dani", 500),
+            wal.mensaje(4, "Dani", "uno", false), wal.mensaje(4, "Dani", "dos", false),
+            wal.clienteEnCola(5, "Eva")};
+    bool durable = wal.esperarDurable(lsns.back());
+    wal.detener();
+    return durable;
+}
+
+/// Índices en 'lsns' de algunos registros de escribirHistoria().
+static const size_t REG_MENSAJE_UNO = 14, REG_MENSAJE_DOS = 15, REG_EVA = 16;
+
+/**
+ * @brief Byte del archivo donde empieza el registro 'k' (después de la cabecera de iniciar()).
+ * * Se calcula con el archivo completo, antes de cortarlo.
+ */
+static off_t inicioRegistro(const std::string& archivo, const std::vector<uint64_t>& lsns, size_t k) {
+    off_t cabecera = tamArchivo(archivo) - static_cast<off_t>(lsns.back());
+    return cabecera + static_cast<off_t>(k == 0 ? 0 : lsns[k - 1]);
+}
+
+static const SesionRecuperada* pendienteDe(const EstadoRecuperado& estado, int clienteId) {
+    for (const SesionRecuperada& s : estado.pendientes)
+        if (s.clienteId == clienteId) return &s;
+    return nullptr;
+}
+
+static std::vector<Prueba> pruebasWAL(const std::string& temporal) {
+    std::vector<Prueba> pruebas;
+
+    pruebas.push_back({"wal/recuperarCompleto", [temporal] {
+        std::string carpeta = temporal + "/walCompleto";
+        std::vector<uint64_t> lsns;
+        COMPROBAR(escribirHistoria(carpeta, lsns));
+
+        WAL wal;
+        EstadoRecuperado estado;
+        COMPROBAR(wal.recuperar(carpeta, estado));
+        COMPROBAR(estado.ultimoId == 5);
+        COMPROBAR(estado.cola.size() == 1 && estado.cola[0].clienteId == 5 && estado.cola[0].nombre == "Eva");
+        COMPROBAR(estado.pendientes.size() == 2);
+        COMPROBAR(pendienteDe(estado, 1) == nullptr);
+
+        const SesionRecuperada* caro = pendienteDe(estado, 3);
+        COMPROBAR(caro && caro->terminada && caro->fecha == 400 && caro->nombre == "Caro");
+        COMPROBAR(caro && caro->mensajes.size() == 1 && caro->mensajes[0].texto == "ayuda");
+
+        const SesionRecuperada* dani = pendienteDe(estado, 4);
+        COMPROBAR(dani && !dani->terminada && dani->mensajes.size() == 2);
+        COMPROBAR(dani && dani->mensajes.size() == 2 && dani->mensajes[1].texto == "dos" && !dani->mensajes[1].esMio);
+    }});
+
+    pruebas.push_back({"wal/registroCortado", [temporal] {
+        // El proceso murió a la mitad del write() del último registro.
+        std::string carpeta = temporal + "/walCortado";
+        std::vector<uint64_t> lsns;
+        COMPROBAR(escribirHistoria(carpeta, lsns));
+        std::string archivo = carpeta + "/wal_000001.log";
+        off_t eva = inicioRegistro(archivo, lsns, REG_EVA), dos = inicioRegistro(archivo, lsns, REG_MENSAJE_DOS);
+        COMPROBAR(cortar(archivo, eva + 5));
+
+        WAL wal;
+        EstadoRecuperado estado;
+        COMPROBAR(wal.recuperar(carpeta, estado));
+        COMPROBAR(estado.ultimoId == 4);
+        COMPROBAR(estado.cola.empty());
+        const SesionRecuperada* dani = pendienteDe(estado, 4);
+        COMPROBAR(dani && dani->mensajes.size() == 2);
+
+        // Cortado dentro de los datos (la cabecera del registro sí llegó).
+        COMPROBAR(cortar(archivo, dos + 12));
+        COMPROBAR(wal.recuperar(carpeta, estado));
+        dani = pendienteDe(estado, 4);
+        COMPROBAR(dani && dani->mensajes.size() == 1 && dani->mensajes[0].texto == "uno");
+    }});
+
+    pruebas.push_back({"wal/crcCorrupto", [temporal] {
+        // Un registro dañado corta la recuperación ahí aunque lo que sigue esté bien.
+        std::string carpeta = temporal + "/walCrc";
+        std::vector<uint64_t> lsns;
+        COMPROBAR(escribirHistoria(carpeta, lsns));
+        std::string archivo = carpeta + "/wal_000001.log";
+        off_t inicio = inicioRegistro(archivo, lsns, REG_MENSAJE_UNO);
+        off_t tam = tamArchivo(archivo);
+
+        int fd = open(archivo.c_str(), O_RDWR);
+        char byte = 0;
+        COMPROBAR(fd >= 0 && pread(fd, &byte, 1, inicio + 10) == 1);
+        byte ^= 0x20;
+        COMPROBAR(fd >= 0 && pwrite(fd, &byte, 1, inicio + 10) == 1);
+        if (fd >= 0) close(fd);
+
+        WAL wal;
+        EstadoRecuperado estado;
+        COMPROBAR(wal.recuperar(carpeta, estado));
+        COMPROBAR(tamArchivo(archivo) == tam); // Recuperar no modifica nada.
+        COMPROBAR(estado.cola.empty());        // El EN_COLA de Eva venía después.
+        const SesionRecuperada* dani = pendienteDe(estado, 4);
+        COMPROBAR(dani && dani->mensajes.empty());
+        COMPROBAR(pendienteDe(estado, 3) != nullptr);
+    }});
+
+    pruebas.push_back({"wal/iniciarDescartaLoViejo", [temporal] {
+        std::string carpeta = temporal + "/walIniciar";
+        std::vector<uint64_t> lsns;
+        COMPROBAR(escribirHistoria(carpeta, lsns));
+        {
+            WAL wal;
+            EstadoRecuperado estado;
+            COMPROBAR(wal.recuperar(carpeta, estado));
+            COMPROBAR(wal.iniciar(estado.ultimoId)); // Como si las pendientes ya fueran tickets.
+            wal.detener();
+        }
+        COMPROBAR(tamArchivo(carpeta + "/wal_000001.log") < 0);
+
+        WAL wal;
+        EstadoRecuperado estado;
+        COMPROBAR(wal.recuperar(carpeta, estado));
+        COMPROBAR(estado.ultimoId == 5); // Los IDs no se repiten aunque lo demás se olvide.
+        COMPROBAR(estado.pendientes.empty() && estado.cola.empty());
+    }});
+
+    pruebas.push_back({"wal/discoFallido", [temporal] {
+        // Con RLIMIT_FSIZE el write() del lote falla: nada de eso se puede dar por durable.
+        std::string carpeta = temporal + "/walFallido";
+        WAL wal;
+        EstadoRecuperado estado;
+        COMPROBAR(wal.recuperar(carpeta, estado));
+        COMPROBAR(wal.iniciar(0));
+        COMPROBAR(wal.esperarDurable(wal.clienteEnCola(1, "Ana")));
+        off_t antes = tamArchivo(carpeta + "/wal_000001.log");
+
+        signal(SIGXFSZ, SIG_IGN);
+        rlimit original;
+        getrlimit(RLIMIT_FSIZE, &original);
+        rlimit limite = original;
+        limite.rlim_cur = static_cast<rlim_t>(antes + 10);
+        setrlimit(RLIMIT_FSIZE, &limite);
+        COMPROBAR(!wal.esperarDurable(wal.mensaje(1, "Ana", std::string(200, 'x'), false)));
+        setrlimit(RLIMIT_FSIZE, &original);
+
+        // Ya fallido: lo siguiente tampoco llega, aunque el disco "se recupere".
+        COMPROBAR(!wal.esperarDurable(wal.clienteEnCola(2, "Beto")));
+        wal.detener();
+
+        WAL otro;
+        COMPROBAR(otro.recuperar(carpeta, estado));
+        COMPROBAR(estado.cola.size() == 1 && estado.cola[0].clienteId == 1);
+    }});
+
+    return pruebas;
+}
+
+// ================= POSICIONES EN LA FILA =================
+
+using Reloj = std::chrono::steady_clock;
+
+static std::vector<Prueba> pruebasPosicionesCola() {
+    std::vector<Prueba> pruebas;
+
+    pruebas.push_back({"posicionesCola/basico", [] {
+        PosicionesCola fila;
+        Reloj::time_point t0 = Reloj::now();
+        uint64_t a = fila.agregar(t0), b = fila.agregar(t0 + std::chrono::seconds(1)), c = fila.agregar(t0 + std::chrono::seconds(2));
+        COMPROBAR(fila.posicion(a) == 1 && fila.posicion(b) == 2 && fila.posicion(c) == 3);
+        fila.quitar(b);
+        COMPROBAR(fila.posicion(b) == 0 && fila.posicion(c) == 2 && fila.total() == 2);
+        fila.quitar(b); // Repetirlo no hace nada.
+        COMPROBAR(fila.total() == 2);
+        fila.quitar(a);
+        COMPROBAR(fila.posicion(c) == 1);
+        COMPROBAR(fila.posicion(c + 100) == 0);
+    }});
+
+    pruebas.push_back({"posicionesCola/llegadasNoDecrecen", [] {
+        PosicionesCola fila;
+        Reloj::time_point t0 = Reloj::now();
+        uint64_t a = fila.agregar(t0 + std::chrono::seconds(5));
+        uint64_t b = fila.agregar(t0); // El reloj "retrocede": se toma la llegada anterior.
+        COMPROBAR(fila.llegada(b) == fila.llegada(a));
+        COMPROBAR(fila.anterioresA(t0 + std::chrono::seconds(5)) == 0);
+        COMPROBAR(fila.anterioresA(t0 + std::chrono::seconds(6)) == 2);
+    }});
+
+    pruebas.push_back({"posicionesCola/contraModeloIngenuo", [] {
+        // Miles de operaciones al azar (reproducibles) comparadas contra una lista simple:
+        // la ventana se llena, se vacía y se reconstruye muchas veces.
+        const size_t CLASES = 3;
+        struct Turno { uint64_t turno; int clase; Reloj::time_point llegada; };
+        std::vector<Turno> modelo;
+        PosicionesCola fila(CLASES);
+        std::mt19937 azar(12345);
+        Reloj::time_point reloj{};
+        int errores = 0;
+
+        for (int paso = 0; paso < 20000 && errores == 0; ++paso) {
+            unsigned op = azar() % 10;
+            std::vector<size_t> vigentes;
+            for (size_t i = 0; i < modelo.size(); ++i)
+                if (modelo[i].clase >= 0) vigentes.push_back(i);
+
+            // Más altas que bajas al principio y al revés después: la fila crece y se vacía.
+            bool creciendo = (paso / 2000) % 2 == 0;
+            if (vigentes.empty() || op < (creciendo ? 6u : 3u)) {
+                reloj += std::chrono::milliseconds(azar() % 3); // A veces dos llegan al mismo tiempo.
+                int clase = static_cast<int>(azar() % CLASES);
+                uint64_t turno = fila.agregar(reloj, static_cast<size_t>(clase));
+                if (!modelo.empty() && turno != modelo.back().turno + 1) ++errores;
+                modelo.push_back({turno, clase, reloj});
+            } else if (op < 9) {
+                // Casi siempre sale el primero (lo atienden), a veces uno del medio (colgó).
+                size_t i = azar() % 4 == 0 ? vigentes[azar() % vigentes.size()] : vigentes.front();
+                fila.quitar(modelo[i].turno);
+                modelo[i].clase = -1;
+            } else {
+                size_t i = vigentes[azar() % vigentes.size()];
+                int clase = static_cast<int>(azar() % CLASES);
+                fila.cambiarClase(modelo[i].turno, static_cast<size_t>(clase));
+                modelo[i].clase = clase;
+            }
+
+            // Los que ya salieron del frente no hace falta seguirlos revisando.
+            size_t salidos = 0;
+            while (salidos < modelo.size() && modelo[salidos].clase < 0) ++salidos;
+            modelo.erase(modelo.begin(), modelo.begin() + static_cast<ptrdiff_t>(salidos));
+
+            std::vector<uint32_t> vistos(CLASES, 0);
+            for (const Turno& t : modelo) {
+                uint32_t esperada = t.clase >= 0 ? ++vistos[static_cast<size_t>(t.clase)] : 0;
+                if (fila.posicion(t.turno) != esperada) ++errores;
+            }
+            for (size_t k = 0; k < CLASES; ++k)
+                if (fila.total(k) != vistos[k]) ++errores;
+
+            Reloj::time_point momento = reloj - std::chrono::milliseconds(azar() % 50);
+            size_t clase = azar() % CLASES;
+            uint32_t antes = 0;
+            for (const Turno& t : modelo)
+                if (t.clase == static_cast<int>(clase) && t.llegada < momento) ++antes;
+            if (fila.anterioresA(momento, clase) != antes) ++errores;
+        }
+        COMPROBAR(errores == 0);
+    }});
+
+    pruebas.push_back({"posicionesCola/estimador", [] {
+        using std::chrono::seconds;
+        EstimadorEspera estimador;
+        COMPROBAR(estimador.segundos(1, seconds(-1)) == -1); // Sin sesiones terminadas no hay con qué.
+
+        estimador.registrarSesion(seconds(100));
+        estimador.registrarSesion(seconds(200));      // Promedio 150.
+        COMPROBAR(estimador.segundos(0, seconds(-1)) == -1);
+        COMPROBAR(estimador.segundos(1, Reloj::duration(-1)) == 0);   // Agente libre: pasa ya.
+        COMPROBAR(estimador.segundos(3, Reloj::duration(-1)) == 300); // Dos sesiones promedio.
+        COMPROBAR(estimador.segundos(1, seconds(50)) == 100);         // Lo que le falta a la actual.
+        COMPROBAR(estimador.segundos(2, seconds(50)) == 250);
+        COMPROBAR(estimador.segundos(2, seconds(400)) == 150);        // Pasada del promedio: por acabar.
+
+        // Solo cuentan las últimas 32: las 40 de 10 s desplazan a las dos primeras.
+        for (int i = 0; i < 40; ++i) estimador.registrarSesion(seconds(10));
+        COMPROBAR(estimador.segundos(2, Reloj::duration(-1)) == 10);
+    }});
+
+    pruebas.push_back({"posicionesCola/avisoPosicion", [] {
+        AvisoPosicion aviso{7, 42, -1}, leido;
+        std::string carga = codificarPosicion(aviso);
+        COMPROBAR(carga.size() == TAM_AVISO_POSICION);
+        COMPROBAR(decodificarPosicion(carga, leido));
+        COMPROBAR(leido.posicion == 7 && leido.enCola == 42 && leido.segundos == -1);
+        COMPROBAR(!decodificarPosicion(std::string_view(carga).substr(1), leido));
+    }});
+
+    return pruebas;
+}
+
+// ================= PLANIFICADOR DE LA FILA =================
+
+static EntradaFila entradaCon(int socket, Reloj::time_point limite) {
+    EntradaFila e;
+    e.socket = socket;
+    e.limite = limite;
+    return e;
+}
+
+/**
+ * @brief Saca todo del planificador y devuelve los sockets en el orden en que salieron.
+ */
+static std::vector<int> vaciarPlanificador(PlanificadorFila& planificador) {
+    std::vector<int> orden;
+    while (!planificador.vacio()) {
+        orden.push_back(planificador.frente().socket);
+        planificador.sacar();
+    }
+    return orden;
+}
+
+/**
+ * @brief Cliente de prueba por loopback: manda tramas y espera un tipo (salta las demás).
+ */
+struct ClientePrueba {
+    int fd = -1;
+    uint32_t secuencia = 0;
+    std::string pendientes;
+
+    ~ClientePrueba() { cerrar(); }
+
+    void cerrar() {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+
+    bool conectar(int puerto) {
+        sockaddr_in direccion{};
+        direccion.sin_family = AF_INET;
+        direccion.sin_port = htons(static_cast<uint16_t>(puerto));
+        inet_pton(AF_INET, "127.0.0.1", &direccion.sin_addr);
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        timeval limite{5, 0}; // Si el servidor no responde, la prueba falla en vez de colgarse.
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &limite, sizeof(limite));
+        return fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&direccion), sizeof(direccion)) == 0;
+    }
+
+    bool enviar(TipoTrama tipo, std::string_view datos) {
+        std::string trama;
+        codificarTrama(trama, tipo, secuencia++, datos);
+        return send(fd, trama.data(), trama.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(trama.size());
+    }
+
+    bool esperar(TipoTrama tipo) {
+        char lectura[4096];
+        while (true) {
+            while (pendientes.size() >= TAM_CABECERA) {
+                uint32_t largo;
+                std::memcpy(&largo, pendientes.data() + 4, sizeof(largo));
+                size_t total = TAM_CABECERA + ntohl(largo);
+                if (pendientes.size() < total) break;
+                bool esBuscada = static_cast<TipoTrama>(pendientes[0]) == tipo;
+                pendientes.erase(0, total);
+                if (esBuscada) return true;
+            }
+            ssize_t leidos = recv(fd, lectura, sizeof(lectura), 0);
+            if (leidos <= 0) return false;
+            pendientes.append(lectura, static_cast<size_t>(leidos));
+        }
+    }
+
+    /**
+     * @brief Ida y vuelta PING -> PONG: al volver, el servidor ya procesó todo lo anterior.
+     */
+    bool sincronizar() { return enviar(TipoTrama::PING, "") && esperar(TipoTrama::PONG); }
+};
+
+static std::vector<Prueba> pruebasPlanificadorFila() {
+    std::vector<Prueba> pruebas;
+
+    pruebas.push_back({"planificadorFila/slaPorFechaLimite", [] {
+        PlanificadorSLA sla(plazosPorDefecto());
+        Reloj::time_point t0 = Reloj::now();
+        std::vector<int> limites = {50, 10, 40, 30, 0, 20, 60};
+        for (int l : limites) sla.agregar(entradaCon(l, t0 + std::chrono::seconds(l)));
+        COMPROBAR(sla.cantidad() == limites.size());
+        COMPROBAR((vaciarPlanificador(sla) == std::vector<int>{0, 10, 20, 30, 40, 50, 60}));
+    }});
+
+    pruebas.push_back({"planificadorFila/empatesEnOrdenDeLlegada", [] {
+        // El montículo no es estable: el desempate tiene que salir del contador de orden.
+        PlanificadorSLA sla(plazosPorDefecto());
+        Reloj::time_point t0 = Reloj::now();
+        std::vector<int> esperado;
+        for (int i = 0; i < 200; ++i) sla.agregar(entradaCon(i, t0 + std::chrono::seconds(i % 3)));
+        for (int grupo = 0; grupo < 3; ++grupo)
+            for (int i = grupo; i < 200; i += 3) esperado.push_back(i);
+        COMPROBAR(vaciarPlanificador(sla) == esperado);
+
+        // Intercalando altas y bajas también.
+        sla.agregar(entradaCon(1, t0));
+        sla.agregar(entradaCon(2, t0));
+        COMPROBAR(sla.frente().socket == 1);
+        sla.sacar();
+        sla.agregar(entradaCon(3, t0));
+        COMPROBAR((vaciarPlanificador(sla) == std::vector<int>{2, 3}));
+    }});
+
+    pruebas.push_back({"planificadorFila/envejecimiento", [] {
+        // Un normal que lleva esperando casi todo su plazo pasa antes que un prioritario recién llegado.
+        PlazosServicio plazos = plazosPorDefecto();
+        PlanificadorSLA sla(plazos);
+        Reloj::time_point t0 = Reloj::now();
+        auto normal = sla.plazo(ClaseServicio::NORMAL), prioritaria = sla.plazo(ClaseServicio::PRIORITARIA);
+        COMPROBAR(normal == plazos[0] && prioritaria == plazos[1] && prioritaria < normal);
+
+        sla.agregar(entradaCon(1, t0 + normal));                                     // Normal, llegó en t0.
+        sla.agregar(entradaCon(2, t0 + std::chrono::seconds(10) + prioritaria));     // Prioritario a los 10 s.
+        sla.agregar(entradaCon(3, t0 + normal - prioritaria / 2 + prioritaria));     // Prioritario casi al vencer el normal.
+        COMPROBAR((vaciarPlanificador(sla) == std::vector<int>{2, 1, 3}));
+    }});
+
+    pruebas.push_back({"planificadorFila/fifoIgnoraClases", [] {
+        std::unique_ptr<PlanificadorFila> fifo = crearPlanificador(PoliticaFila::FIFO, plazosPorDefecto());
+        COMPROBAR(!fifo->distingueClases());
+        COMPROBAR(fifo->plazo(ClaseServicio::PRIORITARIA) == Reloj::duration::zero());
+        Reloj::time_point t0 = Reloj::now();
+        fifo->agregar(entradaCon(1, t0 + std::chrono::seconds(9)));
+        fifo->agregar(entradaCon(2, t0));
+        COMPROBAR((vaciarPlanificador(*fifo) == std::vector<int>{1, 2}));
+        COMPROBAR(crearPlanificador(PoliticaFila::SLA, plazosPorDefecto())->distingueClases());
+    }});
+
+    pruebas.push_back({"planificadorFila/servidorSaltaEntradasViejas", [] {
+        // El servidor anuncia a cada cliente en std::cout; no debe mezclarse con los resultados.
+        struct Silencio {
+            std::streambuf* anterior = std::cout.rdbuf(nullptr);
+            ~Silencio() { std::cout.rdbuf(anterior); }
+        } silencio;
+
+        ServerSocket servidor;
+        servidor.usarBackend(BackendRed::EPOLL);
+        servidor.usarPlanificador(crearPlanificador(PoliticaFila::SLA, plazosPorDefecto()));
+        COMPROBAR(servidor.autorizarPrioridad({"127.0.0.1"}));
+        COMPROBAR(servidor.crear());
+        int puerto = 47900;
+        while (puerto < 47950 && !(servidor.configurar("127.0.0.1", puerto) && servidor.bindear())) ++puerto;
+        COMPROBAR(puerto < 47950 && servidor.escuchar());
+        std::thread reactor([&servidor] { servidor.aceptarClientes(); });
+
+        // IDs 1..4 en orden de conexión; cada uno sincroniza antes de que entre el siguiente.
+        ClientePrueba clientes[4];
+        for (ClientePrueba& c : clientes) COMPROBAR(c.conectar(puerto) && c.sincronizar());
+
+        // El 3 pide prioridad (su entrada NORMAL queda vieja) y luego intenta cambiar otra vez: se ignora.
+        COMPROBAR(clientes[2].enviar(TipoTrama::CLASE, std::string(1, static_cast<char>(ClaseServicio::PRIORITARIA))));
+        COMPROBAR(clientes[2].enviar(TipoTrama::CLASE, std::string(1, static_cast<char>(ClaseServicio::NORMAL))));
+        COMPROBAR(clientes[2].sincronizar());
+
+        // El 2 cuelga mientras espera; dos idas y vueltas de otro garantizan que el reactor ya lo vio.
+        clientes[1].cerrar();
+        COMPROBAR(clientes[0].sincronizar() && clientes[0].sincronizar());
+
+        std::vector<int> atendidos;
+        while (servidor.tomarSiguienteCliente()) {
+            atendidos.push_back(servidor.obtenerIdPorSocket(servidor.getClienteActual()));
+            servidor.cerrarCliente();
+        }
+        COMPROBAR((atendidos == std::vector<int>{3, 1, 4}));
+
+        servidor.cerrarServidor();
+        reactor.join();
+    }});
+
+    return pruebas;
+}
+
+// ================= COLA MPSC =================
+
+static std::vector<Prueba> pruebasColaMPSC() {
+    std::vector<Prueba> pruebas;
+
+    pruebas.push_back({"colaMPSC/fifoPorProductor", [] {
+        // Entre productores no hay orden definido; lo de cada uno sale en el orden en que lo empujó.
+        const int productores = 4, porProductor = 20000;
+        ColaMPSC<uint64_t> cola;
+        std::vector<std::thread> hilos;
+        for (int p = 0; p < productores; ++p)
+            hilos.emplace_back([&cola, p] {
+                for (uint64_t k = 0; k < porProductor; ++k) cola.empujar((uint64_t(p) << 32) | k);
+            });
+
+        std::vector<uint64_t> siguiente(productores, 0);
+        bool enOrden = true;
+        for (int recibidos = 0; recibidos < productores * porProductor;) {
+            uint64_t valor;
+            if (!cola.sacar(valor)) continue;
+            uint64_t p = valor >> 32, k = valor & 0xFFFFFFFFu;
+            if (p >= productores || k != siguiente[p]) enOrden = false;
+            else ++siguiente[p];
+            ++recibidos;
+        }
+        for (std::thread& h : hilos) h.join();
+        COMPROBAR(enOrden);
+        uint64_t sobra;
+        COMPROBAR(!cola.sacar(sobra));
+
+        // Con un solo productor es FIFO estricto.
+        for (int i = 0; i < 100; ++i) cola.empujar(i);
+        bool fifo = true;
+        for (uint64_t i = 0; i < 100; ++i) fifo = fifo && cola.sacar(sobra) && sobra == i;
+        COMPROBAR(fifo && !cola.sacar(sobra));
+    }});
+
+    pruebas.push_back({"colaMPSC/despiertaAlLlegarAVacia", [] {
+        ColaMPSC<int> cola;
+        COMPROBAR(!cola.esperar(std::chrono::milliseconds(0)));
+
+        // El consumidor ya duerme cuando llega el primero.
+        Reloj::time_point inicio = Reloj::now();
+        std::thread productor([&cola] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            cola.empujar(7);
+        });
+        COMPROBAR(cola.esperar(std::chrono::seconds(5)));
+        COMPROBAR(Reloj::now() - inicio < std::chrono::seconds(2));
+        productor.join();
+        int valor = 0;
+        COMPROBAR(cola.sacar(valor) && valor == 7);
+
+        // Una vez consumido el aviso, la siguiente llegada a la cola vacía vuelve a avisar...
+        COMPROBAR(!cola.esperar(std::chrono::milliseconds(0)));
+        cola.empujar(8);
+        COMPROBAR(cola.esperar(std::chrono::milliseconds(0)));
+        COMPROBAR(cola.sacar(valor) && valor == 8);
+
+        // ...y también la que llega mientras el consumidor todavía vaciaba (aviso ya consumido).
+        cola.empujar(9);
+        COMPROBAR(cola.esperar(std::chrono::milliseconds(0)));
+        cola.empujar(10);
+        COMPROBAR(cola.esperar(std::chrono::milliseconds(0)));
+        COMPROBAR(cola.sacar(valor) && valor == 9 && cola.sacar(valor) && valor == 10);
+
+        cola.despertar();
+        COMPROBAR(cola.esperar(std::chrono::milliseconds(0)) && !cola.sacar(valor));
+    }});
+
+    pruebas.push_back({"colaMPSC/sinPerdidasConcurrentes", [] {
+        // El consumidor solo vacía al despertar: un aviso perdido deja elementos varados y se nota.
+        const int productores = 8, porProductor = 10000;
+        ColaMPSC<uint32_t> cola;
+        std::vector<std::thread> hilos;
+        for (int p = 0; p < productores; ++p)
+            hilos.emplace_back([&cola, p] {
+                for (uint32_t k = 0; k < porProductor; ++k) {
+                    cola.empujar(uint32_t(p) * porProductor + k);
+                    if (k % 512 == 0) std::this_thread::yield();
+                }
+            });
+
+        std::vector<char> visto(productores * porProductor, 0);
+        size_t recibidos = 0, repetidos = 0;
+        Reloj::time_point limite = Reloj::now() + std::chrono::seconds(10);
+        while (recibidos < visto.size() && Reloj::now() < limite) {
+            if (!cola.esperar(std::chrono::milliseconds(1000))) continue;
+            uint32_t valor;
+            while (cola.sacar(valor)) {
+                if (valor < visto.size() && !visto[valor]) { visto[valor] = 1; ++recibidos; }
+                else ++repetidos;
+            }
+        }
+        for (std::thread& h : hilos) h.join();
+        COMPROBAR(recibidos == visto.size());
+        COMPROBAR(repetidos == 0);
+    }});
+
+    return pruebas;
+}
+
+// ================= REGISTRO DE CLIENTES =================
+
+static std::vector<Prueba> pruebasRegistroClientes() {
+    std::vector<Prueba> pruebas;
+
+    pruebas.push_back({"registroClientes/idViejoNoResuelveTrasReuso", [] {
+        RegistroClientes registro;
+        ManejadorCliente viejo = registro.agregar({5, 1, "Cliente 1"});
+        COMPROBAR(registro.quitar(viejo));
+        COMPROBAR(!registro.quitar(viejo));
+
+        ManejadorCliente nuevo = registro.agregar({6, 2, "Cliente 2"});
+        COMPROBAR(nuevo.indice == viejo.indice && nuevo.generacion != viejo.generacion); // Misma ranura.
+        COMPROBAR(registro.buscar(viejo) == nullptr);
+        COMPROBAR(registro.buscarPorId(1) == nullptr);
+        COMPROBAR(registro.buscarPorSocket(5) == nullptr);
+
+        // Quitar con el manejador viejo no se lleva al que ocupa la ranura ahora.
+        COMPROBAR(!registro.quitar(viejo));
+        const InfoCliente* info = registro.buscarPorId(2);
+        COMPROBAR(info && info->socket == 6 && info->nombre == "Cliente 2");
+        COMPROBAR(registro.buscarPorSocket(6) == info && registro.buscar(nuevo) == info);
+        COMPROBAR(registro.cantidad() == 1);
+    }});
+
+    pruebas.push_back({"registroClientes/socketRecicladoReemplaza", [] {
+        // El Kernel reusó el descriptor antes de que viéramos el cierre: el ID anterior deja de existir.
+        RegistroClientes registro;
+        ManejadorCliente anterior = registro.agregar({5, 1, "Cliente 1"});
+        registro.agregar({5, 2, "Cliente 2"});
+        COMPROBAR(registro.cantidad() == 1);
+        COMPROBAR(registro.buscar(anterior) == nullptr && registro.buscarPorId(1) == nullptr);
+        const InfoCliente* info = registro.buscarPorSocket(5);
+        COMPROBAR(info && info->id == 2 && registro.buscarPorId(2) == info);
+    }});
+
+    pruebas.push_back({"registroClientes/indicesConsistentes", [] {
+        // Contra un modelo: tras cada alta o baja, socket -> cliente e id -> cliente dicen lo mismo.
+        RegistroClientes registro;
+        std::map<int, int> idPorSocket;
+        std::map<int, ManejadorCliente> manejadores; // Por id, incluidos los ya dados de baja.
+        std::mt19937 azar(2026);
+        int siguienteId = 1;
+        bool consistente = true;
+
+        for (int paso = 0; paso < 5000; ++paso) {
+            int socket = 3 + static_cast<int>(azar() % 40);
+            if (azar() % 3 != 0) {
+                int id = siguienteId++;
+                manejadores[id] = registro.agregar({socket, id, "Cliente " + std::to_string(id)});
+                idPorSocket[socket] = id;
+            } else if (idPorSocket.count(socket)) {
+                consistente = consistente && registro.quitar(manejadores[idPorSocket[socket]]);
+                idPorSocket.erase(socket);
+            }
+
+            if (registro.cantidad() != idPorSocket.size()) consistente = false;
+            for (int s = 3; s < 43; ++s) {
+                const InfoCliente* info = registro.buscarPorSocket(s);
+                auto esperado = idPorSocket.find(s);
+                if (esperado == idPorSocket.end()) {
+                    if (info) consistente = false;
+                } else if (!info || info->id != esperado->second || registro.buscarPorId(info->id) != info) {
+                    consistente = false;
+                }
+            }
+        }
+        // Los IDs que ya no están en el modelo no resuelven por ninguna vía.
+        for (const auto& [id, manejador] : manejadores) {
+            auto esperado = std::find_if(idPorSocket.begin(), idPorSocket.end(),
+                                         [id](const auto& par) { return par.second == id; });
+            bool vivo = esperado != idPorSocket.end();
+            if ((registro.buscarPorId(id) != nullptr) != vivo || (registro.buscar(manejador) != nullptr) != vivo)
+                consistente = false;
+        }
+        COMPROBAR(consistente);
+    }});
+
+    return pruebas;
+}
+
+// ================= CHAT =================
+
+/**
+ * @brief Bloques de arena que el Chat pidió al sistema (los reciclados no cuentan).
+ */
+static std::atomic<size_t> bloquesPedidos{0};
+
+// Solo para contar: la arena del Chat pide sus bloques con new char[TAM_BLOQUE].
+void* operator new[](std::size_t tam) {
+    if (tam == Chat::TAM_BLOQUE) bloquesPedidos.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(tam ? tam : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+/**
+ * @brief Agrega 'cuantos' textos de 30000 bytes (dos por bloque) y dice cuántos bloques nuevos se pidieron.
+ */
+static size_t escribirBloques(Chat& chat, int cuantos) {
+    size_t antes = bloquesPedidos.load();
+    std::string texto(30000, 'x');
+    for (int i = 0; i < cuantos; ++i) chat.agregarMensaje("Cliente 1", texto, false);
+    return bloquesPedidos.load() - antes;
+}
+
+static std::vector<Prueba> pruebasChat() {
+    std::vector<Prueba> pruebas;
+
+    pruebas.push_back({"chat/cambiosDesdeElCursor", [] {
+        Chat chat;
+        uint64_t version = 0;
+        std::vector<Mensaje> copia;
+        COMPROBAR(!chat.obtenerCambios(version, copia));
+
+        chat.agregarMensaje("Cliente 1", "uno", false);
+        chat.agregarMensaje("Yo", "dos", true);
+        chat.agregarMensaje("Cliente 1", "tres", false);
+        COMPROBAR(chat.obtenerCambios(version, copia));
+        COMPROBAR(version == 3 && version == chat.obtenerVersion() && copia.size() == 3);
+        COMPROBAR(!chat.obtenerCambios(version, copia)); // Nada nuevo: no toca la copia.
+
+        // Solo se agrega lo posterior al cursor.
+        chat.agregarMensaje("Yo", "cuatro", true);
+        COMPROBAR(chat.obtenerCambios(version, copia));
+        COMPROBAR(version == 4 && copia.size() == 4 && copia[3].texto == "cuatro" && copia[3].esMio);
+        COMPROBAR(copia[0].emisor == "Cliente 1" && copia[1].texto == "dos" && copia[2].texto == "tres");
+
+        // Una limpieza que el consumidor no vio lo obliga a empezar de cero.
+        chat.limpiarHistorial();
+        chat.agregarMensaje("Cliente 2", "otra sesion", false);
+        COMPROBAR(chat.obtenerCambios(version, copia));
+        COMPROBAR(copia.size() == 1 && copia[0].emisor == "Cliente 2" && version == chat.obtenerVersion());
+
+        // Un consumidor que sí vio la limpieza (cursor justo en la base) solo recibe lo nuevo.
+        uint64_t otraVersion = 0;
+        std::vector<Mensaje> otraCopia;
+        chat.limpiarHistorial();
+        COMPROBAR(chat.obtenerCambios(otraVersion, otraCopia) && otraCopia.empty());
+        chat.agregarMensaje("Cliente 3", "a", false);
+        COMPROBAR(chat.obtenerCambios(otraVersion, otraCopia));
+        COMPROBAR(otraCopia.size() == 1 && otraCopia[0].texto == "a");
+    }});
+
+    pruebas.push_back({"chat/cambiosConEscritorConcurrente", [] {
+        // El lector va sincronizando mientras se escribe: al final su copia es exactamente el historial.
+        const int mensajes = 20000;
+        Chat chat;
+        std::thread escritor([&chat] {
+            for (int i = 0; i < mensajes; ++i) chat.agregarMensaje("Cliente 1", std::to_string(i), false);
+        });
+
+        uint64_t version = 0;
+        std::vector<Mensaje> copia;
+        while (copia.size() < static_cast<size_t>(mensajes)) chat.obtenerCambios(version, copia);
+        escritor.join();
+
+        bool enOrden = copia.size() == static_cast<size_t>(mensajes);
+        for (size_t i = 0; enOrden && i < copia.size(); ++i) enOrden = copia[i].texto == std::to_string(i);
+        COMPROBAR(enOrden);
+        COMPROBAR(version == chat.obtenerVersion() && !chat.obtenerCambios(version, copia));
+    }});
+
+    pruebas.push_back({"chat/vistaEstableConEscritores", [] {
+        // Cada vista ve un prefijo de lo de cada escritor, y no cambia aunque se siga escribiendo.
+        const int escritores = 3, porEscritor = 5000;
+        Chat chat;
+        std::vector<std::thread> hilos;
+        for (int e = 0; e < escritores; ++e)
+            hilos.emplace_back([&chat, e] {
+                std::string emisor = "Cliente " + std::to_string(e);
+                for (int i = 0; i < porEscritor; ++i) chat.agregarMensaje(emisor, std::to_string(i), e == 0);
+            });
+
+        auto copiar = [](const Chat::Vista& vista) {
+            std::vector<Mensaje> copia;
+            for (VistaMensaje m : vista) copia.push_back(m.copia());
+            return copia;
+        };
+        auto bienFormada = [](const std::vector<Mensaje>& copia) {
+            std::vector<int> siguiente(escritores, 0);
+            for (const Mensaje& m : copia) {
+                if (m.emisor.size() != 9 || m.emisor.compare(0, 8, "Cliente ") != 0) return false;
+                int e = m.emisor[8] - '0';
+                if (e < 0 || e >= escritores || m.esMio != (e == 0) || m.texto != std::to_string(siguiente[e]++)) return false;
+            }
+            return true;
+        };
+
+        Chat::Vista primera = chat.obtenerVista();
+        std::vector<Mensaje> contenidoPrimera = copiar(primera);
+        bool consistentes = bienFormada(contenidoPrimera);
+        size_t anterior = 0;
+        while (anterior < static_cast<size_t>(escritores * porEscritor)) {
+            Chat::Vista vista = chat.obtenerVista();
+            std::vector<Mensaje> copia = copiar(vista);
+            if (copia.size() != vista.size() || vista.size() < anterior || !bienFormada(copia)) consistentes = false;
+            if (vista.obtenerVersion() != vista.obtenerVersionBase() + vista.size()) consistentes = false;
+            if (copiar(vista).size() != copia.size()) consistentes = false; // Releerla da lo mismo.
+            anterior = vista.size();
+        }
+        for (std::thread& h : hilos) h.join();
+        COMPROBAR(consistentes);
+
+        // La primera vista sigue igual, incluso después de limpiar el historial.
+        chat.limpiarHistorial();
+        chat.agregarMensaje("Cliente 9", "nueva sesion", false);
+        std::vector<Mensaje> ahora = copiar(primera);
+        bool igual = ahora.size() == contenidoPrimera.size();
+        for (size_t i = 0; igual && i < ahora.size(); ++i)
+            igual = ahora[i].emisor == contenidoPrimera[i].emisor && ahora[i].texto == contenidoPrimera[i].texto;
+        COMPROBAR(igual);
+        COMPROBAR(chat.obtenerVista().size() == 1);
+    }});
+
+    pruebas.push_back({"chat/arenaReciclaHasta16Bloques", [] {
+        Chat chat;
+        COMPROBAR(Chat::MAX_BLOQUES_LIBRES == 16);
+        COMPROBAR(escribirBloques(chat, 40) == 20);
+
+        // De los 20 bloques de la sesión anterior solo se guardan 16.
+        chat.limpiarHistorial();
+        COMPROBAR(escribirBloques(chat, 40) == 4);
+
+        // Una sesión corta sale entera de la reserva, y al limpiar la reserva vuelve a 16.
+        chat.limpiarHistorial();
+        COMPROBAR(escribirBloques(chat, 10) == 0);
+        chat.limpiarHistorial();
+        COMPROBAR(escribirBloques(chat, 40) == 4);
+
+        // Mientras una vista lee la sesión vieja, sus bloques no se reciclan...
+        std::optional<Chat::Vista> vista = chat.obtenerVista();
+        chat.limpiarHistorial();
+        COMPROBAR(escribirBloques(chat, 10) == 5);
+        VistaMensaje primero = (*vista)[0];
+        COMPROBAR(vista->size() == 40 && primero.texto.size() == 30000 && primero.texto.back() == 'x');
+
+        // ...y en cuanto se suelta, la siguiente escritura los recupera (se reclama al terminar de agregar).
+        vista.reset();
+        chat.agregarMensaje("Cliente 1", "corto", false);
+        COMPROBAR(escribirBloques(chat, 4) == 0);
+        chat.limpiarHistorial();
+        COMPROBAR(escribirBloques(chat, 40) == 4);
+    }});
+
+    pruebas.push_back({"chat/maximoDeEmisores", [] {
+        struct Silencio {
+            std::streambuf* anterior = std::cerr.rdbuf(nullptr);
+            ~Silencio() { std::cerr.rdbuf(anterior); }
+        } silencio;
+
+        Chat chat;
+        for (size_t i = 0; i < Chat::MAX_EMISORES; ++i) chat.agregarMensaje("Cliente " + std::to_string(i), "hola", false);
+        COMPROBAR(chat.obtenerVista().size() == Chat::MAX_EMISORES);
+
+        // Uno más se descarta; los ya conocidos siguen pudiendo escribir.
+        chat.agregarMensaje("Cliente nuevo", "no entra", false);
+        COMPROBAR(chat.obtenerVista().size() == Chat::MAX_EMISORES);
+        chat.agregarMensaje("Cliente 7", "si entra", false);
+        Chat::Vista vista = chat.obtenerVista();
+        COMPROBAR(vista.size() == Chat::MAX_EMISORES + 1);
+        COMPROBAR(vista[Chat::MAX_EMISORES].emisor == "Cliente 7" && vista[Chat::MAX_EMISORES].texto == "si entra");
+        bool emisoresBien = true;
+        for (size_t i = 0; i < Chat::MAX_EMISORES; ++i) emisoresBien = emisoresBien && vista[i].emisor == "Cliente " + std::to_string(i);
+        COMPROBAR(emisoresBien);
+
+        // La tabla es por sesión.
+        chat.limpiarHistorial();
+        chat.agregarMensaje("Cliente nuevo", "ahora si", false);
+        COMPROBAR(chat.obtenerVista().size() == 1 && chat.obtenerVista()[0].emisor == "Cliente nuevo");
+    }});
+
+    return pruebas;
+}
+
+// ================= CANAL DE MEMORIA =================
+
+/**
+ * @brief Copia de la disposición de CabeceraCanal (canalMemoria.cpp), para corromper los índices a propósito.
+ */
+struct CabeceraEspejo {
+    uint32_t magia;
+    uint32_t version;
+    uint64_t capacidad;
+    AnilloCompartido haciaServidor;
+    AnilloCompartido haciaCliente;
+};
+
+/**
+ * @brief Cliente y servidor de un canal, con la prueba en medio de la negociación.
+ * * La oferta pasa por la prueba (socketpair -> prueba -> socketpair) para
+ * quedarse con un descriptor de la memoria, como lo tendría un cliente hostil.
+ */
+struct ParCanal {
+    std::unique_ptr<CanalMemoria> servidor, cliente;
+    int memoriaFd = -1;
+
+    ~ParCanal() {
+        if (memoriaFd != -1) close(memoriaFd);
+    }
+
+    bool negociar() {
+        int haciaPrueba[2], haciaCliente[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, haciaPrueba) != 0) return false;
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, haciaCliente) != 0) return false;
+
+        servidor = CanalMemoria::crear();
+        bool listo = servidor && servidor->ofrecer(haciaPrueba[0]) && reenviar(haciaPrueba[1], haciaCliente[0]);
+        if (listo) cliente = CanalMemoria::aceptarOferta(haciaCliente[1]);
+        for (int fd : {haciaPrueba[0], haciaPrueba[1], haciaCliente[0], haciaCliente[1]}) close(fd);
+        return listo && cliente;
+    }
+
+    /**
+     * @brief Mapea la cabecera por cuenta propia (otra vista de la misma memoria).
+     */
+    CabeceraEspejo* cabecera() {
+        void* p = mmap(nullptr, sizeof(CabeceraEspejo), PROT_READ | PROT_WRITE, MAP_SHARED, memoriaFd, 0);
+        return p == MAP_FAILED ? nullptr : static_cast<CabeceraEspejo*>(p);
+    }
+
+private:
+    bool reenviar(int desde, int hacia) {
+        char byte = 0;
+        iovec tramo{&byte, 1};
+        alignas(cmsghdr) char control[CMSG_SPACE(3 * sizeof(int))] = {};
+        msghdr mensaje{};
+        mensaje.msg_iov = &tramo;
+        mensaje.msg_iovlen = 1;
+        mensaje.msg_control = control;
+        mensaje.msg_controllen = sizeof(control);
+        if (recvmsg(desde, &mensaje, MSG_CMSG_CLOEXEC) != 1) return false;
+
+        cmsghdr* cm = CMSG_FIRSTHDR(&mensaje);
+        if (!cm || cm->cmsg_len != CMSG_LEN(3 * sizeof(int))) return false;
+        int descriptores[3];
+        std::memcpy(descriptores, CMSG_DATA(cm), sizeof(descriptores));
+        memoriaFd = dup(descriptores[0]);
+
+        // Se reenvía el mismo mensaje (byte y descriptores) al cliente.
+        bool enviado = sendmsg(hacia, &mensaje, MSG_NOSIGNAL) == 1;
+        for (int fd : descriptores) close(fd);
+        return enviado && memoriaFd != -1;
+    }
+};
+
+/**
+ * @brief Bytes distinguibles por posición (un corrimiento o un tramo repetido se nota).
+ */
+static std::string patron(size_t desde, size_t n) {
+    std::string datos(n, '\0');
+    for (size_t i = 0; i < n; ++i) datos[i] = static_cast<char>((desde + i) * 131 + (desde + i) / 251);
+    return datos;
+}
+
+static bool timbreSono(const CanalMemoria& canal) {
+    pollfd p{canal.timbre(), POLLIN, 0};
+    return poll(&p, 1, 0) == 1;
+}
+
+static std::vector<Prueba> pruebasCanalMemoria() {
+    std::vector<Prueba> pruebas;
+
+    pruebas.push_back({"canalMemoria/memoriaSellada", [] {
+        ParCanal par;
+        COMPROBAR(par.negociar());
+        int sellos = fcntl(par.memoriaFd, F_GET_SEALS);
+        COMPROBAR(sellos != -1 && (sellos & F_SEAL_SHRINK) && (sellos & F_SEAL_GROW) && (sellos & F_SEAL_SEAL));
+
+        // Quien tenga el descriptor no puede achicar la memoria bajo los pies del servidor.
+        struct stat info;
+        COMPROBAR(fstat(par.memoriaFd, &info) == 0);
+        COMPROBAR(ftruncate(par.memoriaFd, 0) != 0 && ftruncate(par.memoriaFd, info.st_size + 4096) != 0);
+        COMPROBAR(fcntl(par.memoriaFd, F_ADD_SEALS, F_SEAL_WRITE) != 0);
+    }});
+
+    pruebas.push_back({"canalMemoria/anilloLleno", [] {
+        ParCanal par;
+        COMPROBAR(par.negociar());
+        const size_t capacidad = CanalMemoria::CAPACIDAD;
+        std::string datos = patron(0, capacidad + 100);
+
+        COMPROBAR(par.servidor->escribir(datos.data(), datos.size()) == capacidad);
+        COMPROBAR(par.servidor->escribir(datos.data(), 1) == 0);
+        COMPROBAR(par.servidor->esperarLugar());
+        par.servidor->apagarTimbre();
+
+        // Al leer, el cliente libera lugar y despierta al servidor que esperaba.
+        BufferLectura buffer;
+        COMPROBAR(par.cliente->leerEn(buffer) == static_cast<long>(capacidad));
+        COMPROBAR(buffer.pendiente() == std::string_view(datos).substr(0, capacidad));
+        COMPROBAR(timbreSono(*par.servidor));
+        COMPROBAR(!par.servidor->esperarLugar());
+        COMPROBAR(par.servidor->escribir(datos.data() + capacidad, 100) == 100);
+    }});
+
+    pruebas.push_back({"canalMemoria/vueltaAlAnilloByteExacto", [] {
+        ParCanal par;
+        COMPROBAR(par.negociar());
+        const size_t capacidad = CanalMemoria::CAPACIDAD;
+
+        // Un escrito que empieza 100 bytes antes del final se parte en dos memcpy.
+        std::string primero = patron(0, capacidad - 100), cruza = patron(capacidad - 100, 300);
+        BufferLectura entrada;
+        COMPROBAR(par.servidor->escribir(primero.data(), primero.size()) == primero.size());
+        COMPROBAR(par.cliente->leerEn(entrada) == static_cast<long>(primero.size()));
+        entrada.consumir(primero.size());
+        COMPROBAR(par.servidor->escribir(cruza.data(), cruza.size()) == cruza.size());
+        COMPROBAR(par.cliente->leerEn(entrada) == 300 && entrada.pendiente() == cruza);
+
+        // Tramos de largo variable en ambos sentidos, varias vueltas completas.
+        std::mt19937 azar(21);
+        for (CanalMemoria* escritor : {par.cliente.get(), par.servidor.get()}) {
+            CanalMemoria* lector = escritor == par.cliente.get() ? par.servidor.get() : par.cliente.get();
+            size_t enviados = 0;
+            std::string esperado, recibido;
+            BufferLectura buffer(1);
+            while (enviados < 5 * capacidad) {
+                std::string tramo = patron(enviados, 1 + azar() % 20000);
+                size_t cupo = escritor->escribir(tramo.data(), tramo.size());
+                esperado.append(tramo, 0, cupo);
+                enviados += cupo;
+                if (azar() % 2 == 0 || cupo < tramo.size()) {
+                    if (lector->leerEn(buffer) < 0) break;
+                    recibido.append(buffer.pendiente());
+                    buffer.consumir(buffer.pendiente().size());
+                }
+            }
+            COMPROBAR(lector->leerEn(buffer) >= 0);
+            recibido.append(buffer.pendiente());
+            COMPROBAR(recibido.size() == esperado.size() && recibido == esperado);
+        }
+    }});
+
+    pruebas.push_back({"canalMemoria/indicesCorruptos", [] {
+        ParCanal par;
+        COMPROBAR(par.negociar());
+        CabeceraEspejo* cabecera = par.cabecera();
+        COMPROBAR(cabecera && cabecera->capacidad == CanalMemoria::CAPACIDAD);
+        if (!cabecera) return;
+
+        // El otro lado dice haber escrito más de lo que cabe: el lector lo trata como corrupto.
+        std::string datos = patron(0, 10);
+        COMPROBAR(par.servidor->escribir(datos.data(), datos.size()) == datos.size());
+        cabecera->haciaCliente.escrito.store(cabecera->haciaCliente.leido.load() + CanalMemoria::CAPACIDAD + 1);
+        BufferLectura buffer;
+        COMPROBAR(par.cliente->leerEn(buffer) == -1);
+        COMPROBAR(buffer.pendiente().empty());
+
+        // 'leido' por delante de 'escrito': el escritor no copia nada.
+        uint64_t escrito = cabecera->haciaServidor.escrito.load();
+        cabecera->haciaServidor.leido.store(escrito + 1);
+        COMPROBAR(par.cliente->escribir(datos.data(), datos.size()) == 0);
+        COMPROBAR(cabecera->haciaServidor.escrito.load() == escrito);
+
+        // Justo la capacidad sigue siendo válido (anillo lleno).
+        cabecera->haciaServidor.leido.store(escrito);
+        cabecera->haciaServidor.escrito.store(escrito + CanalMemoria::CAPACIDAD);
+        COMPROBAR(par.servidor->leerEn(buffer) == static_cast<long>(CanalMemoria::CAPACIDAD));
+        munmap(cabecera, sizeof(CabeceraEspejo));
+    }});
+
+    return pruebas;
+}
+
+// ================= PRINCIPAL =================
+
+static void uso() {
+    std::cerr << "Uso: pruebas [--filtro TEXTO]\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string filtro;
+    for (int i = 1; i < argc; ++i) {
+        std::string opcion = argv[i];
+        if (i + 1 >= argc) { uso(); return 1; }
+        const char* valor = argv[++i];
+        if (opcion == "--filtro") filtro = valor;
+        else { uso(); return 1; }
+    }
+
+    char plantilla[] = "/tmp/pruebasXXXXXX";
+    const char* temporal = mkdtemp(plantilla);
+    if (!temporal) {
+        std::cerr << "[ERROR] No se pudo crear una carpeta temporal.\n";
+        return 1;
+    }
+
+    std::vector<Prueba> pruebas;
+    for (auto grupo : {pruebasProtocolo(), pruebasBufferSalida(), pruebasAlmacenTickets(temporal), pruebasWAL(temporal),
+                        pruebasPosicionesCola(), pruebasPlanificadorFila(), pruebasColaMPSC(),
+                        pruebasRegistroClientes(), pruebasChat(), pruebasCanalMemoria()})
+        pruebas.insert(pruebas.end(), grupo.begin(), grupo.end());
+
+    int corridas = 0, fallidas = 0;
+    for (const Prueba& p : pruebas) {
+        if (!filtro.empty() && p.nombre.find(filtro) == std::string::npos) continue;
+        fallas = 0;
+        p.correr();
+        ++corridas;
+        if (fallas > 0) ++fallidas;
+        std::cout << (fallas > 0 ? "FALLA  " : "ok     ") << p.nombre << std::endl;
+    }
+
+    std::string limpiar = std::string("rm -rf '") + temporal + "'";
+    if (std::system(limpiar.c_str()) != 0) std::cerr << "[AVISO] No se pudo borrar " << temporal << ".\n";
+
+    if (corridas == 0) {
+        std::cerr << "[ERROR] Ninguna prueba coincide con '" << filtro << "'.\n";
+        return 1;
+    }
+    std::cout << corridas - fallidas << "/" << corridas << " pruebas correctas.\n";
+    return fallidas > 0 ? 1 : 0;
+}
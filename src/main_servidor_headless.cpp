@@ -0,0 +1,215 @@
+/**
+ * @file main_servidor_headless.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Servidor de soporte sin interfaz gráfica.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Mismo núcleo que el servidor gráfico (ServicioSoporte), pero sin SFML ni
+ * arial.ttf: sirve para correr en servidores sin pantalla, arrancar en
+ * milisegundos y medir el rendimiento de la red.
+ *
+ * Uso: servidor_headless [opciones]
+ *   --ip <ip>                 Dirección a escuchar (127.0.0.1).
+ *   --puerto <n>              Puerto (8080).
+ *   --espera <n>              Backlog de listen() (SOMAXCONN).
+ *   --tickets <carpeta>       Almacén de tickets (tickets).
+ *   --wal <carpeta>           Carpeta del WAL (wal).
+ *   --durabilidad <modo>      ninguna | lote | ticket (lote).
+ *   --backend <red>           epoll | io_uring (epoll).
+ *   --fragmentos <n>          Reactores, cada uno con su socket SO_REUSEPORT (1; 0 = uno por núcleo).
+ *   --fijar-nucleos           Fija el hilo de cada reactor a un núcleo distinto.
+ *   --sin-memoria             No ofrece memoria compartida a los clientes locales (todo por TCP).
+ *   --fila <orden>            fifo | sla: por llegada o primero quien vence antes (fifo).
+ *   --sla-normal <s>          Plazo de la clase NORMAL en segundos, con --fila sla (300).
+ *   --sla-prioritaria <s>     Plazo de la clase PRIORITARIA en segundos, con --fila sla (30).
+ *   --prioridad-ip <ip>       IP a la que se le concede la clase PRIORITARIA si la pide
+ *                             (se puede repetir; sin ninguna, todos se atienden como NORMAL).
+ *   --eco                     Responde a cada mensaje con el mismo texto.
+ *   --guion <archivo>         Responde con las líneas del archivo, en orden y en ciclo.
+ *
+ * Sin --eco ni --guion el agente es la entrada estándar: cada línea se envía
+ * al cliente activo, "/aviso <texto>" lo manda a todos los que esperan en la
+ * cola y "/salir" (o fin de archivo) apaga el servidor.
+ * Con respondedor automático corre hasta recibir SIGINT o SIGTERM.
+ */
+
+#include "../include/servicio.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <chrono>
+#include <pthread.h>
+
+/**
+ * @brief Respuestas automáticas: eco o un guion que se repite.
+ */
+struct Respondedor {
+    bool eco = false;
+    std::vector<std::string> guion;
+    size_t siguiente = 0; ///< Solo lo usa el hilo lector.
+
+    bool activo() const { return eco || !guion.empty(); }
+
+    const std::string& responder(const std::string& recibido) {
+        if (eco) return recibido;
+        const std::string& linea = guion[siguiente];
+        siguiente = (siguiente + 1) % guion.size();
+        return linea;
+    }
+};
+
+static void uso() {
+    std::cerr << "Uso: servidor_headless [--ip IP] [--puerto N] [--espera N] [--tickets DIR] [--wal DIR]\n"
+              << "                         [--durabilidad ninguna|lote|ticket] [--backend epoll|io_uring]\n"
+              << "                         [--fragmentos N] [--fijar-nucleos] [--sin-memoria]\n"
+              << "                         [--fila fifo|sla] [--sla-normal S] [--sla-prioritaria S]\n"
+              << "                         [--prioridad-ip IP]...\n"
+              << "                         [--eco | --guion ARCHIVO]\n";
+}
+
+static bool leerDurabilidad(const char* texto, PoliticaDurabilidad& politica) {
+    if (std::strcmp(texto, "ninguna") == 0) politica = PoliticaDurabilidad::NINGUNA;
+    else if (std::strcmp(texto, "lote") == 0) politica = PoliticaDurabilidad::POR_LOTE;
+    else if (std::strcmp(texto, "ticket") == 0) politica = PoliticaDurabilidad::POR_TICKET;
+    else return false;
+    return true;
+}
+
+static bool leerBackend(const char* texto, BackendRed& backend) {
+    if (std::strcmp(texto, "epoll") == 0) backend = BackendRed::EPOLL;
+    else if (std::strcmp(texto, "io_uring") == 0) backend = BackendRed::IO_URING;
+    else return false;
+    return true;
+}
+
+static bool leerFila(const char* texto, PoliticaFila& politica) {
+    if (std::strcmp(texto, "fifo") == 0) politica = PoliticaFila::FIFO;
+    else if (std::strcmp(texto, "sla") == 0) politica = PoliticaFila::SLA;
+    else return false;
+    return true;
+}
+
+static bool leerPlazo(const char* texto, std::chrono::seconds& plazo) {
+    // Un plazo de 0 (o "30s", que atoi leería como 30) no es un SLA: mejor avisar.
+    char* resto;
+    errno = 0;
+    long segundos = std::strtol(texto, &resto, 10);
+    if (*texto == '\0' || *resto != '\0' || errno == ERANGE || segundos <= 0) return false;
+    plazo = std::chrono::seconds(segundos);
+    return true;
+}
+
+static bool leerGuion(const char* archivo, std::vector<std::string>& guion) {
+    std::ifstream entrada(archivo);
+    if (!entrada) return false;
+    std::string linea;
+    while (std::getline(entrada, linea))
+        if (!linea.empty()) guion.push_back(linea);
+    return !guion.empty();
+}
+
+int main(int argc, char* argv[]) {
+    ConfigServicio config;
+    Respondedor respondedor;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string opcion = argv[i];
+        bool hayValor = i + 1 < argc;
+        if (opcion == "--eco") {
+            respondedor.eco = true;
+        } else if (opcion == "--fijar-nucleos") {
+            config.fijarNucleos = true;
+        } else if (opcion == "--sin-memoria") {
+            config.memoriaCompartida = false;
+        } else if (opcion == "--fragmentos" && hayValor) {
+            config.fragmentos = std::atoi(argv[++i]);
+        } else if (opcion == "--ip" && hayValor) {
+            config.ip = argv[++i];
+        } else if (opcion == "--puerto" && hayValor) {
+            config.puerto = std::atoi(argv[++i]);
+        } else if (opcion == "--espera" && hayValor) {
+            config.espera = std::atoi(argv[++i]);
+        } else if (opcion == "--tickets" && hayValor) {
+            config.carpetaTickets = argv[++i];
+        } else if (opcion == "--wal" && hayValor) {
+            config.carpetaWAL = argv[++i];
+        } else if (opcion == "--durabilidad" && hayValor) {
+            if (!leerDurabilidad(argv[++i], config.durabilidad)) { uso(); return 1; }
+        } else if (opcion == "--backend" && hayValor) {
+            if (!leerBackend(argv[++i], config.backend)) { uso(); return 1; }
+        } else if (opcion == "--fila" && hayValor) {
+            if (!leerFila(argv[++i], config.politicaFila)) { uso(); return 1; }
+        } else if (opcion == "--sla-normal" && hayValor) {
+            if (!leerPlazo(argv[++i], config.plazos[static_cast<size_t>(ClaseServicio::NORMAL)])) { uso(); return 1; }
+        } else if (opcion == "--sla-prioritaria" && hayValor) {
+            if (!leerPlazo(argv[++i], config.plazos[static_cast<size_t>(ClaseServicio::PRIORITARIA)])) { uso(); return 1; }
+        } else if (opcion == "--prioridad-ip" && hayValor) {
+            config.autorizadosPrioridad.push_back(argv[++i]);
+        } else if (opcion == "--guion" && hayValor) {
+            if (!leerGuion(argv[++i], respondedor.guion)) {
+                std::cerr << "[ERROR] No se pudo leer el guion " << argv[i] << ".\n";
+                return 1;
+            }
+        } else {
+            uso();
+            return 1;
+        }
+    }
+
+    // Con respondedor automático se apaga por señal: se bloquean ANTES de crear
+    // hilos (los heredan) y solo el hilo principal las recibe con sigwait().
+    sigset_t senales;
+    sigemptyset(&senales);
+    sigaddset(&senales, SIGINT);
+    sigaddset(&senales, SIGTERM);
+    if (respondedor.activo()) pthread_sigmask(SIG_BLOCK, &senales, nullptr);
+
+    ServicioSoporte servicio(config);
+
+    if (respondedor.activo()) {
+        servicio.alRecibirMensaje([&servicio, &respondedor](const std::string&, const std::string& texto) {
+            servicio.enviar(respondedor.responder(texto));
+        });
+    } else {
+        servicio.alRecibirMensaje([](const std::string& nombre, const std::string& texto) {
+            std::cout << "[" << nombre << "] " << texto << "\n";
+        });
+    }
+
+    if (!servicio.iniciar()) return 1;
+    std::cout << "Servidor listo en " << config.ip << ":" << config.puerto << ".\n";
+
+    // Las sesiones avanzan solas en el hilo de sesiones; aquí solo se responde o se espera la señal.
+    if (respondedor.activo()) {
+        int senal = 0;
+        sigwait(&senales, &senal);
+        std::cout << "[SISTEMA] Senal " << senal << " recibida, apagando...\n";
+    } else {
+        std::string linea;
+        while (std::getline(std::cin, linea)) {
+            if (linea == "/salir") break;
+            if (linea.empty()) continue;
+            if (linea.rfind("/aviso ", 0) == 0) {
+                auto inicio = std::chrono::steady_clock::now();
+                size_t destinatarios = servicio.difundir(std::string_view(linea).substr(7));
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count();
+                std::cout << "[SISTEMA] Aviso encolado para " << destinatarios << " cliente(s) en " << ms << " ms.\n";
+                continue;
+            }
+            EstadoEnvio estadoEnvio = servicio.enviar(linea);
+            if (estadoEnvio == EstadoEnvio::CERRADO) std::cout << "[AVISO] No hay cliente activo.\n";
+            if (estadoEnvio == EstadoEnvio::SATURADO) std::cout << "[AVISO] El cliente no esta leyendo; el mensaje espera en su buffer.\n";
+            if (estadoEnvio == EstadoEnvio::DEMASIADO_GRANDE) std::cout << "[AVISO] El mensaje es demasiado largo; no se envio.\n";
+        }
+    }
+
+    servicio.detener();
+    return 0;
+}
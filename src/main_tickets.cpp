@@ -0,0 +1,142 @@
+/**
+ * @file main_tickets.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Herramienta de línea de comandos para consultar el almacén de tickets.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Abre el almacén en solo lectura (puede usarse con el servidor corriendo)
+ * y permite buscar tickets o exportarlos al formato .txt de siempre.
+ *
+ * Uso: tickets <carpeta> <comando> [argumentos]
+ *   listar                      Todos los tickets (uno por línea).
+ *   ver <ticketId>              Imprime el ticket en formato de texto.
+ *   cliente <clienteId>         Tickets de un cliente.
+ *   fechas <desde> <hasta>      Tickets en un rango (segundos Unix o AAAA-MM-DD).
+ *   exportar <ticketId> [arch]  Escribe el .txt (por defecto Ticket_<nombre>_<fecha>.txt).
+ */
+
+#include "../include/almacenTickets.h"
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <climits>
+
+static void uso() {
+    std::cerr << "Uso: tickets <carpeta> <comando> [argumentos]\n"
+              << "  listar\n"
+              << "  ver <ticketId>\n"
+              << "  cliente <clienteId>\n"
+              << "  fechas <desde> <hasta>   (segundos Unix o AAAA-MM-DD)\n"
+              << "  exportar <ticketId> [archivo]\n";
+}
+
+/**
+ * @brief Acepta segundos Unix o una fecha AAAA-MM-DD (hora local, inicio del día).
+ */
+static bool leerFecha(const char* texto, int64_t& fecha) {
+    std::tm tm{};
+    const char* fin = strptime(texto, "%Y-%m-%d", &tm);
+    if (fin && *fin == '\0') {
+        tm.tm_isdst = -1;
+        fecha = static_cast<int64_t>(std::mktime(&tm));
+        return true;
+    }
+
+    char* resto;
+    long long valor = std::strtoll(texto, &resto, 10);
+    if (*texto == '\0' || *resto != '\0') return false;
+    fecha = valor;
+    return true;
+}
+
+static void imprimirResumen(const AlmacenTickets& almacen, const EntradaIndice& e) {
+    RegistroTicket r;
+    if (!almacen.leer(e, r)) {
+        std::cout << "#" << e.ticketId << "\t(ilegible)\n";
+        return;
+    }
+
+    char fechaTexto[32];
+    std::time_t fecha = static_cast<std::time_t>(r.fecha);
+    std::tm tm;
+    localtime_r(&fecha, &tm);
+    std::strftime(fechaTexto, sizeof(fechaTexto), "%Y-%m-%d %H:%M:%S", &tm);
+
+    std::cout << "#" << r.ticketId << "\t" << fechaTexto << "\tcliente " << r.clienteId
+              << "\t" << r.nombre << "\t" << r.mensajes.size() << " msjs\n";
+}
+
+static bool leerTicket(const AlmacenTickets& almacen, const char* texto, RegistroTicket& r) {
+    EntradaIndice e;
+    uint64_t ticketId = std::strtoull(texto, nullptr, 10);
+    if (!almacen.buscarPorTicket(ticketId, e)) {
+        std::cerr << "No existe el ticket #" << texto << ".\n";
+        return false;
+    }
+    return almacen.leer(e, r);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        uso();
+        return 1;
+    }
+
+    AlmacenTickets almacen;
+    if (!almacen.abrir(argv[1], true)) return 1;
+
+    std::string comando = argv[2];
+
+    if (comando == "listar") {
+        for (const EntradaIndice& e : almacen.buscarPorFecha(INT64_MIN, INT64_MAX)) imprimirResumen(almacen, e);
+        std::cout << almacen.cantidad() << " tickets.\n";
+        return 0;
+    }
+
+    if (comando == "cliente" && argc >= 4) {
+        uint32_t clienteId = static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10));
+        for (const EntradaIndice& e : almacen.buscarPorCliente(clienteId)) imprimirResumen(almacen, e);
+        return 0;
+    }
+
+    if (comando == "fechas" && argc >= 5) {
+        int64_t desde, hasta;
+        if (!leerFecha(argv[3], desde) || !leerFecha(argv[4], hasta)) {
+            uso();
+            return 1;
+        }
+        // Una fecha AAAA-MM-DD como límite superior incluye todo ese día.
+        if (std::strchr(argv[4], '-')) hasta += 24 * 60 * 60 - 1;
+        for (const EntradaIndice& e : almacen.buscarPorFecha(desde, hasta)) imprimirResumen(almacen, e);
+        return 0;
+    }
+
+    if ((comando == "ver" || comando == "exportar") && argc >= 4) {
+        RegistroTicket r;
+        if (!leerTicket(almacen, argv[3], r)) return 1;
+
+        std::string texto;
+        exportarTexto(r, texto);
+
+        if (comando == "ver") {
+            std::cout << texto;
+            return 0;
+        }
+
+        std::string archivo = argc >= 5 ? argv[4] : "Ticket_" + r.nombre + "_" + std::to_string(r.fecha) + ".txt";
+        std::ofstream salida(archivo, std::ios::binary);
+        if (!salida || !(salida << texto)) {
+            std::cerr << "[ERROR] No se pudo escribir " << archivo << ".\n";
+            return 1;
+        }
+        std::cout << "Ticket #" << r.ticketId << " exportado a " << archivo << "\n";
+        return 0;
+    }
+
+    uso();
+    return 1;
+}
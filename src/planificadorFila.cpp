@@ -0,0 +1,49 @@
+/**
+ * @file planificadorFila.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación del planificador por plazos (SLA).
+ * @version 1.0
+ * @date 06/01/2026
+ */
+
+#include "../include/planificadorFila.h"
+#include <algorithm>
+
+PlanificadorSLA::PlanificadorSLA(const PlazosServicio& plazos) : siguienteOrden(0), plazos(plazos) {}
+
+/**
+ * @brief Comparador de std::push_heap: el "mayor" queda arriba, así que se
+ * invierte para que arriba quede quien vence antes.
+ */
+bool PlanificadorSLA::despues(const Nodo& a, const Nodo& b) {
+    if (a.entrada.limite != b.entrada.limite) return a.entrada.limite > b.entrada.limite;
+    return a.orden > b.orden;
+}
+
+void PlanificadorSLA::agregar(const EntradaFila& entrada) {
+    monticulo.push_back({entrada, siguienteOrden++});
+    std::push_heap(monticulo.begin(), monticulo.end(), despues);
+}
+
+void PlanificadorSLA::sacar() {
+    std::pop_heap(monticulo.begin(), monticulo.end(), despues);
+    monticulo.pop_back();
+}
+
+std::chrono::steady_clock::duration PlanificadorSLA::plazo(ClaseServicio clase) const {
+    return plazos[static_cast<size_t>(clase)];
+}
+
+PlazosServicio plazosPorDefecto() {
+    PlazosServicio plazos;
+    plazos[static_cast<size_t>(ClaseServicio::NORMAL)] = std::chrono::seconds(300);
+    plazos[static_cast<size_t>(ClaseServicio::PRIORITARIA)] = std::chrono::seconds(30);
+    return plazos;
+}
+
+std::unique_ptr<PlanificadorFila> crearPlanificador(PoliticaFila politica, const PlazosServicio& plazos) {
+    if (politica == PoliticaFila::SLA) return std::make_unique<PlanificadorSLA>(plazos);
+    return std::make_unique<PlanificadorFIFO>();
+}
@@ -0,0 +1,138 @@
+/**
+ * @file posicionesCola.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación de los árboles de Fenwick de turnos y del estimador de espera.
+ * @version 1.0
+ * @date 06/01/2026
+ */
+
+#include "../include/posicionesCola.h"
+#include <algorithm>
+#include <cmath>
+
+/// Turnos que caben en la ventana al principio.
+static const size_t CAPACIDAD_MINIMA = 64;
+
+PosicionesCola::PosicionesCola(size_t numClases)
+    : arboles(numClases, std::vector<uint32_t>(CAPACIDAD_MINIMA + 1, 0)), clases(CAPACIDAD_MINIMA, 0),
+      llegadas(CAPACIDAD_MINIMA), vivos(numClases, 0), base(0), siguiente(0) {}
+
+void PosicionesCola::sumar(size_t clase, size_t indice, int delta) {
+    std::vector<uint32_t>& arbol = arboles[clase];
+    // i & -i: el bit más bajo encendido = cuántos elementos cubre el nodo i.
+    for (size_t i = indice + 1; i < arbol.size(); i += i & (~i + 1))
+        arbol[i] += static_cast<uint32_t>(delta);
+}
+
+uint32_t PosicionesCola::prefijo(size_t clase, size_t indice) const {
+    const std::vector<uint32_t>& arbol = arboles[clase];
+    uint32_t total = 0;
+    for (size_t i = indice + 1; i > 0; i -= i & (~i + 1)) total += arbol[i];
+    return total;
+}
+
+void PosicionesCola::reconstruir() {
+    uint64_t primero = base;
+    while (primero < siguiente && !clases[primero - base]) ++primero;
+
+    size_t ocupados = static_cast<size_t>(siguiente - primero);
+    size_t capacidad = std::max(CAPACIDAD_MINIMA, 2 * ocupados);
+    std::vector<uint8_t> nuevas(capacidad, 0);
+    std::copy(clases.begin() + static_cast<ptrdiff_t>(primero - base),
+              clases.begin() + static_cast<ptrdiff_t>(siguiente - base), nuevas.begin());
+    std::vector<std::chrono::steady_clock::time_point> nuevasLlegadas(capacidad);
+    std::copy(llegadas.begin() + static_cast<ptrdiff_t>(primero - base),
+              llegadas.begin() + static_cast<ptrdiff_t>(siguiente - base), nuevasLlegadas.begin());
+
+    // Construcción en O(n): cada nodo le pasa su suma a su padre.
+    for (size_t clase = 0; clase < arboles.size(); ++clase) {
+        std::vector<uint32_t>& arbol = arboles[clase];
+        arbol.assign(capacidad + 1, 0);
+        for (size_t i = 1; i <= capacidad; ++i) {
+            if (nuevas[i - 1] == clase + 1) ++arbol[i];
+            size_t padre = i + (i & (~i + 1));
+            if (padre <= capacidad) arbol[padre] += arbol[i];
+        }
+    }
+    clases = std::move(nuevas);
+    llegadas = std::move(nuevasLlegadas);
+    base = primero;
+}
+
+uint64_t PosicionesCola::agregar(std::chrono::steady_clock::time_point llegada, size_t clase) {
+    if (siguiente - base == clases.size()) reconstruir();
+    uint64_t turno = siguiente++;
+    size_t indice = static_cast<size_t>(turno - base);
+    llegadas[indice] = indice > 0 ? std::max(llegada, llegadas[indice - 1]) : llegada;
+    clases[indice] = static_cast<uint8_t>(clase + 1);
+    sumar(clase, indice, 1);
+    ++vivos[clase];
+    return turno;
+}
+
+void PosicionesCola::quitar(uint64_t turno) {
+    if (turno < base || turno >= siguiente) return;
+    size_t indice = static_cast<size_t>(turno - base);
+    if (!clases[indice]) return;
+    size_t clase = clases[indice] - 1u;
+    clases[indice] = 0;
+    sumar(clase, indice, -1);
+    --vivos[clase];
+}
+
+void PosicionesCola::cambiarClase(uint64_t turno, size_t clase) {
+    if (turno < base || turno >= siguiente) return;
+    size_t indice = static_cast<size_t>(turno - base);
+    if (!clases[indice] || clases[indice] == clase + 1) return;
+    size_t anterior = clases[indice] - 1u;
+    sumar(anterior, indice, -1);
+    --vivos[anterior];
+    clases[indice] = static_cast<uint8_t>(clase + 1);
+    sumar(clase, indice, 1);
+    ++vivos[clase];
+}
+
+uint32_t PosicionesCola::posicion(uint64_t turno) const {
+    if (turno < base || turno >= siguiente) return 0;
+    size_t indice = static_cast<size_t>(turno - base);
+    return clases[indice] ? prefijo(clases[indice] - 1u, indice) : 0;
+}
+
+uint32_t PosicionesCola::anterioresA(std::chrono::steady_clock::time_point momento, size_t clase) const {
+    auto fin = llegadas.begin() + static_cast<ptrdiff_t>(siguiente - base);
+    size_t cuantos = static_cast<size_t>(std::lower_bound(llegadas.begin(), fin, momento) - llegadas.begin());
+    return cuantos > 0 ? prefijo(clase, cuantos - 1) : 0;
+}
+
+size_t PosicionesCola::total() const {
+    size_t suma = 0;
+    for (size_t v : vivos) suma += v;
+    return suma;
+}
+
+// ================= ESTIMADOR DE ESPERA =================
+
+EstimadorEspera::EstimadorEspera() : duraciones{}, cantidad(0), siguiente(0), suma(0) {}
+
+void EstimadorEspera::registrarSesion(std::chrono::steady_clock::duration duracion) {
+    double segundos = std::chrono::duration<double>(duracion).count();
+    if (cantidad == VENTANA) suma -= duraciones[siguiente];
+    else ++cantidad;
+    duraciones[siguiente] = segundos;
+    suma += segundos;
+    siguiente = (siguiente + 1) % VENTANA;
+}
+
+int32_t EstimadorEspera::segundos(uint32_t posicion, std::chrono::steady_clock::duration enCurso) const {
+    if (cantidad == 0 || posicion == 0) return -1;
+    double promedio = suma / static_cast<double>(cantidad);
+
+    // Lo que le falta a la sesión actual; si ya se pasó del promedio, se supone que está por acabar.
+    double restante = 0;
+    if (enCurso.count() >= 0)
+        restante = std::max(0.0, promedio - std::chrono::duration<double>(enCurso).count());
+
+    return static_cast<int32_t>(std::lround(restante + promedio * (posicion - 1)));
+}
@@ -0,0 +1,358 @@
+/**
+ * @file protocolo.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación del buffer de lectura y del codificador/decodificador de tramas.
+ * @version 1.0
+ * @date 06/01/2026
+ */
+
+#include "../include/protocolo.h"
+#include <cstring>     // memcpy, memmove
+#include <cerrno>
+#include <algorithm>   // std::min
+#include <arpa/inet.h> // htonl, ntohl
+#include <sys/socket.h>
+#include <sys/uio.h>   // iovec
+
+// ================= BUFFER DE LECTURA =================
+
+BufferLectura::BufferLectura(size_t capacidadInicial)
+    : datos(capacidadInicial), inicio(0), fin(0) {}
+
+/**
+ * @brief Hace espacio al final del buffer.
+ * * 1. Si está todo consumido, simplemente reinicia los índices (gratis).
+ * 2. Si no, compacta moviendo lo pendiente al principio.
+ * 3. Si aun así no cabe, duplica la capacidad.
+ */
+char* BufferLectura::reservar(size_t minimo) {
+    if (inicio == fin) {
+        inicio = fin = 0;
+    }
+
+    if (datos.size() - fin < minimo && inicio > 0) {
+        std::memmove(datos.data(), datos.data() + inicio, fin - inicio);
+        fin -= inicio;
+        inicio = 0;
+    }
+
+    if (datos.size() - fin < minimo) {
+        // Con capacidad 0 (BufferLectura(0)) duplicar no avanzaría: se parte de 1.
+        size_t nuevaCapacidad = std::max<size_t>(datos.size(), 1) * 2;
+        while (nuevaCapacidad - fin < minimo) nuevaCapacidad *= 2;
+        datos.resize(nuevaCapacidad);
+    }
+
+    return datos.data() + fin;
+}
+
+size_t BufferLectura::espacioLibre() const {
+    return datos.size() - fin;
+}
+
+void BufferLectura::confirmar(size_t n) {
+    fin += n;
+}
+
+std::string_view BufferLectura::pendiente() const {
+    return std::string_view(datos.data() + inicio, fin - inicio);
+}
+
+void BufferLectura::consumir(size_t n) {
+    inicio += n;
+}
+
+// ================= BUFFER DE SALIDA =================
+
+/// Tramos por sendmsg(): el anillo da dos y cada adjunto hasta dos más.
+static const size_t MAX_TRAMOS = 32;
+
+/**
+ * @brief Escribe la cabecera de una trama en 'cabecera' (TAM_CABECERA bytes).
+ */
+static inline void escribirCabecera(char* cabecera, TipoTrama tipo, uint32_t secuencia, size_t longitud) {
+    uint32_t longitudRed = htonl(static_cast<uint32_t>(longitud));
+    uint32_t secuenciaRed = htonl(secuencia);
+
+    cabecera[0] = static_cast<char>(tipo);
+    cabecera[1] = static_cast<char>(VERSION_PROTOCOLO);
+    cabecera[2] = 0; // Reservado.
+    cabecera[3] = 0;
+    std::memcpy(cabecera + 4, &longitudRed, sizeof(longitudRed));
+    std::memcpy(cabecera + 8, &secuenciaRed, sizeof(secuenciaRed));
+}
+
+BufferSalida::BufferSalida(size_t capacidadInicial, size_t marcaAlta, size_t marcaBaja)
+    : inicio(0), ocupados(0), enVuelo(0), marcaAlta(marcaAlta), marcaBaja(marcaBaja), saturado(false),
+      entregadosAnillo(0), bytesAdjuntos(0) {
+    size_t capacidad = 64;
+    while (capacidad < capacidadInicial) capacidad *= 2;
+    datos.resize(capacidad);
+}
+
+void BufferSalida::asegurarEspacio(size_t n) {
+    if (datos.size() - ocupados >= n) return;
+
+    size_t nuevaCapacidad = datos.size() * 2;
+    while (nuevaCapacidad - ocupados < n) nuevaCapacidad *= 2;
+
+    // Enderezar: lo pendiente queda al principio de la memoria nueva.
+    std::vector<char> nuevos(nuevaCapacidad);
+    size_t primerTramo = std::min(ocupados, datos.size() - inicio);
+    std::memcpy(nuevos.data(), datos.data() + inicio, primerTramo);
+    std::memcpy(nuevos.data() + primerTramo, datos.data(), ocupados - primerTramo);
+    datos.swap(nuevos);
+    inicio = 0;
+}
+
+void BufferSalida::copiarAlFinal(const char* origen, size_t n) {
+    size_t mascara = datos.size() - 1;
+    size_t fin = (inicio + ocupados) & mascara;
+    size_t primerTramo = std::min(n, datos.size() - fin);
+    std::memcpy(datos.data() + fin, origen, primerTramo);
+    std::memcpy(datos.data(), origen + primerTramo, n - primerTramo);
+    ocupados += n;
+}
+
+void BufferSalida::agregarTrama(TipoTrama tipo, uint32_t secuencia, std::string_view carga) {
+    char cabecera[TAM_CABECERA];
+    escribirCabecera(cabecera, tipo, secuencia, carga.size());
+
+    asegurarEspacio(TAM_CABECERA + carga.size());
+    copiarAlFinal(cabecera, TAM_CABECERA);
+    copiarAlFinal(carga.data(), carga.size());
+
+    if (pendiente() >= marcaAlta) saturado = true;
+}
+
+/**
+ * @brief Solo la carga se comparte; la cabecera lleva la secuencia de ESTA conexión.
+ */
+bool BufferSalida::agregarCompartida(TipoTrama tipo, uint32_t secuencia, const CargaCompartida& carga, uint32_t clave) {
+    if (clave != 0) {
+        for (Adjunto& a : adjuntos) {
+            if (a.clave != clave || a.tipo != tipo || a.entregados != 0) continue;
+            // Conserva su lugar y su secuencia; solo cambia la carga (y el largo en la cabecera).
+            bytesAdjuntos -= a.total();
+            a.carga = carga;
+            escribirCabecera(a.cabecera, a.tipo, a.secuencia, carga->size());
+            bytesAdjuntos += a.total();
+            if (pendiente() >= marcaAlta) saturado = true;
+            return false;
+        }
+    }
+
+    Adjunto a;
+    a.corte = entregadosAnillo + ocupados;
+    escribirCabecera(a.cabecera, tipo, secuencia, carga->size());
+    a.carga = carga;
+    a.tipo = tipo;
+    a.secuencia = secuencia;
+    a.clave = clave;
+    a.entregados = 0;
+    bytesAdjuntos += a.total();
+    adjuntos.push_back(std::move(a));
+
+    if (pendiente() >= marcaAlta) saturado = true;
+    return true;
+}
+
+/**
+ * @brief Recorre el flujo en orden: anillo hasta el corte del primer adjunto,
+ * el adjunto (cabecera y carga), anillo hasta el siguiente corte...
+ */
+size_t BufferSalida::armarTramos(iovec* tramos, size_t max) const {
+    size_t n = 0;
+    uint64_t posicion = entregadosAnillo;
+    size_t fisico = inicio;
+    auto agregarAnillo = [&](uint64_t hasta) {
+        while (posicion < hasta && n < max) {
+            size_t tramo = static_cast<size_t>(std::min<uint64_t>(hasta - posicion, datos.size() - fisico));
+            tramos[n].iov_base = const_cast<char*>(datos.data()) + fisico;
+            tramos[n++].iov_len = tramo;
+            fisico = (fisico + tramo) & (datos.size() - 1);
+            posicion += tramo;
+        }
+    };
+
+    for (const Adjunto& a : adjuntos) {
+        agregarAnillo(a.corte);
+        if (posicion < a.corte || n == max) return n;
+        if (a.entregados < TAM_CABECERA) {
+            tramos[n].iov_base = const_cast<char*>(a.cabecera) + a.entregados;
+            tramos[n++].iov_len = TAM_CABECERA - a.entregados;
+            if (n == max) return n;
+        }
+        size_t desde = a.entregados > TAM_CABECERA ? a.entregados - TAM_CABECERA : 0;
+        if (desde < a.carga->size()) {
+            tramos[n].iov_base = const_cast<char*>(a.carga->data()) + desde;
+            tramos[n++].iov_len = a.carga->size() - desde;
+            if (n == max) return n;
+        }
+    }
+    agregarAnillo(entregadosAnillo + ocupados);
+    return n;
+}
+
+void BufferSalida::consumirFlujo(size_t n) {
+    while (n > 0) {
+        if (!adjuntos.empty() && adjuntos.front().corte == entregadosAnillo) {
+            Adjunto& a = adjuntos.front();
+            size_t parte = std::min(n, a.total() - a.entregados);
+            a.entregados += parte;
+            bytesAdjuntos -= parte;
+            n -= parte;
+            if (a.entregados == a.total()) adjuntos.pop_front();
+            continue;
+        }
+        uint64_t limite = adjuntos.empty() ? entregadosAnillo + ocupados : adjuntos.front().corte;
+        size_t parte = static_cast<size_t>(std::min<uint64_t>(n, limite - entregadosAnillo));
+        if (parte == 0) break;
+        consumir(parte);
+        n -= parte;
+    }
+    if (pendiente() <= marcaBaja) saturado = false;
+}
+
+void BufferSalida::consumir(size_t n) {
+    ocupados -= n;
+    entregadosAnillo += n;
+    // Vacío: volver al principio para que la próxima ráfaga salga en un solo tramo.
+    inicio = ocupados == 0 ? 0 : (inicio + n) & (datos.size() - 1);
+    if (pendiente() <= marcaBaja) saturado = false;
+}
+
+void BufferSalida::extraer(std::string& destino) {
+    size_t n = ocupados + bytesAdjuntos;
+    destino.clear();
+    destino.reserve(n);
+    enVuelo += n; // Siguen contando para la contrapresión hasta confirmarEnvio().
+
+    // Las cargas compartidas se copian aquí: el send asíncrono necesita memoria propia.
+    iovec tramos[MAX_TRAMOS];
+    while (!vacio()) {
+        size_t cuantos = armarTramos(tramos, MAX_TRAMOS);
+        size_t copiados = 0;
+        for (size_t i = 0; i < cuantos; ++i) {
+            destino.append(static_cast<const char*>(tramos[i].iov_base), tramos[i].iov_len);
+            copiados += tramos[i].iov_len;
+        }
+        consumirFlujo(copiados);
+    }
+}
+
+void BufferSalida::confirmarEnvio(size_t n) {
+    enVuelo -= std::min(n, enVuelo);
+    if (pendiente() <= marcaBaja) saturado = false;
+}
+
+std::string_view BufferSalida::tramoPendiente() const {
+    iovec tramo;
+    if (armarTramos(&tramo, 1) == 0) return {};
+    return std::string_view(static_cast<const char*>(tramo.iov_base), tramo.iov_len);
+}
+
+void BufferSalida::confirmarEntrega(size_t n) {
+    if (n > 0) consumirFlujo(n);
+}
+
+void BufferSalida::descartar() {
+    enVuelo = 0;
+    adjuntos.clear();
+    bytesAdjuntos = 0;
+    consumir(ocupados);
+}
+
+/**
+ * @brief Junta todas las tramas pendientes en un solo sendmsg().
+ * * El anillo da a lo más dos tramos (antes y después de dar la vuelta); las
+ * cargas compartidas van como tramos propios, sin copiarlas al anillo.
+ */
+ResultadoVaciado BufferSalida::vaciar(int fd) {
+    while (!vacio()) {
+        iovec tramos[MAX_TRAMOS];
+        msghdr mensaje{};
+        mensaje.msg_iov = tramos;
+        mensaje.msg_iovlen = armarTramos(tramos, MAX_TRAMOS);
+
+        // MSG_NOSIGNAL: si el otro lado ya colgó no queremos que SIGPIPE mate al proceso.
+        ssize_t enviados = sendmsg(fd, &mensaje, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (enviados > 0) {
+            consumirFlujo(static_cast<size_t>(enviados));
+            continue;
+        }
+        if (enviados < 0 && errno == EINTR) continue;
+        if (enviados < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return ResultadoVaciado::PENDIENTE;
+        return ResultadoVaciado::ERROR;
+    }
+    return ResultadoVaciado::VACIO;
+}
+
+// ================= DECODIFICADOR =================
+
+DecodificadorTramas::DecodificadorTramas() : secuenciaEsperada(0) {}
+
+/**
+ * @brief Lee un entero de 32 bits en orden de red desde memoria sin alinear.
+ */
+static uint32_t leerU32(const char* p) {
+    uint32_t valor;
+    std::memcpy(&valor, p, sizeof(valor));
+    return ntohl(valor);
+}
+
+ResultadoDecodificacion DecodificadorTramas::siguiente(BufferLectura& buffer, VistaTrama& trama) {
+    std::string_view pendiente = buffer.pendiente();
+    if (pendiente.size() < TAM_CABECERA) return ResultadoDecodificacion::INCOMPLETA;
+
+    const char* p = pendiente.data();
+    uint8_t tipo = static_cast<uint8_t>(p[0]);
+    uint8_t version = static_cast<uint8_t>(p[1]);
+    uint32_t longitud = leerU32(p + 4);
+    uint32_t secuencia = leerU32(p + 8);
+
+    // Validaciones: si algo no cuadra, el flujo está corrupto y no hay forma de resincronizar.
+    if (version != VERSION_PROTOCOLO) return ResultadoDecodificacion::ERROR;
+    if (tipo < static_cast<uint8_t>(TipoTrama::MENSAJE) || tipo > static_cast<uint8_t>(TipoTrama::CLASE))
+        return ResultadoDecodificacion::ERROR;
+    if (longitud > MAX_CARGA) return ResultadoDecodificacion::ERROR;
+    if (secuencia != secuenciaEsperada) return ResultadoDecodificacion::ERROR;
+
+    if (pendiente.size() < TAM_CABECERA + longitud) return ResultadoDecodificacion::INCOMPLETA;
+
+    trama.tipo = static_cast<TipoTrama>(tipo);
+    trama.secuencia = secuencia;
+    trama.datos = pendiente.substr(TAM_CABECERA, longitud);
+
+    buffer.consumir(TAM_CABECERA + longitud);
+    secuenciaEsperada++;
+    return ResultadoDecodificacion::TRAMA;
+}
+
+// ================= CODIFICADOR =================
+
+void codificarTrama(std::string& salida, TipoTrama tipo, uint32_t secuencia, std::string_view datos) {
+    char cabecera[TAM_CABECERA];
+    escribirCabecera(cabecera, tipo, secuencia, datos.size());
+
+    salida.append(cabecera, TAM_CABECERA);
+    salida.append(datos.data(), datos.size());
+}
+
+// ================= AVISO DE POSICION =================
+
+std::string codificarPosicion(const AvisoPosicion& aviso) {
+    uint32_t campos[3] = {htonl(aviso.posicion), htonl(aviso.enCola),
+                          htonl(static_cast<uint32_t>(aviso.segundos))};
+    return std::string(reinterpret_cast<const char*>(campos), TAM_AVISO_POSICION);
+}
+
+bool decodificarPosicion(std::string_view datos, AvisoPosicion& aviso) {
+    if (datos.size() != TAM_AVISO_POSICION) return false;
+    aviso.posicion = leerU32(datos.data());
+    aviso.enCola = leerU32(datos.data() + 4);
+    aviso.segundos = static_cast<int32_t>(leerU32(datos.data() + 8));
+    return true;
+}
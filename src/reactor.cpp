@@ -0,0 +1,180 @@
+/**
+ * @file reactor.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación del bucle de eventos epoll.
+ * @version 1.0
+ * @date 06/01/2026
+ * * Aquí viven las syscalls epoll_create1, epoll_ctl, epoll_wait y eventfd.
+ */
+
+#include "../include/reactor.h"
+#include <iostream>
+#include <unistd.h>       // close(), read(), write()
+#include <sys/epoll.h>    // epoll_*
+#include <sys/eventfd.h>  // eventfd()
+#include <sys/timerfd.h>  // timerfd_create(), timerfd_settime()
+#include <cerrno>
+
+using namespace std;
+
+/// Cantidad máxima de eventos que pedimos al Kernel por cada epoll_wait().
+static const int MAX_EVENTOS = 256;
+
+Reactor::Reactor() : epollFd(-1), despertadorFd(-1), corriendo(false) {}
+
+Reactor::~Reactor() {
+    for (int fd : temporizadores) close(fd);
+    if (despertadorFd != -1) close(despertadorFd);
+    if (epollFd != -1) close(epollFd);
+}
+
+/**
+ * @brief Crea la instancia epoll y el "timbre" (eventfd).
+ * * El eventfd se registra como un descriptor más: escribir en él hace que
+ * epoll_wait() regrese aunque no haya tráfico de red.
+ */
+bool Reactor::crear() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1) {
+        cerr << "Error al crear epoll" << endl;
+        return false;
+    }
+
+    despertadorFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (despertadorFd == -1) {
+        cerr << "Error al crear eventfd" << endl;
+        return false;
+    }
+
+    // Se arma aquí y no en ejecutar(): un detener() que llegue antes de que
+    // el hilo arranque el bucle no debe perderse.
+    corriendo = true;
+    return registrar(despertadorFd, EPOLLIN, [this](uint32_t) {
+        uint64_t valor;
+        // Vaciamos el contador para que el Kernel deje de reportarlo listo.
+        while (read(despertadorFd, &valor, sizeof(valor)) > 0) {}
+    });
+}
+
+bool Reactor::registrar(int fd, uint32_t eventos, Callback cb) {
+    auto manejador = make_unique<Manejador>(Manejador{fd, std::move(cb), true});
+
+    epoll_event ev{};
+    ev.events = eventos;
+    ev.data.ptr = manejador.get();
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        cerr << "Error en epoll_ctl(ADD) para fd " << fd << endl;
+        return false;
+    }
+
+    manejadores[fd] = std::move(manejador);
+    return true;
+}
+
+bool Reactor::modificar(int fd, uint32_t eventos) {
+    auto it = manejadores.find(fd);
+    if (it == manejadores.end()) return false;
+
+    epoll_event ev{};
+    ev.events = eventos;
+    ev.data.ptr = it->second.get();
+    return epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+/**
+ * @brief Saca el descriptor de epoll y retira su manejador.
+ * * El manejador se mueve a 'retirados' en lugar de destruirse porque podría
+ * estar ejecutándose justo ahora (un callback que se quita a sí mismo).
+ */
+void Reactor::quitar(int fd) {
+    auto it = manejadores.find(fd);
+    if (it == manejadores.end()) return;
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    it->second->activo = false;
+    retirados.push_back(std::move(it->second));
+    manejadores.erase(it);
+}
+
+bool Reactor::programarPeriodico(chrono::milliseconds intervalo, function<void()> tarea) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd == -1) {
+        cerr << "Error al crear timerfd" << endl;
+        return false;
+    }
+
+    itimerspec periodo{};
+    periodo.it_interval.tv_sec = intervalo.count() / 1000;
+    periodo.it_interval.tv_nsec = (intervalo.count() % 1000) * 1000000;
+    periodo.it_value = periodo.it_interval; // Primer disparo tras un intervalo completo.
+    timerfd_settime(fd, 0, &periodo, nullptr);
+
+    temporizadores.push_back(fd);
+    return registrar(fd, EPOLLIN, [fd, tarea = std::move(tarea)](uint32_t) {
+        uint64_t vencimientos;
+        // Leer el timerfd lo "rearma"; si se acumularon varios disparos basta con una ejecución.
+        if (read(fd, &vencimientos, sizeof(vencimientos)) > 0) tarea();
+    });
+}
+
+void Reactor::publicar(function<void()> tarea) {
+    {
+        lock_guard<mutex> lock(mtxTareas);
+        tareas.push_back(std::move(tarea));
+    }
+    uint64_t uno = 1;
+    // Tocamos el timbre. Si falla es porque el contador ya estaba alto: igual despierta.
+    ssize_t ignorado = write(despertadorFd, &uno, sizeof(uno));
+    (void)ignorado;
+}
+
+/**
+ * @brief Ejecuta las tareas publicadas por otros hilos.
+ * * Se intercambia el vector bajo el mutex para ejecutar las tareas sin
+ * tenerlo bloqueado (una tarea podría publicar otra).
+ */
+void Reactor::ejecutarTareas() {
+    vector<function<void()>> pendientes;
+    {
+        lock_guard<mutex> lock(mtxTareas);
+        pendientes.swap(tareas);
+    }
+    for (auto& tarea : pendientes) tarea();
+}
+
+/**
+ * @brief Bucle principal del reactor.
+ * * 1. Espera a que el Kernel reporte descriptores listos.
+ * 2. Ejecuta el callback de cada uno.
+ * 3. Ejecuta las tareas que otros hilos publicaron.
+ */
+void Reactor::ejecutar() {
+    epoll_event eventos[MAX_EVENTOS];
+
+    while (corriendo) {
+        int n = epoll_wait(epollFd, eventos, MAX_EVENTOS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue; // Una señal nos interrumpió, no es error.
+            cerr << "Error en epoll_wait" << endl;
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            Manejador* m = static_cast<Manejador*>(eventos[i].data.ptr);
+            if (m->activo) m->cb(eventos[i].events);
+        }
+
+        ejecutarTareas();
+        retirados.clear();
+    }
+}
+
+void Reactor::detener() {
+    corriendo = false;
+    uint64_t uno = 1;
+    ssize_t ignorado = write(despertadorFd, &uno, sizeof(uno));
+    (void)ignorado;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file redibujo.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación de la señal de redibujo.
+ * @version 1.0
+ * @date 06/01/2026
+ */
+
+#include "../include/redibujo.h"
+
+SenalRedibujo::SenalRedibujo() : pendiente(true) {} // El primer frame siempre se dibuja.
+
+void SenalRedibujo::marcar() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pendiente = true;
+    }
+    cv.notify_one();
+}
+
+bool SenalRedibujo::esperar(std::chrono::milliseconds limite) {
+    std::unique_lock<std::mutex> lock(mtx);
+    return cv.wait_for(lock, limite, [this] { return pendiente; });
+}
+
+bool SenalRedibujo::tomar() {
+    std::lock_guard<std::mutex> lock(mtx);
+    bool estaba = pendiente;
+    pendiente = false;
+    return estaba;
+}
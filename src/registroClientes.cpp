@@ -0,0 +1,67 @@
+/**
+ * @file registroClientes.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación del registro de clientes (slab generacional).
+ * @version 1.0
+ * @date 06/01/2026
+ */
+
+#include "../include/registroClientes.h"
+
+ManejadorCliente RegistroClientes::agregar(InfoCliente info) {
+    // Un socket que el Kernel recicló sin que nos enteráramos del cierre: el registro viejo ya no vale.
+    auto anterior = porSocket.find(info.socket);
+    if (anterior != porSocket.end()) quitar(anterior->second);
+
+    uint32_t indice;
+    if (!libres.empty()) {
+        indice = libres.back();
+        libres.pop_back();
+    } else {
+        indice = static_cast<uint32_t>(ranuras.size());
+        ranuras.emplace_back();
+    }
+
+    Ranura& r = ranuras[indice];
+    r.ocupada = true;
+    r.info = std::move(info);
+
+    ManejadorCliente manejador{indice, r.generacion};
+    porSocket[r.info.socket] = manejador;
+    porId[r.info.id] = manejador;
+    return manejador;
+}
+
+bool RegistroClientes::quitar(ManejadorCliente manejador) {
+    if (!buscar(manejador)) return false;
+
+    Ranura& r = ranuras[manejador.indice];
+    porSocket.erase(r.info.socket);
+    porId.erase(r.info.id);
+
+    r.ocupada = false;
+    ++r.generacion;         // Invalida cualquier manejador que siga apuntando aquí.
+    r.info.nombre.clear();
+    r.info.nombre.shrink_to_fit();
+    libres.push_back(manejador.indice);
+    return true;
+}
+
+const InfoCliente* RegistroClientes::buscar(ManejadorCliente manejador) const {
+    if (manejador.indice >= ranuras.size()) return nullptr;
+    const Ranura& r = ranuras[manejador.indice];
+    if (!r.ocupada || r.generacion != manejador.generacion) return nullptr;
+    return &r.info;
+}
+
+const InfoCliente* RegistroClientes::buscarPorSocket(int socket) const {
+    auto it = porSocket.find(socket);
+    return it == porSocket.end() ? nullptr : buscar(it->second);
+}
+
+const InfoCliente* RegistroClientes::buscarPorId(int id) const {
+    auto it = porId.find(id);
+    return it == porId.end() ? nullptr : buscar(it->second);
+}
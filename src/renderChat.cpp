@@ -0,0 +1,229 @@
+/**
+ * @file renderChat.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación de la caché de layout, el recorte por ventana visible
+ * y el dibujo por lotes con sf::VertexArray.
+ * @version 1.0
+ * @date 06/01/2026
+ */
+
+#include "../include/renderChat.h"
+#include <algorithm>
+#include <cmath>
+
+/// Segmentos con los que se aproxima cada esquina redondeada.
+static const int SEGMENTOS_ESQUINA = 6;
+
+LayoutChat::LayoutChat(const sf::Font& fuente, const EstiloBurbujas& estiloBurbujas, const Chat& chat)
+    : font(fuente), estilo(estiloBurbujas), vista(chat.obtenerVista()),
+      versionSincronizada(vista.obtenerVersionBase()), alturaAcumulada(estiloBurbujas.margenSuperior),
+      verticesBurbujas(sf::PrimitiveType::Triangles), verticesTexto(sf::PrimitiveType::Triangles),
+      rangoDesde(0), rangoHasta(0), verticesSucios(true) {
+    sincronizar(chat);
+}
+
+/**
+ * @brief Mide el texto una sola vez y fija la geometría de la burbuja.
+ * * Propios: alineados a la derecha. Recibidos: a la izquierda.
+ */
+void LayoutChat::agregarBurbuja(const VistaMensaje& m) {
+    sf::FloatRect bounds = colocarTexto(m.texto, {0.f, 0.f}, sf::Color::White, nullptr);
+
+    GeometriaBurbuja g;
+    g.tamano = {bounds.size.x + (estilo.padding * 2), bounds.size.y + (estilo.padding * 2)};
+
+    float xPos = m.esMio ? estilo.anchoVentana - g.tamano.x - estilo.margenLateral : estilo.margenLateral;
+    g.posicion = {xPos, alturaAcumulada};
+    g.posTexto = {xPos + estilo.padding, alturaAcumulada + estilo.padding - 4.f};
+
+    burbujas.push_back(g);
+    alturaAcumulada += g.tamano.y + estilo.separacion;
+}
+
+void LayoutChat::sincronizar(const Chat& chat) {
+    if (chat.obtenerVersion() == versionSincronizada) return; // Nada nuevo.
+
+    Chat::Vista nueva = chat.obtenerVista();
+    if (nueva.obtenerVersionBase() != vista.obtenerVersionBase()) {
+        // El historial se limpió (cambio de cliente): la caché empieza de cero.
+        burbujas.clear();
+        alturaAcumulada = estilo.margenSuperior;
+    }
+
+    for (size_t i = burbujas.size(); i < nueva.size(); ++i) agregarBurbuja(nueva[i]);
+
+    versionSincronizada = nueva.obtenerVersion();
+    vista = std::move(nueva);
+    verticesSucios = true;
+}
+
+/**
+ * @brief Misma disposición de glifos que sf::Text (kerning, espacios, saltos de línea).
+ * * Por cada glifo se agregan 2 triángulos cuyas coordenadas de textura apuntan
+ * a su rectángulo dentro de la textura de la fuente.
+ */
+sf::FloatRect LayoutChat::colocarTexto(std::string_view texto, sf::Vector2f origen, sf::Color color,
+                                       sf::VertexArray* destino) const {
+    const unsigned tam = estilo.tamLetra;
+    const float anchoEspacio = font.getGlyph(U' ', tam, false).advance;
+    const float altoLinea = font.getLineSpacing(tam);
+
+    float x = 0.f;
+    float y = static_cast<float>(tam);
+    float minX = static_cast<float>(tam), minY = static_cast<float>(tam), maxX = 0.f, maxY = 0.f;
+    std::uint32_t anterior = 0;
+
+    for (unsigned char byte : texto) {
+        std::uint32_t c = byte;
+        if (c == '\r') continue;
+
+        x += font.getKerning(anterior, c, tam);
+        anterior = c;
+
+        if (c == ' ' || c == '\n' || c == '\t') {
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            if (c == ' ') x += anchoEspacio;
+            else if (c == '\t') x += anchoEspacio * 4;
+            else { y += altoLinea; x = 0.f; }
+            maxX = std::max(maxX, x);
+            maxY = std::max(maxY, y);
+            continue;
+        }
+
+        const sf::Glyph& glifo = font.getGlyph(c, tam, false);
+
+        float izq = glifo.bounds.position.x;
+        float arr = glifo.bounds.position.y;
+        float der = izq + glifo.bounds.size.x;
+        float aba = arr + glifo.bounds.size.y;
+
+        if (destino) {
+            // 1px de margen alrededor del glifo, igual que SFML, para no cortar el antialias.
+            const float m = 1.f;
+            float u1 = static_cast<float>(glifo.textureRect.position.x) - m;
+            float v1 = static_cast<float>(glifo.textureRect.position.y) - m;
+            float u2 = static_cast<float>(glifo.textureRect.position.x + glifo.textureRect.size.x) + m;
+            float v2 = static_cast<float>(glifo.textureRect.position.y + glifo.textureRect.size.y) + m;
+
+            sf::Vector2f p1{origen.x + x + izq - m, origen.y + y + arr - m};
+            sf::Vector2f p2{origen.x + x + der + m, origen.y + y + aba + m};
+
+            destino->append({p1, color, {u1, v1}});
+            destino->append({{p2.x, p1.y}, color, {u2, v1}});
+            destino->append({{p1.x, p2.y}, color, {u1, v2}});
+            destino->append({{p1.x, p2.y}, color, {u1, v2}});
+            destino->append({{p2.x, p1.y}, color, {u2, v1}});
+            destino->append({p2, color, {u2, v2}});
+        }
+
+        minX = std::min(minX, x + izq);
+        maxX = std::max(maxX, x + der);
+        minY = std::min(minY, y + arr);
+        maxY = std::max(maxY, y + aba);
+
+        x += glifo.advance;
+    }
+
+    if (maxX < minX || maxY < minY) return sf::FloatRect({0.f, 0.f}, {0.f, 0.f}); // Texto vacío
+    return sf::FloatRect({minX, minY}, {maxX - minX, maxY - minY});
+}
+
+/**
+ * @brief Rectángulo redondeado como abanico de triángulos desde el centro.
+ * * Es una figura convexa, así que el abanico la cubre sin huecos.
+ */
+void LayoutChat::agregarRectanguloRedondeado(sf::Vector2f posicion, sf::Vector2f tamano, float radio, sf::Color color) {
+    radio = std::min({radio, tamano.x / 2.f, tamano.y / 2.f});
+
+    // Centros de las 4 esquinas, en sentido horario empezando arriba a la derecha.
+    const sf::Vector2f centros[4] = {
+        {posicion.x + tamano.x - radio, posicion.y + radio},
+        {posicion.x + tamano.x - radio, posicion.y + tamano.y - radio},
+        {posicion.x + radio, posicion.y + tamano.y - radio},
+        {posicion.x + radio, posicion.y + radio},
+    };
+    const float pi = 3.14159265f;
+
+    sf::Vector2f centro{posicion.x + tamano.x / 2.f, posicion.y + tamano.y / 2.f};
+    sf::Vector2f primero, previo;
+    bool hayPrevio = false;
+
+    for (int e = 0; e < 4; ++e) {
+        float anguloInicial = -pi / 2.f + e * (pi / 2.f);
+        for (int i = 0; i <= SEGMENTOS_ESQUINA; ++i) {
+            float a = anguloInicial + (pi / 2.f) * i / SEGMENTOS_ESQUINA;
+            sf::Vector2f punto{centros[e].x + std::cos(a) * radio, centros[e].y + std::sin(a) * radio};
+            if (hayPrevio) {
+                verticesBurbujas.append({centro, color, {}});
+                verticesBurbujas.append({previo, color, {}});
+                verticesBurbujas.append({punto, color, {}});
+            } else {
+                primero = punto;
+                hayPrevio = true;
+            }
+            previo = punto;
+        }
+    }
+
+    // Cerramos el contorno uniendo el último punto con el primero.
+    verticesBurbujas.append({centro, color, {}});
+    verticesBurbujas.append({previo, color, {}});
+    verticesBurbujas.append({primero, color, {}});
+}
+
+void LayoutChat::construirVertices(size_t desde, size_t hasta) {
+    verticesBurbujas.clear();
+    verticesTexto.clear();
+
+    for (size_t i = desde; i < hasta; ++i) {
+        const GeometriaBurbuja& g = burbujas[i];
+        VistaMensaje m = vista[i];
+
+        if (m.esMio) {
+            agregarRectanguloRedondeado(g.posicion, g.tamano, estilo.radio, estilo.fondoMio);
+        } else {
+            // El contorno es la misma figura 1px más grande, dibujada antes (queda detrás).
+            agregarRectanguloRedondeado({g.posicion.x - 1.f, g.posicion.y - 1.f},
+                                        {g.tamano.x + 2.f, g.tamano.y + 2.f}, estilo.radio + 1.f, estilo.bordeOtro);
+            agregarRectanguloRedondeado(g.posicion, g.tamano, estilo.radio, estilo.fondoOtro);
+        }
+
+        colocarTexto(m.texto, g.posTexto, m.esMio ? estilo.textoMio : estilo.textoOtro, &verticesTexto);
+    }
+
+    rangoDesde = desde;
+    rangoHasta = hasta;
+    verticesSucios = false;
+}
+
+/**
+ * @brief Dibuja solo lo visible, en 2 llamadas a draw().
+ * * 1. Búsqueda binaria: primera burbuja cuyo borde inferior está debajo de 'arriba'.
+ * 2. Se avanza hasta la primera que empieza después de 'arriba + alto'.
+ * 3. Si el rango cambió, se reconstruyen los vértices; si no, se reutilizan.
+ */
+void LayoutChat::dibujar(sf::RenderTarget& destino, float arriba, float alto) {
+    float abajo = arriba + alto;
+
+    auto primera = std::partition_point(burbujas.begin(), burbujas.end(), [&](const GeometriaBurbuja& g) {
+        return g.posicion.y + g.tamano.y < arriba;
+    });
+    auto ultima = std::partition_point(primera, burbujas.end(), [&](const GeometriaBurbuja& g) {
+        return g.posicion.y <= abajo;
+    });
+
+    size_t desde = static_cast<size_t>(primera - burbujas.begin());
+    size_t hasta = static_cast<size_t>(ultima - burbujas.begin());
+    if (verticesSucios || desde != rangoDesde || hasta != rangoHasta) construirVertices(desde, hasta);
+
+    destino.draw(verticesBurbujas);
+    // Todos los glifos de un mismo tamaño viven en la misma textura de la fuente.
+    destino.draw(verticesTexto, sf::RenderStates(&font.getTexture(estilo.tamLetra)));
+}
+
+float LayoutChat::alturaTotal() const {
+    return alturaAcumulada;
+}
@@ -0,0 +1,289 @@
+/**
+ * @file servicio.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación del núcleo del servidor de soporte.
+ * @version 1.0
+ * @date 06/01/2026
+ */
+
+#include "../include/servicio.h"
+#include <iostream>
+#include <chrono>
+#include <ctime>
+
+ServicioSoporte::ServicioSoporte(ConfigServicio configuracion)
+    : config(std::move(configuracion)),
+      persistencia(config.carpetaTickets, config.durabilidad),
+      detenido(false),
+      estado(EstadoSesion::LIBRE),
+      avisoLlegadas(reactorSesiones, servidor.descriptorLlegadas(),
+                    [this] { servidor.consumirAvisoLlegadas(); }),
+      avisoEntrada(reactorSesiones, servidor.descriptorEntrada()) {}
+
+ServicioSoporte::~ServicioSoporte() {
+    detener();
+}
+
+void ServicioSoporte::alCambiar(std::function<void()> aviso) {
+    avisoCambios = std::move(aviso);
+}
+
+void ServicioSoporte::alRecibirMensaje(AvisoMensaje aviso) {
+    avisoMensaje = std::move(aviso);
+}
+
+void ServicioSoporte::notificar() {
+    if (avisoCambios) avisoCambios();
+}
+
+/**
+ * @brief Orden de la recuperación: leer el WAL, guardar (con fsync) las
+ * sesiones sin ticket y SOLO entonces empezar un WAL limpio.
+ */
+bool ServicioSoporte::recuperar() {
+    EstadoRecuperado estado;
+    if (!wal.recuperar(config.carpetaWAL, estado)) {
+        std::cerr << "[ERROR] No se pudo leer el WAL.\n";
+        return false;
+    }
+
+    if (!persistencia.abrir()) {
+        std::cerr << "[ERROR] No se pudo abrir el almacen de tickets.\n";
+        return false;
+    }
+
+    // Sesiones de la corrida anterior que nunca llegaron a ser ticket.
+    for (const SesionRecuperada& s : estado.pendientes) {
+        uint64_t ticketId = persistencia.guardarAhora(s.clienteId, s.nombre, s.fecha, s.mensajes);
+        if (ticketId == 0) {
+            std::cerr << "[ERROR] No se pudo recuperar la sesion de " << s.nombre << ".\n";
+            return false;
+        }
+        std::cout << "[WAL] Ticket #" << ticketId << " recuperado (" << s.nombre
+                  << (s.terminada ? ")" : ", sesion interrumpida)") << ".\n";
+    }
+
+    // Ya todo está en el almacén: se puede empezar un WAL limpio.
+    if (!wal.iniciar(estado.ultimoId)) {
+        std::cerr << "[ERROR] No se pudo iniciar el WAL.\n";
+        return false;
+    }
+    servidor.continuarIdsDesde(estado.ultimoId);
+    servidor.usarWAL(&wal);
+
+    // Los clientes no tienen identidad propia en el protocolo: al reconectar
+    // reciben un ID nuevo, así que la cola anterior solo se informa.
+    if (!estado.cola.empty()) {
+        std::cout << "[WAL] Clientes en espera al caer el servidor (deben reconectarse):\n";
+        for (size_t i = 0; i < estado.cola.size(); ++i)
+            std::cout << "  " << (i + 1) << ". " << estado.cola[i].nombre << "\n";
+    }
+
+    persistencia.alGuardar([this](int clienteId) { wal.ticketGuardado(clienteId); });
+    if (!persistencia.iniciar()) {
+        std::cerr << "[ERROR] No se pudo iniciar el hilo de tickets.\n";
+        return false;
+    }
+    return true;
+}
+
+bool ServicioSoporte::iniciar() {
+    if (hiloReactor.joinable()) return true;
+    if (!recuperar()) return false;
+
+    servidor.usarBackend(config.backend);
+    servidor.usarFragmentos(config.fragmentos, config.fijarNucleos);
+    servidor.usarMemoriaCompartida(config.memoriaCompartida);
+    servidor.usarPlanificador(crearPlanificador(config.politicaFila, config.plazos));
+    if (!servidor.autorizarPrioridad(config.autorizadosPrioridad)) return false;
+    if (!servidor.crear() || !servidor.configurar(config.ip.c_str(), config.puerto) ||
+        !servidor.bindear() || !servidor.escuchar(config.espera)) {
+        std::cerr << "[ERROR] No se pudo iniciar el servidor.\n";
+        return false;
+    }
+
+    // El reactor avisa cuando alguien entra o sale de la cola.
+    servidor.alCambiarEstado([this] { notificar(); });
+
+    if (!reactorSesiones.crear() || !avisoLlegadas.armar() || !avisoEntrada.armar()) {
+        std::cerr << "[ERROR] No se pudo crear el reactor de sesiones.\n";
+        return false;
+    }
+    // La corrutina arranca ya dentro del hilo de sesiones.
+    fila = atenderFila();
+    reactorSesiones.publicar([this] { fila.iniciar(); });
+
+    // Hilo del Reactor: acepta clientes, vigila la cola y lee al cliente activo (epoll).
+    hiloReactor = std::thread(&ServerSocket::aceptarClientes, &servidor);
+    // Hilo de Sesiones: su reactor reanuda la corrutina de la fila y la de la sesión activa.
+    hiloSesiones = std::thread(&ServicioSoporte::bucleSesiones, this);
+    return true;
+}
+
+void ServicioSoporte::detener() {
+    if (detenido.exchange(true)) return;
+
+    // Cerrar el servidor suelta al cliente activo (suena la bandeja y la
+    // fila de llegadas) y detiene los reactores de red. Una corrutina que
+    // siga suspendida se destruye junto con 'fila'.
+    servidor.cerrarServidor();
+    reactorSesiones.detener();
+    if (hiloSesiones.joinable()) hiloSesiones.join();
+    if (hiloReactor.joinable()) hiloReactor.join();
+
+    // Primero los tickets (que aún anotan en el WAL) y al final el WAL.
+    persistencia.detener();
+    wal.detener();
+}
+
+void ServicioSoporte::bucleSesiones() {
+    reactorSesiones.ejecutar();
+}
+
+/**
+ * @brief La fila completa como una corrutina.
+ * * Al cerrar una sesión vuelve al inicio del while y revisa la fila en el
+ *   acto: el siguiente cliente recibe START sin esperar ningún intervalo.
+ */
+Tarea<> ServicioSoporte::atenderFila() {
+    while (!detenido) {
+        // En una variable y no dentro del if: GCC 12 compila mal "if (!co_await ...)".
+        bool hayCliente = co_await siguienteCliente();
+        if (!hayCliente) break;
+        co_await sesion();
+    }
+}
+
+Tarea<bool> ServicioSoporte::siguienteCliente() {
+    // Se revisa ANTES de suspender: un aviso que ya se consumió no se pierde.
+    while (!asignarSiguiente()) {
+        co_await avisoLlegadas.siguiente();
+        if (detenido) co_return false;
+    }
+    co_return true;
+}
+
+Tarea<std::optional<std::string>> ServicioSoporte::leerMensaje() {
+    std::string mensaje;
+    EstadoEntrada resultado;
+    while ((resultado = servidor.intentarRecibir(mensaje)) == EstadoEntrada::VACIA)
+        co_await avisoEntrada.siguiente();
+    if (resultado != EstadoEntrada::MENSAJE) co_return std::nullopt;
+    co_return mensaje;
+}
+
+Tarea<> ServicioSoporte::sesion() {
+    for (;;) {
+        std::optional<std::string> mensaje = co_await leerMensaje();
+
+        // Sin mensaje: el cliente cortó la conexión (FIN) o el servicio se apaga.
+        if (!mensaje) break;
+        // Una trama MENSAJE vacía es válida, pero no hay nada que anotar ni responder.
+        if (mensaje->empty()) continue;
+        atenderMensaje(*mensaje);
+    }
+
+    // Al apagar, la sesión queda en el WAL como interrumpida (sin ticket).
+    if (detenido) co_return;
+    cambiarEstado(EstadoSesion::CERRANDO);
+    cerrarSesion();
+}
+
+void ServicioSoporte::cambiarEstado(EstadoSesion nuevo) {
+    estado.store(nuevo);
+}
+
+bool ServicioSoporte::asignarSiguiente() {
+    if (!servidor.tomarSiguienteCliente()) return false;
+    cambiarEstado(EstadoSesion::ASIGNADA);
+
+    // Limpiamos el historial para la nueva sesión
+    historial.limpiarHistorial();
+
+    int socketActual = servidor.getClienteActual();
+    std::string nombre = servidor.obtenerNombrePorSocket(socketActual);
+    std::cout << "[SISTEMA] Atendiendo a " << nombre << ".\n";
+    wal.mensaje(servidor.obtenerIdPorSocket(socketActual), "Sistema", "Conectado con: " + nombre, false);
+    historial.agregarMensaje("Sistema", "Conectado con: " + nombre, false);
+
+    cambiarEstado(EstadoSesion::ACTIVA);
+    notificar();
+    return true;
+}
+
+void ServicioSoporte::atenderMensaje(const std::string& mensaje) {
+    // Si llega mensaje real, buscamos quién lo envía
+    int idSocket = servidor.getClienteActual();
+    std::string nombreCliente = servidor.obtenerNombrePorSocket(idSocket);
+
+    wal.mensaje(servidor.obtenerIdPorSocket(idSocket), nombreCliente, mensaje, false);
+    // Lo agregamos al historial compartido (Thread-Safe gracias al Mutex en Chat)
+    historial.agregarMensaje(nombreCliente, mensaje, false);
+    if (avisoMensaje) avisoMensaje(nombreCliente, mensaje);
+    notificar();
+}
+
+/**
+ * @brief Detecta la desconexión y dispara la generación automática del ticket.
+ */
+void ServicioSoporte::cerrarSesion() {
+    std::cout << "[RED] El cliente actual se ha desconectado.\n";
+
+    // --- GENERAR EL TICKET ---
+    // Solo se encola: el disco lo atiende el hilo escritor. La vista
+    // del historial se mueve al ticket, sin copiar mensajes.
+    int socketActual = servidor.getClienteActual();
+    int id = servidor.obtenerIdPorSocket(socketActual);
+    std::string nombre = servidor.obtenerNombrePorSocket(socketActual);
+    std::time_t fecha = std::time(nullptr);
+
+    // Si caemos antes de que el ticket llegue al disco, el WAL lo rehace.
+    wal.sesionTerminada(id, fecha);
+    persistencia.encolar(Ticket{id, std::move(nombre), fecha, historial.obtenerVista()});
+
+    historial.agregarMensaje("Sistema", "Ticket guardado. Sesion finalizada.", false);
+
+    // Liberamos el puesto: la siguiente vuelta del bucle ya revisa la fila.
+    servidor.liberarClienteActual();
+    cambiarEstado(EstadoSesion::LIBRE);
+    notificar();
+}
+
+EstadoEnvio ServicioSoporte::enviar(const std::string& texto) {
+    int socketActual = servidor.getClienteActual();
+    if (socketActual == -1) return EstadoEnvio::CERRADO;
+
+    EstadoEnvio estadoEnvio = servidor.enviar(texto);
+    if (estadoEnvio == EstadoEnvio::CERRADO || estadoEnvio == EstadoEnvio::DEMASIADO_GRANDE) return estadoEnvio;
+
+    wal.mensaje(servidor.obtenerIdPorSocket(socketActual), "Yo", texto, true);
+    historial.agregarMensaje("Yo", texto, true); // True = Es Mío (Color Azul)
+    return estadoEnvio;
+}
+
+size_t ServicioSoporte::difundir(std::string_view texto, uint32_t clave, DestinoDifusion destino) {
+    return servidor.difundir(texto, clave, destino);
+}
+
+bool ServicioSoporte::salidaSaturada() {
+    return servidor.salidaSaturada();
+}
+
+EstadoSesion ServicioSoporte::estadoSesion() const {
+    return estado.load();
+}
+
+bool ServicioSoporte::estoyAtendiendo() {
+    return servidor.estoyAtendiendo();
+}
+
+std::string ServicioSoporte::nombreClienteActual() {
+    int socketActual = servidor.getClienteActual();
+    return socketActual == -1 ? "" : servidor.obtenerNombrePorSocket(socketActual);
+}
+
+Chat& ServicioSoporte::chat() {
+    return historial;
+}
@@ -13,18 +13,138 @@
 #include "../include/socket.h"
 #include <iostream>
 #include <unistd.h>      // close()
+#include <fcntl.h>       // fcntl() para modo no bloqueante
 #include <arpa/inet.h>   // inet_pton, htons
-#include <cstring>       // memset
+#include <netinet/tcp.h> // TCP_KEEPIDLE, TCP_KEEPINTVL, TCP_KEEPCNT
+#include <sys/epoll.h>   // EPOLLIN, EPOLLRDHUP...
+#include <sys/un.h>      // sockaddr_un del socket local
+#include <cstddef>       // offsetof
+#include <sched.h>       // sched_getaffinity/sched_setaffinity para fijar núcleos
+#include <sys/eventfd.h> // eventfd() del aviso de entrada
+#include <cerrno>
+#include <ctime>
+#include <cstring>      // memcpy() desde los buffers de io_uring
+#include <cstdlib>      // std::abs
+#include <algorithm>    // std::find en la lista de autorizados
 
 using namespace std;
 
+/**
+ * @brief Activa los keepalives de TCP en un socket de cliente.
+ * * Si un cliente en cola se queda sin red (cable desconectado, Wi-Fi caído)
+ * nunca llega un FIN. Con keepalive el Kernel sondea la conexión inactiva y,
+ * si no responde, el reactor recibe EPOLLERR/EPOLLHUP y lo saca de la fila.
+ */
+static void configurarKeepalive(int fd) {
+    int si = 1;
+    int inactivo = 30;  // Segundos sin tráfico antes de empezar a sondear.
+    int intervalo = 10; // Segundos entre sondeos.
+    int intentos = 3;   // Sondeos sin respuesta antes de declarar la conexión muerta.
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &si, sizeof(si));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &inactivo, sizeof(inactivo));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &intervalo, sizeof(intervalo));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &intentos, sizeof(intentos));
+}
+
+/// Cada cuánto el reactor revisa conexiones inactivas.
+static const chrono::seconds INTERVALO_KEEPALIVE(15);
+/// Inactividad tras la cual se manda un PING.
+static const chrono::seconds INACTIVIDAD_PING(15);
+/// Inactividad tras la cual la conexión se da por muerta (no contestó los PING).
+static const chrono::seconds INACTIVIDAD_MAXIMA(45);
+/// Espacio libre mínimo que se pide al buffer antes de cada recv().
+static const size_t TAM_LECTURA = 16 * 1024;
+/// Salida pendiente a partir de la cual un cliente que no lee se da por muerto.
+static const size_t MAX_SALIDA_PENDIENTE = 4 * 1024 * 1024;
+/// Eventos que se vigilan siempre en un socket de cliente.
+static const uint32_t EVENTOS_CLIENTE = EPOLLIN | EPOLLRDHUP;
+/// Máximo de accept4() seguidos antes de registrar el lote (una sola toma del mutex).
+static const size_t LOTE_ACEPTAR = 64;
+/// Cada cuánto, como mucho, se le avisa a un cliente en cola su lugar.
+static const chrono::seconds INTERVALO_POSICIONES(1);
+/// Sin cambios en la fila, cada cuánto se revisa si las esperas estimadas se movieron.
+static const chrono::seconds REFRESCO_ESTIMACION(10);
+/// Diferencia (segundos) a partir de la cual vale la pena avisar una espera estimada nueva.
+static const int32_t UMBRAL_ESTIMACION = 30;
+/// Clave de coalescencia de las tramas POSICION: a un cliente lento solo le llega la última.
+static const uint32_t CLAVE_POSICION = 1;
+
+// --- io_uring ---
+/// Entradas de la SQ.
+static const unsigned ENTRADAS_URING = 256;
+/// Buffers provistos para los recv multishot (potencia de 2) y su tamaño.
+static const unsigned BUFFERS_URING = 512;
+static const unsigned TAM_BUFFER_URING = 16 * 1024;
+
+/**
+ * @enum OperacionUring
+ * @brief Qué operación identifica una etiqueta (byte alto del user_data).
+ */
+enum class OperacionUring : uint8_t { ACEPTAR = 1, RECIBIR, ENVIAR, CANCELAR };
+
+/**
+ * @brief Etiqueta = operación (8 bits) | generación de la conexión (32) | socket (24).
+ * * La generación evita confundir un resultado atrasado con la conexión que
+ * recibió después el mismo número de socket.
+ */
+static uint64_t etiquetaUring(OperacionUring op, uint32_t generacion, int fd) {
+    return (static_cast<uint64_t>(op) << 56) | (static_cast<uint64_t>(generacion) << 24) |
+           (static_cast<uint32_t>(fd) & 0xFFFFFF);
+}
+
+/**
+ * @brief Fragmento cuyo anillo está procesando este hilo: sus peticiones se
+ * acumulan y se someten todas juntas al final (una syscall por lote).
+ */
+static thread_local Fragmento* loteUring = nullptr;
+
+/**
+ * @brief Somete ya las peticiones de 'fragmento', salvo que su lote esté en curso en este hilo.
+ */
+static void someterFueraDeLote(Fragmento& fragmento) {
+    if (loteUring != &fragmento) fragmento.anillo->someter();
+}
+
+/**
+ * @brief Fija el hilo que llama al 'indice'-ésimo núcleo permitido para el proceso.
+ * * Se cuenta sobre los núcleos permitidos (taskset, cgroups), no sobre todos los de la máquina.
+ */
+static bool fijarANucleo(int indice) {
+    cpu_set_t permitidos;
+    if (sched_getaffinity(0, sizeof(permitidos), &permitidos) != 0) return false;
+    int total = CPU_COUNT(&permitidos);
+    if (total == 0) return false;
+
+    int buscado = indice % total;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &permitidos)) continue;
+        if (buscado-- > 0) continue;
+        cpu_set_t uno;
+        CPU_ZERO(&uno);
+        CPU_SET(cpu, &uno);
+        return sched_setaffinity(0, sizeof(uno), &uno) == 0; // 0 = el hilo que llama.
+    }
+    return false;
+}
+
 /**
  * @brief Constructor. Inicializa los descriptores en -1 (estado inválido).
  */
 ServerSocket::ServerSocket(){
-    serverSocket = -1;
     clienteActual = -1;
+    backendPedido = BackendRed::EPOLL;
+    fragmentosPedidos = 1;
+    fijarNucleos = false;
+    siguienteGeneracion = 1;
+    versionFila = 0;
+    planificador = std::make_unique<PlanificadorFIFO>();
+    posiciones = PosicionesCola(NUM_CLASES);
+    memoriaCompartida = false;
+    socketLocal = -1;
     contadorID = 1;
+    activoDesconectado = false;
+    avisoEntrada = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    wal = nullptr;
 }
 
 /**
@@ -33,6 +153,10 @@ ServerSocket::ServerSocket(){
 ServerSocket::~ServerSocket()
 {
     cerrarServidor();
+    // Por si aceptarClientes() no alcanzó a esperarlos (sus reactores ya están detenidos).
+    for (auto& fragmento : fragmentos)
+        if (fragmento->hilo.joinable()) fragmento->hilo.join();
+    if (avisoEntrada != -1) close(avisoEntrada);
 }
 
 // 1 - Crear socket
@@ -43,8 +167,54 @@ ServerSocket::~ServerSocket()
  */
 bool ServerSocket::crear()
 {
-    serverSocket = socket(AF_INET, SOCK_STREAM, 0);
-    return serverSocket != -1;
+    for (int i = 0; i < fragmentosPedidos; ++i) {
+        fragmentos.push_back(std::make_unique<Fragmento>());
+        Fragmento& fragmento = *fragmentos.back();
+        fragmento.indice = i;
+        fragmento.socketEscucha = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fragmento.socketEscucha == -1) return false;
+
+        // Varios sockets en el mismo puerto: el Kernel reparte las conexiones entre ellos.
+        if (fragmentosPedidos > 1) {
+            int si = 1;
+            if (setsockopt(fragmento.socketEscucha, SOL_SOCKET, SO_REUSEPORT, &si, sizeof(si)) < 0) return false;
+        }
+
+        // El reactor se crea aquí para que exista antes de que cualquier hilo lo use.
+        if (!fragmento.reactor.crear()) return false;
+        fragmento.descriptorReserva = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    }
+
+    if (backendPedido == BackendRed::IO_URING) {
+        // Todos con io_uring o ninguno: así el backend es uno solo para todo el servidor.
+        bool todos = true;
+        for (auto& fragmento : fragmentos) {
+            fragmento->anillo = std::make_unique<AnilloUring>();
+            if (!fragmento->anillo->crear(ENTRADAS_URING, BUFFERS_URING, TAM_BUFFER_URING)) {
+                todos = false;
+                break;
+            }
+        }
+        if (!todos) {
+            cerr << "[AVISO] io_uring no esta disponible en este Kernel; se usa epoll." << endl;
+            for (auto& fragmento : fragmentos) fragmento->anillo.reset();
+        }
+    }
+
+    for (auto& f : fragmentos) {
+        Fragmento* fragmento = f.get();
+        if (fragmento->anillo &&
+            !fragmento->reactor.registrar(fragmento->anillo->descriptor(), EPOLLIN,
+                                          [this, fragmento](uint32_t) { procesarCompletados(*fragmento); })) {
+            return false;
+        }
+        // Keepalive de aplicación: detecta clientes colgados que TCP aún no reporta.
+        if (!fragmento->reactor.programarPeriodico(INTERVALO_KEEPALIVE, [this, fragmento] { revisarInactivos(*fragmento); }))
+            return false;
+        if (!fragmento->reactor.programarPeriodico(INTERVALO_POSICIONES, [this, fragmento] { avisarPosiciones(*fragmento); }))
+            return false;
+    }
+    return true;
 }
 
 // 2 - Configurar
@@ -69,12 +239,14 @@ bool ServerSocket::configurar(const char *ip, int puerto)
  */
 bool ServerSocket::bindear()
 {
-    if (::bind(serverSocket,
-               (struct sockaddr *)&serverAddr,
-               sizeof(serverAddr)) < 0)
-    {
-        cerr << "Error en el bind" << endl;
-        return false;
+    for (auto& fragmento : fragmentos) {
+        if (::bind(fragmento->socketEscucha,
+                   (struct sockaddr *)&serverAddr,
+                   sizeof(serverAddr)) < 0)
+        {
+            cerr << "Error en el bind" << endl;
+            return false;
+        }
     }
     return true;
 }
@@ -86,132 +258,1140 @@ bool ServerSocket::bindear()
  */
 bool ServerSocket::escuchar(int espera)
 {
-    return listen(serverSocket, espera) >= 0;
+    for (auto& f : fragmentos) {
+        Fragmento* fragmento = f.get();
+        int fd = fragmento->socketEscucha;
+        if (listen(fd, espera) < 0) return false;
+
+        // io_uring: una sola petición de accept multishot sirve para todas las conexiones.
+        if (fragmento->anillo) {
+            if (!fragmento->anillo->aceptar(fd, etiquetaUring(OperacionUring::ACEPTAR, 0, fd)) ||
+                !fragmento->anillo->someter())
+                return false;
+            continue;
+        }
+
+        // El socket que escucha es un descriptor más dentro del reactor:
+        // cuando está "listo para leer" significa que hay conexiones por aceptar.
+        if (!fragmento->reactor.registrar(fd, EPOLLIN, [this, fragmento](uint32_t) {
+                aceptarPendientes(*fragmento);
+            }))
+            return false;
+    }
+
+    // Sin el socket local los clientes siguen entrando por TCP: solo se avisa.
+    if (memoriaCompartida && !abrirLocal())
+        cerr << "[AVISO] No se pudo abrir el socket local; sin memoria compartida." << endl;
+    return true;
+}
+
+/**
+ * @brief Socket Unix en el espacio abstracto (no deja archivo en disco) con el
+ * nombre que el cliente deduce del puerto. Lo atiende el fragmento 0.
+ */
+bool ServerSocket::abrirLocal()
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) return false;
+
+    sockaddr_un direccion{};
+    direccion.sun_family = AF_UNIX;
+    std::string nombre = CanalMemoria::nombreLocal(ntohs(serverAddr.sin_port));
+    std::memcpy(direccion.sun_path, nombre.data(), nombre.size());
+    socklen_t largo = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + nombre.size());
+
+    Fragmento* fragmento = fragmentos[0].get();
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&direccion), largo) < 0 || listen(fd, SOMAXCONN) < 0 ||
+        !fragmento->reactor.registrar(fd, EPOLLIN, [this, fragmento](uint32_t) { aceptarLocales(*fragmento); })) {
+        close(fd);
+        return false;
+    }
+    socketLocal = fd;
+    return true;
 }
 
-// 5 - Aceptar clientes (HILO ACEPTADOR)
+// 5 - Bucle del reactor (HILO DE RED)
 /**
- * @brief Bucle infinito que corre en un hilo secundario (Background).
- * * Su única tarea es esperar a que alguien se conecte y meterlo a la cola.
- * * CRÍTICO: Usa Mutex para proteger el acceso a 'colaClientes' y 'listaClientes'.
+ * @brief Bucle que corre en un hilo secundario (Background).
+ * * Ya no se bloquea en accept(): le entrega el control al reactor, que
+ * despierta solo cuando algún socket (el que escucha o un cliente) tiene actividad.
  */
 void ServerSocket::aceptarClientes() {
+    if (fragmentos.empty()) return;
+    for (size_t i = 1; i < fragmentos.size(); ++i) {
+        Fragmento* fragmento = fragmentos[i].get();
+        fragmento->hilo = std::thread([this, fragmento] { correrFragmento(*fragmento); });
+    }
+    correrFragmento(*fragmentos[0]);
+
+    // cerrarServidor() detiene a todos a la vez.
+    for (size_t i = 1; i < fragmentos.size(); ++i)
+        if (fragmentos[i]->hilo.joinable()) fragmentos[i]->hilo.join();
+}
+
+void ServerSocket::correrFragmento(Fragmento& fragmento) {
+    if (fijarNucleos && !fijarANucleo(fragmento.indice))
+        cerr << "[AVISO] No se pudo fijar el fragmento " << fragmento.indice << " a un nucleo." << endl;
+    fragmento.reactor.ejecutar();
+}
+
+void ServerSocket::usarBackend(BackendRed backend) {
+    backendPedido = backend;
+}
+
+BackendRed ServerSocket::backend() const {
+    return !fragmentos.empty() && fragmentos[0]->anillo ? BackendRed::IO_URING : BackendRed::EPOLL;
+}
+
+void ServerSocket::usarFragmentos(int cantidad, bool fijar) {
+    if (cantidad <= 0) {
+        cpu_set_t permitidos;
+        cantidad = sched_getaffinity(0, sizeof(permitidos), &permitidos) == 0 ? CPU_COUNT(&permitidos) : 1;
+    }
+    fragmentosPedidos = std::max(1, cantidad);
+    fijarNucleos = fijar;
+}
+
+size_t ServerSocket::cantidadFragmentos() const {
+    return fragmentos.size();
+}
+
+void ServerSocket::usarMemoriaCompartida(bool activar) {
+    memoriaCompartida = activar;
+}
+
+void ServerSocket::usarPlanificador(std::unique_ptr<PlanificadorFila> nuevo) {
+    if (nuevo) planificador = std::move(nuevo);
+}
+
+bool ServerSocket::autorizarPrioridad(const std::vector<std::string>& direcciones) {
+    std::vector<uint32_t> nuevas;
+    for (const std::string& texto : direcciones) {
+        in_addr direccion;
+        if (inet_pton(AF_INET, texto.c_str(), &direccion) <= 0) {
+            cerr << "[ERROR] Direccion invalida para la clase prioritaria: " << texto << endl;
+            return false;
+        }
+        nuevas.push_back(direccion.s_addr);
+    }
+    autorizadosPrioridad = std::move(nuevas);
+    return true;
+}
+
+void ServerSocket::alCambiarEstado(std::function<void()> aviso) {
+    avisoCambios = std::move(aviso);
+}
+
+void ServerSocket::usarWAL(WAL* bitacora) {
+    wal = bitacora;
+}
+
+void ServerSocket::continuarIdsDesde(int ultimoId) {
+    std::lock_guard<std::mutex> lock(mtxCola);
+    if (ultimoId >= contadorID) contadorID = ultimoId + 1;
+}
+
+/**
+ * @brief Acepta a todos los que están tocando la puerta (solo con epoll).
+ * * El socket es no bloqueante, así que vaciamos la cola del Kernel hasta EAGAIN,
+ * de LOTE_ACEPTAR en LOTE_ACEPTAR: en una avalancha de conexiones el mutex
+ * se toma una vez por lote y no una por cliente.
+ */
+void ServerSocket::aceptarPendientes(Fragmento& fragmento) {
+    int lote[LOTE_ACEPTAR];
     while (true) {
-        sockaddr_in clienteAddr;
-        socklen_t len = sizeof(clienteAddr);
+        size_t cantidad = 0;
+        while (cantidad < LOTE_ACEPTAR) {
+            int nuevoSocket = accept4(fragmento.socketEscucha, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (nuevoSocket < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                if ((errno == EMFILE || errno == ENFILE) && rechazarSinDescriptores(fragmento, fragmento.socketEscucha))
+                    continue;
+                break; // EAGAIN: ya no hay nadie esperando en el Kernel.
+            }
+            lote[cantidad++] = nuevoSocket;
+        }
 
-        // accept(): SE BLOQUEA aquí hasta que alguien intente entrar.
-        int nuevoSocket = accept(serverSocket, (sockaddr*)&clienteAddr, &len);
+        if (cantidad > 0) registrarClientes(fragmento, lote, cantidad);
+        if (cantidad < LOTE_ACEPTAR) return;
+    }
+}
+
+/**
+ * @brief Sin descriptores libres la conexión se queda en la cola del Kernel y,
+ * como epoll avisa por nivel, el socket de escucha seguiría "listo": el
+ * reactor giraría al 100% sin aceptar a nadie.
+ * * Se suelta el descriptor de reserva, se acepta y se cierra de inmediato (el
+ * cliente ve el cierre en vez de quedarse colgado) y se vuelve a guardar.
+ * Si ni así (otro hilo ganó el descriptor), se deja de vigilar 'escucha'
+ * (con io_uring: no se vuelve a pedir el accept) y revisarInactivos() lo reactiva.
+ */
+bool ServerSocket::rechazarSinDescriptores(Fragmento& fragmento, int escucha) {
+    int rechazado = -1;
+    if (fragmento.descriptorReserva != -1) {
+        close(fragmento.descriptorReserva);
+        rechazado = accept4(escucha, nullptr, nullptr, SOCK_CLOEXEC);
+        if (rechazado >= 0) close(rechazado);
+        fragmento.descriptorReserva = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    }
+    if (rechazado >= 0) {
+        cerr << "[AVISO] Sin descriptores libres: se rechazo una conexion." << endl;
+        return true;
+    }
+    if (fragmento.anillo || fragmento.reactor.modificar(escucha, 0)) {
+        cerr << "[AVISO] Sin descriptores libres: no se aceptan conexiones hasta el siguiente keepalive." << endl;
+        fragmento.escuchasPausadas.push_back(escucha);
+    }
+    return false;
+}
+
+/**
+ * @brief Como aceptarPendientes(), pero por el socket local: cada cliente
+ * recibe su memoria y sus timbres antes de quedar registrado.
+ * * Si la oferta falla se cierra el socket; el cliente lo nota y entra por TCP.
+ */
+void ServerSocket::aceptarLocales(Fragmento& fragmento) {
+    int lote[LOTE_ACEPTAR];
+    std::unique_ptr<CanalMemoria> canales[LOTE_ACEPTAR];
+    while (true) {
+        size_t cantidad = 0;
+        while (cantidad < LOTE_ACEPTAR) {
+            int nuevoSocket = accept4(socketLocal, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (nuevoSocket < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                if ((errno == EMFILE || errno == ENFILE) && rechazarSinDescriptores(fragmento, socketLocal)) continue;
+                break;
+            }
+            std::unique_ptr<CanalMemoria> canal = CanalMemoria::crear();
+            if (!canal || !canal->ofrecer(nuevoSocket)) {
+                cerr << "[AVISO] No se pudo ofrecer memoria compartida a un cliente local." << endl;
+                close(nuevoSocket);
+                continue;
+            }
+            lote[cantidad] = nuevoSocket;
+            canales[cantidad++] = std::move(canal);
+        }
+
+        if (cantidad > 0) registrarClientes(fragmento, lote, cantidad, canales);
+        if (cantidad < LOTE_ACEPTAR) return;
+    }
+}
+
+/**
+ * @brief Da de alta a clientes recién aceptados (por accept4() o por io_uring).
+ * * Usa Mutex para 'conexiones' y 'registroClientes'; la entrega a la fila de
+ * espera va por 'llegadas' (sin bloqueos), pero DENTRO del mutex: así, con
+ * varios fragmentos aceptando a la vez, el orden de la fila es el de los IDs.
+ */
+void ServerSocket::registrarClientes(Fragmento& fragmento, const int* sockets, size_t cantidad,
+                                     std::unique_ptr<CanalMemoria>* canales) {
+    if (!canales)
+        for (size_t i = 0; i < cantidad; ++i) configurarKeepalive(sockets[i]);
+
+    // La dirección no cambia: se resuelve aquí para no hacer syscalls con mtxCola tomado.
+    std::vector<char> autorizados(cantidad, 0);
+    for (size_t i = 0; i < cantidad; ++i) autorizados[i] = puedePedirPrioridad(sockets[i]);
+
+    std::vector<uint32_t> generaciones(cantidad);
+    std::vector<int> timbres(cantidad, -1);
+    std::string anuncio;
+    {
+        // BLOQUEO DE SEGURIDAD (Mutex)
+        std::lock_guard<std::mutex> lock(mtxCola);
+        auto ahora = chrono::steady_clock::now();
+
+        for (size_t i = 0; i < cantidad; ++i) {
+            int nuevoSocket = sockets[i];
 
-        if (nuevoSocket >= 0) {
-            // BLOQUEO DE SEGURIDAD (Mutex)
-            std::lock_guard<std::mutex> lock(mtxCola);
-            
             // 1. Crear ficha técnica del cliente
             InfoCliente info;
             info.socket = nuevoSocket;
             info.id = contadorID++;
             info.nombre = "Cliente " + std::to_string(info.id);
+            anuncio += "Nuevo: " + info.nombre + "\n";
+
+            // 2. Estado de la conexión
+            EstadoConexion& conexion = conexiones[nuevoSocket];
+            conexion.socket = nuevoSocket;
+            conexion.id = info.id;
+            conexion.fragmento = &fragmento;
+            conexion.generacion = generaciones[i] = siguienteGeneracion++;
+            conexion.autorizadoPrioridad = autorizados[i];
+            if (canales) {
+                conexion.memoria = std::move(canales[i]);
+                timbres[i] = conexion.memoria->timbre();
+            }
+
+            // 3. Guardar su ficha (se borra cuando se cierre el socket)
+            std::string nombre = info.nombre;
+            conexion.cliente = registroClientes.agregar(std::move(info));
+            conexion.ultimaActividad = ahora;
+
+            // 4. PROTOCOLO: Enviamos la trama WAIT para que el cliente se ponga en pantalla de espera,
+            // y en el mismo envío su lugar en la fila. Entrar al final no mueve a nadie más.
+            conexion.turno = posiciones.agregar(ahora, static_cast<size_t>(conexion.clase));
+            conexion.llegada = posiciones.llegada(conexion.turno);
+            conexion.salida.agregarTrama(TipoTrama::WAIT, conexion.secuenciaSalida++, "");
+            encolarPosicion(conexion, calcularPosicion(conexion, ahora));
+            empujarSalida(conexion);
+
+            // 5. Anotarlo en el WAL (solo copia a memoria, no espera al disco).
+            if (wal) wal->clienteEnCola(conexion.id, nombre);
+
+            // 6. Meter a la cola de espera (todos llegan como NORMAL; la trama CLASE puede cambiarlo)
+            llegadas.empujar({nuevoSocket, conexion.cliente,
+                              conexion.llegada + planificador->plazo(conexion.clase), conexion.ingreso});
+        }
+    }
+
+    std::cout << anuncio;
+    if (avisoCambios) avisoCambios();
+
+    // 7. Vigilar los sockets: así también se nota si un cliente cuelga mientras espera.
+    for (size_t i = 0; i < cantidad; ++i) vigilarCliente(fragmento, sockets[i], generaciones[i], timbres[i]);
+}
+
+void ServerSocket::vigilarCliente(Fragmento& fragmento, int fd, uint32_t generacion, int timbre) {
+    if (timbre != -1) {
+        fragmento.reactor.registrar(fd, EVENTOS_CLIENTE, [this, fd](uint32_t eventos) {
+            atenderConexion(fd, eventos);
+        });
+        fragmento.reactor.registrar(timbre, EPOLLIN, [this, fd](uint32_t) { atenderTimbre(fd); });
+        return;
+    }
+    if (fragmento.anillo) {
+        fragmento.anillo->recibir(fd, etiquetaUring(OperacionUring::RECIBIR, generacion, fd));
+        someterFueraDeLote(fragmento);
+        return;
+    }
+    // EPOLLRDHUP avisa si el cliente cuelga mientras espera.
+    fragmento.reactor.registrar(fd, EVENTOS_CLIENTE, [this, fd](uint32_t eventos) {
+        atenderConexion(fd, eventos);
+    });
+}
+
+void ServerSocket::dejarDeVigilar(EstadoConexion& conexion) {
+    Fragmento& fragmento = *conexion.fragmento;
+    if (conexion.memoria) {
+        fragmento.reactor.quitar(conexion.socket);
+        fragmento.reactor.quitar(conexion.memoria->timbre());
+        return;
+    }
+    if (!fragmento.anillo) {
+        fragmento.reactor.quitar(conexion.socket);
+        return;
+    }
+    if (!conexion.vigilada) return;
+    conexion.vigilada = false;
+    fragmento.anillo->cancelar(etiquetaUring(OperacionUring::RECIBIR, conexion.generacion, conexion.socket),
+                               etiquetaUring(OperacionUring::CANCELAR, conexion.generacion, conexion.socket));
+    someterFueraDeLote(fragmento);
+}
+
+/**
+ * @brief Lee todo lo disponible en un socket de cliente.
+ * * Los bytes se acumulan en el buffer de la conexión y se decodifican como tramas,
+ * así varias tramas pegadas en un solo recv() (o una trama partida) se procesan bien.
+ */
+void ServerSocket::atenderConexion(int fd, uint32_t eventos) {
+    EstadoConexion* encontrada;
+    {
+        // Otros fragmentos insertan al mismo tiempo: se busca con el mutex. La
+        // entrada solo la borra este hilo, así que el puntero sigue valiendo.
+        std::lock_guard<std::mutex> lock(mtxCola);
+        auto it = conexiones.find(fd);
+        if (it == conexiones.end()) return;
+        encontrada = &it->second;
+    }
+    EstadoConexion& conexion = *encontrada;
+
+    bool colgo = (eventos & (EPOLLERR | EPOLLHUP)) != 0;
+    if (!colgo && (eventos & EPOLLOUT)) colgo = !continuarEscritura(fd);
+
+    while (!colgo) {
+        char* destino = conexion.entrada.reservar(TAM_LECTURA);
+        ssize_t bytes = recv(fd, destino, conexion.entrada.espacioLibre(), 0);
+
+        if (bytes > 0) {
+            conexion.entrada.confirmar(bytes);
+            conexion.ultimaActividad = chrono::steady_clock::now();
+            if (!procesarTramas(fd, conexion)) {
+                std::cerr << "[RED] Trama invalida en socket " << fd << ", cerrando conexion.\n";
+                colgo = true;
+            }
+            continue;
+        }
+
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break; // Ya no hay más datos.
+        if (bytes < 0 && errno == EINTR) continue;
+        colgo = true; // bytes == 0 (FIN) o error real.
+    }
+
+    // EPOLLRDHUP sin datos pendientes también significa que el cliente cerró su lado.
+    if (colgo || (eventos & EPOLLRDHUP)) desconectar(fd);
+}
+
+/**
+ * @brief Timbre de una conexión por memoria compartida.
+ * * Puede significar lugar libre en el anillo de salida (se termina de
+ * mandar lo pendiente) o tramas nuevas en el de entrada. Se lee hasta que
+ * el anillo quede vacío DESPUÉS de declararse dormido: así ningún escrito
+ * del cliente se queda sin su timbre.
+ */
+void ServerSocket::atenderTimbre(int fd) {
+    EstadoConexion* encontrada;
+    bool liberado = false;
+    {
+        std::lock_guard<std::mutex> lock(mtxCola);
+        auto it = conexiones.find(fd);
+        if (it == conexiones.end() || !it->second.memoria) return;
+        encontrada = &it->second;
+        encontrada->memoria->apagarTimbre();
+        if (encontrada->esperandoEscritura) {
+            bool estabaSaturado = encontrada->salida.estaSaturado();
+            vaciarSalida(*encontrada);
+            liberado = estabaSaturado && !encontrada->salida.estaSaturado();
+        }
+    }
+    if (liberado && avisoCambios) avisoCambios();
+
+    // El anillo de entrada solo lo lee este hilo: no hace falta el mutex.
+    EstadoConexion& conexion = *encontrada;
+    CanalMemoria& canal = *conexion.memoria;
+    do {
+        long leidos = canal.leerEn(conexion.entrada);
+        if (leidos == 0) continue;
+        if (leidos < 0 || !procesarTramas(fd, conexion)) {
+            std::cerr << "[RED] Trama invalida en la memoria de socket " << fd << ", cerrando conexion.\n";
+            desconectar(fd);
+            return;
+        }
+        conexion.ultimaActividad = chrono::steady_clock::now();
+    } while (!canal.prepararEspera());
+}
+
+/**
+ * @brief Extrae y despacha todas las tramas completas del buffer.
+ * * MENSAJE del cliente activo: se copia a 'bandejaEntrada' (única copia).
+ * * MENSAJE de alguien en cola: se descarta (su UI está bloqueada, no debería escribir).
+ * * PING: se contesta con PONG. PONG: basta con haber actualizado 'ultimaActividad'.
+ */
+bool ServerSocket::procesarTramas(int fd, EstadoConexion& conexion) {
+    std::lock_guard<std::mutex> lock(mtxCola);
+    bool esActivo = (fd == clienteActual);
+    bool nuevos = false;
+
+    VistaTrama trama;
+    ResultadoDecodificacion resultado;
+    while ((resultado = conexion.decodificador.siguiente(conexion.entrada, trama)) == ResultadoDecodificacion::TRAMA) {
+        switch (trama.tipo) {
+            case TipoTrama::MENSAJE:
+                if (esActivo) {
+                    bandejaEntrada.emplace_back(trama.datos);
+                    nuevos = true;
+                }
+                break;
+            case TipoTrama::PING:
+                enviarTrama(conexion, TipoTrama::PONG, "");
+                break;
+            case TipoTrama::CLASE:
+                if (conexion.enCola) reclasificar(fd, conexion, trama.datos);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (nuevos) avisarEntrada();
+    return resultado != ResultadoDecodificacion::ERROR;
+}
+
+/**
+ * @brief Codifica la trama con la siguiente secuencia de la conexión y la envía.
+ * * Se llama con mtxCola tomado: así dos hilos no pueden intercalar tramas
+ * con secuencias desordenadas.
+ * * Si ya hay una escritura esperando EPOLLOUT, la trama solo se agrega al
+ * buffer: saldrá junto con las demás en un solo sendmsg().
+ */
+void ServerSocket::enviarTrama(EstadoConexion& conexion, TipoTrama tipo, std::string_view datos) {
+    conexion.salida.agregarTrama(tipo, conexion.secuenciaSalida++, datos);
+    empujarSalida(conexion);
+}
+
+void ServerSocket::empujarSalida(EstadoConexion& conexion) {
+    if (conexion.esperandoEscritura) return;
+
+    if (conexion.fragmento->anillo && !conexion.memoria) {
+        iniciarEnvioUring(conexion);
+    } else {
+        vaciarSalida(conexion);
+    }
+}
+
+void ServerSocket::vaciarSalida(EstadoConexion& conexion) {
+    if (conexion.memoria) {
+        // Anillo lleno: el cliente tocará el timbre cuando lea (no hay EPOLLOUT).
+        conexion.esperandoEscritura = conexion.memoria->vaciar(conexion.salida) == ResultadoVaciado::PENDIENTE;
+        return;
+    }
+    switch (conexion.salida.vaciar(conexion.socket)) {
+        case ResultadoVaciado::VACIO:
+            break;
+        case ResultadoVaciado::PENDIENTE: {
+            // El Kernel está lleno: que el reactor avise cuando haya lugar.
+            // modificar() no es Thread-Safe, así que se publica como tarea.
+            conexion.esperandoEscritura = true;
+            int fd = conexion.socket;
+            uint32_t generacion = conexion.generacion;
+            Fragmento* fragmento = conexion.fragmento;
+            fragmento->reactor.publicar([this, fragmento, fd, generacion] {
+                std::lock_guard<std::mutex> lock(mtxCola);
+                // Si mientras tanto se cerró, otro fragmento pudo recibir el mismo número de socket.
+                auto it = conexiones.find(fd);
+                if (it != conexiones.end() && it->second.generacion == generacion && it->second.esperandoEscritura)
+                    fragmento->reactor.modificar(fd, EVENTOS_CLIENTE | EPOLLOUT);
+            });
+            break;
+        }
+        case ResultadoVaciado::ERROR:
+            // El otro lado colgó; el reactor lo notará por el lado de lectura.
+            conexion.salida.descartar();
+            break;
+    }
+}
+
+bool ServerSocket::continuarEscritura(int fd) {
+    bool liberado = false;
+    {
+        std::lock_guard<std::mutex> lock(mtxCola);
+        auto it = conexiones.find(fd);
+        if (it == conexiones.end()) return true;
+        EstadoConexion& conexion = it->second;
+
+        bool estabaSaturado = conexion.salida.estaSaturado();
+        ResultadoVaciado resultado = conexion.salida.vaciar(fd);
+        if (resultado == ResultadoVaciado::ERROR) return false;
+        if (resultado == ResultadoVaciado::VACIO) {
+            conexion.esperandoEscritura = false;
+            conexion.fragmento->reactor.modificar(fd, EVENTOS_CLIENTE);
+        }
+        liberado = estabaSaturado && !conexion.salida.estaSaturado();
+    }
+
+    // El agente puede volver a escribir: que la interfaz se entere.
+    if (liberado && avisoCambios) avisoCambios();
+    return true;
+}
+
+// ================= BACKEND IO_URING =================
+
+/**
+ * @brief Un solo send por conexión a la vez: lo que llegue mientras tanto se
+ * acumula en 'salida' y sale completo en el siguiente (igual que con EPOLLOUT).
+ */
+void ServerSocket::iniciarEnvioUring(EstadoConexion& conexion) {
+    if (conexion.salida.vacio()) return;
+
+    uint64_t etiqueta = etiquetaUring(OperacionUring::ENVIAR, conexion.generacion, conexion.socket);
+    std::string& enVuelo = enviosEnVuelo[etiqueta];
+    conexion.salida.extraer(enVuelo);
+    conexion.esperandoEscritura = true;
+
+    Fragmento& fragmento = *conexion.fragmento;
+    fragmento.anillo->enviar(conexion.socket, enVuelo.data(), enVuelo.size(), etiqueta);
+    someterFueraDeLote(fragmento);
+}
+
+/**
+ * @brief Callback del reactor: el anillo tiene resultados.
+ * * Las peticiones que se generen al procesarlos (re-armar un recv, contestar
+ * un PING, mandar WAIT a los recién aceptados) se someten juntas al final.
+ */
+void ServerSocket::procesarCompletados(Fragmento& fragmento) {
+    loteUring = &fragmento;
+    fragmento.anillo->procesar([this, &fragmento](const Completado& c) { alCompletarUring(fragmento, c); });
+    if (!fragmento.aceptadosUring.empty()) {
+        registrarClientes(fragmento, fragmento.aceptadosUring.data(), fragmento.aceptadosUring.size());
+        fragmento.aceptadosUring.clear();
+    }
+    loteUring = nullptr;
+    fragmento.anillo->someter();
+}
+
+void ServerSocket::alCompletarUring(Fragmento& fragmento, const Completado& c) {
+    AnilloUring& anillo = *fragmento.anillo;
+    OperacionUring op = static_cast<OperacionUring>(c.etiqueta >> 56);
+    uint32_t generacion = static_cast<uint32_t>(c.etiqueta >> 24);
+    int fd = static_cast<int>(c.etiqueta & 0xFFFFFF);
+
+    switch (op) {
+    case OperacionUring::ACEPTAR:
+        if (c.resultado >= 0) fragmento.aceptadosUring.push_back(c.resultado); // Se registran al final del lote.
+        if (fragmento.socketEscucha == -1) break;
+
+        if (c.resultado == -EMFILE || c.resultado == -ENFILE) {
+            // Como con epoll: se rechaza al primero de la cola; si ni así, se espera al keepalive.
+            bool rechazado = rechazarSinDescriptores(fragmento, fragmento.socketEscucha);
+            if (rechazado && !c.hayMas()) anillo.aceptar(fragmento.socketEscucha, c.etiqueta);
+        } else if (c.hayMas()) {
+            break;
+        } else if (c.resultado == -EINVAL) {
+            // No es pasajero (el Kernel no acepta la petición): pedirlo otra vez sería un ciclo sin fin.
+            cerr << "[ERROR] io_uring rechazo el accept multishot; el fragmento " << fragmento.indice
+                 << " ya no acepta conexiones." << endl;
+        } else if (c.resultado >= 0 || c.resultado == -ECONNABORTED || c.resultado == -EINTR ||
+                   c.resultado == -EAGAIN) {
+            // El Kernel cortó el multishot (ej. CQ llena) o falló un solo cliente: se vuelve a pedir.
+            anillo.aceptar(fragmento.socketEscucha, c.etiqueta);
+        } else {
+            // Otro error: se reintenta en el siguiente keepalive, no en un ciclo apretado.
+            cerr << "[AVISO] El accept de io_uring fallo (" << -c.resultado << "); se reintenta en el keepalive." << endl;
+            fragmento.escuchasPausadas.push_back(fragmento.socketEscucha);
+        }
+        break;
+
+    case OperacionUring::RECIBIR: {
+        // Igual que en atenderConexion(): se busca con el mutex y solo este hilo la borra.
+        EstadoConexion* encontrada = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mtxCola);
+            auto it = conexiones.find(fd);
+            if (it != conexiones.end()) encontrada = &it->second;
+        }
+        bool vigente = encontrada && encontrada->generacion == generacion && encontrada->vigilada;
+
+        if (c.usaBuffer()) {
+            // Copia al buffer de la conexión (ahí se arman las tramas partidas) y se devuelve al anillo.
+            if (vigente && c.resultado > 0) {
+                EstadoConexion& conexion = *encontrada;
+                char* destino = conexion.entrada.reservar(static_cast<size_t>(c.resultado));
+                std::memcpy(destino, anillo.datosBuffer(c.buffer()), static_cast<size_t>(c.resultado));
+                conexion.entrada.confirmar(static_cast<size_t>(c.resultado));
+            }
+            anillo.devolverBuffer(c.buffer());
+        }
+        if (!vigente) break;
+
+        EstadoConexion& conexion = *encontrada;
+        bool colgo = false;
+        if (c.resultado > 0) {
+            conexion.ultimaActividad = chrono::steady_clock::now();
+            if (!procesarTramas(fd, conexion)) {
+                std::cerr << "[RED] Trama invalida en socket " << fd << ", cerrando conexion.\n";
+                colgo = true;
+            }
+        } else if (c.resultado != -ENOBUFS) {
+            colgo = true; // 0 = FIN del cliente; negativo = error real.
+        }
 
-            // 2. Guardar en registro histórico
-            listaClientes.push_back(info);
+        if (colgo) {
+            desconectar(fd);
+        } else if (!c.hayMas()) {
+            // Se acabaron los buffers (ENOBUFS) o el Kernel cortó el multishot: volver a pedirlo.
+            anillo.recibir(fd, c.etiqueta);
+        }
+        break;
+    }
+
+    case OperacionUring::ENVIAR: {
+        bool liberado = false;
+        {
+            std::lock_guard<std::mutex> lock(mtxCola);
+            auto vuelo = enviosEnVuelo.find(c.etiqueta);
+            auto it = conexiones.find(fd);
+            if (it == conexiones.end() || it->second.generacion != generacion) {
+                // La conexión ya se cerró: solo faltaba liberar la memoria del send.
+                if (vuelo != enviosEnVuelo.end()) enviosEnVuelo.erase(vuelo);
+                break;
+            }
+            EstadoConexion& conexion = it->second;
+
+            if (c.resultado > 0 && vuelo != enviosEnVuelo.end() &&
+                static_cast<size_t>(c.resultado) < vuelo->second.size()) {
+                // Envío parcial (solo si una señal lo interrumpió): mandar el resto.
+                conexion.salida.confirmarEnvio(static_cast<size_t>(c.resultado));
+                vuelo->second.erase(0, static_cast<size_t>(c.resultado));
+                anillo.enviar(fd, vuelo->second.data(), vuelo->second.size(), c.etiqueta);
+                break;
+            }
+            bool estabaSaturado = conexion.salida.estaSaturado();
+            if (vuelo != enviosEnVuelo.end()) {
+                conexion.salida.confirmarEnvio(vuelo->second.size());
+                enviosEnVuelo.erase(vuelo);
+            }
+
+            conexion.esperandoEscritura = false;
+            if (c.resultado < 0) {
+                // El otro lado colgó; el recv lo va a notar.
+                conexion.salida.descartar();
+            } else {
+                iniciarEnvioUring(conexion);
+            }
+            liberado = estabaSaturado && !conexion.salida.estaSaturado();
+        }
+        if (liberado && avisoCambios) avisoCambios();
+        break;
+    }
+
+    case OperacionUring::CANCELAR:
+        break;
+    }
+}
+
+/**
+ * @brief Keepalive de aplicación (corre en el hilo del reactor).
+ * * Con mucha gente en cola, un cliente puede "congelarse" sin cerrar el socket.
+ * A quien lleva INACTIVIDAD_PING sin hablar se le manda un PING; a quien
+ * lleva INACTIVIDAD_MAXIMA (no contestó) se le desconecta. Igual a quien
+ * acumula MAX_SALIDA_PENDIENTE sin leer: contesta PINGs pero no recibe nada.
+ * * Cada fragmento revisa solo sus conexiones (solo él puede cerrarlas).
+ */
+void ServerSocket::revisarInactivos(Fragmento& fragmento) {
+    // Lo pausado por falta de descriptores vuelve a aceptar (y se reintenta guardar la reserva).
+    if (fragmento.descriptorReserva == -1) fragmento.descriptorReserva = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    for (int escucha : fragmento.escuchasPausadas) {
+        if (!fragmento.anillo) {
+            fragmento.reactor.modificar(escucha, EPOLLIN);
+        } else if (escucha == fragmento.socketEscucha) {
+            fragmento.anillo->aceptar(escucha, etiquetaUring(OperacionUring::ACEPTAR, 0, escucha));
+            someterFueraDeLote(fragmento);
+        }
+    }
+    fragmento.escuchasPausadas.clear();
+
+    auto ahora = chrono::steady_clock::now();
+    std::vector<int> muertos;
+    {
+        std::lock_guard<std::mutex> lock(mtxCola);
+        for (auto& par : conexiones) {
+            EstadoConexion& conexion = par.second;
+            if (conexion.fragmento != &fragmento) continue;
+            auto inactivo = ahora - conexion.ultimaActividad;
+            if (inactivo >= INACTIVIDAD_MAXIMA || conexion.salida.pendiente() > MAX_SALIDA_PENDIENTE) {
+                muertos.push_back(par.first);
+            } else if (inactivo >= INACTIVIDAD_PING) {
+                enviarTrama(conexion, TipoTrama::PING, "");
+            }
+        }
+    }
+
+    for (int fd : muertos) desconectar(fd);
+}
 
-            // 3. Meter a la cola de espera
-            colaClientes.push(nuevoSocket);
+/**
+ * @brief ¿Vale la pena mandarle al cliente este aviso, dado lo que ya sabe?
+ * * El total de la fila no cuenta: crece con cada llegada y a nadie le cambia el lugar.
+ */
+static bool cambioVisible(const AvisoPosicion& antes, const AvisoPosicion& ahora) {
+    if (antes.posicion != ahora.posicion) return true;
+    if ((antes.segundos < 0) != (ahora.segundos < 0)) return true;
+    return std::abs(antes.segundos - ahora.segundos) >= UMBRAL_ESTIMACION;
+}
 
-            std::cout << "Nuevo: " << info.nombre << "\n";
+/**
+ * @brief Lugares en la fila (corre en el hilo del reactor, cada INTERVALO_POSICIONES).
+ * * Cada lugar sale del árbol en O(log n); salir de la fila no recorre a
+ * nadie. El recorrido se hace aquí, a lo más una vez por periodo, y solo
+ * si la fila cambió (o, sin cambios, cada REFRESCO_ESTIMACION para que la
+ * espera estimada siga bajando mientras dura una sesión).
+ */
+void ServerSocket::avisarPosiciones(Fragmento& fragmento) {
+    auto ahora = chrono::steady_clock::now();
+    uint64_t version = versionFila.load();
+    if (version == fragmento.versionAvisada && ahora - fragmento.ultimoAvisoPosiciones < REFRESCO_ESTIMACION)
+        return;
+    fragmento.versionAvisada = version;
+    fragmento.ultimoAvisoPosiciones = ahora;
 
-            // 4. PROTOCOLO: Enviamos comando /WAIT para que el cliente se ponga en pantalla de espera
-            std::string msg = "/WAIT";
-            send(nuevoSocket, msg.c_str(), msg.size() + 1, 0); 
+    std::vector<std::pair<int, uint32_t>> porVaciar;
+    {
+        std::lock_guard<std::mutex> lock(mtxCola);
+        for (auto& par : conexiones) {
+            EstadoConexion& conexion = par.second;
+            if (conexion.fragmento != &fragmento || !conexion.enCola) continue;
+            AvisoPosicion aviso = calcularPosicion(conexion, ahora);
+            if (!cambioVisible(conexion.avisado, aviso)) continue;
+            encolarPosicion(conexion, aviso);
+            if (!conexion.esperandoEscritura) porVaciar.push_back({par.first, conexion.generacion});
         }
     }
+
+    // Los envíos, por tandas (como en difundir()): no se retiene mtxCola mientras tanto.
+    if (!porVaciar.empty()) vaciarLote(fragmento, porVaciar);
+}
+
+/**
+ * @brief Lugar = los de su clase que llegaron antes (árbol de su clase) más,
+ * por cada otra clase, los que vencen antes que él: de la clase k vencen
+ * antes los que llegaron antes de (su límite - plazo de k).
+ * * Con FIFO todos son NORMAL y queda solo el primer término.
+ */
+AvisoPosicion ServerSocket::calcularPosicion(const EstadoConexion& conexion, chrono::steady_clock::time_point ahora) const {
+    AvisoPosicion aviso;
+    size_t propia = static_cast<size_t>(conexion.clase);
+    aviso.posicion = posiciones.posicion(conexion.turno);
+    aviso.enCola = static_cast<uint32_t>(posiciones.total());
+    chrono::steady_clock::time_point limite = conexion.llegada + planificador->plazo(conexion.clase);
+    for (size_t k = 0; k < NUM_CLASES; ++k) {
+        if (k != propia && posiciones.total(k) > 0)
+            aviso.posicion += posiciones.anterioresA(limite - planificador->plazo(static_cast<ClaseServicio>(k)), k);
+    }
+    // Sin cliente activo el agente está libre: quien va primero pasa enseguida.
+    chrono::steady_clock::duration enCurso = clienteActual != -1 ? ahora - inicioSesion
+                                                                 : chrono::steady_clock::duration(-1);
+    aviso.segundos = estimador.segundos(aviso.posicion, enCurso);
+    return aviso;
+}
+
+/**
+ * @brief Solo cuenta la primera trama CLASE de cada conexión: cada cambio deja
+ * una entrada vieja en el planificador y un turno en las posiciones, así
+ * que un cliente que alternara de clase sin parar los haría crecer sin límite.
+ */
+void ServerSocket::reclasificar(int fd, EstadoConexion& conexion, std::string_view datos) {
+    if (conexion.pidioClase) return;
+    conexion.pidioClase = true;
+    if (!planificador->distingueClases()) return; // Con FIFO la clase no cambia nada.
+    if (datos.size() != 1 || static_cast<uint8_t>(datos[0]) >= NUM_CLASES) return;
+    ClaseServicio nueva = static_cast<ClaseServicio>(datos[0]);
+    if (nueva == conexion.clase) return;
+    if (nueva != ClaseServicio::NORMAL && !conexion.autorizadoPrioridad) {
+        cerr << "[AVISO] " << nombreDe(fd) << " pidio prioridad sin estar autorizado; sigue como NORMAL." << endl;
+        return;
+    }
+
+    // Conserva su llegada y su turno: en la nueva clase queda entre quienes
+    // llegaron antes y después que él, y su fecha límite sale de su llegada real.
+    posiciones.cambiarClase(conexion.turno, static_cast<size_t>(nueva));
+    conexion.clase = nueva;
+    ++conexion.ingreso;
+    ++versionFila;
+
+    // La entrada vieja se queda en el planificador hasta que salga; vigente() la salta.
+    llegadas.empujar({fd, conexion.cliente, conexion.llegada + planificador->plazo(nueva), conexion.ingreso});
+}
+
+bool ServerSocket::puedePedirPrioridad(int fd) const {
+    if (autorizadosPrioridad.empty()) return false;
+    sockaddr_storage direccion{};
+    socklen_t largo = sizeof(direccion);
+    if (getpeername(fd, reinterpret_cast<sockaddr*>(&direccion), &largo) < 0) return false;
+
+    uint32_t ip;
+    if (direccion.ss_family == AF_INET) ip = reinterpret_cast<const sockaddr_in&>(direccion).sin_addr.s_addr;
+    else if (direccion.ss_family == AF_UNIX) ip = htonl(INADDR_LOOPBACK); // Memoria compartida: la misma máquina.
+    else return false;
+    return std::find(autorizadosPrioridad.begin(), autorizadosPrioridad.end(), ip) != autorizadosPrioridad.end();
+}
+
+void ServerSocket::encolarPosicion(EstadoConexion& conexion, const AvisoPosicion& aviso) {
+    CargaCompartida carga = std::make_shared<const std::string>(codificarPosicion(aviso));
+    if (conexion.salida.agregarCompartida(TipoTrama::POSICION, conexion.secuenciaSalida, carga, CLAVE_POSICION))
+        ++conexion.secuenciaSalida;
+    conexion.avisado = aviso;
+}
+
+/**
+ * @brief Retira una conexión caída.
+ * * Si estaba en cola: se saca de la fila y se cierra el socket.
+ * * Si era el cliente activo: se avisa a recibir(). El socket NO se cierra aquí
+ *   sino en liberarClienteActual(), para que el Kernel no recicle el número
+ *   mientras la sesión todavía lo usa como identificador.
+ */
+void ServerSocket::desconectar(int fd) {
+    std::string nombre;
+    {
+        std::lock_guard<std::mutex> lock(mtxCola);
+        if (fd == clienteActual) {
+            activoDesconectado = true;
+            avisarEntrada();
+            // Dejamos de vigilarlo, pero su estado vive hasta cerrarCliente().
+            auto it = conexiones.find(fd);
+            if (it != conexiones.end()) dejarDeVigilar(it->second);
+            return;
+        }
+        nombre = nombreDe(fd);
+    }
+
+    cerrarConexion(fd);
+    std::cout << "[RED] " << nombre << " abandono la cola de espera.\n";
+    if (avisoCambios) avisoCambios();
+}
+
+/**
+ * @brief Cierre definitivo de un socket de cliente (hilo del fragmento dueño).
+ * * Es idempotente: si la conexión ya fue borrada no vuelve a cerrar el
+ * descriptor (que el Kernel podría haber reciclado para otro cliente).
+ */
+void ServerSocket::cerrarConexion(int fd) {
+    bool conUring;
+    {
+        std::lock_guard<std::mutex> lock(mtxCola);
+        auto conexion = conexiones.find(fd);
+        if (conexion == conexiones.end()) return;
+        Fragmento& fragmento = *conexion->second.fragmento;
+        conUring = fragmento.anillo != nullptr && !conexion->second.memoria;
+        if (!conUring) fragmento.reactor.quitar(fd);
+        if (conexion->second.memoria) fragmento.reactor.quitar(conexion->second.memoria->timbre());
+
+        int id = conexion->second.id;
+        bool estabaEnCola = conexion->second.enCola;
+        if (estabaEnCola) {
+            posiciones.quitar(conexion->second.turno);
+            ++versionFila;
+        }
+        registroClientes.quitar(conexion->second.cliente);
+        conexiones.erase(conexion);
+
+        // Si seguía en el planificador, su manejador ya no es válido: el despachador lo salta.
+        if (estabaEnCola && wal) wal->clienteFueraDeCola(id);
+    }
+    // io_uring retiene el socket mientras tenga peticiones pendientes (el recv
+    // multishot, algún send): shutdown() las termina y el close() sí lo libera.
+    if (conUring) shutdown(fd, SHUT_RDWR);
+    close(fd);
 }
 
 // 6 - Tomar siguiente cliente (HILO ATENCION)
 /**
  * @brief Saca al siguiente cliente de la cola y empieza la sesión.
- * * Esta función es llamada por el 'Main Loop'.
- * * CRÍTICO: Usa Mutex porque modifica la misma cola que usa aceptarClientes().
+ * * Esta función es llamada por el 'Main Loop' (el hilo despachador).
+ * * La fila es suya; el mutex solo cubre la conexión que pasa a ser la activa.
  */
 bool ServerSocket::tomarSiguienteCliente() {
+    actualizarFila();
+    if (planificador->vacio()) return false;
+
     std::lock_guard<std::mutex> lock(mtxCola);
 
-    if (colaClientes.empty()) return false;
+    // Extraemos al que diga el planificador, saltando a quien colgó (o cambió de clase) desde actualizarFila()
+    int fd = -1;
+    while (!planificador->vacio()) {
+        EntradaFila entrada = planificador->frente();
+        planificador->sacar();
+        if (vigente(entrada)) {
+            fd = entrada.socket;
+            break;
+        }
+    }
+    if (fd == -1) return false;
+    clienteActual = fd;
 
-    // Extraemos el primero de la fila (FIFO)
-    clienteActual = colaClientes.front();
-    colaClientes.pop();
+    // Sesión nueva: bandeja limpia.
+    bandejaEntrada.clear();
+    activoDesconectado = false;
 
-    std::string nombre = obtenerNombrePorSocket(clienteActual);
+    std::string nombre = nombreDe(fd);
     std::cout << "Atendiendo a: " << nombre << "\n";
 
-    // PROTOCOLO: Enviamos comando /START para desbloquear la UI del cliente
-    std::string msg = "/START";
-    send(clienteActual, msg.c_str(), msg.size() + 1, 0);
+    // PROTOCOLO: Enviamos la trama START para desbloquear la UI del cliente
+    EstadoConexion& conexion = conexiones.at(fd);
+    conexion.enCola = false;
+    posiciones.quitar(conexion.turno); // O(log n): los demás no se tocan, avisarPosiciones() les dirá.
+    ++versionFila;
+    inicioSesion = chrono::steady_clock::now();
+    enviarTrama(conexion, TipoTrama::START, "");
+    if (wal) wal->sesionIniciada(conexion.id, nombre, std::time(nullptr));
 
     return true;
 }
 
 // 7 - Recibir
 /**
- * @brief Lee datos del cliente actual.
- * * Usa memset para limpiar el buffer antes de leer, evitando basura de memoria.
+ * @brief Entrega el siguiente mensaje del cliente actual.
+ * * Ya no llama a recv(): el reactor es quien lee del socket. Aquí solo
+ * esperamos (sin gastar CPU) a que deje algo en la bandeja o avise que colgó.
  */
 string ServerSocket::recibir()
 {
-    char buffer[1024];
-    // memset llena de ceros todo el arreglo. Es vital para strings de C.
-    memset(buffer, 0, sizeof(buffer));
+    std::unique_lock<std::mutex> lock(mtxCola);
+    int fd = clienteActual;
+    if (fd == -1)
+        return ""; // Nadie siendo atendido
 
-    int bytes = recv(clienteActual, buffer, sizeof(buffer), 0);
-    if (bytes <= 0)
-        return ""; // Desconexión o error
+    cvEntrada.wait(lock, [&] {
+        return !bandejaEntrada.empty() || activoDesconectado || clienteActual != fd;
+    });
+
+    if (bandejaEntrada.empty() || clienteActual != fd)
+        return ""; // Desconexión o cambio de cliente
+
+    string msg = std::move(bandejaEntrada.front());
+    bandejaEntrada.pop_front();
+    return msg;
+}
+
+EstadoEntrada ServerSocket::intentarRecibir(std::string& mensaje)
+{
+    std::lock_guard<std::mutex> lock(mtxCola);
+    if (clienteActual == -1) return EstadoEntrada::CERRADA;
+    if (!bandejaEntrada.empty()) {
+        mensaje = std::move(bandejaEntrada.front());
+        bandejaEntrada.pop_front();
+        return EstadoEntrada::MENSAJE;
+    }
+    return activoDesconectado ? EstadoEntrada::CERRADA : EstadoEntrada::VACIA;
+}
 
-    return string(buffer);
+int ServerSocket::descriptorEntrada() const {
+    return avisoEntrada;
+}
+
+/**
+ * @brief Un solo aviso para los dos tipos de lector: el que duerme en
+ * cvEntrada (recibir()) y el que vigila el eventfd (una corrutina en otro reactor).
+ */
+void ServerSocket::avisarEntrada() {
+    cvEntrada.notify_all();
+    uint64_t uno = 1;
+    ssize_t ignorado = write(avisoEntrada, &uno, sizeof(uno));
+    (void)ignorado;
 }
 
 // 8 - Enviar
-void ServerSocket::enviar(const string &msg)
+EstadoEnvio ServerSocket::enviar(const string &msg)
 {
-    if (clienteActual != -1)
+    // El decodificador del cliente rechaza la trama y cuelga: mejor no mandarla.
+    if (msg.size() > MAX_CARGA) return EstadoEnvio::DEMASIADO_GRANDE;
+
+    std::lock_guard<std::mutex> lock(mtxCola);
+    auto it = conexiones.find(clienteActual);
+    if (it == conexiones.end()) return EstadoEnvio::CERRADO;
+
+    enviarTrama(it->second, TipoTrama::MENSAJE, msg);
+    return it->second.salida.estaSaturado() ? EstadoEnvio::SATURADO : EstadoEnvio::ENVIADO;
+}
+
+/**
+ * @brief Difusión: una carga compartida, una cabecera por conexión.
+ * * Las conexiones que ya esperan EPOLLOUT (o un send de io_uring) no se
+ * tocan: su aviso sale junto con lo demás cuando el Kernel tenga lugar.
+ */
+size_t ServerSocket::difundir(std::string_view texto, uint32_t clave, DestinoDifusion destino)
+{
+    if (texto.size() > MAX_CARGA) {
+        cerr << "[AVISO] El aviso pasa de " << MAX_CARGA << " bytes; no se difunde." << endl;
+        return 0;
+    }
+    CargaCompartida carga = std::make_shared<const std::string>(texto);
+    std::vector<std::vector<std::pair<int, uint32_t>>> porVaciar(fragmentos.size());
+    size_t destinatarios = 0;
     {
-        send(clienteActual, msg.c_str(), msg.size(), 0);
+        std::lock_guard<std::mutex> lock(mtxCola);
+        for (auto& par : conexiones) {
+            EstadoConexion& conexion = par.second;
+            if (destino == DestinoDifusion::EN_COLA && !conexion.enCola) continue;
+            if (conexion.salida.agregarCompartida(TipoTrama::MENSAJE, conexion.secuenciaSalida, carga, clave))
+                ++conexion.secuenciaSalida;
+            ++destinatarios;
+            if (!conexion.esperandoEscritura)
+                porVaciar[conexion.fragmento->indice].push_back({par.first, conexion.generacion});
+        }
+    }
+
+    for (size_t i = 0; i < porVaciar.size(); ++i) {
+        if (porVaciar[i].empty()) continue;
+        Fragmento* fragmento = fragmentos[i].get();
+        fragmento->reactor.publicar([this, fragmento, destinos = std::move(porVaciar[i])] {
+            vaciarLote(*fragmento, destinos);
+        });
+    }
+    return destinatarios;
+}
+
+void ServerSocket::vaciarLote(Fragmento& fragmento, const std::vector<std::pair<int, uint32_t>>& destinos)
+{
+    const size_t TANDA = 256;
+    loteUring = &fragmento; // Con io_uring, todos los sends se someten juntos al final.
+    for (size_t desde = 0; desde < destinos.size(); desde += TANDA) {
+        std::lock_guard<std::mutex> lock(mtxCola);
+        size_t hasta = std::min(destinos.size(), desde + TANDA);
+        for (size_t i = desde; i < hasta; ++i) {
+            auto it = conexiones.find(destinos[i].first);
+            if (it == conexiones.end() || it->second.generacion != destinos[i].second) continue;
+            empujarSalida(it->second);
+        }
     }
+    loteUring = nullptr;
+    if (fragmento.anillo) fragmento.anillo->someter();
+}
+
+bool ServerSocket::salidaSaturada()
+{
+    std::lock_guard<std::mutex> lock(mtxCola);
+    auto it = conexiones.find(clienteActual);
+    return it != conexiones.end() && it->second.salida.estaSaturado();
 }
 
 // 9 - Cerrar cliente
+/**
+ * @brief Cierra la conexión del cliente activo.
+ * * El reactor de su fragmento podría seguir vigilando el socket, así que el
+ * cierre se publica como tarea para que ocurra dentro de ese hilo.
+ */
 void ServerSocket::cerrarCliente()
 {
-    if (clienteActual != -1)
+    int fd;
+    Fragmento* dueno = nullptr;
     {
-        close(clienteActual);
-        clienteActual = -1;
+        std::lock_guard<std::mutex> lock(mtxCola);
+        fd = clienteActual.exchange(-1);
+        if (fd == -1) return;
+        estimador.registrarSesion(chrono::steady_clock::now() - inicioSesion);
+        ++versionFila;
+        bandejaEntrada.clear();
+        avisarEntrada();
+        auto it = conexiones.find(fd);
+        if (it != conexiones.end()) dueno = it->second.fragmento;
     }
+
+    if (dueno) dueno->reactor.publicar([this, fd] { cerrarConexion(fd); });
 }
 
 // 10 - Cerrar servidor
 void ServerSocket::cerrarServidor()
 {
     cerrarCliente();
-    if (serverSocket != -1)
+    llegadas.despertar(); // Suelta a quien espere clientes nuevos.
+    for (auto& fragmento : fragmentos) fragmento->reactor.detener();
+    for (auto& fragmento : fragmentos)
     {
-        close(serverSocket);
-        serverSocket = -1;
+        if (fragmento->socketEscucha == -1) continue;
+        // Termina el accept multishot y libera el puerto.
+        if (fragmento->anillo) shutdown(fragmento->socketEscucha, SHUT_RDWR);
+        close(fragmento->socketEscucha);
+        fragmento->socketEscucha = -1;
+    }
+    for (auto& fragmento : fragmentos) {
+        if (fragmento->descriptorReserva == -1) continue;
+        close(fragmento->descriptorReserva);
+        fragmento->descriptorReserva = -1;
+    }
+    if (socketLocal != -1) {
+        close(socketLocal);
+        socketLocal = -1;
     }
 }
 
 /**
- * @brief Búsqueda lineal en el vector de clientes.
- * * Itera sobre la listaClientes para encontrar el nombre asociado a un socket.
+ * @brief Búsqueda en la tabla hash del registro (ya no se recorre a todos los que han pasado).
+ * * Como la ficha se borra al cerrar el socket, un número de socket reciclado
+ * nunca devuelve el nombre del cliente anterior.
  */
+std::string ServerSocket::nombreDe(int fd) const {
+    const InfoCliente* info = registroClientes.buscarPorSocket(fd);
+    return info ? info->nombre : "Desconocido";
+}
+
 std::string ServerSocket::obtenerNombrePorSocket(int socketBuscado) {
-    for(size_t i = 0; i < listaClientes.size(); ++i) {
-        if (listaClientes[i].socket == socketBuscado) {
-            return listaClientes[i].nombre;
-        }
-    }
-    return "Desconocido";
+    std::lock_guard<std::mutex> lock(mtxCola);
+    return nombreDe(socketBuscado);
+}
+
+int ServerSocket::obtenerIdPorSocket(int socketBuscado) {
+    std::lock_guard<std::mutex> lock(mtxCola);
+    const InfoCliente* info = registroClientes.buscarPorSocket(socketBuscado);
+    return info ? info->id : 0;
 }
 
 int ServerSocket::getClienteActual() {
@@ -219,8 +1399,39 @@ int ServerSocket::getClienteActual() {
 }
 
 bool ServerSocket::hayClientesEnCola() {
-    std::lock_guard<std::mutex> lock(mtxCola); // Protección de lectura
-    return !colaClientes.empty();
+    actualizarFila();
+    return !planificador->vacio();
+}
+
+bool ServerSocket::esperarClientes(std::chrono::milliseconds limite) {
+    if (hayClientesEnCola()) return true;
+    llegadas.esperar(limite);
+    return hayClientesEnCola();
+}
+
+int ServerSocket::descriptorLlegadas() const {
+    return llegadas.descriptor();
+}
+
+void ServerSocket::consumirAvisoLlegadas() {
+    llegadas.esperar(std::chrono::milliseconds(0));
+}
+
+void ServerSocket::actualizarFila() {
+    EntradaFila entrada;
+    while (llegadas.sacar(entrada)) planificador->agregar(entrada);
+    if (planificador->vacio()) return;
+
+    // Los que colgaron mientras esperaban se descartan aquí, no en cerrarConexion().
+    std::lock_guard<std::mutex> lock(mtxCola);
+    while (!planificador->vacio() && !vigente(planificador->frente()))
+        planificador->sacar();
+}
+
+bool ServerSocket::vigente(const EntradaFila& entrada) const {
+    if (!registroClientes.buscar(entrada.cliente)) return false;
+    auto it = conexiones.find(entrada.socket);
+    return it != conexiones.end() && it->second.enCola && it->second.ingreso == entrada.ingreso;
 }
 
 bool ServerSocket::estoyAtendiendo() {
@@ -228,5 +1439,5 @@ bool ServerSocket::estoyAtendiendo() {
 }
 
 void ServerSocket::liberarClienteActual() {
-    clienteActual = -1; 
+    cerrarCliente();
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+/**
+ * @file tickets.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación de la persistencia asíncrona de tickets.
+ * @version 1.0
+ * @date 06/01/2026
+ * * El hilo escritor serializa cada ticket directamente desde la vista del
+ * Chat al segmento del almacén: una escritura secuencial por ticket.
+ */
+
+#include "../include/tickets.h"
+#include <iostream>
+
+PersistenciaTickets::PersistenciaTickets(std::string carpeta, PoliticaDurabilidad politicaDisco,
+                                         size_t capacidadCola, size_t tamLote)
+    : directorio(std::move(carpeta)), politica(politicaDisco),
+      capacidad(capacidadCola > 0 ? capacidadCola : 1), maxLote(tamLote > 0 ? tamLote : 1),
+      detenido(false), abierto(false) {}
+
+PersistenciaTickets::~PersistenciaTickets() {
+    detener();
+}
+
+bool PersistenciaTickets::abrir() {
+    if (!abierto) abierto = almacen.abrir(directorio);
+    return abierto;
+}
+
+uint64_t PersistenciaTickets::guardarAhora(int clienteId, const std::string& nombre, std::time_t fecha,
+                                           const std::vector<Mensaje>& mensajes) {
+    if (escritor.joinable() || !abrir()) return 0;
+    uint64_t ticketId = almacen.agregar(static_cast<uint32_t>(clienteId), nombre, fecha, mensajes);
+    if (ticketId != 0 && !almacen.sincronizar()) return 0;
+    return ticketId;
+}
+
+void PersistenciaTickets::alGuardar(std::function<void(int clienteId)> aviso) {
+    avisoGuardado = std::move(aviso);
+}
+
+bool PersistenciaTickets::iniciar() {
+    if (escritor.joinable()) return true;
+    if (!abrir()) return false;
+    escritor = std::thread(&PersistenciaTickets::bucleEscritor, this);
+    return true;
+}
+
+/**
+ * @brief Pone el ticket en la cola. El costo para el hilo de red es mover
+ * unos punteros y despertar al escritor: nunca toca el disco.
+ */
+bool PersistenciaTickets::encolar(Ticket&& ticket) {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cvEspacio.wait(lock, [this] { return pendientes.size() < capacidad || detenido; });
+        if (detenido) {
+            std::cerr << "[TICKETS] Persistencia detenida, se descarta el ticket de " << ticket.nombre << ".\n";
+            return false;
+        }
+        pendientes.push_back(std::move(ticket));
+    }
+    cvTrabajo.notify_one();
+    return true;
+}
+
+void PersistenciaTickets::detener() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        detenido = true;
+    }
+    cvTrabajo.notify_all();
+    cvEspacio.notify_all();
+    if (escritor.joinable()) escritor.join();
+}
+
+/**
+ * @brief Hilo escritor.
+ * * Duerme hasta que haya tickets, se lleva hasta 'maxLote' de una vez (así
+ * una ráfaga de cierres cuesta un solo fdatasync) y los escribe SIN el mutex.
+ * Al detenerse vacía la cola antes de salir.
+ */
+void PersistenciaTickets::bucleEscritor() {
+    std::vector<Ticket> lote;
+    lote.reserve(maxLote);
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cvTrabajo.wait(lock, [this] { return !pendientes.empty() || detenido; });
+            if (pendientes.empty()) return; // Detenido y sin trabajo.
+
+            while (!pendientes.empty() && lote.size() < maxLote) {
+                lote.push_back(std::move(pendientes.front()));
+                pendientes.pop_front();
+            }
+        }
+        cvEspacio.notify_all();
+
+        escribirLote(lote);
+        lote.clear(); // Suelta las vistas: la bitácora de esas sesiones ya puede liberarse.
+    }
+}
+
+/**
+ * @brief Guarda el lote y, cuando ya es durable, avisa ticket por ticket.
+ * * Si la sincronización falla no se avisa: el WAL conserva esas sesiones y
+ * la siguiente recuperación las vuelve a guardar.
+ */
+void PersistenciaTickets::escribirLote(std::vector<Ticket>& lote) {
+    std::vector<int> guardados;
+    for (const Ticket& t : lote) {
+        uint64_t ticketId = almacen.agregar(static_cast<uint32_t>(t.id), t.nombre, t.fecha, t.historial);
+        if (ticketId == 0) continue;
+
+        if (politica == PoliticaDurabilidad::POR_TICKET && !almacen.sincronizar()) {
+            std::cerr << "[TICKETS] No se pudo sincronizar el ticket #" << ticketId << " con el disco.\n";
+            continue;
+        }
+        std::cout << "[SISTEMA] Ticket #" << ticketId << " guardado (" << t.nombre << ").\n";
+        guardados.push_back(t.id);
+    }
+
+    if (politica == PoliticaDurabilidad::POR_LOTE && !guardados.empty() && !almacen.sincronizar()) {
+        std::cerr << "[TICKETS] No se pudo sincronizar el lote con el disco.\n";
+        return;
+    }
+
+    if (avisoGuardado)
+        for (int id : guardados) avisoGuardado(id);
+}
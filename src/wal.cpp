@@ -0,0 +1,490 @@
+/**
+ * @file wal.cpp
+ * @author Valencia Cedeño Marcos Gael
+ * @author Peralta Ordóñez Jesús
+ * @author Esteves Flores Andrés
+ * @brief Implementación del WAL con group commit y recuperación.
+ * @version 1.0
+ * @date 06/01/2026
+ */
+
+#include "../include/wal.h"
+#include "../include/almacenTickets.h" // calcularCrc32()
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/// Bytes de cabecera de un registro (largo + crc), sin contar el tipo.
+static const size_t TAM_CABECERA_WAL = 8;
+
+template <typename T>
+static void anexar(std::string& destino, T valor) {
+    destino.append(reinterpret_cast<const char*>(&valor), sizeof(T));
+}
+
+static void anexarTexto16(std::string& destino, const std::string& texto) {
+    uint16_t largo = static_cast<uint16_t>(std::min<size_t>(texto.size(), UINT16_MAX));
+    anexar<uint16_t>(destino, largo);
+    destino.append(texto.data(), largo);
+}
+
+static void anexarTexto32(std::string& destino, const std::string& texto) {
+    anexar<uint32_t>(destino, static_cast<uint32_t>(texto.size()));
+    destino += texto;
+}
+
+/**
+ * @brief Lector con verificación de límites sobre los datos de un registro.
+ */
+struct LectorWAL {
+    const char* p;
+    const char* fin;
+
+    template <typename T>
+    bool leer(T& valor) {
+        if (static_cast<size_t>(fin - p) < sizeof(T)) return false;
+        std::memcpy(&valor, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    template <typename Largo>
+    bool leerTexto(std::string& texto) {
+        Largo largo;
+        if (!leer(largo) || static_cast<size_t>(fin - p) < largo) return false;
+        texto.assign(p, largo);
+        p += largo;
+        return true;
+    }
+};
+
+static bool escribirTodo(int fd, const char* datos, size_t tam) {
+    while (tam > 0) {
+        ssize_t n = ::write(fd, datos, tam);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        datos += n;
+        tam -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static void sincronizarDirectorio(const std::string& directorio) {
+    int dir = ::open(directorio.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir >= 0) {
+        fsync(dir);
+        ::close(dir);
+    }
+}
+
+// ================= CODIFICACIÓN =================
+
+WAL::WAL()
+    : lsnAnotado(0), lsnDurable(0), detenido(false), fallido(false), ultimoId(0),
+      segmentoActual(0), primerSegmento(0), tamSegmento(0), fd(-1) {}
+
+WAL::~WAL() {
+    detener();
+}
+
+std::string WAL::rutaSegmento(uint32_t numero) const {
+    char nombre[32];
+    std::snprintf(nombre, sizeof(nombre), "/wal_%06u.log", numero);
+    return directorio + nombre;
+}
+
+size_t WAL::abrirRegistro(std::string& destino, Tipo tipo) {
+    size_t inicio = destino.size();
+    destino.append(TAM_CABECERA_WAL, '\0');
+    anexar<uint8_t>(destino, static_cast<uint8_t>(tipo));
+    return inicio;
+}
+
+void WAL::cerrarRegistro(std::string& destino, size_t inicio) {
+    const char* cuerpo = destino.data() + inicio + TAM_CABECERA_WAL; // tipo + datos
+    size_t tamCuerpo = destino.size() - inicio - TAM_CABECERA_WAL;
+    uint32_t largo = static_cast<uint32_t>(tamCuerpo - 1);
+    uint32_t crc = calcularCrc32(cuerpo, tamCuerpo);
+    std::memcpy(&destino[inicio], &largo, sizeof(largo));
+    std::memcpy(&destino[inicio + 4], &crc, sizeof(crc));
+}
+
+/**
+ * @brief Lo único que paga el hilo que anota: cerrar el registro y, si el
+ * escritor estaba dormido (buffer vacío), despertarlo.
+ */
+uint64_t WAL::confirmar(size_t inicio) {
+    cerrarRegistro(pendiente, inicio);
+    size_t tam = pendiente.size() - inicio;
+    lsnAnotado += tam;
+    tamSegmento += tam;
+    if (inicio == 0) cvPendiente.notify_one();
+    return lsnAnotado;
+}
+
+// ================= ANOTACIONES =================
+
+uint64_t WAL::clienteEnCola(int clienteId, const std::string& nombre) {
+    std::lock_guard<std::mutex> lock(mtx);
+    ultimoId = std::max(ultimoId, clienteId);
+    cola.push_back({clienteId, nombre});
+
+    size_t inicio = abrirRegistro(pendiente, Tipo::EN_COLA);
+    anexar<int32_t>(pendiente, clienteId);
+    anexarTexto16(pendiente, nombre);
+    return confirmar(inicio);
+}
+
+uint64_t WAL::clienteFueraDeCola(int clienteId) {
+    std::lock_guard<std::mutex> lock(mtx);
+    cola.erase(std::remove_if(cola.begin(), cola.end(),
+                              [&](const ClienteEnEspera& c) { return c.clienteId == clienteId; }),
+               cola.end());
+
+    size_t inicio = abrirRegistro(pendiente, Tipo::FUERA_DE_COLA);
+    anexar<int32_t>(pendiente, clienteId);
+    return confirmar(inicio);
+}
+
+uint64_t WAL::sesionIniciada(int clienteId, const std::string& nombre, int64_t fecha) {
+    std::lock_guard<std::mutex> lock(mtx);
+    cola.erase(std::remove_if(cola.begin(), cola.end(),
+                              [&](const ClienteEnEspera& c) { return c.clienteId == clienteId; }),
+               cola.end());
+    ultimoId = std::max(ultimoId, clienteId);
+    sesionesSinTicket.emplace(clienteId, segmentoActual);
+
+    size_t inicio = abrirRegistro(pendiente, Tipo::INICIO_SESION);
+    anexar<int32_t>(pendiente, clienteId);
+    anexar<int64_t>(pendiente, fecha);
+    anexarTexto16(pendiente, nombre);
+    return confirmar(inicio);
+}
+
+uint64_t WAL::mensaje(int clienteId, const std::string& emisor, const std::string& texto, bool esMio) {
+    std::lock_guard<std::mutex> lock(mtx);
+    size_t inicio = abrirRegistro(pendiente, Tipo::MENSAJE);
+    anexar<int32_t>(pendiente, clienteId);
+    anexar<uint8_t>(pendiente, esMio ? 1 : 0);
+    anexarTexto16(pendiente, emisor);
+    anexarTexto32(pendiente, texto);
+    return confirmar(inicio);
+}
+
+uint64_t WAL::sesionTerminada(int clienteId, int64_t fecha) {
+    std::lock_guard<std::mutex> lock(mtx);
+    size_t inicio = abrirRegistro(pendiente, Tipo::FIN_SESION);
+    anexar<int32_t>(pendiente, clienteId);
+    anexar<int64_t>(pendiente, fecha);
+    return confirmar(inicio);
+}
+
+uint64_t WAL::ticketGuardado(int clienteId) {
+    std::lock_guard<std::mutex> lock(mtx);
+    sesionesSinTicket.erase(clienteId);
+
+    size_t inicio = abrirRegistro(pendiente, Tipo::TICKET_GUARDADO);
+    anexar<int32_t>(pendiente, clienteId);
+    return confirmar(inicio);
+}
+
+bool WAL::esperarDurable(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mtx);
+    cvDurable.wait(lock, [&] { return lsnDurable >= lsn || detenido || fallido; });
+    return lsnDurable >= lsn;
+}
+
+/**
+ * @brief Cabecera de un archivo nuevo: el contador y la cola tal como están.
+ * * Las sesiones sin ticket NO se copian: sus registros se quedan en los
+ * archivos viejos, que no se borran mientras esas sesiones sigan pendientes.
+ */
+std::string WAL::instantanea() const {
+    std::string datos;
+    size_t inicio = abrirRegistro(datos, Tipo::CONTADOR);
+    anexar<int32_t>(datos, ultimoId);
+    cerrarRegistro(datos, inicio);
+
+    for (const ClienteEnEspera& c : cola) {
+        inicio = abrirRegistro(datos, Tipo::EN_COLA);
+        anexar<int32_t>(datos, c.clienteId);
+        anexarTexto16(datos, c.nombre);
+        cerrarRegistro(datos, inicio);
+    }
+    return datos;
+}
+
+// ================= HILO ESCRITOR (GROUP COMMIT) =================
+
+/**
+ * @brief Escribe lotes hasta que se detenga.
+ * * Mientras hace fdatasync() de un lote, los demás hilos siguen anotando en
+ * 'pendiente': todo eso forma el lote siguiente. A más carga, lotes más grandes
+ * y el mismo número de fsync por segundo.
+ * * Si write() o fdatasync() fallan no se reintenta: tras un fdatasync fallido
+ * el Kernel puede haber descartado las páginas sucias, así que otro intento
+ * "exitoso" no probaría nada. El WAL queda 'fallido': lsnDurable no avanza,
+ * esperarDurable() devuelve false y lo que se anote después se descarta.
+ * Lo mismo si no se puede abrir el archivo al rotar.
+ */
+void WAL::bucleEscritor() {
+    std::string lote;
+
+    while (true) {
+        std::string cabeceraNueva;
+        bool rotar = false;
+        uint32_t nuevo = 0, borrarDesde = 0, borrarHasta = 0;
+        uint64_t lsnLote;
+
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cvPendiente.wait(lock, [this] { return !pendiente.empty() || detenido; });
+            if (pendiente.empty()) return; // Detenido y sin nada pendiente.
+
+            lote.clear();
+            lote.swap(pendiente);
+            lsnLote = lsnAnotado;
+
+            // El archivo actual creció demasiado: lo que se anote desde ya va al siguiente.
+            if (tamSegmento >= TAM_MAX_SEGMENTO) {
+                rotar = true;
+                nuevo = ++segmentoActual;
+                cabeceraNueva = instantanea();
+                tamSegmento = cabeceraNueva.size();
+
+                // Se conservan los archivos que aún tengan registros de sesiones sin ticket.
+                uint32_t conservarDesde = nuevo;
+                for (const auto& par : sesionesSinTicket) conservarDesde = std::min(conservarDesde, par.second);
+                borrarDesde = primerSegmento;
+                borrarHasta = conservarDesde;
+                primerSegmento = std::max(primerSegmento, conservarDesde);
+            }
+        }
+
+        // Solo este hilo cambia 'fallido': se puede leer sin el mutex.
+        if (fallido) continue;
+
+        bool durable = escribirTodo(fd, lote.data(), lote.size()) && fdatasync(fd) == 0;
+        bool sigue = durable;
+        if (!durable) std::cerr << "[WAL] No se pudo escribir en el disco; el WAL se detiene.\n";
+
+        if (durable && rotar) {
+            ::close(fd);
+            fd = ::open(rutaSegmento(nuevo).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+            if (fd < 0 || !escribirTodo(fd, cabeceraNueva.data(), cabeceraNueva.size()) || fdatasync(fd) < 0) {
+                // El lote ya está en el archivo anterior; lo que siga no tendría dónde ir.
+                std::cerr << "[WAL] No se pudo abrir el archivo " << nuevo << "; el WAL se detiene.\n";
+                sigue = false;
+            } else {
+                sincronizarDirectorio(directorio);
+                for (uint32_t s = borrarDesde; s < borrarHasta; ++s) ::unlink(rutaSegmento(s).c_str());
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (durable) lsnDurable = lsnLote;
+            if (!sigue) fallido = true;
+        }
+        cvDurable.notify_all();
+    }
+}
+
+// ================= RECUPERACIÓN =================
+
+bool WAL::aplicar(Tipo tipo, const char* datos, size_t tam, EstadoRecuperado& estado,
+                  std::map<int, SesionRecuperada>& sesiones) {
+    LectorWAL l{datos, datos + tam};
+    int32_t id;
+
+    auto quitarDeCola = [&](int clienteId) {
+        estado.cola.erase(std::remove_if(estado.cola.begin(), estado.cola.end(),
+                                         [&](const ClienteEnEspera& c) { return c.clienteId == clienteId; }),
+                          estado.cola.end());
+    };
+
+    switch (tipo) {
+        case Tipo::CONTADOR:
+            if (!l.leer(id)) return false;
+            estado.ultimoId = std::max(estado.ultimoId, static_cast<int>(id));
+            return true;
+
+        case Tipo::EN_COLA: {
+            ClienteEnEspera c;
+            if (!l.leer(id) || !l.leerTexto<uint16_t>(c.nombre)) return false;
+            c.clienteId = id;
+            estado.ultimoId = std::max(estado.ultimoId, c.clienteId);
+            // La cabecera de un archivo nuevo repite la cola: no se duplica.
+            bool yaEsta = std::any_of(estado.cola.begin(), estado.cola.end(),
+                                      [&](const ClienteEnEspera& e) { return e.clienteId == c.clienteId; });
+            if (!yaEsta) estado.cola.push_back(std::move(c));
+            return true;
+        }
+
+        case Tipo::FUERA_DE_COLA:
+            if (!l.leer(id)) return false;
+            quitarDeCola(id);
+            return true;
+
+        case Tipo::INICIO_SESION: {
+            SesionRecuperada s;
+            if (!l.leer(id) || !l.leer(s.fecha) || !l.leerTexto<uint16_t>(s.nombre)) return false;
+            s.clienteId = id;
+            estado.ultimoId = std::max(estado.ultimoId, s.clienteId);
+            quitarDeCola(id);
+            sesiones[id] = std::move(s);
+            return true;
+        }
+
+        case Tipo::MENSAJE: {
+            Mensaje m;
+            uint8_t esMio;
+            if (!l.leer(id) || !l.leer(esMio) || !l.leerTexto<uint16_t>(m.emisor) || !l.leerTexto<uint32_t>(m.texto))
+                return false;
+            m.esMio = esMio != 0;
+            auto it = sesiones.find(id);
+            if (it != sesiones.end()) it->second.mensajes.push_back(std::move(m));
+            return true;
+        }
+
+        case Tipo::FIN_SESION: {
+            int64_t fecha;
+            if (!l.leer(id) || !l.leer(fecha)) return false;
+            auto it = sesiones.find(id);
+            if (it != sesiones.end()) {
+                it->second.fecha = fecha;
+                it->second.terminada = true;
+            }
+            return true;
+        }
+
+        case Tipo::TICKET_GUARDADO:
+            if (!l.leer(id)) return false;
+            sesiones.erase(id);
+            return true;
+    }
+    return false; // Tipo desconocido: se trata como corrupción.
+}
+
+/**
+ * @brief Relee todos los archivos en orden.
+ * * En cuanto un registro no cuadra (incompleto o crc distinto) se deja de leer
+ * ese archivo: en el último es el punto exacto donde el proceso murió.
+ */
+bool WAL::recuperar(const std::string& carpeta, EstadoRecuperado& estado) {
+    directorio = carpeta;
+    estado = EstadoRecuperado();
+
+    if (mkdir(directorio.c_str(), 0755) < 0 && errno != EEXIST) {
+        std::cerr << "[WAL] No se pudo crear la carpeta " << directorio << ".\n";
+        return false;
+    }
+
+    DIR* dir = opendir(directorio.c_str());
+    if (!dir) return false;
+    segmentosViejos.clear();
+    while (dirent* d = readdir(dir)) {
+        unsigned numero;
+        char resto;
+        if (std::sscanf(d->d_name, "wal_%u.lo%c", &numero, &resto) == 2 && resto == 'g') segmentosViejos.push_back(numero);
+    }
+    closedir(dir);
+    std::sort(segmentosViejos.begin(), segmentosViejos.end());
+
+    std::map<int, SesionRecuperada> sesiones;
+    for (uint32_t numero : segmentosViejos) {
+        int fdLectura = ::open(rutaSegmento(numero).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fdLectura < 0) continue;
+
+        std::string contenido;
+        char bloque[64 * 1024];
+        ssize_t n;
+        while ((n = ::read(fdLectura, bloque, sizeof(bloque))) > 0) contenido.append(bloque, n);
+        ::close(fdLectura);
+
+        size_t pos = 0;
+        while (contenido.size() - pos >= TAM_CABECERA_WAL + 1) {
+            uint32_t largo, crc;
+            std::memcpy(&largo, contenido.data() + pos, 4);
+            std::memcpy(&crc, contenido.data() + pos + 4, 4);
+            const char* cuerpo = contenido.data() + pos + TAM_CABECERA_WAL;
+            if (contenido.size() - pos - TAM_CABECERA_WAL < static_cast<size_t>(largo) + 1) break;
+            if (calcularCrc32(cuerpo, largo + 1) != crc) break;
+            if (!aplicar(static_cast<Tipo>(cuerpo[0]), cuerpo + 1, largo, estado, sesiones)) break;
+            pos += TAM_CABECERA_WAL + 1 + largo;
+        }
+
+        if (pos < contenido.size())
+            std::cerr << "[WAL] wal_" << numero << ": se ignoran " << (contenido.size() - pos)
+                      << " bytes incompletos al final.\n";
+    }
+
+    int64_t ahora = static_cast<int64_t>(std::time(nullptr));
+    for (auto& par : sesiones) {
+        if (!par.second.terminada) par.second.fecha = ahora;
+        estado.pendientes.push_back(std::move(par.second));
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    segmentoActual = segmentosViejos.empty() ? 0 : segmentosViejos.back();
+    ultimoId = estado.ultimoId;
+    return true;
+}
+
+/**
+ * @brief Empieza un archivo limpio.
+ * * Primero el archivo nuevo queda en disco (con el contador) y SOLO después
+ * se borran los de la corrida anterior: si cae aquí, la recuperación se repite.
+ */
+bool WAL::iniciar(int ultimoIdAsignado) {
+    if (escritor.joinable()) return true;
+    if (directorio.empty()) {
+        std::cerr << "[WAL] Hay que llamar a recuperar() antes de iniciar().\n";
+        return false;
+    }
+
+    std::string cabecera;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        ultimoId = std::max(ultimoId, ultimoIdAsignado);
+        cola.clear(); // Las conexiones de la corrida anterior ya no existen.
+        sesionesSinTicket.clear();
+        primerSegmento = ++segmentoActual;
+        cabecera = instantanea();
+        tamSegmento = cabecera.size() + pendiente.size();
+    }
+
+    fd = ::open(rutaSegmento(segmentoActual).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0 || !escribirTodo(fd, cabecera.data(), cabecera.size()) || fdatasync(fd) < 0) {
+        std::cerr << "[WAL] No se pudo crear el archivo del WAL.\n";
+        return false;
+    }
+    sincronizarDirectorio(directorio);
+
+    for (uint32_t numero : segmentosViejos) ::unlink(rutaSegmento(numero).c_str());
+    segmentosViejos.clear();
+
+    escritor = std::thread(&WAL::bucleEscritor, this);
+    return true;
+}
+
+void WAL::detener() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        detenido = true;
+    }
+    cvPendiente.notify_all();
+    cvDurable.notify_all();
+    if (escritor.joinable()) escritor.join();
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}